@@ -604,8 +604,7 @@ ApfsDriverLoaderSupported (
 /**
   Routine Description:
 
-    Start this driver on ControllerHandle by opening a Block IO and Disk IO
-    protocol, reading ApfsContainer if present.
+    Worker of ApfsDriverLoaderStart.
 
   Arguments:
 
@@ -621,9 +620,9 @@ ApfsDriverLoaderSupported (
     other                 - This driver does not support this device.
 
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-ApfsDriverLoaderStart (
+ApfsDriverLoaderStartWorker (
   IN EFI_DRIVER_BINDING_PROTOCOL  *This,
   IN EFI_HANDLE                   ControllerHandle,
   IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath
@@ -1078,6 +1077,47 @@ ApfsDriverLoaderStart (
   return EFI_SUCCESS;
 }
 
+/**
+  Routine Description:
+
+    Start this driver on ControllerHandle by opening a Block IO and Disk IO
+    protocol, reading ApfsContainer if present.
+
+  Arguments:
+
+    This                  - Protocol instance pointer.
+    ControllerHandle      - Handle of device to bind driver to.
+    RemainingDevicePath   - Not used.
+
+  Returns:
+
+    EFI_SUCCESS           - This driver is added to DeviceHandle.
+    EFI_ALREADY_STARTED   - This driver is already running on DeviceHandle.
+    EFI_OUT_OF_RESOURCES  - Can not allocate the memory.
+    other                 - This driver does not support this device.
+
+**/
+EFI_STATUS
+EFIAPI
+ApfsDriverLoaderStart (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *This,
+  IN EFI_HANDLE                   ControllerHandle,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath
+  )
+{
+  EFI_STATUS                        Status;
+
+  BootTimelineBegin ("ApfsDriverLoaderStart");
+  Status = ApfsDriverLoaderStartWorker (
+             This,
+             ControllerHandle,
+             RemainingDevicePath
+             );
+  BootTimelineEnd ("ApfsDriverLoaderStart");
+
+  return Status;
+}
+
 /**
 
   Routine Description:
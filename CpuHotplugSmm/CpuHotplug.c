@@ -15,6 +15,7 @@
 #include <Library/MmServicesTableLib.h>      // gMmst
 #include <Library/PcdLib.h>                  // PcdGetBool()
 #include <Library/SafeIntLib.h>              // SafeUintnSub()
+#include <Library/TimerLib.h>                // GetPerformanceCounter()
 #include <Pcd/CpuHotEjectData.h>             // CPU_HOT_EJECT_DATA
 #include <Protocol/MmCpuIo.h>                // EFI_MM_CPU_IO_PROTOCOL
 #include <Protocol/SmmCpuService.h>          // EFI_SMM_CPU_SERVICE_PROTOCOL
@@ -56,7 +57,11 @@ STATIC CPU_HOT_EJECT_DATA *mCpuHotEjectData;
 // in a single MMI. The numbers of used (populated) elements in the arrays are
 // determined on every MMI separately.
 //
+// The fourth array is indexed like the first one, and stores the
+// CPU_HOT_PLUG_DATA slots reserved for the hot-added CPUs.
+//
 STATIC APIC_ID *mPluggedApicIds;
+STATIC UINT32  *mPluggedSlots;
 STATIC APIC_ID *mToUnplugApicIds;
 STATIC UINT32  *mToUnplugSelectors;
 //
@@ -72,34 +77,46 @@ STATIC EFI_HANDLE mDispatchHandle;
 /**
   Process CPUs that have been hot-added, per QemuCpuhpCollectApicIds().
 
-  For each such CPU, relocate the SMBASE, and report the CPU to PiSmmCpuDxeSmm
-  via EFI_SMM_CPU_SERVICE_PROTOCOL. If the supposedly hot-added CPU is already
-  known, skip it silently.
+  Reserve a CPU_HOT_PLUG_DATA slot for each such CPU; if the supposedly
+  hot-added CPU is already known, skip it silently. Then boot the new CPUs in
+  batches, relocate the SMBASE of each, and report each to PiSmmCpuDxeSmm via
+  EFI_SMM_CPU_SERVICE_PROTOCOL.
 
-  @param[in] PluggedApicIds    The APIC IDs of the CPUs that have been
-                               hot-plugged.
+  @param[in,out] PluggedApicIds  The APIC IDs of the CPUs that have been
+                                 hot-plugged. On output, the first elements
+                                 are the APIC IDs of the CPUs that were new.
 
-  @param[in] PluggedCount      The number of filled-in APIC IDs in
-                               PluggedApicIds.
+  @param[in] PluggedCount        The number of filled-in APIC IDs in
+                                 PluggedApicIds.
 
-  @retval EFI_SUCCESS          CPUs corresponding to all the APIC IDs are
-                               populated.
+  @retval EFI_SUCCESS            CPUs corresponding to all the APIC IDs are
+                                 populated.
 
-  @retval EFI_OUT_OF_RESOURCES Out of APIC ID space in "mCpuHotPlugData".
+  @retval EFI_OUT_OF_RESOURCES   Out of APIC ID space in "mCpuHotPlugData". The
+                                 CPUs that fit have been populated.
 
-  @return                      Error codes propagated from SmbaseRelocate()
-                               and mMmCpuService->AddProcessor().
+  @return                        Error codes propagated from SmbaseRelocate()
+                                 and mMmCpuService->AddProcessor(), for the
+                                 first CPU that failed. The other CPUs of its
+                                 batch have been populated; the CPUs of later
+                                 batches have not been booted.
 **/
 STATIC
 EFI_STATUS
 ProcessHotAddedCpus (
-  IN APIC_ID                      *PluggedApicIds,
-  IN UINT32                       PluggedCount
+  IN OUT APIC_ID                  *PluggedApicIds,
+  IN     UINT32                   PluggedCount
   )
 {
   EFI_STATUS Status;
+  EFI_STATUS SlotStatus;
+  EFI_STATUS CpuStatus;
   UINT32     PluggedIdx;
+  UINT32     NewCount;
+  UINT32     NewIdx;
   UINT32     NewSlot;
+  UINT32     BatchIdx;
+  UINT32     BatchCount;
 
   //
   // The Post-SMM Pen need not be reinstalled multiple times within a single
@@ -109,12 +126,12 @@ ProcessHotAddedCpus (
   //
   SmbaseReinstallPostSmmPen (mPostSmmPenAddress);
 
-  PluggedIdx = 0;
+  SlotStatus = EFI_SUCCESS;
+  NewCount = 0;
   NewSlot = 0;
-  while (PluggedIdx < PluggedCount) {
+  for (PluggedIdx = 0; PluggedIdx < PluggedCount; PluggedIdx++) {
     APIC_ID NewApicId;
     UINT32  CheckSlot;
-    UINTN   NewProcessorNumberByProtocol;
 
     NewApicId = PluggedApicIds[PluggedIdx];
 
@@ -131,7 +148,6 @@ ProcessHotAddedCpus (
     if (CheckSlot < mCpuHotPlugData->ArrayLength) {
       DEBUG ((DEBUG_VERBOSE, "%a: APIC ID " FMT_APIC_ID " was hot-plugged "
         "before; ignoring it\n", __FUNCTION__, NewApicId));
-      PluggedIdx++;
       continue;
     }
 
@@ -145,52 +161,86 @@ ProcessHotAddedCpus (
     if (NewSlot == mCpuHotPlugData->ArrayLength) {
       DEBUG ((DEBUG_ERROR, "%a: no room for APIC ID " FMT_APIC_ID "\n",
         __FUNCTION__, NewApicId));
-      return EFI_OUT_OF_RESOURCES;
+      SlotStatus = EFI_OUT_OF_RESOURCES;
+      break;
     }
 
     //
     // Store the APIC ID of the new processor to the slot.
     //
     mCpuHotPlugData->ApicId[NewSlot] = NewApicId;
+    PluggedApicIds[NewCount] = NewApicId;
+    mPluggedSlots[NewCount] = NewSlot;
+    NewCount++;
+    NewSlot++;
+  }
 
-    //
-    // Relocate the SMBASE of the new CPU.
-    //
-    Status = SmbaseRelocate (NewApicId, mCpuHotPlugData->SmBase[NewSlot],
-               mPostSmmPenAddress);
-    if (EFI_ERROR (Status)) {
-      goto RevokeNewSlot;
-    }
+  //
+  // Boot as many of the new CPUs as fit in one batch, then relocate their
+  // SMBASEs one by one. Once booted, every CPU of the batch waits at the
+  // default SMBASE for its relocation, so the batch is finished even if one of
+  // its CPUs fails; the slot of that CPU is revoked. The next batches are not
+  // booted after a failure, and the slots of their CPUs are revoked as well.
+  //
+  Status = EFI_SUCCESS;
+  for (BatchIdx = 0;
+       BatchIdx < NewCount && !EFI_ERROR (Status);
+       BatchIdx += BatchCount) {
+    BatchCount = NewCount - BatchIdx;
+    SmbaseBootBatch (&PluggedApicIds[BatchIdx], &BatchCount,
+      mPostSmmPenAddress);
 
-    //
-    // Add the new CPU with EFI_SMM_CPU_SERVICE_PROTOCOL.
-    //
-    Status = mMmCpuService->AddProcessor (mMmCpuService, NewApicId,
-                              &NewProcessorNumberByProtocol);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: AddProcessor(" FMT_APIC_ID "): %r\n",
-        __FUNCTION__, NewApicId, Status));
-      goto RevokeNewSlot;
-    }
+    for (NewIdx = BatchIdx; NewIdx < BatchIdx + BatchCount; NewIdx++) {
+      APIC_ID NewApicId;
+      UINTN   NewProcessorNumberByProtocol;
 
-    DEBUG ((DEBUG_INFO, "%a: hot-added APIC ID " FMT_APIC_ID ", SMBASE 0x%Lx, "
-      "EFI_SMM_CPU_SERVICE_PROTOCOL assigned number %Lu\n", __FUNCTION__,
-      NewApicId, (UINT64)mCpuHotPlugData->SmBase[NewSlot],
-      (UINT64)NewProcessorNumberByProtocol));
+      NewApicId = PluggedApicIds[NewIdx];
+      NewSlot = mPluggedSlots[NewIdx];
 
-    NewSlot++;
-    PluggedIdx++;
+      //
+      // Relocate the SMBASE of the new CPU, and add it with
+      // EFI_SMM_CPU_SERVICE_PROTOCOL.
+      //
+      CpuStatus = SmbaseRelocate (NewApicId, mCpuHotPlugData->SmBase[NewSlot],
+                    mPostSmmPenAddress);
+      if (!EFI_ERROR (CpuStatus)) {
+        CpuStatus = mMmCpuService->AddProcessor (mMmCpuService, NewApicId,
+                                     &NewProcessorNumberByProtocol);
+        if (EFI_ERROR (CpuStatus)) {
+          DEBUG ((DEBUG_ERROR, "%a: AddProcessor(" FMT_APIC_ID "): %r\n",
+            __FUNCTION__, NewApicId, CpuStatus));
+        }
+      }
+      if (EFI_ERROR (CpuStatus)) {
+        mCpuHotPlugData->ApicId[NewSlot] = MAX_UINT64;
+        if (!EFI_ERROR (Status)) {
+          Status = CpuStatus;
+        }
+        continue;
+      }
+
+      DEBUG ((DEBUG_INFO, "%a: hot-added APIC ID " FMT_APIC_ID ", SMBASE "
+        "0x%Lx, EFI_SMM_CPU_SERVICE_PROTOCOL assigned number %Lu\n",
+        __FUNCTION__, NewApicId, (UINT64)mCpuHotPlugData->SmBase[NewSlot],
+        (UINT64)NewProcessorNumberByProtocol));
+    }
   }
 
   //
-  // We've processed this batch of hot-added CPUs.
+  // Revoke the slots of the CPUs that have not been booted.
   //
-  return EFI_SUCCESS;
+  for (NewIdx = BatchIdx; NewIdx < NewCount; NewIdx++) {
+    mCpuHotPlugData->ApicId[mPluggedSlots[NewIdx]] = MAX_UINT64;
+  }
 
-RevokeNewSlot:
-  mCpuHotPlugData->ApicId[NewSlot] = MAX_UINT64;
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
-  return Status;
+  //
+  // We've processed this batch of hot-added CPUs.
+  //
+  return SlotStatus;
 }
 
 /**
@@ -549,6 +599,7 @@ CpuHotplugMmi (
   UINT8      ApmControl;
   UINT32     PluggedCount;
   UINT32     ToUnplugCount;
+  UINT64     StartTick;
 
   //
   // Assert that we are entering this function due to our root MMI handler
@@ -583,6 +634,8 @@ CpuHotplugMmi (
     return EFI_WARN_INTERRUPT_SOURCE_QUIESCED;
   }
 
+  StartTick = GetPerformanceCounter ();
+
   //
   // Collect the CPUs with pending events.
   //
@@ -614,6 +667,14 @@ CpuHotplugMmi (
     }
   }
 
+  //
+  // The OS is stalled for the whole MMI; log how long it took.
+  //
+  DEBUG ((DEBUG_INFO, "%a: plugged %u, unplugged %u CPU(s) in %Lu us\n",
+    __FUNCTION__, PluggedCount, ToUnplugCount,
+    DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter () - StartTick),
+      1000)));
+
   //
   // We've handled this MMI.
   //
@@ -727,11 +788,17 @@ CpuHotplugEntry (
     DEBUG ((DEBUG_ERROR, "%a: MmAllocatePool(): %r\n", __FUNCTION__, Status));
     goto Fatal;
   }
+  Status = gMmst->MmAllocatePool (EfiRuntimeServicesData, SizeSel,
+                    (VOID **)&mPluggedSlots);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: MmAllocatePool(): %r\n", __FUNCTION__, Status));
+    goto ReleasePluggedApicIds;
+  }
   Status = gMmst->MmAllocatePool (EfiRuntimeServicesData, Size,
                     (VOID **)&mToUnplugApicIds);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: MmAllocatePool(): %r\n", __FUNCTION__, Status));
-    goto ReleasePluggedApicIds;
+    goto ReleasePluggedSlots;
   }
   Status = gMmst->MmAllocatePool (EfiRuntimeServicesData, SizeSel,
                     (VOID **)&mToUnplugSelectors);
@@ -814,6 +881,10 @@ ReleaseToUnplugApicIds:
   gMmst->MmFreePool (mToUnplugApicIds);
   mToUnplugApicIds = NULL;
 
+ReleasePluggedSlots:
+  gMmst->MmFreePool (mPluggedSlots);
+  mPluggedSlots = NULL;
+
 ReleasePluggedApicIds:
   gMmst->MmFreePool (mPluggedApicIds);
   mPluggedApicIds = NULL;
@@ -11,6 +11,27 @@
 #ifndef FIRST_SMI_HANDLER_CONTEXT_H_
 #define FIRST_SMI_HANDLER_CONTEXT_H_
 
+//
+// The most hot-added CPUs the SMM Monarch boots in one batch.
+//
+#define FIRST_SMI_HANDLER_BATCH_MAX 1024
+
+//
+// A hot-added CPU of the batch that the SMM Monarch is relocating.
+//
+#pragma pack (1)
+typedef struct {
+  UINT32 ApicId;
+  //
+  // The hot-added CPU sets this field to 1 when it finds its APIC ID in the
+  // batch, while it knocks on ApicIdGate. From then on, it has entered SMM,
+  // and stored its state in the SMRAM Save State Map.
+  //
+  UINT8  Arrived;
+  UINT8  Reserved[3];
+} FIRST_SMI_HANDLER_BATCH_SLOT;
+#pragma pack ()
+
 //
 // The following structure is used to communicate between the SMM Monarch
 // (running the root MMI handler) and the hot-added CPU (handling its first
@@ -41,6 +62,19 @@ typedef struct {
   // byte of the normal RAM reserved page (Post-SMM Pen).
   //
   UINT8 AboutToLeaveSmm;
+  UINT8 Reserved1[3];
+  //
+  // The hot-added CPUs the SMM Monarch booted together, in Batch[0] through
+  // Batch[BatchCount - 1].
+  //
+  // All the CPUs at SMM_DEFAULT_SMBASE share one SMRAM Save State Map. The
+  // SMM Monarch may only un-gate the first CPU of the batch after all of them
+  // have entered SMM; otherwise, a late arrival could overwrite the SMBASE
+  // field that the CPU being relocated has just set, before its RSM.
+  //
+  UINT32                       BatchCount;
+  UINT32                       Reserved2;
+  FIRST_SMI_HANDLER_BATCH_SLOT Batch[FIRST_SMI_HANDLER_BATCH_MAX];
 } FIRST_SMI_HANDLER_CONTEXT;
 #pragma pack ()
 
@@ -10,8 +10,12 @@
 #include <Library/BaseLib.h>                  // CpuPause()
 #include <Library/BaseMemoryLib.h>            // CopyMem()
 #include <Library/DebugLib.h>                 // DEBUG()
-#include <Library/LocalApicLib.h>             // SendInitSipiSipi()
+#include <Library/IoLib.h>                    // MmioWrite32()
+#include <Library/LocalApicLib.h>             // SendInitIpi()
+#include <Library/PcdLib.h>                   // PcdGet32()
 #include <Library/SynchronizationLib.h>       // InterlockedCompareExchange64()
+#include <Library/TimerLib.h>                 // MicroSecondDelay()
+#include <Register/Intel/LocalApic.h>         // XAPIC_ICR_LOW_OFFSET
 #include <Register/Intel/SmramSaveStateMap.h> // SMM_DEFAULT_SMBASE
 
 #include "FirstSmiHandlerContext.h"           // FIRST_SMI_HANDLER_CONTEXT
@@ -23,6 +27,18 @@ extern CONST UINT16 mPostSmmPenSize;
 extern CONST UINT8 mFirstSmiHandler[];
 extern CONST UINT16 mFirstSmiHandlerSize;
 
+//
+// FIRST_SMI_HANDLER_CONTEXT must not reach into the first SMI handler.
+//
+STATIC_ASSERT (sizeof (FIRST_SMI_HANDLER_CONTEXT) <= SMM_HANDLER_OFFSET,
+  "FIRST_SMI_HANDLER_CONTEXT overlaps the first SMI handler");
+
+//
+// PcdCpuInitIpiDelayInMicroSeconds, fetched while boot services are
+// available.
+//
+STATIC UINT32 mInitIpiDelay;
+
 /**
   Allocate a non-SMRAM reserved memory page for the Post-SMM Pen for hot-added
   CPUs.
@@ -140,12 +156,58 @@ SmbaseInstallFirstSmiHandler (
 
   Context = (VOID *)(UINTN)SMM_DEFAULT_SMBASE;
   Context->ApicIdGate = MAX_UINT64;
+  Context->BatchCount = 0;
+
+  mInitIpiDelay = PcdGet32 (PcdCpuInitIpiDelayInMicroSeconds);
 }
 
 /**
-  Relocate the SMBASE on a hot-added CPU. Then pen the hot-added CPU in the
-  normal RAM reserved memory page, set up earlier with
-  SmbaseAllocatePostSmmPen() and SmbaseReinstallPostSmmPen().
+  Send a Start-up IPI to a CPU.
+
+  LocalApicLib only sends Start-up IPIs as part of SendInitSipiSipi(), which
+  waits PcdCpuInitIpiDelayInMicroSeconds after the INIT IPI on every call.
+
+  @param[in] ApicId      The APIC ID of the CPU.
+
+  @param[in] PenAddress  The page-aligned startup vector, below 1MB.
+**/
+STATIC
+VOID
+SmbaseSendStartupIpi (
+  IN APIC_ID ApicId,
+  IN UINT32  PenAddress
+  )
+{
+  LOCAL_APIC_ICR_LOW IcrLow;
+  UINTN              ApicBase;
+
+  IcrLow.Uint32 = 0;
+  IcrLow.Bits.Vector = PenAddress >> 12;
+  IcrLow.Bits.DeliveryMode = LOCAL_APIC_DELIVERY_MODE_STARTUP;
+  IcrLow.Bits.Level = 1;
+
+  if (GetApicMode () == LOCAL_APIC_MODE_X2APIC) {
+    AsmWriteMsr64 (X2APIC_MSR_ICR_ADDRESS,
+      LShiftU64 (ApicId, 32) | IcrLow.Uint32);
+    return;
+  }
+
+  ApicBase = GetLocalApicBaseAddress ();
+  MmioWrite32 (ApicBase + XAPIC_ICR_HIGH_OFFSET, ApicId << 24);
+  MmioWrite32 (ApicBase + XAPIC_ICR_LOW_OFFSET, IcrLow.Uint32);
+  do {
+    IcrLow.Uint32 = MmioRead32 (ApicBase + XAPIC_ICR_LOW_OFFSET);
+  } while (IcrLow.Bits.DeliveryStatus != 0);
+}
+
+/**
+  Boot a batch of hot-added CPUs, and wait until all of them have entered SMM
+  at SMM_DEFAULT_SMBASE. After this function returns, relocate the SMBASE of
+  each CPU of the batch with SmbaseRelocate(), in any order.
+
+  The CPUs are sent their SMIs and INIT IPIs back to back, and then their
+  Start-up IPIs, so the delay after INIT is spent once per batch rather than
+  once per CPU.
 
   The SMM Monarch is supposed to call this function from the root MMI handler.
 
@@ -153,6 +215,110 @@ SmbaseInstallFirstSmiHandler (
   SmbaseAllocatePostSmmPen(), and SmbaseReinstallPostSmmPen() before calling
   this function.
 
+  If a CPU of the batch never enters the first SMI handler, then this function
+  will hang forever.
+
+  @param[in] ApicIds     The APIC IDs of the hot-added CPUs.
+
+  @param[in,out] Count   On input, the number of APIC IDs in ApicIds. On
+                         output, the number of CPUs booted, from the start of
+                         ApicIds; at most FIRST_SMI_HANDLER_BATCH_MAX.
+
+  @param[in] PenAddress  The address of the Post-SMM Pen for hot-added CPUs, as
+                         returned by SmbaseAllocatePostSmmPen(), and installed
+                         by SmbaseReinstallPostSmmPen().
+**/
+VOID
+SmbaseBootBatch (
+  IN     CONST APIC_ID *ApicIds,
+  IN OUT UINT32        *Count,
+  IN     UINT32        PenAddress
+  )
+{
+  volatile FIRST_SMI_HANDLER_CONTEXT *Context;
+  UINT32                             Idx;
+
+  Context = (VOID *)(UINTN)SMM_DEFAULT_SMBASE;
+  *Count = MIN (*Count, FIRST_SMI_HANDLER_BATCH_MAX);
+
+  //
+  // Populate the batch before publishing its size; CPUs already in the first
+  // SMI handler look up their APIC IDs in it.
+  //
+  Context->BatchCount = 0;
+  for (Idx = 0; Idx < *Count; Idx++) {
+    Context->Batch[Idx].ApicId = ApicIds[Idx];
+    Context->Batch[Idx].Arrived = 0;
+  }
+  Context->BatchCount = *Count;
+
+  //
+  // Boot the hot-added CPUs.
+  //
+  // There are 2*2 cases to consider for each:
+  //
+  // (1) The CPU was hot-added before the SMI was broadcast.
+  //
+  // (1.1) The OS is benign.
+  //
+  //       The hot-added CPU is in RESET state, with the broadcast SMI pending
+  //       for it. The directed SMI below will be ignored (it's idempotent),
+  //       and the INIT-SIPI-SIPI will launch the CPU directly into SMM.
+  //
+  // (1.2) The OS is malicious.
+  //
+  //       The hot-added CPU has been booted, by the OS. Thus, the hot-added
+  //       CPU is spinning on the APIC ID gate. In that case, both the SMI and
+  //       the INIT-SIPI-SIPI below will be ignored.
+  //
+  // (2) The CPU was hot-added after the SMI was broadcast.
+  //
+  // (2.1) The OS is benign.
+  //
+  //       The hot-added CPU is in RESET state, with no SMI pending for it. The
+  //       directed SMI will latch the SMI for the CPU. Then the INIT-SIPI-SIPI
+  //       will launch the CPU into SMM.
+  //
+  // (2.2) The OS is malicious.
+  //
+  //       The hot-added CPU is executing OS code. The directed SMI will pull
+  //       the hot-added CPU into SMM, where it will start spinning on the APIC
+  //       ID gate. The INIT-SIPI-SIPI will be ignored.
+  //
+  for (Idx = 0; Idx < *Count; Idx++) {
+    SendSmiIpi (ApicIds[Idx]);
+    SendInitIpi (ApicIds[Idx]);
+  }
+  MicroSecondDelay (mInitIpiDelay);
+  for (Idx = 0; Idx < *Count; Idx++) {
+    SmbaseSendStartupIpi (ApicIds[Idx], PenAddress);
+  }
+  MicroSecondDelay (200);
+  for (Idx = 0; Idx < *Count; Idx++) {
+    SmbaseSendStartupIpi (ApicIds[Idx], PenAddress);
+  }
+
+  //
+  // Wait until every CPU of the batch is in SMM, and so is done writing the
+  // shared SMRAM Save State Map on SMM entry.
+  //
+  for (Idx = 0; Idx < *Count; Idx++) {
+    while (Context->Batch[Idx].Arrived == 0) {
+      CpuPause ();
+    }
+  }
+}
+
+/**
+  Relocate the SMBASE on a hot-added CPU. Then pen the hot-added CPU in the
+  normal RAM reserved memory page, set up earlier with
+  SmbaseAllocatePostSmmPen() and SmbaseReinstallPostSmmPen().
+
+  The SMM Monarch is supposed to call this function from the root MMI handler.
+
+  The SMM Monarch is responsible for booting the hot-added CPU with
+  SmbaseBootBatch() before calling this function.
+
   If the OS maliciously boots the hot-added CPU ahead of letting the ACPI CPU
   hotplug event handler broadcast the CPU hotplug MMI, then the hot-added CPU
   returns to the OS rather than to the pen, upon RSM. In that case, this
@@ -217,42 +383,6 @@ SmbaseRelocate (
   //
   *SmmVacated = 0;
 
-  //
-  // Boot the hot-added CPU.
-  //
-  // There are 2*2 cases to consider:
-  //
-  // (1) The CPU was hot-added before the SMI was broadcast.
-  //
-  // (1.1) The OS is benign.
-  //
-  //       The hot-added CPU is in RESET state, with the broadcast SMI pending
-  //       for it. The directed SMI below will be ignored (it's idempotent),
-  //       and the INIT-SIPI-SIPI will launch the CPU directly into SMM.
-  //
-  // (1.2) The OS is malicious.
-  //
-  //       The hot-added CPU has been booted, by the OS. Thus, the hot-added
-  //       CPU is spinning on the APIC ID gate. In that case, both the SMI and
-  //       the INIT-SIPI-SIPI below will be ignored.
-  //
-  // (2) The CPU was hot-added after the SMI was broadcast.
-  //
-  // (2.1) The OS is benign.
-  //
-  //       The hot-added CPU is in RESET state, with no SMI pending for it. The
-  //       directed SMI will latch the SMI for the CPU. Then the INIT-SIPI-SIPI
-  //       will launch the CPU into SMM.
-  //
-  // (2.2) The OS is malicious.
-  //
-  //       The hot-added CPU is executing OS code. The directed SMI will pull
-  //       the hot-added CPU into SMM, where it will start spinning on the APIC
-  //       ID gate. The INIT-SIPI-SIPI will be ignored.
-  //
-  SendSmiIpi (ApicId);
-  SendInitSipiSipi (ApicId, PenAddress);
-
   //
   // Expose the desired new SMBASE value to the hot-added CPU.
   //
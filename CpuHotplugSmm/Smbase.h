@@ -36,6 +36,13 @@ SmbaseInstallFirstSmiHandler (
   VOID
   );
 
+VOID
+SmbaseBootBatch (
+  IN     CONST APIC_ID *ApicIds,
+  IN OUT UINT32        *Count,
+  IN     UINT32        PenAddress
+  );
+
 EFI_STATUS
 SmbaseRelocate (
   IN APIC_ID ApicId,
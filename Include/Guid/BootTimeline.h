@@ -0,0 +1,89 @@
+/** @file
+  GUIDs and data structures for the boot timeline.
+
+  BootTimelineLib collects named begin / end probes, timestamped with the TSC,
+  in a BOOT_TIMELINE_TABLE. The table lives in:
+
+  - a PPI installed by SEC, for the probes taken before PEI runs,
+  - a GUID HOB in PEI,
+  - reserved memory in DXE, installed as a configuration table under
+    gOvmfBootTimelineGuid, so that it survives ExitBootServices() and can be
+    dumped from the guest OS.
+
+  Every phase imports the records of the previous one. When BDS is about to
+  boot an option, the records are also converted to an FPDT boot performance
+  table (FBPT) of dynamic string event records, at BOOT_TIMELINE_TABLE.Fpdt.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __BOOT_TIMELINE_H__
+#define __BOOT_TIMELINE_H__
+
+#define BOOT_TIMELINE_GUID \
+{0xe146edef, 0x977f, 0x4daa, {0xa5, 0xdd, 0x85, 0x59, 0x12, 0xb3, 0xf1, 0xce}}
+
+#define BOOT_TIMELINE_SEC_PPI_GUID \
+{0xf7ee78fe, 0x8e98, 0x4fca, {0xb2, 0x1d, 0x18, 0xf2, 0x06, 0x6e, 0xdb, 0x7b}}
+
+#define BOOT_TIMELINE_SIGNATURE  SIGNATURE_32 ('O', 'B', 'T', 'L')
+#define BOOT_TIMELINE_REVISION   1
+
+//
+// Values for BOOT_TIMELINE_RECORD.Type.
+//
+#define BOOT_TIMELINE_BEGIN  0
+#define BOOT_TIMELINE_END    1
+
+//
+// Probe names longer than this (including the terminating NUL) are truncated.
+//
+#define BOOT_TIMELINE_NAME_SIZE  24
+
+typedef struct {
+  UINT64 Tsc;
+  UINT32 Type;
+  UINT32 Reserved;
+  CHAR8  Name[BOOT_TIMELINE_NAME_SIZE];
+} BOOT_TIMELINE_RECORD;
+
+//
+// The header is followed by Capacity BOOT_TIMELINE_RECORD entries, used as a
+// ring: record N is stored at index N % Capacity, so once Count exceeds
+// Capacity, only the newest Capacity records are kept.
+//
+typedef struct {
+  UINT32 Signature;
+  UINT32 Revision;
+  UINT32 Capacity;
+  UINT32 Count;
+  //
+  // TSC ticks per second, from the TSC frequency HOB (see
+  // <Guid/TscFrequencyHob.h>), or measured against the ACPI PM timer if there
+  // is no such HOB; zero until the table is published.
+  //
+  UINT64 TscFrequency;
+  //
+  // Address of the FPDT boot performance table; zero until the table is
+  // published.
+  //
+  UINT64 Fpdt;
+} BOOT_TIMELINE_TABLE;
+
+//
+// The number of records SEC can hand over in its PPI.
+//
+#define BOOT_TIMELINE_SEC_RECORDS  4
+
+typedef struct {
+  BOOT_TIMELINE_TABLE  Header;
+  BOOT_TIMELINE_RECORD Records[BOOT_TIMELINE_SEC_RECORDS];
+} BOOT_TIMELINE_SEC_PPI;
+
+extern EFI_GUID gOvmfBootTimelineGuid;
+extern EFI_GUID gOvmfBootTimelineSecPpiGuid;
+
+#endif
@@ -0,0 +1,47 @@
+/** @file
+  GUID and data structure for the debug log ring.
+
+  The ring instance of PlatformDebugLibIoPort appends DEBUG() messages to a
+  DEBUG_LOG_RING in reserved memory, instead of writing them to the debug I/O
+  port one message at a time. The ring is drained to the port in bursts from
+  a periodic TPL_CALLBACK timer, synchronously on ASSERT(), and at
+  ExitBootServices(). It is installed as a configuration table under
+  gOvmfDebugLogRingGuid, so the newest Size bytes of the log can be retrieved
+  from the guest OS after boot.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __DEBUG_LOG_RING_H__
+#define __DEBUG_LOG_RING_H__
+
+#define DEBUG_LOG_RING_GUID \
+{0xcafd7ae1, 0x7d0f, 0x42e7, {0xbc, 0x01, 0x88, 0x9e, 0x64, 0xde, 0x03, 0xd8}}
+
+#define DEBUG_LOG_RING_SIGNATURE  SIGNATURE_32 ('O', 'D', 'L', 'R')
+
+//
+// The header is followed by Size bytes of data, with Size a power of two. The
+// byte at log offset N is stored at data index N % Size. Head and Tail are log
+// offsets, so they only grow: [Tail, Head) is not yet on the debug port, and
+// [MAX (Head, Size) - Size, Head) is what the ring still holds.
+//
+typedef struct {
+  UINT32 Signature;
+  UINT32 Size;
+  UINT64 Head;
+  UINT64 Tail;
+  //
+  // Set at ExitBootServices(), when the drain timer stops: from then on,
+  // every message is sent to the debug port as soon as it is appended.
+  //
+  UINT32 Bypass;
+  UINT32 Reserved;
+} DEBUG_LOG_RING;
+
+extern EFI_GUID gOvmfDebugLogRingGuid;
+
+#endif
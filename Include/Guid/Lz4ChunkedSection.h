@@ -0,0 +1,45 @@
+/** @file
+  GUID and payload format of the chunked LZ4 GUID-defined section.
+
+  The payload of the section is the uncompressed data split into chunks of
+  ChunkSize bytes (the last chunk may be shorter), each compressed separately
+  as an LZ4 block. Because no chunk refers to data of another, the chunks can
+  be decoded in any order, or concurrently.
+
+  The payload is laid out as follows:
+
+    LZ4_CHUNKED_SECTION_HEADER
+    UINT32 CompressedSize[ChunkCount]
+    compressed chunks, back to back, in order
+
+  If BIT31 is set in CompressedSize, the chunk is stored without compression,
+  and the remaining bits give its size.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __LZ4_CHUNKED_SECTION_H__
+#define __LZ4_CHUNKED_SECTION_H__
+
+#define LZ4_CHUNKED_CUSTOM_DECOMPRESS_GUID \
+{0xfd67af30, 0xb63e, 0x4a7f, {0xb6, 0x23, 0xd3, 0xcc, 0x0e, 0xe6, 0x3d, 0x2f}}
+
+#define LZ4_CHUNKED_SECTION_SIGNATURE   SIGNATURE_32 ('L', 'Z', '4', 'C')
+
+#define LZ4_CHUNKED_SECTION_CHUNK_RAW   BIT31
+
+#pragma pack (1)
+typedef struct {
+  UINT32 Signature;
+  UINT32 ChunkSize;
+  UINT32 ChunkCount;
+  UINT32 UncompressedSize;
+} LZ4_CHUNKED_SECTION_HEADER;
+#pragma pack ()
+
+extern EFI_GUID gLz4ChunkedCustomDecompressGuid;
+
+#endif
@@ -0,0 +1,47 @@
+/** @file
+  GUID and data structure for the fw_cfg file directory HOB.
+
+  The first PEIM that looks up a named fw_cfg file reads the complete file
+  directory (QemuFwCfgItemFileDir) once, converts it to CPU byte order, sorts
+  it by file name, and publishes it in a GUID HOB. Later lookups, in PEI and
+  in DXE, bisect the HOB contents instead of rescanning the directory through
+  the fw_cfg data register.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __QEMU_FW_CFG_FILE_DIR_H__
+#define __QEMU_FW_CFG_FILE_DIR_H__
+
+#include <IndustryStandard/QemuFwCfg.h>
+
+#define QEMU_FW_CFG_FILE_DIR_HOB_GUID \
+{0xdb9a587c, 0xcf9e, 0x46a3, {0x80, 0x5d, 0x5f, 0x07, 0xb7, 0x43, 0xc4, 0x50}}
+
+#pragma pack (1)
+//
+// One entry of the fw_cfg file directory. The layout matches the directory
+// entries that QEMU exposes, but Size and Select are kept in CPU byte order.
+//
+typedef struct {
+  UINT32 Size;
+  UINT16 Select;
+  UINT16 Reserved;
+  CHAR8  Name[QEMU_FW_CFG_FNAME_SIZE];
+} QEMU_FW_CFG_FILE;
+
+//
+// The HOB payload: Count is followed by Count QEMU_FW_CFG_FILE entries, sorted
+// in ascending AsciiStrCmp() order of Name.
+//
+typedef struct {
+  UINT32 Count;
+} QEMU_FW_CFG_FILE_DIR;
+#pragma pack ()
+
+extern EFI_GUID gQemuFwCfgFileDirHobGuid;
+
+#endif
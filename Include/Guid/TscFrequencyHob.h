@@ -0,0 +1,23 @@
+/** @file
+  GUID for the TSC frequency HOB.
+
+  The PEI instance of the TSC Timer Library determines the frequency of the
+  invariant TSC once -- from CPUID, or by calibrating it against the ACPI PM
+  timer -- and hands it to the DXE instance in this HOB. The HOB payload is a
+  single UINT64, the number of TSC ticks per second.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __TSC_FREQUENCY_HOB_H__
+#define __TSC_FREQUENCY_HOB_H__
+
+#define TSC_FREQUENCY_HOB_GUID \
+{0x4a2b3e50, 0xf792, 0x47c9, {0x8e, 0xd9, 0x31, 0x18, 0xd9, 0x60, 0xb1, 0x06}}
+
+extern EFI_GUID gOvmfTscFrequencyHobGuid;
+
+#endif
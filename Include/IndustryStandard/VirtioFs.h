@@ -124,6 +124,13 @@ typedef struct {
 // Flags for VirtioFsFuseOpInit.
 //
 #define VIRTIO_FS_FUSE_INIT_REQ_F_DO_READDIRPLUS BIT13
+#define VIRTIO_FS_FUSE_INIT_REQ_F_MAX_PAGES      BIT22
+
+//
+// The maximum number of pages in a request, unless the VirtioFsFuseOpInit
+// response sets VIRTIO_FS_FUSE_INIT_REQ_F_MAX_PAGES.
+//
+#define VIRTIO_FS_FUSE_DEFAULT_MAX_PAGES 32
 
 /**
   Macro for calculating the size of a directory stream entry.
@@ -0,0 +1,53 @@
+/** @file
+  Record named begin / end probes in the boot timeline -- include file.
+
+  See <Guid/BootTimeline.h> for where the records are kept. The probes do
+  nothing unless PcdBootTimelineEnable is TRUE.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef __BOOT_TIMELINE_LIB_H__
+#define __BOOT_TIMELINE_LIB_H__
+
+#include <Base.h>
+
+/**
+  Record the beginning of a named interval.
+
+  @param[in] Name  The name of the interval. Only the first
+                   BOOT_TIMELINE_NAME_SIZE - 1 characters are kept.
+**/
+VOID
+EFIAPI
+BootTimelineBegin (
+  IN CONST CHAR8 *Name
+  );
+
+/**
+  Record the end of a named interval.
+
+  @param[in] Name  The name passed to BootTimelineBegin().
+**/
+VOID
+EFIAPI
+BootTimelineEnd (
+  IN CONST CHAR8 *Name
+  );
+
+/**
+  Calibrate the TSC, and convert the timeline to an FPDT boot performance
+  table that the guest OS can read.
+
+  The DXE instance does this; the PEI instance does nothing. It may be called
+  more than once; every call replaces the previous FPDT table.
+**/
+VOID
+EFIAPI
+BootTimelinePublish (
+  VOID
+  );
+
+#endif
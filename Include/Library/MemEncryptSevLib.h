@@ -34,6 +34,13 @@ typedef struct {
 
   UINTN   VcCount;
   VOID    *GhcbBackupPages;
+
+  //
+  // #VC handler statistics, kept with PcdVcHandlerProfile: the number of
+  // #VCs and the TSC cycles spent handling them.
+  //
+  UINT64  VcHandled;
+  UINT64  VcCycles;
 } SEV_ES_PER_CPU_DATA;
 
 //
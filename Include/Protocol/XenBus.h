@@ -177,6 +177,10 @@ XENSTORE_STATUS
 /**
   End a transaction.
 
+  Writes made within the transaction are acknowledged only here. If one of
+  them failed, the transaction is discarded and the error of that write is
+  returned, so callers must check the result before relying on the writes.
+
   @param This         A pointer to XENBUS_PROTOCOL instance.
   @param Transaction  The transaction to end/commit.
   @param Abort        If TRUE, the transaction is discarded
@@ -219,6 +223,9 @@ XENSTORE_STATUS
   @param Frame      Frame Number of the page to grant access to.
   @param ReadOnly   Provide read-only or read-write access.
   @param RefPtr     Reference number of the grant will be written to this pointer.
+
+  @retval EFI_SUCCESS           The access has been granted.
+  @retval EFI_OUT_OF_RESOURCES  The grant table has no free entry.
 **/
 typedef
 EFI_STATUS
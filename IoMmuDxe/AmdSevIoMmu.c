@@ -14,6 +14,47 @@
 
 #include "AmdSevIoMmu.h"
 
+//
+// Bounce buffers for BusMasterRead[64] and BusMasterWrite[64] operations of up
+// to BOUNCE_CHUNK_PAGES pages are taken from a pool, in size classes of 1, 2,
+// 4, ... BOUNCE_CHUNK_PAGES pages. The pool grows by chunks of
+// BOUNCE_CHUNK_PAGES pages, each decrypted with a single page table update
+// (and TLB flush), and carved into the buffers of one size class.
+//
+// A bounce buffer released by Unmap() stays decrypted, and is recycled by the
+// next Map() in its size class. The chunks are re-encrypted only when
+// ExitBootServices() tears down all mappings.
+//
+#define BOUNCE_CLASS_COUNT  6
+#define BOUNCE_CHUNK_PAGES  (1 << (BOUNCE_CLASS_COUNT - 1))
+
+typedef struct {
+  LIST_ENTRY                                Link;
+  EFI_PHYSICAL_ADDRESS                      Address;
+  UINTN                                     Class;
+} BOUNCE_BUFFER;
+
+typedef struct {
+  LIST_ENTRY                                Link;
+  EFI_PHYSICAL_ADDRESS                      Base;
+  //
+  // Followed by the BOUNCE_BUFFER structures the chunk is carved into.
+  //
+} BOUNCE_CHUNK;
+
+//
+// All the chunks in the pool, and the bounce buffers not in use, by size
+// class. The descriptors live in encrypted memory, so the host cannot tamper
+// with the lists.
+//
+STATIC LIST_ENTRY mBounceChunks = INITIALIZE_LIST_HEAD_VARIABLE (mBounceChunks);
+STATIC LIST_ENTRY mFreeBounceBuffers[BOUNCE_CLASS_COUNT];
+
+//
+// Set once the pool has been re-encrypted at ExitBootServices().
+//
+STATIC BOOLEAN mBouncePoolDisabled;
+
 #define MAP_INFO_SIG SIGNATURE_64 ('M', 'A', 'P', '_', 'I', 'N', 'F', 'O')
 
 typedef struct {
@@ -24,6 +65,11 @@ typedef struct {
   UINTN                                     NumberOfPages;
   EFI_PHYSICAL_ADDRESS                      CryptedAddress;
   EFI_PHYSICAL_ADDRESS                      PlainTextAddress;
+  //
+  // The pooled bounce buffer at PlainTextAddress, or NULL if the plaintext
+  // buffer is not from the pool.
+  //
+  BOUNCE_BUFFER                             *BounceBuffer;
 } MAP_INFO;
 
 //
@@ -33,6 +79,24 @@ typedef struct {
 //
 STATIC LIST_ENTRY mMapInfos = INITIALIZE_LIST_HEAD_VARIABLE (mMapInfos);
 
+//
+// MAP_INFO structures released by IoMmuUnmap(), for IoMmuMap() to recycle.
+//
+STATIC LIST_ENTRY mFreeMapInfos = INITIALIZE_LIST_HEAD_VARIABLE (mFreeMapInfos);
+
+//
+// Counters reported at ExitBootServices(), showing where the cost of the
+// mappings goes.
+//
+typedef struct {
+  UINT64                                    Maps;
+  UINT64                                    PooledMaps;
+  UINT64                                    BytesBounced;
+  UINT64                                    EncMaskUpdates;
+} IOMMU_STATS;
+
+STATIC IOMMU_STATS mIoMmuStats;
+
 #define COMMON_BUFFER_SIG SIGNATURE_64 ('C', 'M', 'N', 'B', 'U', 'F', 'F', 'R')
 
 //
@@ -72,6 +136,116 @@ typedef struct {
 } COMMON_BUFFER_HEADER;
 #pragma pack ()
 
+/**
+  Grow the bounce buffer pool with a chunk carved into buffers of one size
+  class.
+
+  @param[in] Class  The size class to grow; the buffers are (1 << Class)
+                    pages in size.
+
+  @retval EFI_SUCCESS           The free list of Class has been populated.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+GrowBouncePool (
+  IN UINTN Class
+  )
+{
+  EFI_STATUS           Status;
+  UINTN                Count;
+  UINTN                Index;
+  BOUNCE_CHUNK         *Chunk;
+  BOUNCE_BUFFER        *Buffers;
+  EFI_PHYSICAL_ADDRESS Base;
+
+  Count = BOUNCE_CHUNK_PAGES >> Class;
+  Chunk = AllocatePool (sizeof *Chunk + Count * sizeof *Buffers);
+  if (Chunk == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // The chunk serves BusMasterRead and BusMasterWrite operations too, so keep
+  // it under 4GB.
+  //
+  Base = BASE_4GB - 1;
+  Status = gBS->AllocatePages (
+                  AllocateMaxAddress,
+                  EfiBootServicesData,
+                  BOUNCE_CHUNK_PAGES,
+                  &Base
+                  );
+  if (EFI_ERROR (Status)) {
+    FreePool (Chunk);
+    return Status;
+  }
+
+  Status = MemEncryptSevClearPageEncMask (0, Base, BOUNCE_CHUNK_PAGES, TRUE);
+  ASSERT_EFI_ERROR (Status);
+  if (EFI_ERROR (Status)) {
+    CpuDeadLoop ();
+  }
+  mIoMmuStats.EncMaskUpdates++;
+
+  Chunk->Base = Base;
+  InsertTailList (&mBounceChunks, &Chunk->Link);
+
+  Buffers = (BOUNCE_BUFFER *)(Chunk + 1);
+  for (Index = 0; Index < Count; Index++) {
+    Buffers[Index].Address = Base + EFI_PAGES_TO_SIZE (Index << Class);
+    Buffers[Index].Class   = Class;
+    InsertTailList (&mFreeBounceBuffers[Class], &Buffers[Index].Link);
+  }
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "%a: Class=%Lu Base=0x%Lx Buffers=%Lu\n",
+    __FUNCTION__,
+    (UINT64)Class,
+    Base,
+    (UINT64)Count
+    ));
+  return EFI_SUCCESS;
+}
+
+/**
+  Take a decrypted bounce buffer from the pool.
+
+  @param[in] NumberOfPages  The size of the bounce buffer in pages.
+
+  @return  The bounce buffer, or NULL if the pool does not serve the size or
+           cannot grow. The caller falls back to a bounce buffer of its own
+           then.
+**/
+STATIC
+BOUNCE_BUFFER *
+AllocateBounceBuffer (
+  IN UINTN NumberOfPages
+  )
+{
+  UINTN      Class;
+  LIST_ENTRY *Link;
+
+  if (mBouncePoolDisabled || NumberOfPages > BOUNCE_CHUNK_PAGES) {
+    return NULL;
+  }
+
+  Class = 0;
+  while ((UINTN)(1 << Class) < NumberOfPages) {
+    Class++;
+  }
+
+  if (IsListEmpty (&mFreeBounceBuffers[Class]) &&
+      EFI_ERROR (GrowBouncePool (Class))) {
+    return NULL;
+  }
+
+  Link = GetFirstNode (&mFreeBounceBuffers[Class]);
+  RemoveEntryList (Link);
+  return BASE_CR (Link, BOUNCE_BUFFER, Link);
+}
+
 /**
   Provides the controller-specific addresses required to access system memory
   from a DMA bus master. On SEV guest, the DMA operations must be performed on
@@ -138,12 +312,17 @@ IoMmuMap (
 
   //
   // Allocate a MAP_INFO structure to remember the mapping when Unmap() is
-  // called later.
+  // called later. Recycle one that Unmap() has released, if possible.
   //
-  MapInfo = AllocatePool (sizeof (MAP_INFO));
-  if (MapInfo == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Failed;
+  if (!IsListEmpty (&mFreeMapInfos)) {
+    MapInfo = CR (GetFirstNode (&mFreeMapInfos), MAP_INFO, Link, MAP_INFO_SIG);
+    RemoveEntryList (&MapInfo->Link);
+  } else {
+    MapInfo = AllocatePool (sizeof (MAP_INFO));
+    if (MapInfo == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Failed;
+    }
   }
 
   //
@@ -155,6 +334,7 @@ IoMmuMap (
   MapInfo->NumberOfBytes     = *NumberOfBytes;
   MapInfo->NumberOfPages     = EFI_SIZE_TO_PAGES (MapInfo->NumberOfBytes);
   MapInfo->CryptedAddress    = (UINTN)HostAddress;
+  MapInfo->BounceBuffer      = NULL;
 
   //
   // In the switch statement below, we point "MapInfo->PlainTextAddress" to the
@@ -179,6 +359,16 @@ IoMmuMap (
     //
   case EdkiiIoMmuOperationBusMasterRead64:
   case EdkiiIoMmuOperationBusMasterWrite64:
+    //
+    // Take an already decrypted bounce buffer from the pool, if possible. The
+    // pool lives under 4GB.
+    //
+    MapInfo->BounceBuffer = AllocateBounceBuffer (MapInfo->NumberOfPages);
+    if (MapInfo->BounceBuffer != NULL) {
+      MapInfo->PlainTextAddress = MapInfo->BounceBuffer->Address;
+      break;
+    }
+
     //
     // Allocate the implicit plaintext bounce buffer.
     //
@@ -247,17 +437,23 @@ IoMmuMap (
   }
 
   //
-  // Clear the memory encryption mask on the plaintext buffer.
+  // Clear the memory encryption mask on the plaintext buffer, unless it comes
+  // from the pool decrypted already.
   //
-  Status = MemEncryptSevClearPageEncMask (
-             0,
-             MapInfo->PlainTextAddress,
-             MapInfo->NumberOfPages,
-             TRUE
-             );
-  ASSERT_EFI_ERROR (Status);
-  if (EFI_ERROR (Status)) {
-    CpuDeadLoop ();
+  if (MapInfo->BounceBuffer == NULL) {
+    Status = MemEncryptSevClearPageEncMask (
+               0,
+               MapInfo->PlainTextAddress,
+               MapInfo->NumberOfPages,
+               TRUE
+               );
+    ASSERT_EFI_ERROR (Status);
+    if (EFI_ERROR (Status)) {
+      CpuDeadLoop ();
+    }
+    mIoMmuStats.EncMaskUpdates++;
+  } else {
+    mIoMmuStats.PooledMaps++;
   }
 
   //
@@ -279,6 +475,11 @@ IoMmuMap (
       );
   }
 
+  mIoMmuStats.Maps++;
+  if (MapInfo->PlainTextAddress != MapInfo->CryptedAddress) {
+    mIoMmuStats.BytesBounced += MapInfo->NumberOfBytes;
+  }
+
   //
   // Track all MAP_INFO structures.
   //
@@ -302,7 +503,7 @@ IoMmuMap (
   return EFI_SUCCESS;
 
 FreeMapInfo:
-  FreePool (MapInfo);
+  InsertHeadList (&mFreeMapInfos, &MapInfo->Link);
 
 Failed:
   *NumberOfBytes = 0;
@@ -400,6 +601,18 @@ IoMmuUnmapWorker (
     break;
   }
 
+  //
+  // Return a pooled bounce buffer to the pool, still decrypted. Its contents
+  // have been shared with the host already.
+  //
+  if (MapInfo->BounceBuffer != NULL) {
+    InsertHeadList (
+      &mFreeBounceBuffers[MapInfo->BounceBuffer->Class],
+      &MapInfo->BounceBuffer->Link
+      );
+    goto ReleaseMapInfo;
+  }
+
   //
   // Restore the memory encryption mask on the area we used to hold the
   // plaintext.
@@ -414,6 +627,7 @@ IoMmuUnmapWorker (
   if (EFI_ERROR (Status)) {
     CpuDeadLoop ();
   }
+  mIoMmuStats.EncMaskUpdates++;
 
   //
   // For BusMasterCommonBuffer[64] operations, copy the stashed data to the
@@ -440,14 +654,13 @@ IoMmuUnmapWorker (
     }
   }
 
+ReleaseMapInfo:
   //
-  // Forget the MAP_INFO structure, then free it (unless the UEFI memory map is
-  // locked).
+  // Forget the MAP_INFO structure, then keep it for recycling (which does not
+  // touch the UEFI memory map).
   //
   RemoveEntryList (&MapInfo->Link);
-  if (!MemoryMapLocked) {
-    FreePool (MapInfo);
-  }
+  InsertHeadList (&mFreeMapInfos, &MapInfo->Link);
 
   return EFI_SUCCESS;
 }
@@ -822,9 +1035,11 @@ AmdSevUnmapAllMappings (
   IN VOID      *Context
   )
 {
-  LIST_ENTRY *Node;
-  LIST_ENTRY *NextNode;
-  MAP_INFO   *MapInfo;
+  LIST_ENTRY   *Node;
+  LIST_ENTRY   *NextNode;
+  MAP_INFO     *MapInfo;
+  BOUNCE_CHUNK *Chunk;
+  EFI_STATUS   Status;
 
   DEBUG ((DEBUG_VERBOSE, "%a\n", __FUNCTION__));
 
@@ -841,6 +1056,43 @@ AmdSevUnmapAllMappings (
       TRUE      // MemoryMapLocked
       );
   }
+
+  //
+  // Every bounce buffer is back in the pool now. Restore the memory
+  // encryption mask on the pool chunks, and fill them with zeros. The chunks
+  // are not released, as the UEFI memory map is locked.
+  //
+  mBouncePoolDisabled = TRUE;
+  for (Node = GetFirstNode (&mBounceChunks);
+       Node != &mBounceChunks;
+       Node = GetNextNode (&mBounceChunks, Node)) {
+    Chunk = BASE_CR (Node, BOUNCE_CHUNK, Link);
+    Status = MemEncryptSevSetPageEncMask (
+               0,
+               Chunk->Base,
+               BOUNCE_CHUNK_PAGES,
+               TRUE
+               );
+    ASSERT_EFI_ERROR (Status);
+    if (EFI_ERROR (Status)) {
+      CpuDeadLoop ();
+    }
+    mIoMmuStats.EncMaskUpdates++;
+    ZeroMem (
+      (VOID *)(UINTN)Chunk->Base,
+      EFI_PAGES_TO_SIZE (BOUNCE_CHUNK_PAGES)
+      );
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: Maps=%Lu Pooled=%Lu BytesBounced=%Lu EncMaskUpdates=%Lu\n",
+    __FUNCTION__,
+    mIoMmuStats.Maps,
+    mIoMmuStats.PooledMaps,
+    mIoMmuStats.BytesBounced,
+    mIoMmuStats.EncMaskUpdates
+    ));
 }
 
 /**
@@ -857,6 +1109,11 @@ AmdSevInstallIoMmuProtocol (
   EFI_EVENT   UnmapAllMappingsEvent;
   EFI_EVENT   ExitBootEvent;
   EFI_HANDLE  Handle;
+  UINTN       Class;
+
+  for (Class = 0; Class < BOUNCE_CLASS_COUNT; Class++) {
+    InitializeListHead (&mFreeBounceBuffers[Class]);
+  }
 
   //
   // Create the "late" event whose notification function will tear down all
@@ -21,6 +21,201 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 DATA_HUB_INSTANCE mPrivateData;
 
+/**
+  Make room for one more entry in an index, doubling its capacity if it is
+  full.
+
+  @param Index                  The index to grow.
+
+  @retval EFI_SUCCESS           Index can take one more entry.
+  @retval EFI_OUT_OF_RESOURCES  The index could not be grown.
+**/
+EFI_STATUS
+GrowIndex (
+  IN OUT DATA_HUB_INDEX   *Index
+  )
+{
+  EFI_DATA_ENTRY  **Entries;
+  UINTN           Capacity;
+
+  if (Index->Count < Index->Capacity) {
+    return EFI_SUCCESS;
+  }
+
+  if (Index->Capacity == 0) {
+    Capacity = DATA_HUB_INDEX_INITIAL_CAPACITY;
+  } else {
+    Capacity = Index->Capacity * 2;
+  }
+  Entries = ReallocatePool (
+              Index->Capacity * sizeof (EFI_DATA_ENTRY *),
+              Capacity * sizeof (EFI_DATA_ENTRY *),
+              Index->Entries
+              );
+  if (Entries == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Index->Entries  = Entries;
+  Index->Capacity = Capacity;
+  return EFI_SUCCESS;
+}
+
+/**
+  Make room in the data log index, and in the class indexes of
+  DataRecordClass, for one more record. This is done before the record gets
+  its MTC, so that running out of resources leaves no gap in the MTCs.
+
+  @param Private                Data Hub instance.
+  @param DataRecordClass        Class of the record to be logged.
+
+  @retval EFI_SUCCESS           The indexes can take the record.
+  @retval EFI_OUT_OF_RESOURCES  An index could not be grown.
+**/
+EFI_STATUS
+ReserveIndexEntries (
+  IN DATA_HUB_INSTANCE    *Private,
+  IN UINT64               DataRecordClass
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Bit;
+
+  Status = GrowIndex (&Private->Log);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Bit = 0; Bit < DATA_HUB_INDEXED_CLASS_COUNT; Bit++) {
+    if ((DataRecordClass & LShiftU64 (1, Bit)) != 0) {
+      Status = GrowIndex (&Private->ClassLog[Bit]);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Add a logged record to the data log index and to its class indexes. Room
+  must have been made with ReserveIndexEntries ().
+
+  @param Private                Data Hub instance.
+  @param LogEntry               The entry of the record, with its MTC assigned.
+**/
+VOID
+IndexDataEntry (
+  IN DATA_HUB_INSTANCE    *Private,
+  IN EFI_DATA_ENTRY       *LogEntry
+  )
+{
+  DATA_HUB_INDEX  *Index;
+  UINTN           Bit;
+
+  ASSERT (LogEntry->Record->LogMonotonicCount ==
+          Private->FirstMonotonicCount + Private->Log.Count);
+
+  Private->Log.Entries[Private->Log.Count++] = LogEntry;
+
+  for (Bit = 0; Bit < DATA_HUB_INDEXED_CLASS_COUNT; Bit++) {
+    if ((LogEntry->Record->DataRecordClass & LShiftU64 (1, Bit)) != 0) {
+      Index = &Private->ClassLog[Bit];
+      ASSERT (Index->Count < Index->Capacity);
+      Index->Entries[Index->Count++] = LogEntry;
+    }
+  }
+}
+
+/**
+  Allocate the storage for a data log entry. Entries are never freed, so
+  small ones are carved from an arena instead of taking a pool allocation
+  each.
+
+  @param Private                Data Hub instance.
+  @param Size                   Size of the entry, including the record.
+
+  @retval NULL                  Out of resources.
+  @retval Other                 The storage for the entry.
+**/
+EFI_DATA_ENTRY *
+AllocateDataEntry (
+  IN DATA_HUB_INSTANCE    *Private,
+  IN UINTN                Size
+  )
+{
+  EFI_DATA_ENTRY  *LogEntry;
+  UINT8           *Arena;
+
+  Size = ALIGN_VALUE (Size, sizeof (UINT64));
+  if (Size > DATA_HUB_ARENA_SIZE / 4) {
+    return AllocatePool (Size);
+  }
+
+  if (Size > Private->ArenaFree) {
+    Arena = AllocatePool (DATA_HUB_ARENA_SIZE);
+    if (Arena == NULL) {
+      return NULL;
+    }
+    Private->Arena      = Arena;
+    Private->ArenaFree  = DATA_HUB_ARENA_SIZE;
+  }
+
+  LogEntry            = (EFI_DATA_ENTRY *) Private->Arena;
+  Private->Arena     += Size;
+  Private->ArenaFree -= Size;
+  return LogEntry;
+}
+
+/**
+  Get the time to stamp a record with. The RTC is read at most once per
+  DATA_HUB_LOG_TIME_PERIOD; a burst of records logged within that period
+  shares the time read for the first of them.
+
+  @param Private                Data Hub instance.
+  @param LogTime                The time to stamp the record with. Left
+                                untouched if the RTC cannot be read.
+**/
+VOID
+GetLogTime (
+  IN  DATA_HUB_INSTANCE   *Private,
+  OUT EFI_TIME            *LogTime
+  )
+{
+  EFI_TPL     OldTpl;
+  EFI_STATUS  Status;
+
+  //
+  // Serialize the callers at TPL_APPLICATION with those at TPL_CALLBACK, so
+  //  that the cached time is never copied while it is being updated.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  if (!Private->LogTimeValid ||
+      gBS->CheckEvent (Private->LogTimeEvent) != EFI_NOT_READY) {
+    Private->LogTimeValid = FALSE;
+    Status = gRT->GetTime (&Private->LogTime, NULL);
+    if (EFI_ERROR (Status)) {
+      gBS->RestoreTPL (OldTpl);
+      return;
+    }
+
+    if (Private->LogTimeEvent != NULL) {
+      Status = gBS->SetTimer (
+                      Private->LogTimeEvent,
+                      TimerRelative,
+                      DATA_HUB_LOG_TIME_PERIOD
+                      );
+      Private->LogTimeValid = (BOOLEAN) !EFI_ERROR (Status);
+    }
+  }
+
+  CopyMem (LogTime, &Private->LogTime, sizeof (EFI_TIME));
+
+  gBS->RestoreTPL (OldTpl);
+}
+
 /**
   Log data record into the data logging hub
 
@@ -74,7 +269,7 @@ DataHubLogData (
   //
   ZeroMem (&LogTime, sizeof (LogTime));
   if (EfiGetCurrentTpl() <= TPL_CALLBACK) {
-    gRT->GetTime (&LogTime, NULL);
+    GetLogTime (Private, &LogTime);
   }
 
   //
@@ -90,7 +285,13 @@ DataHubLogData (
     return Status;
   }
 
-  LogEntry = AllocatePool (TotalSize);
+  Status = ReserveIndexEntries (Private, DataRecordClass);
+  if (EFI_ERROR (Status)) {
+    EfiReleaseLock (&Private->DataLock);
+    return Status;
+  }
+
+  LogEntry = AllocateDataEntry (Private, TotalSize);
 
   if (LogEntry == NULL) {
     EfiReleaseLock (&Private->DataLock);
@@ -126,6 +327,7 @@ DataHubLogData (
   LogEntry->Record      = Record;
   LogEntry->RecordSize  = sizeof (EFI_DATA_ENTRY) + RawDataSize;
   InsertTailList (&Private->DataListHead, &LogEntry->Link);
+  IndexDataEntry (Private, LogEntry);
 
   CopyMem (Raw, RawData, RawDataSize);
 
@@ -149,77 +351,170 @@ DataHubLogData (
 }
 
 /**
-  Search the Head doubly linked list for the passed in MTC. Return the 
-  matching element in Head and the MTC on the next entry.
+  Find the first entry of an index with a MTC greater than CurrentMTC.
+
+  @param Index            The index to search.
+  @param CurrentMTC       The MTC to search past.
+
+  @retval NULL            All the entries in Index have a MTC up to CurrentMTC.
+  @retval Other           The first entry past CurrentMTC.
+
+**/
+EFI_DATA_ENTRY *
+FindIndexEntryAfter (
+  IN DATA_HUB_INDEX       *Index,
+  IN UINT64               CurrentMTC
+  )
+{
+  UINTN   Low;
+  UINTN   High;
+  UINTN   Middle;
+
+  Low   = 0;
+  High  = Index->Count;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Index->Entries[Middle]->Record->LogMonotonicCount <= CurrentMTC) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  return (Low < Index->Count) ? Index->Entries[Low] : NULL;
+}
+
+/**
+  Find the first entry in the data log that is in ClassFilter and has a MTC
+  greater than CurrentMTC.
+
+  @param Private          Data Hub instance.
+  @param ClassFilter      Only match entries in the same Class as ClassFilter.
+  @param CurrentMTC       The MTC to search past, or zero to search from the
+                          start of the data log.
+
+  @retval NULL            No such entry exists.
+  @retval Other           The entry found.
+
+**/
+EFI_DATA_ENTRY *
+FindDataEntryAfter (
+  IN DATA_HUB_INSTANCE    *Private,
+  IN UINT64               ClassFilter,
+  IN UINT64               CurrentMTC
+  )
+{
+  EFI_DATA_ENTRY  *LogEntry;
+  EFI_DATA_ENTRY  *Candidate;
+  UINTN           Bit;
+  UINTN           Index;
+
+  if ((ClassFilter & ~((UINT64) DATA_HUB_INDEXED_CLASSES)) != 0) {
+    //
+    // The filter has classes that are not indexed; walk the data log.
+    //
+    if (CurrentMTC < Private->FirstMonotonicCount) {
+      Index = 0;
+    } else {
+      Index = (UINTN) (CurrentMTC - Private->FirstMonotonicCount) + 1;
+    }
+    for (; Index < Private->Log.Count; Index++) {
+      LogEntry = Private->Log.Entries[Index];
+      if ((LogEntry->Record->DataRecordClass & ClassFilter) != 0) {
+        return LogEntry;
+      }
+    }
+    return NULL;
+  }
+
+  //
+  // The answer is the earliest of the first matches in the class indexes.
+  //
+  LogEntry = NULL;
+  for (Bit = 0; Bit < DATA_HUB_INDEXED_CLASS_COUNT; Bit++) {
+    if ((ClassFilter & LShiftU64 (1, Bit)) == 0) {
+      continue;
+    }
+    Candidate = FindIndexEntryAfter (&Private->ClassLog[Bit], CurrentMTC);
+    if (Candidate != NULL &&
+        (LogEntry == NULL ||
+         Candidate->Record->LogMonotonicCount < LogEntry->Record->LogMonotonicCount)) {
+      LogEntry = Candidate;
+    }
+  }
+
+  return LogEntry;
+}
+
+/**
+  Look up the passed in MTC in the data log index. Return the matching
+  element and the MTC on the next entry.
 
-  @param Head             Head of Data Log linked list.
+  @param Private          Data Hub instance.
   @param ClassFilter      Only match the MTC if it is in the same Class as the
                           ClassFilter.
   @param PtrCurrentMTC    On IN contians MTC to search for. On OUT contians next
                           MTC in the data log list or zero if at end of the list.
   
-  @retval EFI_DATA_LOG_ENTRY  Return pointer to data log data from Head list.
+  @retval EFI_DATA_LOG_ENTRY  Return pointer to data log data from the data log.
   @retval NULL                If no data record exists.
 
 **/
 EFI_DATA_RECORD_HEADER *
 GetNextDataRecord (
-  IN  LIST_ENTRY          *Head,
+  IN  DATA_HUB_INSTANCE   *Private,
   IN  UINT64              ClassFilter,
   IN OUT  UINT64          *PtrCurrentMTC
   )
 
 {
   EFI_DATA_ENTRY          *LogEntry;
-  LIST_ENTRY              *Link;
-  BOOLEAN                 ReturnFirstEntry;
-  EFI_DATA_RECORD_HEADER  *Record;
   EFI_DATA_ENTRY          *NextLogEntry;
 
   //
-  // If MonotonicCount == 0 just return the first one
+  // The indexes may be reallocated while a record is logged, so look them up
+  //  with the lock held.
   //
-  ReturnFirstEntry  = (BOOLEAN) (*PtrCurrentMTC == 0);
+  EfiAcquireLock (&Private->DataLock);
 
-  Record            = NULL;
-  for (Link = GetFirstNode(Head); Link != Head; Link = GetNextNode(Head, Link)) {
-    LogEntry = DATA_ENTRY_FROM_LINK (Link);
+  if (*PtrCurrentMTC == 0) {
+    //
+    // If MonotonicCount == 0 just return the first one
+    //
+    LogEntry = FindDataEntryAfter (Private, ClassFilter, 0);
+  } else if (*PtrCurrentMTC >= Private->FirstMonotonicCount &&
+             *PtrCurrentMTC - Private->FirstMonotonicCount < Private->Log.Count) {
+    LogEntry = Private->Log.Entries[(UINTN) (*PtrCurrentMTC - Private->FirstMonotonicCount)];
     if ((LogEntry->Record->DataRecordClass & ClassFilter) == 0) {
-      //
-      // Skip any entry that does not have the correct ClassFilter
-      //
-      continue;
+      LogEntry = NULL;
     }
+  } else {
+    LogEntry = NULL;
+  }
 
-    if ((LogEntry->Record->LogMonotonicCount == *PtrCurrentMTC) || ReturnFirstEntry) {
-      //
-      // Return record to the user
-      //
-      Record = LogEntry->Record;
+  if (LogEntry == NULL) {
+    EfiReleaseLock (&Private->DataLock);
+    return NULL;
+  }
 
-      //
-      // Calculate the next MTC value. If there is no next entry set
-      // MTC to zero.
-      //
-      *PtrCurrentMTC = 0;
-      for (Link = GetNextNode(Head, Link); Link != Head; Link = GetNextNode(Head, Link)) {
-        NextLogEntry = DATA_ENTRY_FROM_LINK (Link);
-        if ((NextLogEntry->Record->DataRecordClass & ClassFilter) != 0) {
-          //
-          // Return the MTC of the next thing to search for if found
-          //
-          *PtrCurrentMTC = NextLogEntry->Record->LogMonotonicCount;
-          break;
-        }
-      }
-      //
-      // Record found exit loop and return
-      //
-      break;
-    }
+  //
+  // Calculate the next MTC value. If there is no next entry set
+  // MTC to zero.
+  //
+  NextLogEntry = FindDataEntryAfter (
+                   Private,
+                   ClassFilter,
+                   LogEntry->Record->LogMonotonicCount
+                   );
+  if (NextLogEntry == NULL) {
+    *PtrCurrentMTC = 0;
+  } else {
+    *PtrCurrentMTC = NextLogEntry->Record->LogMonotonicCount;
   }
 
-  return Record;
+  EfiReleaseLock (&Private->DataLock);
+
+  return LogEntry->Record;
 }
 
 /**
@@ -306,7 +601,7 @@ DataHubGetNextRecord (
   // If FilterDriverEvent is NULL, then return the next record
   //
   if (FilterDriverEvent == NULL) {
-    *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+    *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
     if (*Record == NULL) {
       return EFI_NOT_FOUND;
     }
@@ -334,7 +629,7 @@ DataHubGetNextRecord (
   // Retrieve the next record or the first record.
   //   
   if (*MonotonicCount != 0 || FilterDriver->GetNextMonotonicCount == 0) { 
-    *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+    *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
     if (*Record == NULL) {
       return EFI_NOT_FOUND;
     }
@@ -363,7 +658,7 @@ DataHubGetNextRecord (
   // Retrieve the last record successfuly read again, but do not return it since
   // it has already been returned before.
   //
-  *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+  *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
   if (*Record == NULL) {
     return EFI_NOT_FOUND;
   }
@@ -377,7 +672,7 @@ DataHubGetNextRecord (
     //
     // Retrieve the record after the last record successfuly read 
     //  
-    *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+    *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
     if (*Record == NULL) {
       return EFI_NOT_FOUND;
     }
@@ -572,6 +867,23 @@ DataHubInstall (
   } else {
     mPrivateData.GlobalMonotonicCount = LShiftU64 ((UINT64) HighMontonicCount, 32);
   }
+  mPrivateData.FirstMonotonicCount = mPrivateData.GlobalMonotonicCount + 1;
+
+  //
+  // The timer that tells when the time read from the RTC goes stale. Without
+  // it every record gets its own RTC read.
+  //
+  Status = gBS->CreateEvent (
+                  EVT_TIMER,
+                  TPL_CALLBACK,
+                  NULL,
+                  NULL,
+                  &mPrivateData.LogTimeEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    mPrivateData.LogTimeEvent = NULL;
+  }
+
   //
   // Make a new handle and install the protocol
   //
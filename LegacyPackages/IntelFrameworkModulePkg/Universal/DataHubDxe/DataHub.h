@@ -30,6 +30,61 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 
+//
+// Private data structure to contain the data log. One record per
+//  structure. Head pointer to the list is the Log member of
+//  EFI_DATA_ENTRY. Record is a copy of the data passed in.
+//
+#define EFI_DATA_ENTRY_SIGNATURE  SIGNATURE_32 ('D', 'r', 'e', 'c')
+typedef struct {
+  UINT32                  Signature;
+  LIST_ENTRY              Link;
+
+  EFI_DATA_RECORD_HEADER  *Record;
+
+  UINTN                   RecordSize;
+
+} EFI_DATA_ENTRY;
+
+#define DATA_ENTRY_FROM_LINK(link)  CR (link, EFI_DATA_ENTRY, Link, EFI_DATA_ENTRY_SIGNATURE)
+
+//
+// Array of data log entries in ascending order of LogMonotonicCount.
+//
+typedef struct {
+  EFI_DATA_ENTRY          **Entries;
+  UINTN                   Count;
+  UINTN                   Capacity;
+} DATA_HUB_INDEX;
+
+//
+// The record classes defined by the Data Hub specification occupy the low
+//  bits of DataRecordClass; each of them has its own index.
+//
+#define DATA_HUB_INDEXED_CLASS_COUNT  4
+#define DATA_HUB_INDEXED_CLASSES      (EFI_DATA_RECORD_CLASS_DEBUG | \
+                                       EFI_DATA_RECORD_CLASS_ERROR | \
+                                       EFI_DATA_RECORD_CLASS_DATA | \
+                                       EFI_DATA_RECORD_CLASS_PROGRESS_CODE)
+
+//
+// Initial number of entries in a DATA_HUB_INDEX. The capacity doubles
+//  whenever it is exhausted.
+//
+#define DATA_HUB_INDEX_INITIAL_CAPACITY  64
+
+//
+// Size of an arena that records are carved from. Records larger than a
+//  quarter of an arena are allocated from pool on their own.
+//
+#define DATA_HUB_ARENA_SIZE  SIZE_16KB
+
+//
+// The RTC time read for a record is reused for the records logged within
+//  this period (in 100ns units), which matches the resolution of the RTC.
+//
+#define DATA_HUB_LOG_TIME_PERIOD  10000000
+
 #define DATA_HUB_INSTANCE_SIGNATURE SIGNATURE_32 ('D', 'H', 'u', 'b')
 typedef struct {
   UINT32                Signature;
@@ -68,27 +123,38 @@ typedef struct {
   //
   LIST_ENTRY            FilterDriverListHead;
 
-} DATA_HUB_INSTANCE;
-
-#define DATA_HUB_INSTANCE_FROM_THIS(this) CR (this, DATA_HUB_INSTANCE, DataHub, DATA_HUB_INSTANCE_SIGNATURE)
+  //
+  // Index of the data log. Monotonic counts are assigned consecutively, so
+  //  the entry with LogMonotonicCount (FirstMonotonicCount + N) is
+  //  Log.Entries[N].
+  //
+  UINT64                FirstMonotonicCount;
+  DATA_HUB_INDEX        Log;
 
-//
-// Private data structure to contain the data log. One record per
-//  structure. Head pointer to the list is the Log member of
-//  EFI_DATA_ENTRY. Record is a copy of the data passed in.
-//
-#define EFI_DATA_ENTRY_SIGNATURE  SIGNATURE_32 ('D', 'r', 'e', 'c')
-typedef struct {
-  UINT32                  Signature;
-  LIST_ENTRY              Link;
+  //
+  // ClassLog[N] holds the entries whose DataRecordClass has bit N set, so
+  //  that the next record matching a class filter is found with a binary
+  //  search.
+  //
+  DATA_HUB_INDEX        ClassLog[DATA_HUB_INDEXED_CLASS_COUNT];
 
-  EFI_DATA_RECORD_HEADER  *Record;
+  //
+  // Free space in the current arena.
+  //
+  UINT8                 *Arena;
+  UINTN                 ArenaFree;
 
-  UINTN                   RecordSize;
+  //
+  // RTC time read for the current burst of records. LogTimeEvent is a timer
+  //  event that gets signaled when LogTime goes stale.
+  //
+  EFI_TIME              LogTime;
+  BOOLEAN               LogTimeValid;
+  EFI_EVENT             LogTimeEvent;
 
-} EFI_DATA_ENTRY;
+} DATA_HUB_INSTANCE;
 
-#define DATA_ENTRY_FROM_LINK(link)  CR (link, EFI_DATA_ENTRY, Link, EFI_DATA_ENTRY_SIGNATURE)
+#define DATA_HUB_INSTANCE_FROM_THIS(this) CR (this, DATA_HUB_INSTANCE, DataHub, DATA_HUB_INSTANCE_SIGNATURE)
 
 //
 // Private data to contain the filter driver Event and it's
@@ -19,42 +19,6 @@
 //
 #define ACPI_TIMER_COUNT_SIZE  BIT24
 
-/**
-  Stalls the CPU for at least the given number of ticks.
-
-  Stalls the CPU for at least the given number of ticks. It's invoked by
-  MicroSecondDelay() and NanoSecondDelay().
-
-  @param  Delay     A period of time to delay in ticks.
-
-**/
-VOID
-InternalAcpiDelay (
-  IN      UINT32                    Delay
-  )
-{
-  UINT32                            Ticks;
-  UINT32                            Times;
-
-  Times    = Delay >> 22;
-  Delay   &= BIT22 - 1;
-  do {
-    //
-    // The target timer count is calculated here
-    //
-    Ticks    = InternalAcpiGetTimerTick () + Delay;
-    Delay    = BIT22;
-    //
-    // Wait until time out
-    // Delay >= 2^23 could not be handled by this function
-    // Timer wrap-arounds are handled correctly by this function
-    //
-    while (((Ticks - InternalAcpiGetTimerTick ()) & BIT23) == 0) {
-      CpuPause ();
-    }
-  } while (Times-- > 0);
-}
-
 /**
   Stalls the CPU for at least the given number of microseconds.
 
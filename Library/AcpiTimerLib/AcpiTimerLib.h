@@ -20,4 +20,29 @@ InternalAcpiGetTimerTick (
   VOID
   );
 
+/**
+  Stalls the CPU for at least the given number of ACPI timer ticks.
+
+  @param  Delay     A period of time to delay in ticks.
+
+**/
+VOID
+InternalAcpiDelay (
+  IN      UINT32                    Delay
+  );
+
+/**
+  The constructor of the "Base", "BaseRom" and "Dxe" instances: caches the
+  ACPI tick counter address, and, outside DXE, enables ACPI IO space.
+
+  @retval RETURN_SUCCESS      The tick counter address was cached.
+  @retval RETURN_UNSUPPORTED  The host bridge is unknown.
+
+**/
+RETURN_STATUS
+EFIAPI
+AcpiTimerLibConstructor (
+  VOID
+  );
+
 #endif // _ACPI_TIMER_LIB_INTERNAL_H_
@@ -0,0 +1,53 @@
+/** @file
+  Provide the constructor for the DXE instance of TSC Timer Library
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <PiDxe.h>
+#include <Guid/TscFrequencyHob.h>
+#include <Library/HobLib.h>
+
+#include "AcpiTimerLib.h"
+#include "TscTimerLib.h"
+
+/**
+  The constructor function caches the ACPI tick counter address, like the
+  "Dxe" instance, and takes the TSC frequency from the HOB that the PEI
+  instance produced, if the TSC is invariant.
+
+  Without the HOB (PEI was built with another Timer Library), the frequency
+  is read from CPUID, or measured against the ACPI PM timer, in each module.
+
+  @retval RETURN_SUCCESS      The tick counter address was cached.
+  @retval RETURN_UNSUPPORTED  The host bridge is unknown.
+
+**/
+RETURN_STATUS
+EFIAPI
+TscTimerLibConstructor (
+  VOID
+  )
+{
+  RETURN_STATUS     Status;
+  EFI_HOB_GUID_TYPE *GuidHob;
+
+  Status = AcpiTimerLibConstructor ();
+  if (RETURN_ERROR (Status) || !InternalTscIsInvariant ()) {
+    return Status;
+  }
+
+  GuidHob = GetFirstGuidHob (&gOvmfTscFrequencyHobGuid);
+  if (GuidHob != NULL) {
+    mTscTimerFrequency = *(UINT64 *)GET_GUID_HOB_DATA (GuidHob);
+    return RETURN_SUCCESS;
+  }
+
+  mTscTimerFrequency = InternalTscGetCpuidFrequency ();
+  if (mTscTimerFrequency == 0) {
+    mTscTimerFrequency = InternalTscCalibrate ();
+  }
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,60 @@
+/** @file
+  Provide the constructor for the PEI instance of TSC Timer Library
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <PiPei.h>
+#include <Guid/TscFrequencyHob.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+
+#include "AcpiTimerLib.h"
+#include "TscTimerLib.h"
+
+/**
+  The constructor function enables ACPI IO space, like the "Base" instance,
+  and determines the TSC frequency if the TSC is invariant.
+
+  The first PEIM to run it reads the frequency from CPUID, or calibrates the
+  TSC against the ACPI PM timer, and records the result in the TSC frequency
+  HOB; every later PEIM, and the DXE instance, take it from there.
+
+  @retval RETURN_SUCCESS      The tick counter address was cached.
+  @retval RETURN_UNSUPPORTED  The host bridge is unknown.
+
+**/
+RETURN_STATUS
+EFIAPI
+TscTimerLibConstructor (
+  VOID
+  )
+{
+  RETURN_STATUS     Status;
+  EFI_HOB_GUID_TYPE *GuidHob;
+  UINT64            Frequency;
+
+  Status = AcpiTimerLibConstructor ();
+  if (RETURN_ERROR (Status) || !InternalTscIsInvariant ()) {
+    return Status;
+  }
+
+  GuidHob = GetFirstGuidHob (&gOvmfTscFrequencyHobGuid);
+  if (GuidHob != NULL) {
+    mTscTimerFrequency = *(UINT64 *)GET_GUID_HOB_DATA (GuidHob);
+    return RETURN_SUCCESS;
+  }
+
+  Frequency = InternalTscGetCpuidFrequency ();
+  if (Frequency == 0) {
+    Frequency = InternalTscCalibrate ();
+  }
+  DEBUG ((DEBUG_INFO, "%a: invariant TSC at %Lu Hz\n", __FUNCTION__,
+    Frequency));
+
+  BuildGuidDataHob (&gOvmfTscFrequencyHobGuid, &Frequency, sizeof Frequency);
+  mTscTimerFrequency = Frequency;
+  return RETURN_SUCCESS;
+}
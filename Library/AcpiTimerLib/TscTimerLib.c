@@ -0,0 +1,349 @@
+/** @file
+  TSC implements one instance of Timer Library.
+
+  Reading the ACPI PM timer is an I/O port access, and so a VM exit; every
+  iteration of a MicroSecondDelay() loop on it traps to the hypervisor. When
+  the TSC is invariant, this instance counts TSC ticks instead, which RDTSC
+  reads without an exit. Otherwise it behaves like the ACPI instances.
+
+  Copyright (c) 2008 - 2012, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <IndustryStandard/Acpi.h>
+
+#include "AcpiTimerLib.h"
+#include "TscTimerLib.h"
+
+//
+// The ACPI Time is a 24-bit counter
+//
+#define ACPI_TIMER_COUNT_SIZE  BIT24
+
+//
+// The number of ACPI timer ticks InternalTscCalibrate() measures (10ms).
+//
+#define TSC_CALIBRATION_TICKS  (ACPI_TIMER_FREQUENCY / 100)
+
+UINT64  mTscTimerFrequency;
+
+/**
+  Check whether the TSC runs at a constant rate, in all ACPI P-, C- and
+  T-states (CPUID 0x80000007, EDX bit 8).
+
+  @retval TRUE   The TSC is invariant.
+  @retval FALSE  Otherwise.
+
+**/
+BOOLEAN
+InternalTscIsInvariant (
+  VOID
+  )
+{
+  UINT32  MaxExtendedLeaf;
+  UINT32  Edx;
+
+  AsmCpuid (0x80000000, &MaxExtendedLeaf, NULL, NULL, NULL);
+  if (MaxExtendedLeaf < 0x80000007) {
+    return FALSE;
+  }
+  AsmCpuid (0x80000007, NULL, NULL, NULL, &Edx);
+  return (BOOLEAN)((Edx & BIT8) != 0);
+}
+
+/**
+  Read the TSC frequency from CPUID: from the TSC / core crystal clock ratio
+  (leaf 0x15), or from the hypervisor timing leaf (0x40000010).
+
+  @return  The TSC frequency in Hz, or zero if CPUID does not report it.
+
+**/
+UINT64
+InternalTscGetCpuidFrequency (
+  VOID
+  )
+{
+  UINT32  MaxLeaf;
+  UINT32  Denominator;
+  UINT32  Numerator;
+  UINT32  CrystalHz;
+  UINT32  Ecx;
+  UINT32  MaxHypervisorLeaf;
+  UINT32  TscKHz;
+
+  AsmCpuid (0, &MaxLeaf, NULL, NULL, NULL);
+  if (MaxLeaf >= 0x15) {
+    AsmCpuid (0x15, &Denominator, &Numerator, &CrystalHz, NULL);
+    if (Denominator != 0 && Numerator != 0 && CrystalHz != 0) {
+      return DivU64x32 (MultU64x32 (CrystalHz, Numerator), Denominator);
+    }
+  }
+
+  //
+  // CPUID.1:ECX bit 31 is set when running under a hypervisor.
+  //
+  AsmCpuid (1, NULL, NULL, &Ecx, NULL);
+  if ((Ecx & BIT31) != 0) {
+    AsmCpuid (0x40000000, &MaxHypervisorLeaf, NULL, NULL, NULL);
+    if (MaxHypervisorLeaf >= 0x40000010) {
+      AsmCpuid (0x40000010, &TscKHz, NULL, NULL, NULL);
+      if (TscKHz != 0) {
+        return MultU64x32 (TscKHz, 1000);
+      }
+    }
+  }
+
+  return 0;
+}
+
+/**
+  Measure the TSC frequency against the ACPI PM timer.
+
+  @return  The TSC frequency in Hz.
+
+**/
+UINT64
+InternalTscCalibrate (
+  VOID
+  )
+{
+  UINT32  Start;
+  UINT32  Target;
+  UINT32  End;
+  UINT64  TscStart;
+  UINT64  TscEnd;
+
+  //
+  // Start on an ACPI timer tick edge, so that the measurement is off by at
+  // most one tick at the end.
+  //
+  Start = InternalAcpiGetTimerTick ();
+  while (InternalAcpiGetTimerTick () == Start) {
+    CpuPause ();
+  }
+  TscStart = AsmReadTsc ();
+  Start    = InternalAcpiGetTimerTick ();
+
+  Target = Start + TSC_CALIBRATION_TICKS;
+  while (((Target - InternalAcpiGetTimerTick ()) & BIT23) == 0) {
+    CpuPause ();
+  }
+  End    = InternalAcpiGetTimerTick ();
+  TscEnd = AsmReadTsc ();
+
+  return DivU64x32 (
+           MultU64x32 (TscEnd - TscStart, ACPI_TIMER_FREQUENCY),
+           (End - Start) & (ACPI_TIMER_COUNT_SIZE - 1)
+           );
+}
+
+/**
+  Stalls the CPU for at least the given number of TSC ticks.
+
+  @param  Ticks     A period of time to delay in TSC ticks.
+
+**/
+STATIC
+VOID
+InternalTscDelay (
+  IN      UINT64                    Ticks
+  )
+{
+  UINT64                            Start;
+
+  Start = AsmReadTsc ();
+  while (AsmReadTsc () - Start < Ticks) {
+    CpuPause ();
+  }
+}
+
+/**
+  Stalls the CPU for at least the given number of microseconds.
+
+  Stalls the CPU for the number of microseconds specified by MicroSeconds.
+
+  @param  MicroSeconds  The minimum number of microseconds to delay.
+
+  @return MicroSeconds
+
+**/
+UINTN
+EFIAPI
+MicroSecondDelay (
+  IN      UINTN                     MicroSeconds
+  )
+{
+  if (mTscTimerFrequency != 0) {
+    InternalTscDelay (
+      DivU64x32 (
+        MultU64x64 (MicroSeconds, mTscTimerFrequency) + 999999u,
+        1000000u
+        )
+      );
+    return MicroSeconds;
+  }
+
+  InternalAcpiDelay (
+    (UINT32)DivU64x32 (
+              MultU64x32 (
+                MicroSeconds,
+                ACPI_TIMER_FREQUENCY
+                ),
+              1000000u
+              )
+    );
+  return MicroSeconds;
+}
+
+/**
+  Stalls the CPU for at least the given number of nanoseconds.
+
+  Stalls the CPU for the number of nanoseconds specified by NanoSeconds.
+
+  @param  NanoSeconds The minimum number of nanoseconds to delay.
+
+  @return NanoSeconds
+
+**/
+UINTN
+EFIAPI
+NanoSecondDelay (
+  IN      UINTN                     NanoSeconds
+  )
+{
+  if (mTscTimerFrequency != 0) {
+    InternalTscDelay (
+      DivU64x32 (
+        MultU64x64 (NanoSeconds, mTscTimerFrequency) + 999999999u,
+        1000000000u
+        )
+      );
+    return NanoSeconds;
+  }
+
+  InternalAcpiDelay (
+    (UINT32)DivU64x32 (
+              MultU64x32 (
+                NanoSeconds,
+                ACPI_TIMER_FREQUENCY
+                ),
+              1000000000u
+              )
+    );
+  return NanoSeconds;
+}
+
+/**
+  Retrieves the current value of a 64-bit free running performance counter.
+
+  Retrieves the current value of a 64-bit free running performance counter. The
+  counter can either count up by 1 or count down by 1. If the physical
+  performance counter counts by a larger increment, then the counter values
+  must be translated. The properties of the counter can be retrieved from
+  GetPerformanceCounterProperties().
+
+  @return The current value of the free running performance counter.
+
+**/
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  if (mTscTimerFrequency != 0) {
+    return AsmReadTsc ();
+  }
+  return (UINT64)InternalAcpiGetTimerTick ();
+}
+
+/**
+  Retrieves the 64-bit frequency in Hz and the range of performance counter
+  values.
+
+  If StartValue is not NULL, then the value that the performance counter starts
+  with immediately after is it rolls over is returned in StartValue. If
+  EndValue is not NULL, then the value that the performance counter end with
+  immediately before it rolls over is returned in EndValue. The 64-bit
+  frequency of the performance counter in Hz is always returned. If StartValue
+  is less than EndValue, then the performance counter counts up. If StartValue
+  is greater than EndValue, then the performance counter counts down. For
+  example, a 64-bit free running counter that counts up would have a StartValue
+  of 0 and an EndValue of 0xFFFFFFFFFFFFFFFF. A 24-bit free running counter
+  that counts down would have a StartValue of 0xFFFFFF and an EndValue of 0.
+
+  @param  StartValue  The value the performance counter starts with when it
+                      rolls over.
+  @param  EndValue    The value that the performance counter ends with before
+                      it rolls over.
+
+  @return The frequency in Hz.
+
+**/
+UINT64
+EFIAPI
+GetPerformanceCounterProperties (
+  OUT      UINT64                    *StartValue,  OPTIONAL
+  OUT      UINT64                    *EndValue     OPTIONAL
+  )
+{
+  if (StartValue != NULL) {
+    *StartValue = 0;
+  }
+
+  if (mTscTimerFrequency != 0) {
+    if (EndValue != NULL) {
+      *EndValue = MAX_UINT64;
+    }
+    return mTscTimerFrequency;
+  }
+
+  if (EndValue != NULL) {
+    *EndValue = ACPI_TIMER_COUNT_SIZE - 1;
+  }
+
+  return ACPI_TIMER_FREQUENCY;
+}
+
+/**
+  Converts elapsed ticks of performance counter to time in nanoseconds.
+
+  This function converts the elapsed ticks of running performance counter to
+  time value in unit of nanoseconds.
+
+  @param  Ticks     The number of elapsed ticks of running performance counter.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  IN      UINT64                     Ticks
+  )
+{
+  UINT64  Frequency;
+  UINT64  NanoSeconds;
+  UINT64  Remainder;
+
+  Frequency = GetPerformanceCounterProperties (NULL, NULL);
+
+  //
+  //          Ticks
+  // Time = --------- x 1,000,000,000
+  //        Frequency
+  //
+  NanoSeconds = MultU64x32 (DivU64x64Remainder (Ticks, Frequency, &Remainder), 1000000000u);
+
+  //
+  // Frequency < 0x400000000 (17GHz), so (Remainder * 1,000,000,000) will not
+  // overflow 64-bit.
+  //
+  NanoSeconds += DivU64x64Remainder (MultU64x32 (Remainder, 1000000000u), Frequency, NULL);
+
+  return NanoSeconds;
+}
@@ -0,0 +1,54 @@
+/** @file
+  Internal definitions for the TSC instances of the Timer Library
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef _TSC_TIMER_LIB_INTERNAL_H_
+#define _TSC_TIMER_LIB_INTERNAL_H_
+
+//
+// TSC ticks per second, set by the constructor of the instance. Zero if the
+// TSC is not invariant; the library then counts ACPI PM timer ticks instead.
+//
+extern UINT64  mTscTimerFrequency;
+
+/**
+  Check whether the TSC runs at a constant rate, in all ACPI P-, C- and
+  T-states (CPUID 0x80000007, EDX bit 8).
+
+  @retval TRUE   The TSC is invariant.
+  @retval FALSE  Otherwise.
+
+**/
+BOOLEAN
+InternalTscIsInvariant (
+  VOID
+  );
+
+/**
+  Read the TSC frequency from CPUID: from the TSC / core crystal clock ratio
+  (leaf 0x15), or from the hypervisor timing leaf (0x40000010).
+
+  @return  The TSC frequency in Hz, or zero if CPUID does not report it.
+
+**/
+UINT64
+InternalTscGetCpuidFrequency (
+  VOID
+  );
+
+/**
+  Measure the TSC frequency against the ACPI PM timer.
+
+  @return  The TSC frequency in Hz.
+
+**/
+UINT64
+InternalTscCalibrate (
+  VOID
+  );
+
+#endif // _TSC_TIMER_LIB_INTERNAL_H_
@@ -17,66 +17,7 @@
 #include "Datahub.h"
 #include "Boot.h"
 #include "SmBios.h"
-
-/**
-  Register Handler for the specified interrupt source.
-
-  @param This     Instance pointer for this protocol
-  @param Source   Hardware source of the interrupt
-  @param Handler  Callback for interrupt. NULL to unregister
-
-  @retval  EFI_SUCCESS            The firmware has successfully stored the variable and its data as
-  defined by the Attributes.
-  @retval  EFI_INVALID_PARAMETER  An invalid combination of attribute bits was supplied, or the
-  DataSize exceeds the maximum allowed.
-  @retval  EFI_INVALID_PARAMETER  VariableName is an empty Unicode string.
-  @retval  EFI_OUT_OF_RESOURCES   Not enough storage is available to hold the variable and its data.
-  @retval  EFI_DEVICE_ERROR       The variable could not be saved due to a hardware failure.
-  @retval  EFI_WRITE_PROTECTED    The variable in question is read-only.
-  @retval  EFI_WRITE_PROTECTED    The variable in question cannot be deleted.
-  @retval  EFI_SECURITY_VIOLATION The variable could not be written due to EFI_VARIABLE_AUTHENTICATED_WRITE_ACCESS
-  set but the AuthInfo does NOT pass the validation check carried
-  out by the firmware.
-
-**/
-EFI_STATUS
-InitializeFirmware ()
-{
-  EFI_STATUS          Status;
-
-  UINT32              BackgroundClear = 0x00000000;
-  UINT32              FwFeatures      = 0x80000015;
-  UINT32              FwFeaturesMask  = 0x800003ff;
-  CHAR8               BootArgs[]      = "-v debug=0x14e keepsyms=1";
-
-  Status = gRT->SetVariable(L"BackgroundClear",
-                            &gAppleFirmwareVariableGuid,
-                            EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                            sizeof(BackgroundClear), &BackgroundClear);
-  ASSERT_EFI_ERROR (Status);
-
-  Status = gRT->SetVariable(L"FirmwareFeatures",
-                            &gAppleFirmwareVariableGuid,
-                            EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                            sizeof(FwFeatures), &FwFeatures);
-  ASSERT_EFI_ERROR (Status);
-
-  Status = gRT->SetVariable(L"FirmwareFeaturesMask",
-                            &gAppleFirmwareVariableGuid,
-                            EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                            sizeof(FwFeaturesMask), &FwFeaturesMask);
-  ASSERT_EFI_ERROR (Status);
-
-  DEBUG_CODE_BEGIN ();
-  Status = gRT->SetVariable(L"boot-args",
-                            &gAppleNVRAMVariableGuid,
-                            EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                            sizeof(BootArgs), &BootArgs);
-  ASSERT_EFI_ERROR (Status);
-  DEBUG_CODE_END ();
-
-  return EFI_SUCCESS;
-}
+#include "Nvram.h"
 
 /**
   Register driver.
@@ -102,7 +43,7 @@ InitializeAppleSupport (
   Status = InitializeDatahub(ImageHandle);
   ASSERT_EFI_ERROR(Status);
 
-  Status = InitializeFirmware();
+  Status = InitializeNvram ();
   ASSERT_EFI_ERROR(Status);
 
   Status = InitializeAppleBoot(ImageHandle);
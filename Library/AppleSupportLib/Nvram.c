@@ -0,0 +1,230 @@
+/** @file
+*
+*  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+*
+*  This program and the accompanying materials
+*  are licensed and made available under the terms and conditions of the BSD License
+*  which accompanies this distribution.  The full text of the license may be found at
+*  http://opensource.org/licenses/bsd-license.php
+*
+*  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+*
+**/
+
+#include "Nvram.h"
+
+#include <Library/PrintLib.h>
+
+STATIC CONST APPLE_NVRAM_DEFAULT mAppleNvramDefaults[] = {
+  { L"BackgroundClear",      &gAppleFirmwareVariableGuid, APPLE_NVRAM_ATTRIBUTES_NV,
+    AppleNvramUint32,      0x00000000, NULL,                        FALSE },
+  { L"FirmwareFeatures",     &gAppleFirmwareVariableGuid, APPLE_NVRAM_ATTRIBUTES_NV,
+    AppleNvramUint32,      0x80000015, NULL,                        FALSE },
+  { L"FirmwareFeaturesMask", &gAppleFirmwareVariableGuid, APPLE_NVRAM_ATTRIBUTES_NV,
+    AppleNvramUint32,      0x800003ff, NULL,                        FALSE },
+  { L"boot-args",            &gAppleNVRAMVariableGuid,    APPLE_NVRAM_ATTRIBUTES_VOLATILE,
+    AppleNvramAsciiString, 0,          "-v debug=0x14e keepsyms=1", TRUE  },
+};
+
+//
+// A variable whose current value differs from the wanted one
+//
+typedef struct {
+  CONST APPLE_NVRAM_DEFAULT *Default;
+  UINTN                     DataSize;
+  UINT8                     Data[APPLE_NVRAM_MAX_VALUE_SIZE];
+  //
+  // The variable exists with other attributes, and must be deleted first.
+  //
+  BOOLEAN                   Delete;
+  //
+  // The value is a debug-only default; a variable that exists already, set
+  // by the user, is left alone.
+  //
+  BOOLEAN                   OnlyIfAbsent;
+} APPLE_NVRAM_UPDATE;
+
+/**
+ * Reads a string override from the fw_cfg file FileName, without trailing
+ * newlines, and NUL-terminates it
+ * @param FileName The fw_cfg file name
+ * @param Buffer   Receives the string
+ * @param Size     On output, the size of the string, including the NUL
+ * @return TRUE if the file exists and fits in APPLE_NVRAM_MAX_VALUE_SIZE
+ */
+STATIC
+BOOLEAN
+ReadFwCfgString (
+  IN  CONST CHAR8 *FileName,
+  OUT CHAR8       *Buffer,
+  OUT UINTN       *Size
+  )
+{
+  FIRMWARE_CONFIG_ITEM Item;
+  UINTN                FileSize;
+
+  if (RETURN_ERROR (QemuFwCfgFindFile (FileName, &Item, &FileSize))) {
+    return FALSE;
+  }
+  if (FileSize >= APPLE_NVRAM_MAX_VALUE_SIZE) {
+    DEBUG ((DEBUG_WARN, "%a: \"%a\" is too large, ignored\n", __FUNCTION__,
+      FileName));
+    return FALSE;
+  }
+
+  QemuFwCfgSelectItem (Item);
+  QemuFwCfgReadBytes (FileSize, Buffer);
+  while (FileSize > 0 &&
+         (Buffer[FileSize - 1] == '\n' || Buffer[FileSize - 1] == '\r')) {
+    FileSize--;
+  }
+  Buffer[FileSize] = '\0';
+  *Size = FileSize + 1;
+  return TRUE;
+}
+
+/**
+ * Determines the value a variable should have: its default, or the fw_cfg
+ * override
+ * @param Default The defaults table entry of the variable
+ * @param Update  Receives the value in Data and DataSize
+ * @return FALSE if the variable has no value to set
+ */
+STATIC
+BOOLEAN
+ResolveNvramValue (
+  IN     CONST APPLE_NVRAM_DEFAULT *Default,
+  IN OUT APPLE_NVRAM_UPDATE        *Update
+  )
+{
+  CHAR8  FileName[QEMU_FW_CFG_FNAME_SIZE];
+  UINT32 Value;
+
+  AsciiSPrint (FileName, sizeof FileName, "%a%s", APPLE_NVRAM_FW_CFG_PREFIX,
+    Default->Name);
+
+  if (Default->Type == AppleNvramUint32) {
+    Value = Default->Uint32Value;
+    QemuFwCfgParseUint32 (FileName, TRUE, &Value);
+    CopyMem (Update->Data, &Value, sizeof Value);
+    Update->DataSize = sizeof Value;
+    return TRUE;
+  }
+
+  if (ReadFwCfgString (FileName, (CHAR8 *)Update->Data, &Update->DataSize)) {
+    return TRUE;
+  }
+  if (Default->StringValue == NULL ||
+      (Default->DebugOnly && !DebugCodeEnabled ())) {
+    return FALSE;
+  }
+  Update->DataSize = AsciiStrSize (Default->StringValue);
+  ASSERT (Update->DataSize <= APPLE_NVRAM_MAX_VALUE_SIZE);
+  CopyMem (Update->Data, Default->StringValue, Update->DataSize);
+  Update->OnlyIfAbsent = Default->DebugOnly;
+  return TRUE;
+}
+
+/**
+ * Checks whether a variable already has the wanted value and attributes, or,
+ * for a debug-only default, whether it exists at all
+ * @param Update The variable and its wanted value; Delete is set if the
+ *               variable exists with other attributes
+ * @return TRUE if the variable must be written
+ */
+STATIC
+BOOLEAN
+NvramValueDiffers (
+  IN OUT APPLE_NVRAM_UPDATE *Update
+  )
+{
+  EFI_STATUS Status;
+  UINT32     Attributes;
+  UINTN      Size;
+  UINT8      Current[APPLE_NVRAM_MAX_VALUE_SIZE];
+
+  Size = sizeof Current;
+  Status = gRT->GetVariable ((CHAR16 *)Update->Default->Name,
+                  Update->Default->Guid, &Attributes, &Size, Current);
+  if (Status == EFI_NOT_FOUND) {
+    return TRUE;
+  }
+  if (Update->OnlyIfAbsent) {
+    return FALSE;
+  }
+  if (EFI_ERROR (Status)) {
+    //
+    // Too large, or unreadable: overwrite it, deleting it first in case its
+    // attributes differ.
+    //
+    Update->Delete = TRUE;
+    return TRUE;
+  }
+
+  if (Attributes != Update->Default->Attributes) {
+    Update->Delete = TRUE;
+    return TRUE;
+  }
+  return (BOOLEAN)(Size != Update->DataSize ||
+                   CompareMem (Current, Update->Data, Size) != 0);
+}
+
+/**
+ * Sets the Apple firmware variables from the defaults table, and fw_cfg
+ * overrides, writing only the ones whose current values differ
+ *
+ * All variables are compared before any is written, so the writes, each of
+ * which appends a record to the flash-backed variable store, happen back to
+ * back, and not at all on a boot that changes nothing.
+ *
+ * @return EFI_SUCCESS on success, otherwise the first SetVariable error code
+ */
+EFI_STATUS
+InitializeNvram (
+  VOID
+  )
+{
+  APPLE_NVRAM_UPDATE *Updates;
+  UINTN              Count;
+  UINTN              Index;
+  EFI_STATUS         Status;
+  EFI_STATUS         FirstError;
+
+  Updates = AllocateZeroPool (sizeof *Updates * ARRAY_SIZE (mAppleNvramDefaults));
+  if (Updates == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Count = 0;
+  for (Index = 0; Index < ARRAY_SIZE (mAppleNvramDefaults); Index++) {
+    Updates[Count].Default = &mAppleNvramDefaults[Index];
+    if (ResolveNvramValue (&mAppleNvramDefaults[Index], &Updates[Count]) &&
+        NvramValueDiffers (&Updates[Count])) {
+      Count++;
+    } else {
+      ZeroMem (&Updates[Count], sizeof Updates[Count]);
+    }
+  }
+
+  FirstError = EFI_SUCCESS;
+  for (Index = 0; Index < Count; Index++) {
+    DEBUG ((DEBUG_INFO, "%a: setting %s\n", __FUNCTION__,
+      Updates[Index].Default->Name));
+
+    if (Updates[Index].Delete) {
+      gRT->SetVariable ((CHAR16 *)Updates[Index].Default->Name,
+             Updates[Index].Default->Guid, 0, 0, NULL);
+    }
+    Status = gRT->SetVariable ((CHAR16 *)Updates[Index].Default->Name,
+                    Updates[Index].Default->Guid,
+                    Updates[Index].Default->Attributes,
+                    Updates[Index].DataSize, Updates[Index].Data);
+    if (EFI_ERROR (Status) && !EFI_ERROR (FirstError)) {
+      FirstError = Status;
+    }
+  }
+
+  FreePool (Updates);
+  return FirstError;
+}
@@ -0,0 +1,79 @@
+/** @file
+*
+*  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+*
+*  This program and the accompanying materials
+*  are licensed and made available under the terms and conditions of the BSD License
+*  which accompanies this distribution.  The full text of the license may be found at
+*  http://opensource.org/licenses/bsd-license.php
+*
+*  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+*
+**/
+
+#ifndef _APPLESUPPORT_NVRAM_H_INCLUDED_
+#define _APPLESUPPORT_NVRAM_H_INCLUDED_
+
+#include "Common.h"
+
+#include <Guid/Darwin/AppleVariable.h>
+
+#include <Library/QemuFwCfgLib.h>
+#include <Library/QemuFwCfgSimpleParserLib.h>
+
+//
+// Variables are set only if their values differ from these; variables that
+// are already set the same way are not written again.
+//
+// A default can be overridden without rebuilding the firmware, with the
+// fw_cfg file "opt/com.apple/<VariableName>" (for example
+// -fw_cfg name=opt/com.apple/FirmwareFeatures,string=0xe00fe137). UINT32
+// values are given in hex; strings are taken as they are.
+//
+#define APPLE_NVRAM_FW_CFG_PREFIX "opt/com.apple/"
+
+#define APPLE_NVRAM_ATTRIBUTES_NV (EFI_VARIABLE_NON_VOLATILE |       \
+                                   EFI_VARIABLE_BOOTSERVICE_ACCESS | \
+                                   EFI_VARIABLE_RUNTIME_ACCESS)
+#define APPLE_NVRAM_ATTRIBUTES_VOLATILE (EFI_VARIABLE_BOOTSERVICE_ACCESS | \
+                                         EFI_VARIABLE_RUNTIME_ACCESS)
+
+//
+// The largest default, or fw_cfg override, that is accepted.
+//
+#define APPLE_NVRAM_MAX_VALUE_SIZE 1024
+
+typedef enum {
+  AppleNvramUint32,
+  AppleNvramAsciiString
+} APPLE_NVRAM_VALUE_TYPE;
+
+typedef struct {
+  CONST CHAR16            *Name;
+  EFI_GUID                *Guid;
+  UINT32                  Attributes;
+  APPLE_NVRAM_VALUE_TYPE  Type;
+  UINT32                  Uint32Value;
+  //
+  // The default of an AppleNvramAsciiString variable. Without a default, the
+  // variable is set only when fw_cfg provides a value.
+  //
+  CONST CHAR8             *StringValue;
+  //
+  // The default applies to DEBUG builds only.
+  //
+  BOOLEAN                 DebugOnly;
+} APPLE_NVRAM_DEFAULT;
+
+/**
+ * Sets the Apple firmware variables from the defaults table, and fw_cfg
+ * overrides, writing only the ones whose current values differ
+ * @return EFI_SUCCESS on success, otherwise the first SetVariable error code
+ */
+EFI_STATUS
+InitializeNvram (
+  VOID
+  );
+
+#endif //_APPLESUPPORT_NVRAM_H_INCLUDED_
@@ -0,0 +1,127 @@
+/** @file
+  Probe recording common to the BootTimelineLib instances.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BootTimelineLib.h>
+#include <Library/PcdLib.h>
+#include <Library/SynchronizationLib.h>
+
+#include "BootTimelineLibInternal.h"
+
+VOID
+InternalBootTimelineAppend (
+  IN OUT BOOT_TIMELINE_TABLE *Table,
+  IN     UINT32              Type,
+  IN     CONST CHAR8         *Name,
+  IN     UINT64              Tsc
+  )
+{
+  UINT32               Index;
+  BOOT_TIMELINE_RECORD *Record;
+
+  //
+  // Claim the slot first, so that a probe taken from an interrupting
+  // callback does not overwrite this one.
+  //
+  Index  = InterlockedIncrement (&Table->Count) - 1;
+  Record = (BOOT_TIMELINE_RECORD *)(Table + 1) + Index % Table->Capacity;
+
+  Record->Tsc      = Tsc;
+  Record->Type     = Type;
+  Record->Reserved = 0;
+  AsciiStrnCpyS (Record->Name, sizeof Record->Name, Name,
+    sizeof Record->Name - 1);
+}
+
+VOID
+InternalBootTimelineImport (
+  IN OUT BOOT_TIMELINE_TABLE       *Table,
+  IN     CONST BOOT_TIMELINE_TABLE *Source
+  )
+{
+  CONST BOOT_TIMELINE_RECORD *Records;
+  CONST BOOT_TIMELINE_RECORD *Record;
+  UINT32                     Index;
+
+  if (Source->Signature != BOOT_TIMELINE_SIGNATURE ||
+      Source->Capacity == 0) {
+    return;
+  }
+
+  Records = (CONST BOOT_TIMELINE_RECORD *)(Source + 1);
+  Index = 0;
+  if (Source->Count > Source->Capacity) {
+    Index = Source->Count - Source->Capacity;
+  }
+  for (; Index < Source->Count; Index++) {
+    Record = &Records[Index % Source->Capacity];
+    InternalBootTimelineAppend (Table, Record->Type, Record->Name,
+      Record->Tsc);
+  }
+}
+
+/**
+  Record a probe in the timeline of the current phase.
+
+  @param[in] Type  BOOT_TIMELINE_BEGIN or BOOT_TIMELINE_END.
+  @param[in] Name  The name of the probe.
+**/
+STATIC
+VOID
+BootTimelineRecord (
+  IN UINT32      Type,
+  IN CONST CHAR8 *Name
+  )
+{
+  UINT64              Tsc;
+  BOOT_TIMELINE_TABLE *Table;
+
+  if (!FeaturePcdGet (PcdBootTimelineEnable)) {
+    return;
+  }
+
+  //
+  // Take the timestamp before the timeline is looked up, as the first lookup
+  // in a phase creates it.
+  //
+  Tsc   = AsmReadTsc ();
+  Table = InternalBootTimelineGetTable ();
+  if (Table != NULL) {
+    InternalBootTimelineAppend (Table, Type, Name, Tsc);
+  }
+}
+
+/**
+  Record the beginning of a named interval.
+
+  @param[in] Name  The name of the interval. Only the first
+                   BOOT_TIMELINE_NAME_SIZE - 1 characters are kept.
+**/
+VOID
+EFIAPI
+BootTimelineBegin (
+  IN CONST CHAR8 *Name
+  )
+{
+  BootTimelineRecord (BOOT_TIMELINE_BEGIN, Name);
+}
+
+/**
+  Record the end of a named interval.
+
+  @param[in] Name  The name passed to BootTimelineBegin().
+**/
+VOID
+EFIAPI
+BootTimelineEnd (
+  IN CONST CHAR8 *Name
+  )
+{
+  BootTimelineRecord (BOOT_TIMELINE_END, Name);
+}
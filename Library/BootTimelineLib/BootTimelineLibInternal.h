@@ -0,0 +1,54 @@
+/** @file
+  Internal interfaces shared by the BootTimelineLib instances.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __BOOT_TIMELINE_LIB_INTERNAL_H__
+#define __BOOT_TIMELINE_LIB_INTERNAL_H__
+
+#include <Guid/BootTimeline.h>
+
+/**
+  Return the timeline of the current phase, creating it on first use, with
+  the records of the previous phase.
+
+  @return  The timeline, or NULL if it cannot be created.
+**/
+BOOT_TIMELINE_TABLE *
+InternalBootTimelineGetTable (
+  VOID
+  );
+
+/**
+  Append a record to a timeline.
+
+  @param[in,out] Table  The timeline.
+  @param[in]     Type   BOOT_TIMELINE_BEGIN or BOOT_TIMELINE_END.
+  @param[in]     Name   The name of the probe.
+  @param[in]     Tsc    The timestamp of the probe.
+**/
+VOID
+InternalBootTimelineAppend (
+  IN OUT BOOT_TIMELINE_TABLE *Table,
+  IN     UINT32              Type,
+  IN     CONST CHAR8         *Name,
+  IN     UINT64              Tsc
+  );
+
+/**
+  Append the records of a timeline to another one, oldest first.
+
+  @param[in,out] Table   The timeline to append to.
+  @param[in]     Source  The timeline of the previous phase.
+**/
+VOID
+InternalBootTimelineImport (
+  IN OUT BOOT_TIMELINE_TABLE       *Table,
+  IN     CONST BOOT_TIMELINE_TABLE *Source
+  );
+
+#endif
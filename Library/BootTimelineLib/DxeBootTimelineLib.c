@@ -0,0 +1,277 @@
+/** @file
+  DXE instance of BootTimelineLib.
+
+  The first probe taken in DXE allocates the timeline in reserved memory,
+  imports the records of the PEI GUID HOB, and installs it as a configuration
+  table; every other module finds it there.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <Guid/ExtendedFirmwarePerformance.h>
+#include <Guid/TscFrequencyHob.h>
+#include <IndustryStandard/Acpi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BootTimelineLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include "BootTimelineLibInternal.h"
+
+//
+// How long the TSC is measured against the performance counter of TimerLib,
+// in microseconds.
+//
+#define BOOT_TIMELINE_CALIBRATION_US  1000
+
+STATIC BOOT_TIMELINE_TABLE *mTable;
+
+BOOT_TIMELINE_TABLE *
+InternalBootTimelineGetTable (
+  VOID
+  )
+{
+  EFI_STATUS          Status;
+  BOOT_TIMELINE_TABLE *Table;
+  EFI_HOB_GUID_TYPE   *GuidHob;
+  UINT32              Capacity;
+
+  if (mTable != NULL) {
+    return mTable;
+  }
+
+  Status = EfiGetSystemConfigurationTable (
+             &gOvmfBootTimelineGuid,
+             (VOID **)&Table
+             );
+  if (!EFI_ERROR (Status)) {
+    mTable = Table;
+    return mTable;
+  }
+
+  //
+  // Reserved memory, so that the timeline can still be read after
+  // ExitBootServices().
+  //
+  Capacity = FixedPcdGet32 (PcdBootTimelineRecords);
+  Table = AllocateReservedZeroPool (
+            sizeof *Table + Capacity * sizeof (BOOT_TIMELINE_RECORD)
+            );
+  if (Table == NULL) {
+    return NULL;
+  }
+  Table->Signature = BOOT_TIMELINE_SIGNATURE;
+  Table->Revision  = BOOT_TIMELINE_REVISION;
+  Table->Capacity  = Capacity;
+
+  GuidHob = GetFirstGuidHob (&gOvmfBootTimelineGuid);
+  if (GuidHob != NULL) {
+    InternalBootTimelineImport (Table, GET_GUID_HOB_DATA (GuidHob));
+  }
+
+  Status = gBS->InstallConfigurationTable (&gOvmfBootTimelineGuid, Table);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: InstallConfigurationTable: %r\n", __FUNCTION__,
+      Status));
+    FreePool (Table);
+    return NULL;
+  }
+
+  mTable = Table;
+  return mTable;
+}
+
+/**
+  Determine the frequency of the TSC.
+
+  The PEI instance of the TSC Timer Library leaves it in a HOB when the TSC is
+  invariant; the DXE modules linked with that library take it from there as
+  well, and count TSC ticks in their performance counter. Without the HOB, the
+  TSC is measured against the performance counter of TimerLib, which is the
+  ACPI PM timer unless TimerLib found the TSC invariant on its own.
+
+  @return  The number of TSC ticks per second.
+**/
+STATIC
+UINT64
+BootTimelineCalibrateTsc (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE *GuidHob;
+  UINT64            CounterFrequency;
+  UINT64            StartValue;
+  UINT64            EndValue;
+  UINT64            Target;
+  UINT64            Elapsed;
+  UINT64            Previous;
+  UINT64            Current;
+  UINT64            TscStart;
+  UINT64            TscEnd;
+
+  GuidHob = GetFirstGuidHob (&gOvmfTscFrequencyHobGuid);
+  if (GuidHob != NULL) {
+    return *(UINT64 *)GET_GUID_HOB_DATA (GuidHob);
+  }
+
+  CounterFrequency = GetPerformanceCounterProperties (&StartValue, &EndValue);
+  Target = DivU64x32 (
+             MultU64x32 (CounterFrequency, BOOT_TIMELINE_CALIBRATION_US),
+             1000000
+             );
+  Elapsed = 0;
+
+  Previous = GetPerformanceCounter ();
+  TscStart = AsmReadTsc ();
+  while (Elapsed < Target) {
+    Current = GetPerformanceCounter ();
+    //
+    // The counter wraps around at EndValue.
+    //
+    if (StartValue < EndValue) {
+      Elapsed += Current - Previous;
+      if (Current < Previous) {
+        Elapsed += EndValue - StartValue + 1;
+      }
+    } else {
+      Elapsed += Previous - Current;
+      if (Previous < Current) {
+        Elapsed += StartValue - EndValue + 1;
+      }
+    }
+    Previous = Current;
+  }
+  TscEnd = AsmReadTsc ();
+
+  return DivU64x64Remainder (
+           MultU64x64 (TscEnd - TscStart, CounterFrequency),
+           Elapsed,
+           NULL
+           );
+}
+
+/**
+  Convert a TSC value to nanoseconds since reset.
+
+  @param[in] Tsc        The TSC value.
+  @param[in] Frequency  The number of TSC ticks per second.
+
+  @return  The number of nanoseconds.
+**/
+STATIC
+UINT64
+BootTimelineTscToNanoSeconds (
+  IN UINT64 Tsc,
+  IN UINT64 Frequency
+  )
+{
+  UINT64 Seconds;
+  UINT64 Remainder;
+
+  //
+  // Remainder < Frequency, so Remainder * 10^9 does not overflow for TSC
+  // frequencies below 18 GHz.
+  //
+  Seconds = DivU64x64Remainder (Tsc, Frequency, &Remainder);
+  return MultU64x32 (Seconds, 1000000000) +
+         DivU64x64Remainder (MultU64x32 (Remainder, 1000000000), Frequency,
+           NULL);
+}
+
+/**
+  Calibrate the TSC, and convert the timeline to an FPDT boot performance
+  table that the guest OS can read.
+
+  The FPDT table holds one dynamic string event record per probe, with the
+  PERF_INMODULE_START_ID / PERF_INMODULE_END_ID progress IDs, as the
+  PerformanceLib instances of MdeModulePkg produce them.
+**/
+VOID
+EFIAPI
+BootTimelinePublish (
+  VOID
+  )
+{
+  BOOT_TIMELINE_TABLE                        *Table;
+  CONST BOOT_TIMELINE_RECORD                 *Records;
+  CONST BOOT_TIMELINE_RECORD                 *Record;
+  EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fpdt;
+  FPDT_DYNAMIC_STRING_EVENT_RECORD           *Event;
+  UINT8                                      *Cursor;
+  UINT32                                     Count;
+  UINT32                                     Index;
+  UINTN                                      NameSize;
+
+  if (!FeaturePcdGet (PcdBootTimelineEnable)) {
+    return;
+  }
+
+  Table = InternalBootTimelineGetTable ();
+  if (Table == NULL) {
+    return;
+  }
+
+  if (Table->TscFrequency == 0) {
+    Table->TscFrequency = BootTimelineCalibrateTsc ();
+    DEBUG ((DEBUG_INFO, "%a: TSC frequency %Lu Hz\n", __FUNCTION__,
+      Table->TscFrequency));
+    if (Table->TscFrequency == 0) {
+      return;
+    }
+  }
+
+  Records = (CONST BOOT_TIMELINE_RECORD *)(Table + 1);
+  Count   = Table->Count;
+  Index   = 0;
+  if (Count > Table->Capacity) {
+    Index = Count - Table->Capacity;
+  }
+
+  Fpdt = AllocateReservedZeroPool (
+           sizeof *Fpdt +
+           (Count - Index) * (sizeof *Event + BOOT_TIMELINE_NAME_SIZE)
+           );
+  if (Fpdt == NULL) {
+    return;
+  }
+  Fpdt->Signature = EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_SIGNATURE;
+
+  Cursor = (UINT8 *)(Fpdt + 1);
+  for (; Index < Count; Index++) {
+    Record   = &Records[Index % Table->Capacity];
+    NameSize = AsciiStrSize (Record->Name);
+
+    Event = (FPDT_DYNAMIC_STRING_EVENT_RECORD *)Cursor;
+    Event->Header.Type     = FPDT_DYNAMIC_STRING_EVENT_TYPE;
+    Event->Header.Length   = (UINT8)(sizeof *Event + NameSize);
+    Event->Header.Revision = FPDT_RECORD_REVISION_1;
+    Event->ProgressID      = (Record->Type == BOOT_TIMELINE_BEGIN) ?
+                             PERF_INMODULE_START_ID : PERF_INMODULE_END_ID;
+    Event->Timestamp       = BootTimelineTscToNanoSeconds (
+                               Record->Tsc,
+                               Table->TscFrequency
+                               );
+    CopyGuid (&Event->Guid, &gOvmfBootTimelineGuid);
+    CopyMem (Event + 1, Record->Name, NameSize);
+
+    Cursor += Event->Header.Length;
+  }
+  Fpdt->Length = (UINT32)(Cursor - (UINT8 *)Fpdt);
+
+  if (Table->Fpdt != 0) {
+    FreePool ((VOID *)(UINTN)Table->Fpdt);
+  }
+  Table->Fpdt = (UINT64)(UINTN)Fpdt;
+}
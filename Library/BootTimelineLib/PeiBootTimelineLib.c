@@ -0,0 +1,86 @@
+/** @file
+  PEI instance of BootTimelineLib.
+
+  The timeline is kept in a GUID HOB, which the DXE instance imports. It is
+  created by the first probe taken in PEI, with the records handed over by
+  SEC.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/BootTimelineLib.h>
+#include <Library/HobLib.h>
+#include <Library/PeiServicesLib.h>
+
+#include "BootTimelineLibInternal.h"
+
+//
+// PEI modules take few probes; keep the HOB small, as it may be built in
+// temporary RAM.
+//
+#define BOOT_TIMELINE_PEI_RECORDS  32
+
+BOOT_TIMELINE_TABLE *
+InternalBootTimelineGetTable (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE     *GuidHob;
+  BOOT_TIMELINE_TABLE   *Table;
+  BOOT_TIMELINE_SEC_PPI *SecPpi;
+  EFI_STATUS            Status;
+
+  //
+  // PEI modules may run in place from flash; there is no writable global to
+  // cache the table in.
+  //
+  GuidHob = GetFirstGuidHob (&gOvmfBootTimelineGuid);
+  if (GuidHob != NULL) {
+    return GET_GUID_HOB_DATA (GuidHob);
+  }
+
+  Table = BuildGuidHob (
+            &gOvmfBootTimelineGuid,
+            sizeof *Table +
+            BOOT_TIMELINE_PEI_RECORDS * sizeof (BOOT_TIMELINE_RECORD)
+            );
+  if (Table == NULL) {
+    return NULL;
+  }
+  ZeroMem (Table, sizeof *Table);
+  Table->Signature = BOOT_TIMELINE_SIGNATURE;
+  Table->Revision  = BOOT_TIMELINE_REVISION;
+  Table->Capacity  = BOOT_TIMELINE_PEI_RECORDS;
+
+  Status = PeiServicesLocatePpi (
+             &gOvmfBootTimelineSecPpiGuid,
+             0,
+             NULL,
+             (VOID **)&SecPpi
+             );
+  if (!EFI_ERROR (Status)) {
+    InternalBootTimelineImport (Table, &SecPpi->Header);
+  }
+
+  return Table;
+}
+
+/**
+  Calibrate the TSC, and convert the timeline to an FPDT boot performance
+  table that the guest OS can read.
+
+  Nothing to do in PEI; the DXE instance publishes the timeline.
+**/
+VOID
+EFIAPI
+BootTimelinePublish (
+  VOID
+  )
+{
+}
@@ -0,0 +1,165 @@
+/** @file
+  LZ4 block decoder.
+
+  Every read from Source and every write to Destination is bounds-checked, so
+  a malformed block cannot make the decoder access memory outside of the two
+  buffers.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseMemoryLib.h>
+
+#include "Lz4ChunkedDecompressLibInternal.h"
+
+//
+// Every match is at least this long; the match length nibble in the token
+// is biased by it.
+//
+#define LZ4_MIN_MATCH  4
+
+//
+// A length nibble of this value is continued in the following bytes.
+//
+#define LZ4_RUN_MASK   0xF
+
+/**
+  Decode an extended literal or match length.
+
+  @param[in,out] Source     On input, the first length continuation byte. On
+                            output, the byte after the last one.
+  @param[in]     SourceEnd  End of the LZ4 block.
+  @param[in,out] Length     The length to extend.
+
+  @retval TRUE   The length has been decoded.
+  @retval FALSE  The block ended in the middle of the length.
+**/
+STATIC
+BOOLEAN
+Lz4ReadLength (
+  IN OUT CONST UINT8 **Source,
+  IN     CONST UINT8 *SourceEnd,
+  IN OUT UINTN       *Length
+  )
+{
+  UINT8 Byte;
+
+  do {
+    if (*Source >= SourceEnd) {
+      return FALSE;
+    }
+    Byte = *(*Source)++;
+    *Length += Byte;
+  } while (Byte == 0xFF);
+
+  return TRUE;
+}
+
+/**
+  Decode one LZ4 block.
+
+  The block format is the one produced by LZ4_compress_default(): a sequence
+  of (token, literals, match offset, match length) records, the last of which
+  consists of literals only. The block must decode to exactly DestinationSize
+  bytes.
+
+  @param[in]  Source           The LZ4 block.
+  @param[in]  SourceSize       Size of the LZ4 block in bytes.
+  @param[out] Destination      The buffer to decode the block into.
+  @param[in]  DestinationSize  Size of the decoded block in bytes.
+
+  @retval RETURN_SUCCESS            The block has been decoded.
+  @retval RETURN_VOLUME_CORRUPTED   The block is malformed, or it does not
+                                    decode to exactly DestinationSize bytes.
+**/
+RETURN_STATUS
+Lz4BlockDecompress (
+  IN  CONST UINT8 *Source,
+  IN  UINTN       SourceSize,
+  OUT UINT8       *Destination,
+  IN  UINTN       DestinationSize
+  )
+{
+  CONST UINT8 *SourceEnd;
+  UINT8       *Output;
+  UINT8       *OutputEnd;
+  CONST UINT8 *Match;
+  UINT8       Token;
+  UINTN       Length;
+  UINTN       Offset;
+
+  SourceEnd = Source + SourceSize;
+  Output    = Destination;
+  OutputEnd = Destination + DestinationSize;
+
+  for (;;) {
+    if (Source >= SourceEnd) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+    Token = *Source++;
+
+    //
+    // Literals.
+    //
+    Length = Token >> 4;
+    if (Length == LZ4_RUN_MASK &&
+        !Lz4ReadLength (&Source, SourceEnd, &Length)) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+    if (Length > (UINTN)(SourceEnd - Source) ||
+        Length > (UINTN)(OutputEnd - Output)) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+    CopyMem (Output, Source, Length);
+    Output += Length;
+    Source += Length;
+
+    //
+    // The last sequence of the block has no match part.
+    //
+    if (Source == SourceEnd) {
+      break;
+    }
+
+    //
+    // Match.
+    //
+    if (SourceEnd - Source < 2) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+    Offset  = Source[0] | ((UINTN)Source[1] << 8);
+    Source += 2;
+    if (Offset == 0 || Offset > (UINTN)(Output - Destination)) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+
+    Length = Token & LZ4_RUN_MASK;
+    if (Length == LZ4_RUN_MASK &&
+        !Lz4ReadLength (&Source, SourceEnd, &Length)) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+    Length += LZ4_MIN_MATCH;
+    if (Length > (UINTN)(OutputEnd - Output)) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+
+    Match = Output - Offset;
+    if (Offset >= Length) {
+      CopyMem (Output, Match, Length);
+      Output += Length;
+    } else {
+      //
+      // The match overlaps the bytes it produces (a repeated pattern); copy
+      // it forward byte by byte.
+      //
+      while (Length-- > 0) {
+        *Output++ = *Match++;
+      }
+    }
+  }
+
+  return (Output == OutputEnd) ? RETURN_SUCCESS : RETURN_VOLUME_CORRUPTED;
+}
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+## @file
+#  GUIDed section tool producing the chunked LZ4 format that
+#  Lz4ChunkedDecompressLib extracts (see Include/Guid/Lz4ChunkedSection.h).
+#
+#  GenFds invokes the tool as "Lz4ChunkCompress.py -e -o OUTPUT INPUT"; "-d"
+#  decodes a section payload again, for checking the output.
+#
+#  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+##
+
+import argparse
+import struct
+import sys
+
+SIGNATURE = b'LZ4C'
+CHUNK_RAW = 0x80000000
+DEFAULT_CHUNK_SIZE = 0x20000
+
+MIN_MATCH = 4
+LAST_LITERALS = 5
+MF_LIMIT = 12
+MAX_OFFSET = 0xFFFF
+RUN_MASK = 0xF
+
+
+def WriteLength(Output, Length):
+    while Length >= 0xFF:
+        Output.append(0xFF)
+        Length -= 0xFF
+    Output.append(Length)
+
+
+def EmitSequence(Output, Literals, Offset, MatchLength):
+    LiteralLength = len(Literals)
+    Token = min(LiteralLength, RUN_MASK) << 4
+    if Offset:
+        Token |= min(MatchLength - MIN_MATCH, RUN_MASK)
+    Output.append(Token)
+    if LiteralLength >= RUN_MASK:
+        WriteLength(Output, LiteralLength - RUN_MASK)
+    Output += Literals
+    if Offset:
+        Output += struct.pack('<H', Offset)
+        if MatchLength - MIN_MATCH >= RUN_MASK:
+            WriteLength(Output, MatchLength - MIN_MATCH - RUN_MASK)
+
+
+def CompressBlock(Data):
+    Output = bytearray()
+    Size = len(Data)
+    Anchor = 0
+    Position = 0
+    Limit = Size - MF_LIMIT
+    Table = {}
+    Misses = 0
+
+    while Position < Limit:
+        Key = Data[Position:Position + MIN_MATCH]
+        Candidate = Table.get(Key)
+        Table[Key] = Position
+        if Candidate is None or Position - Candidate > MAX_OFFSET:
+            #
+            # Skip ahead faster through incompressible data.
+            #
+            Misses += 1
+            Position += 1 + (Misses >> 6)
+            continue
+        Misses = 0
+
+        MatchLength = MIN_MATCH
+        MaxLength = Size - LAST_LITERALS - Position
+        while (MatchLength < MaxLength and
+               Data[Candidate + MatchLength] == Data[Position + MatchLength]):
+            MatchLength += 1
+
+        EmitSequence(
+            Output,
+            Data[Anchor:Position],
+            Position - Candidate,
+            MatchLength
+            )
+        Position += MatchLength
+        Anchor = Position
+        if Position - 2 < Limit:
+            Table[Data[Position - 2:Position + 2]] = Position - 2
+
+    EmitSequence(Output, Data[Anchor:], 0, 0)
+    return bytes(Output)
+
+
+def DecompressBlock(Data, Size):
+    Output = bytearray()
+    Position = 0
+    while True:
+        Token = Data[Position]
+        Position += 1
+        Length = Token >> 4
+        if Length == RUN_MASK:
+            while True:
+                Byte = Data[Position]
+                Position += 1
+                Length += Byte
+                if Byte != 0xFF:
+                    break
+        Output += Data[Position:Position + Length]
+        Position += Length
+        if Position == len(Data):
+            break
+        Offset = struct.unpack_from('<H', Data, Position)[0]
+        Position += 2
+        if Offset == 0 or Offset > len(Output):
+            raise ValueError('invalid match offset')
+        Length = Token & RUN_MASK
+        if Length == RUN_MASK:
+            while True:
+                Byte = Data[Position]
+                Position += 1
+                Length += Byte
+                if Byte != 0xFF:
+                    break
+        Length += MIN_MATCH
+        for _ in range(Length):
+            Output.append(Output[-Offset])
+    if len(Output) != Size:
+        raise ValueError('block decodes to %d bytes, expected %d' %
+                         (len(Output), Size))
+    return bytes(Output)
+
+
+def Encode(Data, ChunkSize):
+    Chunks = []
+    Sizes = []
+    for Start in range(0, len(Data), ChunkSize):
+        Raw = Data[Start:Start + ChunkSize]
+        Compressed = CompressBlock(Raw)
+        if len(Compressed) >= len(Raw):
+            Chunks.append(Raw)
+            Sizes.append(len(Raw) | CHUNK_RAW)
+        else:
+            Chunks.append(Compressed)
+            Sizes.append(len(Compressed))
+
+    Header = SIGNATURE + struct.pack('<III', ChunkSize, len(Chunks), len(Data))
+    return (Header + struct.pack('<%dI' % len(Sizes), *Sizes) +
+            b''.join(Chunks))
+
+
+def Decode(Data):
+    if Data[0:4] != SIGNATURE:
+        raise ValueError('bad signature')
+    ChunkSize, ChunkCount, Size = struct.unpack_from('<III', Data, 4)
+    Sizes = struct.unpack_from('<%dI' % ChunkCount, Data, 16)
+    Position = 16 + 4 * ChunkCount
+    Output = bytearray()
+    for CompressedSize in Sizes:
+        Expected = min(ChunkSize, Size - len(Output))
+        Length = CompressedSize & ~CHUNK_RAW
+        Chunk = Data[Position:Position + Length]
+        if CompressedSize & CHUNK_RAW:
+            Output += Chunk
+        else:
+            Output += DecompressBlock(Chunk, Expected)
+        Position += Length
+    if len(Output) != Size:
+        raise ValueError('payload decodes to %d bytes, expected %d' %
+                         (len(Output), Size))
+    return bytes(Output)
+
+
+def Main():
+    Parser = argparse.ArgumentParser(
+        description='Chunked LZ4 GUIDed section tool')
+    Group = Parser.add_mutually_exclusive_group(required=True)
+    Group.add_argument('-e', action='store_true', dest='Encode',
+                       help='encode INPUT')
+    Group.add_argument('-d', action='store_true', dest='Decode',
+                       help='decode INPUT')
+    Parser.add_argument('-o', dest='Output', required=True,
+                        help='output file')
+    Parser.add_argument('--chunk-size', dest='ChunkSize', type=int,
+                        default=DEFAULT_CHUNK_SIZE,
+                        help='uncompressed chunk size in bytes')
+    Parser.add_argument('-v', '--verbose', action='store_true')
+    Parser.add_argument('-q', '--quiet', action='store_true')
+    Parser.add_argument('Input', help='input file')
+    Args = Parser.parse_args()
+
+    with open(Args.Input, 'rb') as File:
+        Data = File.read()
+
+    if Args.Encode:
+        if Args.ChunkSize <= 0 or Args.ChunkSize >= CHUNK_RAW:
+            Parser.error('invalid chunk size')
+        Result = Encode(Data, Args.ChunkSize)
+    else:
+        Result = Decode(Data)
+
+    with open(Args.Output, 'wb') as File:
+        File.write(Result)
+
+    if Args.verbose:
+        print('%s: %d -> %d bytes' % (Args.Input, len(Data), len(Result)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(Main())
@@ -0,0 +1,267 @@
+/** @file
+  Chunked LZ4 GUIDed section extraction.
+
+  Sections of this type hold the uncompressed data split into independently
+  compressed LZ4 blocks; see <Guid/Lz4ChunkedSection.h>. The chunks are
+  decoded one after the other, straight into the output buffer, so the working
+  set of the decoder is one chunk of input and output at a time, and no
+  scratch buffer is needed.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+
+#include <Guid/Lz4ChunkedSection.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
+
+#include "Lz4ChunkedDecompressLibInternal.h"
+
+/**
+  Locate the payload of a chunked LZ4 GUIDed section, and validate its header.
+
+  @param[in]  InputSection  A pointer to a GUIDed section.
+  @param[out] Header        The header at the start of the payload.
+  @param[out] PayloadEnd    The end of the payload.
+  @param[out] Attributes    The attributes of the GUIDed section. Optional.
+
+  @retval RETURN_SUCCESS            The payload has been located.
+  @retval RETURN_INVALID_PARAMETER  InputSection is not a chunked LZ4 section,
+                                    or its header is malformed.
+**/
+STATIC
+RETURN_STATUS
+Lz4ChunkedGetPayload (
+  IN  CONST VOID                       *InputSection,
+  OUT CONST LZ4_CHUNKED_SECTION_HEADER **Header,
+  OUT CONST UINT8                      **PayloadEnd,
+  OUT UINT16                           *Attributes  OPTIONAL
+  )
+{
+  CONST EFI_GUID                   *SectionGuid;
+  CONST UINT8                      *Payload;
+  UINTN                            PayloadSize;
+  CONST LZ4_CHUNKED_SECTION_HEADER *ChunkedHeader;
+  UINT64                           ChunkCount;
+
+  if (IS_SECTION2 (InputSection)) {
+    CONST EFI_GUID_DEFINED_SECTION2 *Section2;
+
+    Section2    = InputSection;
+    SectionGuid = &Section2->SectionDefinitionGuid;
+    if (Section2->DataOffset > SECTION2_SIZE (InputSection)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    Payload     = (CONST UINT8 *)InputSection + Section2->DataOffset;
+    PayloadSize = SECTION2_SIZE (InputSection) - Section2->DataOffset;
+    if (Attributes != NULL) {
+      *Attributes = Section2->Attributes;
+    }
+  } else {
+    CONST EFI_GUID_DEFINED_SECTION *Section;
+
+    Section     = InputSection;
+    SectionGuid = &Section->SectionDefinitionGuid;
+    if (Section->DataOffset > SECTION_SIZE (InputSection)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    Payload     = (CONST UINT8 *)InputSection + Section->DataOffset;
+    PayloadSize = SECTION_SIZE (InputSection) - Section->DataOffset;
+    if (Attributes != NULL) {
+      *Attributes = Section->Attributes;
+    }
+  }
+
+  if (!CompareGuid (&gLz4ChunkedCustomDecompressGuid, SectionGuid)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (PayloadSize < sizeof (LZ4_CHUNKED_SECTION_HEADER)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  ChunkedHeader = (CONST LZ4_CHUNKED_SECTION_HEADER *)Payload;
+  if (ChunkedHeader->Signature != LZ4_CHUNKED_SECTION_SIGNATURE ||
+      ChunkedHeader->ChunkSize == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // Every chunk except the last one holds exactly ChunkSize bytes.
+  //
+  ChunkCount = DivU64x32 (
+                 (UINT64)ChunkedHeader->UncompressedSize +
+                 ChunkedHeader->ChunkSize - 1,
+                 ChunkedHeader->ChunkSize
+                 );
+  if (ChunkedHeader->ChunkCount != ChunkCount ||
+      (PayloadSize - sizeof *ChunkedHeader) / sizeof (UINT32) < ChunkCount) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  *Header     = ChunkedHeader;
+  *PayloadEnd = Payload + PayloadSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Examines a GUIDed section and returns the size of the decoded buffer and the
+  size of an optional scratch buffer required to actually decode the data in a
+  GUIDed section.
+
+  @param[in]  InputSection       A pointer to a GUIDed section of an FFS
+                                 formatted file.
+  @param[out] OutputBufferSize   A pointer to the size, in bytes, of an output
+                                 buffer required if the buffer specified by
+                                 InputSection were decoded.
+  @param[out] ScratchBufferSize  A pointer to the size, in bytes, required as
+                                 scratch space if the buffer specified by
+                                 InputSection were decoded.
+  @param[out] SectionAttribute   A pointer to the attributes of the GUIDed
+                                 section.
+
+  @retval RETURN_SUCCESS            The information about InputSection was
+                                    returned.
+  @retval RETURN_INVALID_PARAMETER  The section is not a well-formed chunked
+                                    LZ4 section.
+**/
+RETURN_STATUS
+EFIAPI
+Lz4ChunkedGuidedSectionGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *ScratchBufferSize,
+  OUT UINT16      *SectionAttribute
+  )
+{
+  RETURN_STATUS                    Status;
+  CONST LZ4_CHUNKED_SECTION_HEADER *Header;
+  CONST UINT8                      *PayloadEnd;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBufferSize != NULL);
+  ASSERT (ScratchBufferSize != NULL);
+  ASSERT (SectionAttribute != NULL);
+
+  Status = Lz4ChunkedGetPayload (
+             InputSection,
+             &Header,
+             &PayloadEnd,
+             SectionAttribute
+             );
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  *OutputBufferSize  = Header->UncompressedSize;
+  *ScratchBufferSize = 0;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompress a chunked LZ4 GUIDed section.
+
+  @param[in]  InputSection          A pointer to a GUIDed section of an FFS
+                                    formatted file.
+  @param[out] OutputBuffer          A pointer to a buffer that contains the
+                                    result of the decode operation.
+  @param[out] ScratchBuffer         Unused; this format needs no scratch space.
+  @param[out] AuthenticationStatus  Set to zero; the section carries no
+                                    authentication data.
+
+  @retval RETURN_SUCCESS            The section has been decoded.
+  @retval RETURN_INVALID_PARAMETER  The section is not a well-formed chunked
+                                    LZ4 section.
+  @retval RETURN_VOLUME_CORRUPTED   A chunk of the section failed to decode.
+**/
+RETURN_STATUS
+EFIAPI
+Lz4ChunkedGuidedSectionExtraction (
+  IN CONST  VOID    *InputSection,
+  OUT       VOID    **OutputBuffer,
+  OUT       VOID    *ScratchBuffer,        OPTIONAL
+  OUT       UINT32  *AuthenticationStatus
+  )
+{
+  RETURN_STATUS                    Status;
+  CONST LZ4_CHUNKED_SECTION_HEADER *Header;
+  CONST UINT8                      *PayloadEnd;
+  CONST UINT32                     *CompressedSizes;
+  CONST UINT8                      *Chunk;
+  UINT8                            *Output;
+  UINT32                           Left;
+  UINT32                           Index;
+  UINT32                           CompressedSize;
+  UINT32                           ChunkSize;
+
+  ASSERT (OutputBuffer != NULL);
+  ASSERT (InputSection != NULL);
+  ASSERT (AuthenticationStatus != NULL);
+
+  Status = Lz4ChunkedGetPayload (InputSection, &Header, &PayloadEnd, NULL);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  *AuthenticationStatus = 0;
+
+  CompressedSizes = (CONST UINT32 *)(Header + 1);
+  Chunk           = (CONST UINT8 *)(CompressedSizes + Header->ChunkCount);
+  Output          = *OutputBuffer;
+  Left            = Header->UncompressedSize;
+
+  for (Index = 0; Index < Header->ChunkCount; Index++) {
+    CompressedSize = ReadUnaligned32 (&CompressedSizes[Index]);
+    ChunkSize      = MIN (Left, Header->ChunkSize);
+
+    if ((CompressedSize & ~LZ4_CHUNKED_SECTION_CHUNK_RAW) >
+        (UINTN)(PayloadEnd - Chunk)) {
+      return RETURN_VOLUME_CORRUPTED;
+    }
+
+    if ((CompressedSize & LZ4_CHUNKED_SECTION_CHUNK_RAW) != 0) {
+      CompressedSize &= ~LZ4_CHUNKED_SECTION_CHUNK_RAW;
+      if (CompressedSize != ChunkSize) {
+        return RETURN_VOLUME_CORRUPTED;
+      }
+      CopyMem (Output, Chunk, ChunkSize);
+    } else {
+      Status = Lz4BlockDecompress (Chunk, CompressedSize, Output, ChunkSize);
+      if (RETURN_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "%a: chunk %u: %r\n", __FUNCTION__, Index,
+          Status));
+        return Status;
+      }
+    }
+
+    Chunk  += CompressedSize;
+    Output += ChunkSize;
+    Left   -= ChunkSize;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Register the chunked LZ4 GUIDed section extraction handlers.
+
+  @retval RETURN_SUCCESS           The handlers have been registered.
+  @retval RETURN_OUT_OF_RESOURCES  No room for more handlers.
+**/
+RETURN_STATUS
+EFIAPI
+Lz4ChunkedDecompressLibConstructor (
+  VOID
+  )
+{
+  return ExtractGuidedSectionRegisterHandlers (
+           &gLz4ChunkedCustomDecompressGuid,
+           Lz4ChunkedGuidedSectionGetInfo,
+           Lz4ChunkedGuidedSectionExtraction
+           );
+}
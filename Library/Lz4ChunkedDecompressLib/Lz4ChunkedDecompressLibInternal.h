@@ -0,0 +1,40 @@
+/** @file
+  Internal interfaces of the chunked LZ4 GUIDed section extraction library.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __LZ4_CHUNKED_DECOMPRESS_LIB_INTERNAL_H__
+#define __LZ4_CHUNKED_DECOMPRESS_LIB_INTERNAL_H__
+
+#include <Base.h>
+
+/**
+  Decode one LZ4 block.
+
+  The block format is the one produced by LZ4_compress_default(): a sequence
+  of (token, literals, match offset, match length) records, the last of which
+  consists of literals only. The block must decode to exactly DestinationSize
+  bytes.
+
+  @param[in]  Source           The LZ4 block.
+  @param[in]  SourceSize       Size of the LZ4 block in bytes.
+  @param[out] Destination      The buffer to decode the block into.
+  @param[in]  DestinationSize  Size of the decoded block in bytes.
+
+  @retval RETURN_SUCCESS            The block has been decoded.
+  @retval RETURN_VOLUME_CORRUPTED   The block is malformed, or it does not
+                                    decode to exactly DestinationSize bytes.
+**/
+RETURN_STATUS
+Lz4BlockDecompress (
+  IN  CONST UINT8 *Source,
+  IN  UINTN       SourceSize,
+  OUT UINT8       *Destination,
+  IN  UINTN       DestinationSize
+  );
+
+#endif
@@ -12,6 +12,12 @@
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 
+//
+// Changed variables are appended to the NvVars file, until that would take
+// it past this size, or past twice the size of the live variables, whichever
+// is larger; then the file is rewritten with the live variables only.
+//
+#define NV_VARS_FILE_COMPACT_SIZE  SIZE_64KB
 
 /**
   Open the NvVars file for reading or writing
@@ -168,44 +174,6 @@ FileHandleEmpty (
 }
 
 
-/**
-  Reads a file to a newly allocated buffer
-
-  @param[in]  File - The file to read
-  @param[in]  ReadSize - The size of data to read from the file
-
-  @return     Pointer to buffer allocated to hold the file
-              contents.  NULL if an error occurred.
-
-**/
-VOID*
-FileHandleReadToNewBuffer (
-  IN EFI_FILE_HANDLE            FileHandle,
-  IN UINTN                      ReadSize
-  )
-{
-  EFI_STATUS                  Status;
-  UINTN                       ActualReadSize;
-  VOID                        *FileContents;
-
-  ActualReadSize = ReadSize;
-  FileContents = AllocatePool (ReadSize);
-  if (FileContents != NULL) {
-    Status = FileHandleRead (
-               FileHandle,
-               &ReadSize,
-               FileContents
-               );
-    if (EFI_ERROR (Status) || (ActualReadSize != ReadSize)) {
-      FreePool (FileContents);
-      return NULL;
-    }
-  }
-
-  return FileContents;
-}
-
-
 /**
   Reads the contents of the NvVars file on the file system
 
@@ -223,8 +191,6 @@ ReadNvVarsFile (
   EFI_FILE_HANDLE             File;
   UINTN                       FileSize;
   BOOLEAN                     FileExists;
-  VOID                        *FileContents;
-  EFI_HANDLE                  SerializedVariables;
 
   Status = GetNvVarsFile (FsHandle, TRUE, &File);
   if (EFI_ERROR (Status)) {
@@ -238,29 +204,21 @@ ReadNvVarsFile (
     return EFI_UNSUPPORTED;
   }
 
-  FileContents = FileHandleReadToNewBuffer (File, FileSize);
-  if (FileContents == NULL) {
-    FileHandleClose (File);
-    return EFI_UNSUPPORTED;
-  }
-
   DEBUG ((
     DEBUG_INFO,
-    "FsAccess.c: Read %Lu bytes from NV Variables file\n",
+    "FsAccess.c: Reading %Lu bytes from NV Variables file\n",
     (UINT64)FileSize
     ));
 
-  Status = SerializeVariablesNewInstanceFromBuffer (
-             &SerializedVariables,
-             FileContents,
-             FileSize
-             );
-  if (!RETURN_ERROR (Status)) {
-    Status = SerializeVariablesSetSerializedVariables (SerializedVariables);
-  }
-
-  FreePool (FileContents);
+  //
+  // Stream the records into the snapshot of the journal, which keeps the
+  // last record of each variable, and set the variables from that.
+  //
+  Status = NvVarsJournalLoad (FsHandle, File, FileSize);
   FileHandleClose (File);
+  if (!EFI_ERROR (Status)) {
+    Status = NvVarsJournalApply ();
+  }
 
   return Status;
 }
@@ -368,40 +326,6 @@ LoadNvVarsFromFs (
 }
 
 
-STATIC
-RETURN_STATUS
-EFIAPI
-IterateVariablesCallbackAddAllNvVariables (
-  IN  VOID                         *Context,
-  IN  CHAR16                       *VariableName,
-  IN  EFI_GUID                     *VendorGuid,
-  IN  UINT32                       Attributes,
-  IN  UINTN                        DataSize,
-  IN  VOID                         *Data
-  )
-{
-  EFI_HANDLE  Instance;
-
-  Instance = (EFI_HANDLE) Context;
-
-  //
-  // Only save non-volatile variables
-  //
-  if ((Attributes & EFI_VARIABLE_NON_VOLATILE) == 0) {
-    return RETURN_SUCCESS;
-  }
-
-  return SerializeVariablesAddVariable (
-           Instance,
-           VariableName,
-           VendorGuid,
-           Attributes,
-           DataSize,
-           Data
-           );
-}
-
-
 /**
   Saves the non-volatile variables into the NvVars file on the
   given file system.
@@ -417,51 +341,28 @@ SaveNvVarsToFs (
   )
 {
   EFI_STATUS                  Status;
+  EFI_STATUS                  CloseStatus;
   EFI_FILE_HANDLE             File;
+  BOOLEAN                     FileExists;
+  UINTN                       FileSize;
+  UINTN                       JournalFileSize;
+  BOOLEAN                     Compact;
   UINTN                       WriteSize;
   UINTN                       VariableDataSize;
   VOID                        *VariableData;
-  EFI_HANDLE                  SerializedVariables;
-
-  SerializedVariables = NULL;
-
-  Status = SerializeVariablesNewInstance (&SerializedVariables);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
 
-  Status = SerializeVariablesIterateSystemVariables (
-             IterateVariablesCallbackAddAllNvVariables,
-             (VOID*) SerializedVariables
-             );
+  //
+  // Find the variables that changed since the last save.
+  //
+  Status = NvVarsJournalRefresh ();
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  VariableData = NULL;
-  VariableDataSize = 0;
-  Status = SerializeVariablesToBuffer (
-             SerializedVariables,
-             NULL,
-             &VariableDataSize
-             );
-  if (Status == RETURN_BUFFER_TOO_SMALL) {
-    VariableData = AllocatePool (VariableDataSize);
-    if (VariableData == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-    } else {
-      Status = SerializeVariablesToBuffer (
-                 SerializedVariables,
-                 VariableData,
-                 &VariableDataSize
-                 );
-    }
-  }
-
-  SerializeVariablesFreeInstance (SerializedVariables);
-
-  if (EFI_ERROR (Status)) {
-    return Status;
+  Compact = !NvVarsJournalMatchesFile (FsHandle, &JournalFileSize);
+  if (!Compact && NvVarsJournalGetSize (TRUE) == 0) {
+    DEBUG ((DEBUG_VERBOSE, "FsAccess.c: NV Variables unchanged\n"));
+    return EFI_SUCCESS;
   }
 
   //
@@ -474,35 +375,63 @@ SaveNvVarsToFs (
   }
 
   //
-  // Empty the starting file contents.
+  // Append the changed variables, unless the file is not the one the journal
+  // describes, or has grown past the compaction threshold.
   //
-  Status = FileHandleEmpty (File);
-  if (EFI_ERROR (Status)) {
-    FileHandleClose (File);
-    return Status;
+  FileSize = 0;
+  if (!Compact) {
+    NvVarsFileReadCheckup (File, &FileExists, &FileSize);
+    Compact = (BOOLEAN)(
+                FileSize != JournalFileSize ||
+                FileSize + NvVarsJournalGetSize (TRUE) >
+                  MAX (NV_VARS_FILE_COMPACT_SIZE,
+                       2 * NvVarsJournalGetSize (FALSE))
+                );
   }
 
-  WriteSize = VariableDataSize;
-  Status = FileHandleWrite (File, &WriteSize, VariableData);
-  if (EFI_ERROR (Status)) {
-    return Status;
+  Status = NvVarsJournalSerialize (!Compact, &VariableData, &VariableDataSize);
+  if (!EFI_ERROR (Status)) {
+    if (Compact) {
+      FileSize = 0;
+      Status = FileHandleEmpty (File);
+    } else {
+      Status = FileHandleSetPosition (File, FileSize);
+    }
+    if (!EFI_ERROR (Status)) {
+      WriteSize = VariableDataSize;
+      Status = FileHandleWrite (File, &WriteSize, VariableData);
+    }
+    FreePool (VariableData);
   }
 
-  FileHandleClose (File);
-
+  CloseStatus = FileHandleClose (File);
   if (!EFI_ERROR (Status)) {
+    Status = CloseStatus;
+  }
+
+  if (EFI_ERROR (Status)) {
     //
-    // Write a variable to indicate we've already loaded the
-    // variable data.  If it is found, we skip the loading on
-    // subsequent attempts.
+    // The file may hold part of the records; rewrite it next time.
     //
-    SetNvVarsVariable();
-
-    DEBUG ((DEBUG_INFO, "Saved NV Variables to NvVars file\n"));
+    NvVarsJournalInvalidate ();
+    return Status;
   }
 
-  return Status;
+  NvVarsJournalCommit (FsHandle, FileSize + VariableDataSize);
 
-}
+  //
+  // Write a variable to indicate we've already loaded the
+  // variable data.  If it is found, we skip the loading on
+  // subsequent attempts.
+  //
+  SetNvVarsVariable();
 
+  DEBUG ((
+    DEBUG_INFO,
+    "Saved NV Variables to NvVars file (%a %Lu bytes)\n",
+    Compact ? "wrote" : "appended",
+    (UINT64)VariableDataSize
+    ));
 
+  return Status;
+}
@@ -51,5 +51,133 @@ SaveNvVarsToFs (
   EFI_HANDLE                            FsHandle
   );
 
+
+/**
+  Read the snapshot from the NvVars file, one record at a time.
+
+  If the file ends in a torn or corrupt record, for instance because an
+  append was interrupted, the records before it are kept, and the next save
+  rewrites the file.
+
+  @param[in]  FsHandle  The file system the file is on.
+  @param[in]  File      The NvVars file, positioned at its start.
+  @param[in]  FileSize  The size of the file in bytes.
+
+  @retval EFI_SUCCESS  The snapshot was read, at least in part.
+  @return              No record could be read.
+
+**/
+EFI_STATUS
+NvVarsJournalLoad (
+  IN EFI_HANDLE       FsHandle,
+  IN EFI_FILE_HANDLE  File,
+  IN UINTN            FileSize
+  );
+
+
+/**
+  Set the variables of the snapshot.
+
+  @retval EFI_SUCCESS  The variables were set.
+  @return              The error of the first variable that could not be
+                       set.
+
+**/
+EFI_STATUS
+NvVarsJournalApply (
+  VOID
+  );
+
+
+/**
+  Compare the non-volatile variables against the snapshot, and mark the
+  entries of the changed, new and deleted ones dirty.
+
+  @return  EFI_STATUS of iterating the variables.
+
+**/
+EFI_STATUS
+NvVarsJournalRefresh (
+  VOID
+  );
+
+
+/**
+  Return the size of the records of the snapshot.
+
+  @param[in]  DirtyOnly  TRUE: the records of the dirty entries, that is, of
+                         the changes since the last commit. FALSE: the
+                         records of all the variables that exist.
+
+  @return  The size in bytes.
+
+**/
+UINTN
+NvVarsJournalGetSize (
+  IN BOOLEAN  DirtyOnly
+  );
+
+
+/**
+  Serialize the records of the snapshot to a new buffer.
+
+  @param[in]  DirtyOnly   As for NvVarsJournalGetSize().
+  @param[out] Buffer      The new buffer; the caller frees it.
+  @param[out] BufferSize  The size of Buffer in bytes.
+
+  @retval EFI_SUCCESS           The records were serialized.
+  @retval EFI_OUT_OF_RESOURCES  The buffer could not be allocated.
+
+**/
+EFI_STATUS
+NvVarsJournalSerialize (
+  IN  BOOLEAN  DirtyOnly,
+  OUT VOID     **Buffer,
+  OUT UINTN    *BufferSize
+  );
+
+
+/**
+  Record that the NvVars file now holds the snapshot: the dirty records were
+  written, so the entries are clean, and the deleted ones are dropped.
+
+  @param[in]  FsHandle  The file system the file is on.
+  @param[in]  FileSize  The new size of the file in bytes.
+
+**/
+VOID
+NvVarsJournalCommit (
+  IN EFI_HANDLE  FsHandle,
+  IN UINTN       FileSize
+  );
+
+
+/**
+  Record that the NvVars file is in an unknown state, after a failed write,
+  so that the next save rewrites it.
+
+**/
+VOID
+NvVarsJournalInvalidate (
+  VOID
+  );
+
+
+/**
+  Check whether the snapshot describes the NvVars file on a file system.
+
+  @param[in]  FsHandle  The file system.
+  @param[out] FileSize  The size of the file the snapshot describes.
+
+  @retval TRUE   Changes to the snapshot can be appended to the file.
+  @retval FALSE  The file must be rewritten.
+
+**/
+BOOLEAN
+NvVarsJournalMatchesFile (
+  IN  EFI_HANDLE  FsHandle,
+  OUT UINTN       *FileSize
+  );
+
 #endif
 
@@ -0,0 +1,681 @@
+/** @file
+  Change tracking for the NvVars file.
+
+  The library keeps a snapshot of the non-volatile variables as the NvVars
+  file on the connected file system describes them. On every save, the
+  variables are compared against the snapshot, and only the records of the
+  ones that changed are appended to the file; a record with zero Attributes
+  and DataSize records a deleted variable. Loading replays the records into
+  the snapshot in file order, so the last record of each variable wins.
+
+  The records use the format of SerializeVariablesLib, so a compacted NvVars
+  file is the same as a file written by earlier versions of this library.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "NvVarsFileLib.h"
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#define NV_VARS_ENTRY_SIGNATURE  SIGNATURE_32 ('N', 'V', 'J', 'E')
+
+//
+// A variable of the snapshot. The structure is followed by the name, of
+// NameSize bytes, and the data, of DataSize bytes. An entry with zero
+// Attributes is a deleted variable, whose record has not been written yet.
+//
+typedef struct {
+  UINT32      Signature;
+  LIST_ENTRY  Link;
+  EFI_GUID    VendorGuid;
+  UINT32      Attributes;
+  UINT32      NameSize;
+  UINT32      DataSize;
+  //
+  // The variable was found by the last NvVarsJournalRefresh().
+  //
+  BOOLEAN     Seen;
+  //
+  // The record of the variable is not in the NvVars file yet.
+  //
+  BOOLEAN     Dirty;
+} NV_VARS_ENTRY;
+
+#define NV_VARS_ENTRY_FROM_LINK(a) \
+  CR (a, NV_VARS_ENTRY, Link, NV_VARS_ENTRY_SIGNATURE)
+
+#define NV_VARS_ENTRY_NAME(Entry)  ((CHAR16 *)((Entry) + 1))
+#define NV_VARS_ENTRY_DATA(Entry)  ((UINT8 *)((Entry) + 1) + (Entry)->NameSize)
+
+//
+// The size of the fixed fields of a record: NameSize, VendorGuid,
+// Attributes and DataSize.
+//
+#define NV_VARS_RECORD_HEADER_SIZE  (3 * sizeof (UINT32) + sizeof (EFI_GUID))
+
+#define NV_VARS_RECORD_SIZE(Entry) \
+  (NV_VARS_RECORD_HEADER_SIZE + (Entry)->NameSize + (Entry)->DataSize)
+
+STATIC LIST_ENTRY mNvVarsEntries = INITIALIZE_LIST_HEAD_VARIABLE (mNvVarsEntries);
+
+//
+// The file system whose NvVars file the snapshot describes, and the size of
+// that file. NULL if the snapshot does not describe any file as it is on
+// disk, so that the next save must rewrite the file.
+//
+STATIC EFI_HANDLE mNvVarsJournalFsHandle;
+STATIC UINTN      mNvVarsJournalFileSize;
+
+/**
+  Create a snapshot entry, unlinked and clean.
+
+  @param[in]  Name        The variable name, of NameSize bytes.
+  @param[in]  NameSize    The size of Name in bytes, including the NUL.
+  @param[in]  VendorGuid  The variable GUID.
+  @param[in]  Attributes  The variable attributes.
+  @param[in]  DataSize    The size of the variable data in bytes.
+  @param[in]  Data        The variable data, or NULL to leave it for the
+                          caller to fill in.
+
+  @return  The new entry, or NULL if out of resources.
+
+**/
+STATIC
+NV_VARS_ENTRY *
+NvVarsJournalNewEntry (
+  IN CONST CHAR16    *Name,
+  IN UINT32          NameSize,
+  IN CONST EFI_GUID  *VendorGuid,
+  IN UINT32          Attributes,
+  IN UINT32          DataSize,
+  IN CONST VOID      *Data        OPTIONAL
+  )
+{
+  NV_VARS_ENTRY  *Entry;
+
+  Entry = AllocateZeroPool (sizeof (*Entry) + NameSize + DataSize);
+  if (Entry == NULL) {
+    return NULL;
+  }
+
+  Entry->Signature  = NV_VARS_ENTRY_SIGNATURE;
+  Entry->Attributes = Attributes;
+  Entry->NameSize   = NameSize;
+  Entry->DataSize   = DataSize;
+  CopyGuid (&Entry->VendorGuid, VendorGuid);
+  CopyMem (NV_VARS_ENTRY_NAME (Entry), Name, NameSize);
+  if (Data != NULL) {
+    CopyMem (NV_VARS_ENTRY_DATA (Entry), Data, DataSize);
+  }
+  return Entry;
+}
+
+/**
+  Find a variable in the snapshot.
+
+  @param[in]  Name        The variable name.
+  @param[in]  VendorGuid  The variable GUID.
+
+  @return  The entry of the variable, or NULL if there is none.
+
+**/
+STATIC
+NV_VARS_ENTRY *
+NvVarsJournalFindEntry (
+  IN CONST CHAR16    *Name,
+  IN CONST EFI_GUID  *VendorGuid
+  )
+{
+  LIST_ENTRY     *Link;
+  NV_VARS_ENTRY  *Entry;
+
+  for ( Link = GetFirstNode (&mNvVarsEntries)
+      ; !IsNull (&mNvVarsEntries, Link)
+      ; Link = GetNextNode (&mNvVarsEntries, Link)
+      ) {
+    Entry = NV_VARS_ENTRY_FROM_LINK (Link);
+    if (CompareGuid (&Entry->VendorGuid, VendorGuid) &&
+        StrCmp (NV_VARS_ENTRY_NAME (Entry), Name) == 0) {
+      return Entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Add an entry to the snapshot, in place of an older entry of the same
+  variable if there is one.
+
+  @param[in]  Entry     The new entry.
+  @param[in]  OldEntry  The entry it replaces, or NULL.
+
+**/
+STATIC
+VOID
+NvVarsJournalPutEntry (
+  IN NV_VARS_ENTRY  *Entry,
+  IN NV_VARS_ENTRY  *OldEntry  OPTIONAL
+  )
+{
+  if (OldEntry == NULL) {
+    InsertTailList (&mNvVarsEntries, &Entry->Link);
+    return;
+  }
+
+  InsertTailList (&OldEntry->Link, &Entry->Link);
+  RemoveEntryList (&OldEntry->Link);
+  FreePool (OldEntry);
+}
+
+/**
+  Free every entry of the snapshot.
+
+**/
+STATIC
+VOID
+NvVarsJournalReset (
+  VOID
+  )
+{
+  NV_VARS_ENTRY  *Entry;
+
+  while (!IsListEmpty (&mNvVarsEntries)) {
+    Entry = NV_VARS_ENTRY_FROM_LINK (GetFirstNode (&mNvVarsEntries));
+    RemoveEntryList (&Entry->Link);
+    FreePool (Entry);
+  }
+  mNvVarsJournalFsHandle = NULL;
+  mNvVarsJournalFileSize = 0;
+}
+
+/**
+  Read exactly Size bytes from the current position of a file.
+
+  @param[in]  File    The file to read.
+  @param[in]  Size    The number of bytes to read.
+  @param[out] Buffer  The buffer to read to.
+
+  @retval EFI_SUCCESS      Size bytes were read.
+  @retval EFI_END_OF_FILE  The file ended before Size bytes were read.
+  @return                  Errors from FileHandleRead().
+
+**/
+STATIC
+EFI_STATUS
+NvVarsJournalReadFile (
+  IN  EFI_FILE_HANDLE  File,
+  IN  UINTN            Size,
+  OUT VOID             *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       ReadSize;
+
+  ReadSize = Size;
+  Status = FileHandleRead (File, &ReadSize, Buffer);
+  if (!EFI_ERROR (Status) && ReadSize != Size) {
+    Status = EFI_END_OF_FILE;
+  }
+  return Status;
+}
+
+/**
+  Read the snapshot from the NvVars file, one record at a time.
+
+  If the file ends in a torn or corrupt record, for instance because an
+  append was interrupted, the records before it are kept, and the next save
+  rewrites the file.
+
+  @param[in]  FsHandle  The file system the file is on.
+  @param[in]  File      The NvVars file, positioned at its start.
+  @param[in]  FileSize  The size of the file in bytes.
+
+  @retval EFI_SUCCESS  The snapshot was read, at least in part.
+  @return              No record could be read.
+
+**/
+EFI_STATUS
+NvVarsJournalLoad (
+  IN EFI_HANDLE       FsHandle,
+  IN EFI_FILE_HANDLE  File,
+  IN UINTN            FileSize
+  )
+{
+  EFI_STATUS     Status;
+  UINTN          Offset;
+  UINTN          Remaining;
+  UINTN          Count;
+  UINT32         NameSize;
+  UINT8          *Header;
+  UINTN          HeaderSize;
+  UINTN          HeaderBufferSize;
+  CHAR16         *Name;
+  EFI_GUID       VendorGuid;
+  UINT32         Attributes;
+  UINT32         DataSize;
+  NV_VARS_ENTRY  *OldEntry;
+  NV_VARS_ENTRY  *Entry;
+
+  NvVarsJournalReset ();
+
+  Status           = EFI_SUCCESS;
+  Header           = NULL;
+  HeaderBufferSize = 0;
+  Count            = 0;
+
+  for (Offset = 0; Offset < FileSize; Offset += HeaderSize + DataSize) {
+    Remaining = FileSize - Offset;
+
+    Status = NvVarsJournalReadFile (File, sizeof (NameSize), &NameSize);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    if (NameSize < sizeof (CHAR16) || (NameSize % sizeof (CHAR16)) != 0 ||
+        NameSize > Remaining - sizeof (NameSize) ||
+        NV_VARS_RECORD_HEADER_SIZE + NameSize > Remaining) {
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+
+    //
+    // Read the name and the rest of the fixed fields. The name is copied to
+    // the entry from this pool buffer, which also keeps it 16-bit aligned.
+    //
+    HeaderSize = NV_VARS_RECORD_HEADER_SIZE + NameSize;
+    if (HeaderSize > HeaderBufferSize) {
+      if (Header != NULL) {
+        FreePool (Header);
+      }
+      Header = AllocatePool (HeaderSize);
+      if (Header == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+      HeaderBufferSize = HeaderSize;
+    }
+    Status = NvVarsJournalReadFile (
+               File,
+               HeaderSize - sizeof (NameSize),
+               Header
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Name = (CHAR16 *)Header;
+    CopyGuid (&VendorGuid, (EFI_GUID *)(Header + NameSize));
+    Attributes = ReadUnaligned32 (
+                   (UINT32 *)(Header + NameSize + sizeof (EFI_GUID))
+                   );
+    DataSize   = ReadUnaligned32 (
+                   (UINT32 *)(Header + NameSize + sizeof (EFI_GUID) +
+                              sizeof (UINT32))
+                   );
+    if (Name[NameSize / sizeof (CHAR16) - 1] != L'\0' ||
+        DataSize > Remaining - HeaderSize ||
+        (Attributes == 0 && DataSize != 0)) {
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+
+    OldEntry = NvVarsJournalFindEntry (Name, &VendorGuid);
+    if (Attributes == 0) {
+      if (OldEntry != NULL) {
+        RemoveEntryList (&OldEntry->Link);
+        FreePool (OldEntry);
+      }
+    } else {
+      Entry = NvVarsJournalNewEntry (
+                Name,
+                NameSize,
+                &VendorGuid,
+                Attributes,
+                DataSize,
+                NULL
+                );
+      if (Entry == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+      Status = NvVarsJournalReadFile (
+                 File,
+                 DataSize,
+                 NV_VARS_ENTRY_DATA (Entry)
+                 );
+      if (EFI_ERROR (Status)) {
+        FreePool (Entry);
+        break;
+      }
+      NvVarsJournalPutEntry (Entry, OldEntry);
+    }
+    Count++;
+  }
+
+  if (Header != NULL) {
+    FreePool (Header);
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "NvVarsJournal: read %Lu records from NV Variables file\n",
+    (UINT64)Count
+    ));
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_WARN,
+      "NvVarsJournal: bad record at offset %Lu - %r\n",
+      (UINT64)Offset,
+      Status
+      ));
+    return (Count == 0) ? Status : EFI_SUCCESS;
+  }
+
+  mNvVarsJournalFsHandle = FsHandle;
+  mNvVarsJournalFileSize = FileSize;
+  return EFI_SUCCESS;
+}
+
+/**
+  Set the variables of the snapshot.
+
+  @retval EFI_SUCCESS  The variables were set.
+  @return              The error of the first variable that could not be
+                       set.
+
+**/
+EFI_STATUS
+NvVarsJournalApply (
+  VOID
+  )
+{
+  EFI_STATUS          Status;
+  LIST_ENTRY          *Link;
+  NV_VARS_ENTRY       *Entry;
+  STATIC CONST UINT32 AuthMask =
+                        EFI_VARIABLE_AUTHENTICATED_WRITE_ACCESS |
+                        EFI_VARIABLE_TIME_BASED_AUTHENTICATED_WRITE_ACCESS;
+
+  for ( Link = GetFirstNode (&mNvVarsEntries)
+      ; !IsNull (&mNvVarsEntries, Link)
+      ; Link = GetNextNode (&mNvVarsEntries, Link)
+      ) {
+    Entry = NV_VARS_ENTRY_FROM_LINK (Link);
+    Status = gRT->SetVariable (
+                    NV_VARS_ENTRY_NAME (Entry),
+                    &Entry->VendorGuid,
+                    Entry->Attributes,
+                    Entry->DataSize,
+                    NV_VARS_ENTRY_DATA (Entry)
+                    );
+    if (Status == EFI_SECURITY_VIOLATION &&
+        (Entry->Attributes & AuthMask) != 0) {
+      DEBUG ((DEBUG_WARN, "%a: setting authenticated variable \"%s\" "
+              "failed with EFI_SECURITY_VIOLATION, ignoring\n", __FUNCTION__,
+              NV_VARS_ENTRY_NAME (Entry)));
+    } else if (Status == EFI_WRITE_PROTECTED) {
+      DEBUG ((DEBUG_WARN, "%a: setting ReadOnly variable \"%s\" "
+              "failed with EFI_WRITE_PROTECTED, ignoring\n", __FUNCTION__,
+              NV_VARS_ENTRY_NAME (Entry)));
+    } else if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+RETURN_STATUS
+EFIAPI
+IterateVariablesCallbackRefreshEntry (
+  IN  VOID                         *Context,
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid,
+  IN  UINT32                       Attributes,
+  IN  UINTN                        DataSize,
+  IN  VOID                         *Data
+  )
+{
+  NV_VARS_ENTRY  *OldEntry;
+  NV_VARS_ENTRY  *Entry;
+
+  //
+  // Only save non-volatile variables
+  //
+  if ((Attributes & EFI_VARIABLE_NON_VOLATILE) == 0) {
+    return RETURN_SUCCESS;
+  }
+
+  OldEntry = NvVarsJournalFindEntry (VariableName, VendorGuid);
+  if (OldEntry != NULL &&
+      OldEntry->Attributes == Attributes &&
+      OldEntry->DataSize == DataSize &&
+      CompareMem (NV_VARS_ENTRY_DATA (OldEntry), Data, DataSize) == 0) {
+    OldEntry->Seen = TRUE;
+    return RETURN_SUCCESS;
+  }
+
+  Entry = NvVarsJournalNewEntry (
+            VariableName,
+            (UINT32)StrSize (VariableName),
+            VendorGuid,
+            Attributes,
+            (UINT32)DataSize,
+            Data
+            );
+  if (Entry == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+  Entry->Seen  = TRUE;
+  Entry->Dirty = TRUE;
+  NvVarsJournalPutEntry (Entry, OldEntry);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Compare the non-volatile variables against the snapshot, and mark the
+  entries of the changed, new and deleted ones dirty.
+
+  @return  EFI_STATUS of iterating the variables.
+
+**/
+EFI_STATUS
+NvVarsJournalRefresh (
+  VOID
+  )
+{
+  EFI_STATUS     Status;
+  LIST_ENTRY     *Link;
+  NV_VARS_ENTRY  *Entry;
+
+  for ( Link = GetFirstNode (&mNvVarsEntries)
+      ; !IsNull (&mNvVarsEntries, Link)
+      ; Link = GetNextNode (&mNvVarsEntries, Link)
+      ) {
+    NV_VARS_ENTRY_FROM_LINK (Link)->Seen = FALSE;
+  }
+
+  Status = SerializeVariablesIterateSystemVariables (
+             IterateVariablesCallbackRefreshEntry,
+             NULL
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for ( Link = GetFirstNode (&mNvVarsEntries)
+      ; !IsNull (&mNvVarsEntries, Link)
+      ; Link = GetNextNode (&mNvVarsEntries, Link)
+      ) {
+    Entry = NV_VARS_ENTRY_FROM_LINK (Link);
+    if (!Entry->Seen) {
+      Entry->Attributes = 0;
+      Entry->DataSize   = 0;
+      Entry->Dirty      = TRUE;
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Return the size of the records of the snapshot.
+
+  @param[in]  DirtyOnly  TRUE: the records of the dirty entries, that is, of
+                         the changes since the last commit. FALSE: the
+                         records of all the variables that exist.
+
+  @return  The size in bytes.
+
+**/
+UINTN
+NvVarsJournalGetSize (
+  IN BOOLEAN  DirtyOnly
+  )
+{
+  LIST_ENTRY     *Link;
+  NV_VARS_ENTRY  *Entry;
+  UINTN          Size;
+
+  Size = 0;
+  for ( Link = GetFirstNode (&mNvVarsEntries)
+      ; !IsNull (&mNvVarsEntries, Link)
+      ; Link = GetNextNode (&mNvVarsEntries, Link)
+      ) {
+    Entry = NV_VARS_ENTRY_FROM_LINK (Link);
+    if (DirtyOnly ? Entry->Dirty : (Entry->Attributes != 0)) {
+      Size += NV_VARS_RECORD_SIZE (Entry);
+    }
+  }
+  return Size;
+}
+
+/**
+  Serialize the records of the snapshot to a new buffer.
+
+  @param[in]  DirtyOnly   As for NvVarsJournalGetSize().
+  @param[out] Buffer      The new buffer; the caller frees it.
+  @param[out] BufferSize  The size of Buffer in bytes.
+
+  @retval EFI_SUCCESS           The records were serialized.
+  @retval EFI_OUT_OF_RESOURCES  The buffer could not be allocated.
+
+**/
+EFI_STATUS
+NvVarsJournalSerialize (
+  IN  BOOLEAN  DirtyOnly,
+  OUT VOID     **Buffer,
+  OUT UINTN    *BufferSize
+  )
+{
+  LIST_ENTRY     *Link;
+  NV_VARS_ENTRY  *Entry;
+  UINT8          *Record;
+
+  *BufferSize = NvVarsJournalGetSize (DirtyOnly);
+  *Buffer = AllocatePool (*BufferSize);
+  if (*Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Record = *Buffer;
+  for ( Link = GetFirstNode (&mNvVarsEntries)
+      ; !IsNull (&mNvVarsEntries, Link)
+      ; Link = GetNextNode (&mNvVarsEntries, Link)
+      ) {
+    Entry = NV_VARS_ENTRY_FROM_LINK (Link);
+    if (DirtyOnly ? !Entry->Dirty : (Entry->Attributes == 0)) {
+      continue;
+    }
+
+    WriteUnaligned32 ((UINT32 *)Record, Entry->NameSize);
+    Record += sizeof (UINT32);
+    CopyMem (Record, NV_VARS_ENTRY_NAME (Entry), Entry->NameSize);
+    Record += Entry->NameSize;
+    CopyGuid ((EFI_GUID *)Record, &Entry->VendorGuid);
+    Record += sizeof (EFI_GUID);
+    WriteUnaligned32 ((UINT32 *)Record, Entry->Attributes);
+    Record += sizeof (UINT32);
+    WriteUnaligned32 ((UINT32 *)Record, Entry->DataSize);
+    Record += sizeof (UINT32);
+    CopyMem (Record, NV_VARS_ENTRY_DATA (Entry), Entry->DataSize);
+    Record += Entry->DataSize;
+  }
+
+  ASSERT (Record == (UINT8 *)*Buffer + *BufferSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Record that the NvVars file now holds the snapshot: the dirty records were
+  written, so the entries are clean, and the deleted ones are dropped.
+
+  @param[in]  FsHandle  The file system the file is on.
+  @param[in]  FileSize  The new size of the file in bytes.
+
+**/
+VOID
+NvVarsJournalCommit (
+  IN EFI_HANDLE  FsHandle,
+  IN UINTN       FileSize
+  )
+{
+  LIST_ENTRY     *Link;
+  LIST_ENTRY     *NextLink;
+  NV_VARS_ENTRY  *Entry;
+
+  for ( Link = GetFirstNode (&mNvVarsEntries)
+      ; !IsNull (&mNvVarsEntries, Link)
+      ; Link = NextLink
+      ) {
+    NextLink = GetNextNode (&mNvVarsEntries, Link);
+    Entry = NV_VARS_ENTRY_FROM_LINK (Link);
+    if (Entry->Attributes == 0) {
+      RemoveEntryList (&Entry->Link);
+      FreePool (Entry);
+    } else {
+      Entry->Dirty = FALSE;
+    }
+  }
+
+  mNvVarsJournalFsHandle = FsHandle;
+  mNvVarsJournalFileSize = FileSize;
+}
+
+/**
+  Record that the NvVars file is in an unknown state, after a failed write,
+  so that the next save rewrites it.
+
+**/
+VOID
+NvVarsJournalInvalidate (
+  VOID
+  )
+{
+  mNvVarsJournalFsHandle = NULL;
+}
+
+/**
+  Check whether the snapshot describes the NvVars file on a file system.
+
+  @param[in]  FsHandle  The file system.
+  @param[out] FileSize  The size of the file the snapshot describes.
+
+  @retval TRUE   Changes to the snapshot can be appended to the file.
+  @retval FALSE  The file must be rewritten.
+
+**/
+BOOLEAN
+NvVarsJournalMatchesFile (
+  IN  EFI_HANDLE  FsHandle,
+  OUT UINTN       *FileSize
+  )
+{
+  *FileSize = mNvVarsJournalFileSize;
+  return (BOOLEAN)(FsHandle != NULL && FsHandle == mNvVarsJournalFsHandle);
+}
@@ -10,6 +10,8 @@
 #include <Guid/RootBridgesConnectedEventGroup.h>
 #include <Protocol/FirmwareVolume2.h>
 #include <Library/PlatformBmPrintScLib.h>
+#include <Library/QemuFwCfgSimpleParserLib.h>
+#include <Library/TimerLib.h>
 #include <Library/Tcg2PhysicalPresenceLib.h>
 #include <Library/XenPlatformLib.h>
 #include <Library/Darwin/AppleSupportLib.h>
@@ -25,6 +27,12 @@ VOID          *mEmuVariableEventReg;
 EFI_EVENT     mEmuVariableEvent;
 UINT16        mHostBridgeDevId;
 
+//
+// TRUE if PlatformBdsConnectSequence() connected only the boot device, and
+// PlatformBootManagerUnableToBoot() has yet to connect everything else.
+//
+BOOLEAN       mFastConnectPending;
+
 //
 // Table of host IRQs matching PCI IRQs A-D
 // (for configuring PCI Interrupt Line register)
@@ -1389,6 +1397,149 @@ PlatformBdsRestoreNvVarsFromHardDisk (
 
 }
 
+/**
+  Connect all devices, and log how long that took.
+**/
+STATIC
+VOID
+PlatformBdsConnectAll (
+  VOID
+  )
+{
+  UINT64 Start;
+
+  DEBUG ((DEBUG_INFO, "EfiBootManagerConnectAll\n"));
+  Start = GetPerformanceCounter ();
+  EfiBootManagerConnectAll ();
+  DEBUG ((DEBUG_INFO, "%a: took %Lu us\n", __FUNCTION__,
+    DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter () - Start), 1000)));
+}
+
+/**
+  Check whether the fast connect policy is enabled: by PcdBdsFastConnect,
+  unless the fw_cfg file "opt/org.tianocore/FastConnect" says otherwise.
+
+  @retval TRUE   Connect only the boot device first.
+  @retval FALSE  Connect all devices.
+**/
+STATIC
+BOOLEAN
+PlatformBdsFastConnectEnabled (
+  VOID
+  )
+{
+  BOOLEAN Enabled;
+
+  Enabled = FeaturePcdGet (PcdBdsFastConnect);
+  QemuFwCfgParseBool ("opt/org.tianocore/FastConnect", &Enabled);
+  return Enabled;
+}
+
+/**
+  Return the full device path of the device most likely to boot: the one
+  macOS recorded in efi-boot-device-data, or else the one of the first active
+  boot option, if it starts at a PCI root bridge.
+
+  @return  The device path, to be freed with FreePool(), or NULL if there is
+           no suitable device path.
+**/
+STATIC
+EFI_DEVICE_PATH_PROTOCOL *
+PlatformBdsGetBootDevicePath (
+  VOID
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL     *DevicePath;
+  UINTN                        Size;
+  EFI_BOOT_MANAGER_LOAD_OPTION *BootOptions;
+  UINTN                        BootOptionCount;
+  UINTN                        Index;
+  EFI_STATUS                   Status;
+
+  Status = GetVariable2 (L"efi-boot-device-data", &gAppleNVRAMVariableGuid,
+             (VOID **)&DevicePath, &Size);
+  if (!EFI_ERROR (Status)) {
+    if (IsDevicePathValid (DevicePath, Size) &&
+        DevicePathType (DevicePath) == ACPI_DEVICE_PATH) {
+      return DevicePath;
+    }
+    FreePool (DevicePath);
+  }
+
+  DevicePath = NULL;
+  BootOptions = EfiBootManagerGetLoadOptions (&BootOptionCount,
+                  LoadOptionTypeBoot);
+  for (Index = 0; Index < BootOptionCount; Index++) {
+    if ((BootOptions[Index].Attributes & LOAD_OPTION_ACTIVE) == 0 ||
+        (BootOptions[Index].Attributes & LOAD_OPTION_CATEGORY) !=
+        LOAD_OPTION_CATEGORY_BOOT) {
+      continue;
+    }
+    //
+    // Options in firmware volumes need no device, and short-form device
+    // paths are only expanded by connecting everything.
+    //
+    if (DevicePathType (BootOptions[Index].FilePath) == ACPI_DEVICE_PATH) {
+      DevicePath = DuplicateDevicePath (BootOptions[Index].FilePath);
+    }
+    break;
+  }
+  EfiBootManagerFreeLoadOptions (BootOptions, BootOptionCount);
+  return DevicePath;
+}
+
+/**
+  Connect only the device most likely to boot, up to its file system, and log
+  how long that took.
+
+  @retval TRUE   The device has been connected.
+  @retval FALSE  There is no such device, or it could not be connected.
+**/
+STATIC
+BOOLEAN
+PlatformBdsConnectBootDevice (
+  VOID
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL *DevicePath;
+  EFI_DEVICE_PATH_PROTOCOL *Node;
+  CHAR16                   *DevicePathText;
+  UINT64                   Start;
+  EFI_STATUS               Status;
+
+  DevicePath = PlatformBdsGetBootDevicePath ();
+  if (DevicePath == NULL) {
+    return FALSE;
+  }
+
+  //
+  // Boot option paths end in the file to load, which no driver produces a
+  // handle for; connecting the whole path would dispatch and fail on it.
+  // Connect up to the file system that holds the file.
+  //
+  for (Node = DevicePath; !IsDevicePathEnd (Node);
+       Node = NextDevicePathNode (Node)) {
+    if (DevicePathType (Node) == MEDIA_DEVICE_PATH &&
+        DevicePathSubType (Node) == MEDIA_FILEPATH_DP) {
+      SetDevicePathEndNode (Node);
+      break;
+    }
+  }
+
+  DevicePathText = ConvertDevicePathToText (DevicePath, FALSE, FALSE);
+  Start = GetPerformanceCounter ();
+  Status = EfiBootManagerConnectDevicePath (DevicePath, NULL);
+  DEBUG ((DEBUG_INFO, "%a: %s: %r, took %Lu us\n", __FUNCTION__,
+    DevicePathText == NULL ? L"<device path>" : DevicePathText, Status,
+    DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter () - Start), 1000)));
+
+  if (DevicePathText != NULL) {
+    FreePool (DevicePathText);
+  }
+  FreePool (DevicePath);
+  return (BOOLEAN)!EFI_ERROR (Status);
+}
+
 /**
   Connect with predefined platform connect sequence.
 
@@ -1422,10 +1573,15 @@ PlatformBdsConnectSequence (
   Status = ConnectDevicesFromQemu ();
   if (RETURN_ERROR (Status)) {
     //
-    // Just use the simple policy to connect all devices
+    // Connect only the boot device if we can, and everything else only if
+    // it fails to boot. Otherwise, use the simple policy to connect all
+    // devices.
     //
-    DEBUG ((DEBUG_INFO, "EfiBootManagerConnectAll\n"));
-    EfiBootManagerConnectAll ();
+    if (PlatformBdsFastConnectEnabled () && PlatformBdsConnectBootDevice ()) {
+      mFastConnectPending = TRUE;
+    } else {
+      PlatformBdsConnectAll ();
+    }
   }
 }
 
@@ -1532,7 +1688,13 @@ PlatformBootManagerAfterConsole (
   //
   PlatformBdsConnectSequence ();
 
-  EfiBootManagerRefreshAllBootOption ();
+  //
+  // Refreshing the boot options with only the boot device connected would
+  // remove the options of all other devices.
+  //
+  if (!mFastConnectPending) {
+    EfiBootManagerRefreshAllBootOption ();
+  }
 
   //
   // Register UEFI Shell
@@ -1705,6 +1867,8 @@ PlatformBootManagerUnableToBoot (
   EFI_INPUT_KEY                Key;
   EFI_BOOT_MANAGER_LOAD_OPTION BootManagerMenu;
   UINTN                        Index;
+  EFI_BOOT_MANAGER_LOAD_OPTION *BootOptions;
+  UINTN                        BootOptionCount;
 
   //
   // BootManagerMenu doesn't contain the correct information when return status
@@ -1714,6 +1878,29 @@ PlatformBootManagerUnableToBoot (
   if (EFI_ERROR (Status)) {
     return;
   }
+
+  //
+  // If only the boot device has been connected, connect everything else,
+  // and try the boot options again, before giving up.
+  //
+  if (mFastConnectPending) {
+    mFastConnectPending = FALSE;
+    PlatformBdsConnectAll ();
+    EfiBootManagerRefreshAllBootOption ();
+
+    BootOptions = EfiBootManagerGetLoadOptions (&BootOptionCount,
+                    LoadOptionTypeBoot);
+    for (Index = 0; Index < BootOptionCount; Index++) {
+      if ((BootOptions[Index].Attributes & LOAD_OPTION_ACTIVE) == 0 ||
+          (BootOptions[Index].Attributes & LOAD_OPTION_CATEGORY) !=
+          LOAD_OPTION_CATEGORY_BOOT ||
+          BootOptions[Index].OptionNumber == BootManagerMenu.OptionNumber) {
+        continue;
+      }
+      EfiBootManagerBoot (&BootOptions[Index]);
+    }
+    EfiBootManagerFreeLoadOptions (BootOptions, BootOptionCount);
+  }
   //
   // Normally BdsDxe does not print anything to the system console, but this is
   // a last resort -- the end-user will likely not see any DEBUG messages
@@ -11,12 +11,11 @@
 #include <Base.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseLib.h>
-#include <Library/IoLib.h>
 #include <Library/PrintLib.h>
 #include <Library/PcdLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugPrintErrorLevelLib.h>
-#include "DebugLibDetect.h"
+#include "DebugLibOutput.h"
 
 //
 // Define the maximum debug and assert message length that this library supports
@@ -94,10 +93,10 @@ DebugPrintMarker (
   ASSERT (Format != NULL);
 
   //
-  // Check if the global mask disables this message or the device is inactive
+  // Check if the global mask disables this message or the output is inactive
   //
   if ((ErrorLevel & GetDebugPrintErrorLevel ()) == 0 ||
-      !PlatformDebugLibIoPortFound ()) {
+      !PlatformDebugLibOutputAvailable ()) {
     return;
   }
 
@@ -111,9 +110,9 @@ DebugPrintMarker (
   }
 
   //
-  // Send the print string to the debug I/O port
+  // Send the print string to the debug output
   //
-  IoWriteFifo8 (PcdGet16 (PcdDebugIoPort), Length, Buffer);
+  PlatformDebugLibOutputWrite (Buffer, Length);
 }
 
 
@@ -212,11 +211,11 @@ DebugAssert (
              FileName, (UINT64)LineNumber, Description);
 
   //
-  // Send the print string to the debug I/O port, if present
+  // Send the print string to the debug output, together with anything that
+  // is still buffered, before a breakpoint or dead loop can stop us
   //
-  if (PlatformDebugLibIoPortFound ()) {
-    IoWriteFifo8 (PcdGet16 (PcdDebugIoPort), Length, Buffer);
-  }
+  PlatformDebugLibOutputWrite (Buffer, Length);
+  PlatformDebugLibOutputFlush ();
 
   //
   // Generate a Breakpoint, DeadLoop, or NOP based on PCD settings
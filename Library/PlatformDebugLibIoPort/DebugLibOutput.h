@@ -0,0 +1,52 @@
+/** @file
+  Output back-ends of the debug library instances for the hypervisor debug
+  port: either the I/O port itself, or the debug log ring in front of it.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __DEBUG_LIB_OUTPUT_H__
+#define __DEBUG_LIB_OUTPUT_H__
+
+#include <Base.h>
+
+/**
+  Return whether debug messages have anywhere to go. DebugLib.c checks this
+  before formatting a message.
+
+  @retval TRUE   if PlatformDebugLibOutputWrite() stores or sends messages.
+  @retval FALSE  otherwise
+
+**/
+BOOLEAN
+PlatformDebugLibOutputAvailable (
+  VOID
+  );
+
+/**
+  Send a formatted message to the debug output.
+
+  @param[in] Buffer  The message. It need not be NUL-terminated.
+  @param[in] Length  The number of bytes in Buffer.
+
+**/
+VOID
+PlatformDebugLibOutputWrite (
+  IN CONST CHAR8 *Buffer,
+  IN UINTN       Length
+  );
+
+/**
+  Send whatever earlier calls to PlatformDebugLibOutputWrite() have buffered
+  to the debug I/O port, and wait until it is out.
+
+**/
+VOID
+PlatformDebugLibOutputFlush (
+  VOID
+  );
+
+#endif
@@ -0,0 +1,58 @@
+/** @file
+  Debug output straight to the hypervisor debug port, one message at a time.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/IoLib.h>
+#include <Library/PcdLib.h>
+#include "DebugLibDetect.h"
+#include "DebugLibOutput.h"
+
+/**
+  Return whether debug messages have anywhere to go.
+
+  @retval TRUE   if the debug I/O port device was detected.
+  @retval FALSE  otherwise
+
+**/
+BOOLEAN
+PlatformDebugLibOutputAvailable (
+  VOID
+  )
+{
+  return PlatformDebugLibIoPortFound ();
+}
+
+/**
+  Send a formatted message to the debug I/O port, if present.
+
+  @param[in] Buffer  The message. It need not be NUL-terminated.
+  @param[in] Length  The number of bytes in Buffer.
+
+**/
+VOID
+PlatformDebugLibOutputWrite (
+  IN CONST CHAR8 *Buffer,
+  IN UINTN       Length
+  )
+{
+  if (PlatformDebugLibIoPortFound ()) {
+    IoWriteFifo8 (PcdGet16 (PcdDebugIoPort), Length, (VOID *)Buffer);
+  }
+}
+
+/**
+  Nothing is buffered, so there is nothing to flush.
+
+**/
+VOID
+PlatformDebugLibOutputFlush (
+  VOID
+  )
+{
+}
@@ -0,0 +1,357 @@
+/** @file
+  Debug output through the debug log ring (see <Guid/DebugLogRing.h>).
+
+  DEBUG() only appends the message to the ring; the port I/O (a #VC exit per
+  byte under SEV-ES) happens in bursts from a periodic TPL_CALLBACK timer, so
+  it runs when the TPL drops rather than inside every DEBUG(). The ring is
+  owned by the one module built with PcdDebugLogRingOwner set to TRUE, which
+  must never be unloaded, since the timer and ExitBootServices() callbacks
+  live in it. Every other module finds the ring in the configuration table,
+  and writes straight to the port until the ring exists.
+
+  The ring is protected by disabling interrupts, which serializes the BSP
+  only. DEBUG() from APs was never serialized against the BSP either.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Guid/DebugLogRing.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/IoLib.h>
+#include <Library/PcdLib.h>
+#include "DebugLibDetect.h"
+#include "DebugLibOutput.h"
+
+//
+// The most bytes sent to the port with interrupts disabled.
+//
+#define DEBUG_LOG_RING_BURST         SIZE_4KB
+
+//
+// The drain timer period, in 100ns units (10ms).
+//
+#define DEBUG_LOG_RING_DRAIN_PERIOD  100000
+
+STATIC EFI_SYSTEM_TABLE *mDebugLogRingSystemTable;
+STATIC DEBUG_LOG_RING   *mDebugLogRing;
+
+/**
+  Return the debug log ring, looking it up in the configuration table until
+  it is found.
+
+  @return  The ring, or NULL if it does not exist (yet).
+
+**/
+STATIC
+DEBUG_LOG_RING *
+DebugLogRingGet (
+  VOID
+  )
+{
+  EFI_CONFIGURATION_TABLE *Table;
+  UINTN                   Index;
+
+  if (mDebugLogRing == NULL && mDebugLogRingSystemTable != NULL) {
+    Table = mDebugLogRingSystemTable->ConfigurationTable;
+    for (Index = 0;
+         Index < mDebugLogRingSystemTable->NumberOfTableEntries;
+         Index++) {
+      if (CompareGuid (&Table[Index].VendorGuid, &gOvmfDebugLogRingGuid)) {
+        mDebugLogRing = Table[Index].VendorTable;
+        break;
+      }
+    }
+  }
+  return mDebugLogRing;
+}
+
+/**
+  Send the oldest pending bytes of the ring to the debug I/O port, or drop
+  them from the pending range if there is no port. Interrupts must be
+  disabled.
+
+  @param[in,out] Ring    The debug log ring.
+  @param[in]     Length  The number of bytes to send; at most Head - Tail.
+
+**/
+STATIC
+VOID
+DebugLogRingSend (
+  IN OUT DEBUG_LOG_RING *Ring,
+  IN     UINT64         Length
+  )
+{
+  UINT8 *Data;
+  UINTN Offset;
+  UINTN Chunk;
+
+  Data = (UINT8 *)(Ring + 1);
+  while (Length > 0) {
+    Offset = (UINTN)Ring->Tail & (Ring->Size - 1);
+    Chunk  = (UINTN)MIN (Length, Ring->Size - Offset);
+    if (PlatformDebugLibIoPortFound ()) {
+      IoWriteFifo8 (PcdGet16 (PcdDebugIoPort), Chunk, Data + Offset);
+    }
+    Ring->Tail += Chunk;
+    Length     -= Chunk;
+  }
+}
+
+/**
+  Send all pending bytes of the ring to the debug I/O port, in bursts of
+  DEBUG_LOG_RING_BURST bytes, enabling interrupts between the bursts.
+
+  @param[in,out] Ring  The debug log ring.
+
+**/
+STATIC
+VOID
+DebugLogRingDrain (
+  IN OUT DEBUG_LOG_RING *Ring
+  )
+{
+  BOOLEAN InterruptState;
+  UINT64  Pending;
+
+  do {
+    InterruptState = SaveAndDisableInterrupts ();
+    Pending = Ring->Head - Ring->Tail;
+    DebugLogRingSend (Ring, MIN (Pending, DEBUG_LOG_RING_BURST));
+    SetInterruptState (InterruptState);
+  } while (Pending > DEBUG_LOG_RING_BURST);
+}
+
+/**
+  Periodic timer callback: drain the ring.
+
+  @param[in] Event    The drain timer event.
+  @param[in] Context  The debug log ring.
+
+**/
+STATIC
+VOID
+EFIAPI
+DebugLogRingDrainNotify (
+  IN EFI_EVENT Event,
+  IN VOID      *Context
+  )
+{
+  DebugLogRingDrain (Context);
+}
+
+/**
+  ExitBootServices() callback: drain the ring, and have later messages sent
+  to the port immediately, as the drain timer will not fire any longer.
+
+  @param[in] Event    The ExitBootServices() event.
+  @param[in] Context  The debug log ring.
+
+**/
+STATIC
+VOID
+EFIAPI
+DebugLogRingExitBootServices (
+  IN EFI_EVENT Event,
+  IN VOID      *Context
+  )
+{
+  DEBUG_LOG_RING *Ring;
+
+  Ring = Context;
+  Ring->Bypass = 1;
+  DebugLogRingDrain (Ring);
+}
+
+/**
+  Allocate the debug log ring, start its drain timer, and install it as a
+  configuration table. Failures leave the debug output unbuffered.
+
+  @param[in] SystemTable  The UEFI system table.
+
+**/
+STATIC
+VOID
+DebugLogRingCreate (
+  IN EFI_SYSTEM_TABLE *SystemTable
+  )
+{
+  EFI_BOOT_SERVICES    *BootServices;
+  UINT32               Size;
+  UINTN                Pages;
+  EFI_PHYSICAL_ADDRESS Address;
+  DEBUG_LOG_RING       *Ring;
+  EFI_EVENT            DrainEvent;
+  EFI_EVENT            ExitBootEvent;
+  EFI_STATUS           Status;
+
+  Size = GetPowerOfTwo32 (FixedPcdGet32 (PcdDebugLogRingSize));
+  if (!DebugPrintEnabled () || Size < DEBUG_LOG_RING_BURST) {
+    return;
+  }
+
+  BootServices = SystemTable->BootServices;
+  Pages = EFI_SIZE_TO_PAGES (sizeof *Ring + Size);
+  Status = BootServices->AllocatePages (AllocateAnyPages,
+                           EfiReservedMemoryType, Pages, &Address);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+  Ring = (DEBUG_LOG_RING *)(UINTN)Address;
+  ZeroMem (Ring, sizeof *Ring);
+  Ring->Signature = DEBUG_LOG_RING_SIGNATURE;
+  Ring->Size      = Size;
+
+  Status = BootServices->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                           TPL_CALLBACK, DebugLogRingDrainNotify, Ring,
+                           &DrainEvent);
+  if (EFI_ERROR (Status)) {
+    goto FreeRing;
+  }
+  Status = BootServices->SetTimer (DrainEvent, TimerPeriodic,
+                           DEBUG_LOG_RING_DRAIN_PERIOD);
+  if (EFI_ERROR (Status)) {
+    goto CloseDrainEvent;
+  }
+
+  Status = BootServices->CreateEvent (EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                           TPL_CALLBACK, DebugLogRingExitBootServices, Ring,
+                           &ExitBootEvent);
+  if (EFI_ERROR (Status)) {
+    goto CloseDrainEvent;
+  }
+
+  Status = BootServices->InstallConfigurationTable (&gOvmfDebugLogRingGuid,
+                           Ring);
+  if (EFI_ERROR (Status)) {
+    goto CloseExitBootEvent;
+  }
+
+  mDebugLogRing = Ring;
+  return;
+
+CloseExitBootEvent:
+  BootServices->CloseEvent (ExitBootEvent);
+
+CloseDrainEvent:
+  BootServices->CloseEvent (DrainEvent);
+
+FreeRing:
+  BootServices->FreePages (Address, Pages);
+}
+
+/**
+  Remember the system table, for looking up the ring later, and create the
+  ring in the owner module.
+
+  As with PlatformDebugLibIoPortConstructor(), the DXE Core calls DEBUG()
+  before it runs this constructor; until then, messages go straight to the
+  debug I/O port.
+
+  @param[in] ImageHandle  The image handle of the module.
+  @param[in] SystemTable  The UEFI system table.
+
+  @retval EFI_SUCCESS  The constructor always returns EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+PlatformDebugLibIoPortRingConstructor (
+  IN EFI_HANDLE       ImageHandle,
+  IN EFI_SYSTEM_TABLE *SystemTable
+  )
+{
+  mDebugLogRingSystemTable = SystemTable;
+  if (FeaturePcdGet (PcdDebugLogRingOwner) && DebugLogRingGet () == NULL) {
+    DebugLogRingCreate (SystemTable);
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Return whether debug messages have anywhere to go. The ring keeps them for
+  retrieval after boot even if there is no debug I/O port.
+
+  @retval TRUE   if the ring exists, or the debug I/O port was detected.
+  @retval FALSE  otherwise
+
+**/
+BOOLEAN
+PlatformDebugLibOutputAvailable (
+  VOID
+  )
+{
+  return DebugLogRingGet () != NULL || PlatformDebugLibIoPortFound ();
+}
+
+/**
+  Append a formatted message to the ring. If the ring is full, make room by
+  sending its oldest pending bytes to the port first.
+
+  @param[in] Buffer  The message. It need not be NUL-terminated.
+  @param[in] Length  The number of bytes in Buffer.
+
+**/
+VOID
+PlatformDebugLibOutputWrite (
+  IN CONST CHAR8 *Buffer,
+  IN UINTN       Length
+  )
+{
+  DEBUG_LOG_RING *Ring;
+  UINT8          *Data;
+  BOOLEAN        InterruptState;
+  UINT64         Used;
+  UINTN          Offset;
+  UINTN          Chunk;
+
+  Ring = DebugLogRingGet ();
+  if (Ring == NULL) {
+    if (PlatformDebugLibIoPortFound ()) {
+      IoWriteFifo8 (PcdGet16 (PcdDebugIoPort), Length, (VOID *)Buffer);
+    }
+    return;
+  }
+
+  Data = (UINT8 *)(Ring + 1);
+  InterruptState = SaveAndDisableInterrupts ();
+
+  Used = Ring->Head - Ring->Tail;
+  if (Used + Length > Ring->Size) {
+    DebugLogRingSend (Ring, Used + Length - Ring->Size);
+  }
+
+  Offset = (UINTN)Ring->Head & (Ring->Size - 1);
+  Chunk  = MIN (Length, Ring->Size - Offset);
+  CopyMem (Data + Offset, Buffer, Chunk);
+  CopyMem (Data, Buffer + Chunk, Length - Chunk);
+  Ring->Head += Length;
+
+  if (Ring->Bypass != 0) {
+    DebugLogRingSend (Ring, Ring->Head - Ring->Tail);
+  }
+
+  SetInterruptState (InterruptState);
+}
+
+/**
+  Send everything the ring holds for the port, and wait until it is out.
+
+**/
+VOID
+PlatformDebugLibOutputFlush (
+  VOID
+  )
+{
+  DEBUG_LOG_RING *Ring;
+
+  Ring = DebugLogRingGet ();
+  if (Ring != NULL) {
+    DebugLogRingDrain (Ring);
+  }
+}
@@ -18,6 +18,7 @@
 #include <Library/DevicePathLib.h>
 #include <Library/QemuBootOrderLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/OrderedCollectionLib.h>
 #include <Guid/GlobalVariable.h>
 #include <Guid/VirtioMmioTransport.h>
 
@@ -251,9 +252,22 @@ typedef struct {
                                                   //   ownership
   BOOLEAN                            Appended;    // has been added to a
                                                   //   BOOT_ORDER?
+  CHAR16                             *Converted;  // textual device path,
+                                                  //   expanded if short-form;
+                                                  //   NULL if not indexed
 } ACTIVE_OPTION;
 
 
+/**
+  A translated OpenFirmware path, looked up as a prefix in the index of
+  active boot options.
+**/
+typedef struct {
+  CONST CHAR16 *Translated;
+  UINTN        TranslatedLength; // in CHAR16's
+} TRANSLATED_PREFIX;
+
+
 /**
 
   Append an active boot option to BootOrder, reallocating the latter if needed.
@@ -353,6 +367,7 @@ CollectActiveOptions (
         if (ScanMode == 1) {
           (*ActiveOption)[*Count].BootOption = &BootOptions[Index];
           (*ActiveOption)[*Count].Appended   = FALSE;
+          (*ActiveOption)[*Count].Converted  = NULL;
         }
         ++*Count;
       }
@@ -1599,37 +1614,25 @@ FreeFwCfg:
 
 /**
 
-  Convert the UEFI DevicePath to full text representation with DevPathToText,
-  then match the UEFI device path fragment in Translated against it.
-
-  @param[in] Translated        UEFI device path fragment, translated from
-                               OpenFirmware format, to search for.
-
-  @param[in] TranslatedLength  The length of Translated in CHAR16's.
-
-  @param[in] DevicePath        Boot option device path whose textual rendering
-                               to search in.
-
-  @param[in] DevPathToText  Binary-to-text conversion protocol for DevicePath.
+  Convert a boot option device path to full text representation, for prefix
+  matching against translated OpenFirmware paths. Short-form device paths are
+  expanded to absolute ones first.
 
+  @param[in] DevicePath  Boot option device path to convert.
 
-  @retval TRUE   If Translated was found at the beginning of DevicePath after
-                 converting the latter to text.
 
-  @retval FALSE  If DevicePath was NULL, or it could not be converted, or there
-                 was no match.
+  @return  The textual device path, which the caller is responsible for
+           freeing with FreePool(). NULL if DevicePath could not be expanded or
+           converted.
 
 **/
 STATIC
-BOOLEAN
-Match (
-  IN  CONST CHAR16                           *Translated,
-  IN  UINTN                                  TranslatedLength,
+CHAR16 *
+ConvertBootOptionPath (
   IN  EFI_DEVICE_PATH_PROTOCOL               *DevicePath
   )
 {
   CHAR16                   *Converted;
-  BOOLEAN                  Result;
   VOID                     *FileBuffer;
   UINTN                    FileSize;
   EFI_DEVICE_PATH_PROTOCOL *AbsDevicePath;
@@ -1643,10 +1646,9 @@ Match (
                 FALSE  // AllowShortcuts
                 );
   if (Converted == NULL) {
-    return FALSE;
+    return NULL;
   }
 
-  Result = FALSE;
   Shortform = FALSE;
   //
   // Expand the short-form device path to full device path
@@ -1692,13 +1694,15 @@ Match (
                    DevicePath, &AbsDevicePath, &FileSize
                    );
     if (FileBuffer == NULL) {
-      goto Exit;
+      FreePool (Converted);
+      return NULL;
     }
     FreePool (FileBuffer);
     AbsConverted = ConvertDevicePathToText (AbsDevicePath, FALSE, FALSE);
     FreePool (AbsDevicePath);
     if (AbsConverted == NULL) {
-      goto Exit;
+      FreePool (Converted);
+      return NULL;
     }
     DEBUG ((DEBUG_VERBOSE,
       "%a: expanded relative device path \"%s\" for prefix matching\n",
@@ -1707,20 +1711,286 @@ Match (
     Converted = AbsConverted;
   }
 
+  return Converted;
+}
+
+
+/**
+  An ORDERED_COLLECTION_USER_COMPARE function that orders active boot options
+  by their textual device paths. Options with equal device paths are ordered
+  by their positions in the ACTIVE_OPTION array.
+
+  @param[in] UserStruct1  Pointer to the first ACTIVE_OPTION.
+
+  @param[in] UserStruct2  Pointer to the second ACTIVE_OPTION.
+
+  @retval <0  If UserStruct1 compares less than UserStruct2.
+
+  @retval  0  If UserStruct1 compares equal to UserStruct2.
+
+  @retval >0  If UserStruct1 compares greater than UserStruct2.
+**/
+STATIC
+INTN
+EFIAPI
+ActiveOptionCompare (
+  IN CONST VOID *UserStruct1,
+  IN CONST VOID *UserStruct2
+  )
+{
+  CONST ACTIVE_OPTION *Option1;
+  CONST ACTIVE_OPTION *Option2;
+  INTN                Result;
+
+  Option1 = UserStruct1;
+  Option2 = UserStruct2;
+
+  Result = StrCmp (Option1->Converted, Option2->Converted);
+  if (Result != 0) {
+    return Result;
+  }
+  return Option1 < Option2 ? -1 :
+         Option1 > Option2 ?  1 :
+         0;
+}
+
+
+/**
+  An ORDERED_COLLECTION_KEY_COMPARE function that compares a translated
+  OpenFirmware path against the beginning of the textual device path of an
+  active boot option.
+
+  All the active boot options whose textual device paths start with the
+  translated path compare equal to it, and they are adjacent in the order
+  established by ActiveOptionCompare().
+
+  @param[in] StandaloneKey  Pointer to the TRANSLATED_PREFIX.
+
+  @param[in] UserStruct     Pointer to the ACTIVE_OPTION.
+
+  @retval <0  If StandaloneKey compares less than UserStruct's key.
+
+  @retval  0  If UserStruct's textual device path starts with StandaloneKey.
+
+  @retval >0  If StandaloneKey compares greater than UserStruct's key.
+**/
+STATIC
+INTN
+EFIAPI
+ActiveOptionKeyCompare (
+  IN CONST VOID *StandaloneKey,
+  IN CONST VOID *UserStruct
+  )
+{
+  CONST TRANSLATED_PREFIX *Prefix;
+  CONST ACTIVE_OPTION     *Option;
+
+  Prefix = StandaloneKey;
+  Option = UserStruct;
+
+  return StrnCmp (Prefix->Translated, Option->Converted,
+           Prefix->TranslatedLength);
+}
+
+
+/**
+  Release the index created with CreateActiveOptionIndex(), and the textual
+  device paths of the active boot options.
+
+  @param[in]     Index         The index to release. May be NULL.
+
+  @param[in,out] ActiveOption  The array of active boot options that has been
+                               indexed.
+
+  @param[in]     ActiveCount   Number of elements in ActiveOption.
+**/
+STATIC
+VOID
+DestroyActiveOptionIndex (
+  IN      ORDERED_COLLECTION *Index        OPTIONAL,
+  IN OUT  ACTIVE_OPTION      *ActiveOption,
+  IN      UINTN              ActiveCount
+  )
+{
+  ORDERED_COLLECTION_ENTRY *Entry;
+  ORDERED_COLLECTION_ENTRY *Entry2;
+  UINTN                    Idx;
+
+  if (Index != NULL) {
+    for (Entry = OrderedCollectionMin (Index); Entry != NULL;
+         Entry = Entry2) {
+      Entry2 = OrderedCollectionNext (Entry);
+      OrderedCollectionDelete (Index, Entry, NULL);
+    }
+    OrderedCollectionUninit (Index);
+  }
+
+  for (Idx = 0; Idx < ActiveCount; ++Idx) {
+    if (ActiveOption[Idx].Converted != NULL) {
+      FreePool (ActiveOption[Idx].Converted);
+      ActiveOption[Idx].Converted = NULL;
+    }
+  }
+}
+
+
+/**
+  Index the active boot options by their textual device paths, converting
+  each device path only once.
+
+  @param[in,out] ActiveOption  The array of active boot options to index. The
+                               Converted field of each element is set; the
+                               caller is responsible for releasing it with
+                               DestroyActiveOptionIndex().
+
+  @param[in]     ActiveCount   Number of elements in ActiveOption.
+
+  @param[out]    Index         The new index, an ordered collection of those
+                               elements of ActiveOption whose device paths
+                               could be converted.
+
+
+  @retval RETURN_SUCCESS           The index has been created.
+
+  @retval RETURN_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+STATIC
+RETURN_STATUS
+CreateActiveOptionIndex (
+  IN OUT  ACTIVE_OPTION      *ActiveOption,
+  IN      UINTN              ActiveCount,
+  OUT     ORDERED_COLLECTION **Index
+  )
+{
+  RETURN_STATUS      Status;
+  ORDERED_COLLECTION *Collection;
+  UINTN              Idx;
+
+  Collection = OrderedCollectionInit (ActiveOptionCompare,
+                 ActiveOptionKeyCompare);
+  if (Collection == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  for (Idx = 0; Idx < ActiveCount; ++Idx) {
+    ActiveOption[Idx].Converted = ConvertBootOptionPath (
+                                    ActiveOption[Idx].BootOption->FilePath
+                                    );
+    if (ActiveOption[Idx].Converted == NULL) {
+      continue;
+    }
+    DEBUG ((DEBUG_VERBOSE, "%a: indexing \"%s\"\n", __FUNCTION__,
+      ActiveOption[Idx].Converted));
+
+    Status = OrderedCollectionInsert (Collection, NULL, &ActiveOption[Idx]);
+    if (RETURN_ERROR (Status)) {
+      *Index = Collection;
+      DestroyActiveOptionIndex (Collection, ActiveOption, ActiveCount);
+      return Status;
+    }
+  }
+
+  *Index = Collection;
+  return RETURN_SUCCESS;
+}
+
+
+/**
+  Append the active boot options whose textual device paths start with a
+  translated OpenFirmware path to the boot order, in their original order.
+  Options that have been appended earlier are skipped.
+
+  @param[in,out] BootOrder         The structure holding the boot order to
+                                   extend.
+
+  @param[in]     Index             The index of active boot options, created
+                                   with CreateActiveOptionIndex().
+
+  @param[in]     Translated        UEFI device path fragment, translated from
+                                   OpenFirmware format, to search for.
+
+  @param[in]     TranslatedLength  The length of Translated in CHAR16's.
+
+  @param[out]    Matches           Scratch array with room for as many
+                                   elements as there are active boot options.
+
+
+  @retval RETURN_SUCCESS  The matching boot options, if any, have been
+                          appended.
+
+  @return                 Error codes returned by BootOrderAppend().
+**/
+STATIC
+RETURN_STATUS
+AppendMatchingOptions (
+  IN OUT  BOOT_ORDER         *BootOrder,
+  IN      ORDERED_COLLECTION *Index,
+  IN      CONST CHAR16       *Translated,
+  IN      UINTN              TranslatedLength,
+  OUT     ACTIVE_OPTION      **Matches
+  )
+{
+  RETURN_STATUS            Status;
+  TRANSLATED_PREFIX        Prefix;
+  ORDERED_COLLECTION_ENTRY *Entry;
+  ORDERED_COLLECTION_ENTRY *Entry2;
+  ACTIVE_OPTION            *Option;
+  UINTN                    MatchCount;
+  UINTN                    Idx;
+  UINTN                    Idx2;
+
+  Prefix.Translated       = Translated;
+  Prefix.TranslatedLength = TranslatedLength;
+
+  //
+  // Find any matching option, then go back to the first one.
+  //
+  Entry = OrderedCollectionFind (Index, &Prefix);
+  if (Entry == NULL) {
+    DEBUG ((DEBUG_VERBOSE, "%a: \"%s\": no match\n", __FUNCTION__,
+      Translated));
+    return RETURN_SUCCESS;
+  }
+  for (Entry2 = OrderedCollectionPrev (Entry);
+       Entry2 != NULL &&
+       ActiveOptionKeyCompare (&Prefix,
+         OrderedCollectionUserStruct (Entry2)) == 0;
+       Entry2 = OrderedCollectionPrev (Entry2)) {
+    Entry = Entry2;
+  }
+
   //
-  // Is Translated a prefix of Converted?
+  // Collect the matching options that haven't been appended yet, and sort
+  // them back into the order of the ACTIVE_OPTION array (insertion sort; there
+  // are very few of them).
   //
-  Result = (BOOLEAN)(StrnCmp (Converted, Translated, TranslatedLength) == 0);
-  DEBUG ((
-    DEBUG_VERBOSE,
-    "%a: against \"%s\": %a\n",
-    __FUNCTION__,
-    Converted,
-    Result ? "match" : "no match"
-    ));
-Exit:
-  FreePool (Converted);
-  return Result;
+  MatchCount = 0;
+  for (;
+       Entry != NULL &&
+       ActiveOptionKeyCompare (&Prefix,
+         OrderedCollectionUserStruct (Entry)) == 0;
+       Entry = OrderedCollectionNext (Entry)) {
+    Option = OrderedCollectionUserStruct (Entry);
+    if (Option->Appended) {
+      continue;
+    }
+    DEBUG ((DEBUG_VERBOSE, "%a: \"%s\": match \"%s\"\n", __FUNCTION__,
+      Translated, Option->Converted));
+
+    for (Idx = MatchCount; Idx > 0 && Matches[Idx - 1] > Option; --Idx) {
+      Matches[Idx] = Matches[Idx - 1];
+    }
+    Matches[Idx] = Option;
+    ++MatchCount;
+  }
+
+  for (Idx2 = 0; Idx2 < MatchCount; ++Idx2) {
+    Status = BootOrderAppend (BootOrder, Matches[Idx2]);
+    if (Status != RETURN_SUCCESS) {
+      return Status;
+    }
+  }
+  return RETURN_SUCCESS;
 }
 
 
@@ -1924,6 +2194,9 @@ SetBootOrderFromQemu (
 
   EXTRA_ROOT_BUS_MAP               *ExtraPciRoots;
 
+  ORDERED_COLLECTION               *ActiveIndex;
+  ACTIVE_OPTION                    **Matches;
+
   UINTN                            TranslatedSize;
   CHAR16                           Translated[TRANSLATION_OUTPUT_SIZE];
   EFI_BOOT_MANAGER_LOAD_OPTION     *BootOptions;
@@ -1980,15 +2253,27 @@ SetBootOrderFromQemu (
     goto ErrorFreeBootOptions;
   }
 
+  Matches = AllocatePool (ActiveCount * sizeof *Matches);
+  if (Matches == NULL) {
+    Status = RETURN_OUT_OF_RESOURCES;
+    goto ErrorFreeActiveOption;
+  }
+
   if (FeaturePcdGet (PcdQemuBootOrderPciTranslation)) {
     Status = CreateExtraRootBusMap (&ExtraPciRoots);
     if (EFI_ERROR (Status)) {
-      goto ErrorFreeActiveOption;
+      goto ErrorFreeMatches;
     }
   } else {
     ExtraPciRoots = NULL;
   }
 
+  //
+  // The active boot options are indexed when the first OpenFirmware path is
+  // translated successfully; each device path is converted to text once.
+  //
+  ActiveIndex = NULL;
+
   //
   // translate each OpenFirmware path
   //
@@ -2000,28 +2285,29 @@ SetBootOrderFromQemu (
          Status == RETURN_PROTOCOL_ERROR ||
          Status == RETURN_BUFFER_TOO_SMALL) {
     if (Status == RETURN_SUCCESS) {
-      UINTN Idx;
+      if (ActiveIndex == NULL) {
+        Status = CreateActiveOptionIndex (ActiveOption, ActiveCount,
+                   &ActiveIndex);
+        if (RETURN_ERROR (Status)) {
+          ActiveIndex = NULL;
+          goto ErrorFreeExtraPciRoots;
+        }
+      }
 
       //
-      // match translated OpenFirmware path against all active boot options
+      // match translated OpenFirmware path against the indexed active boot
+      // options
       //
-      for (Idx = 0; Idx < ActiveCount; ++Idx) {
-        if (!ActiveOption[Idx].Appended &&
-            Match (
-              Translated,
-              TranslatedSize, // contains length, not size, in CHAR16's here
-              ActiveOption[Idx].BootOption->FilePath
-              )
-            ) {
-          //
-          // match found, store ID and continue with next OpenFirmware path
-          //
-          Status = BootOrderAppend (&BootOrder, &ActiveOption[Idx]);
-          if (Status != RETURN_SUCCESS) {
-            goto ErrorFreeExtraPciRoots;
-          }
-        }
-      } // scanned all active boot options
+      Status = AppendMatchingOptions (
+                 &BootOrder,
+                 ActiveIndex,
+                 Translated,
+                 TranslatedSize, // contains length, not size, in CHAR16's here
+                 Matches
+                 );
+      if (Status != RETURN_SUCCESS) {
+        goto ErrorFreeExtraPciRoots;
+      }
     }   // translation successful
 
     TranslatedSize = ARRAY_SIZE (Translated);
@@ -2064,10 +2350,14 @@ SetBootOrderFromQemu (
   }
 
 ErrorFreeExtraPciRoots:
+  DestroyActiveOptionIndex (ActiveIndex, ActiveOption, ActiveCount);
   if (ExtraPciRoots != NULL) {
     DestroyExtraRootBusMap (ExtraPciRoots);
   }
 
+ErrorFreeMatches:
+  FreePool (Matches);
+
 ErrorFreeActiveOption:
   FreePool (ActiveOption);
 
@@ -9,7 +9,7 @@
   SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
-#include <Uefi.h>
+#include <PiDxe.h>
 
 #include <Protocol/IoMmu.h>
 
@@ -17,6 +17,8 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/IoLib.h>
 #include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/QemuFwCfgLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemEncryptSevLib.h>
@@ -28,6 +30,8 @@ STATIC BOOLEAN mQemuFwCfgDmaSupported;
 
 STATIC EDKII_IOMMU_PROTOCOL        *mIoMmuProtocol;
 
+STATIC QEMU_FW_CFG_FILE_DIR        *mFileDir;
+
 /**
   Returns a boolean indicating if the firmware configuration interface
   is available or not.
@@ -451,3 +455,48 @@ InternalQemuFwCfgDmaBytes (
     UnmapFwCfgDmaDataBuffer (DataMapping);
   }
 }
+
+/**
+  Return the sorted fw_cfg file directory index of the current boot phase.
+
+  The index that PEI published in a GUID HOB is copied to pool on first use,
+  so that DXE_SMM_DRIVER modules do not depend on memory outside of SMRAM. If
+  PEI did not produce the HOB, the directory is read and indexed here, once
+  per module.
+
+  @return  The directory index, or NULL if memory allocation failed.
+**/
+CONST QEMU_FW_CFG_FILE_DIR *
+InternalQemuFwCfgGetFileDir (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE *GuidHob;
+  UINT32            Count;
+
+  if (mFileDir != NULL) {
+    return mFileDir;
+  }
+
+  GuidHob = GetFirstGuidHob (&gQemuFwCfgFileDirHobGuid);
+  if (GuidHob != NULL) {
+    mFileDir = AllocateCopyPool (
+                 GET_GUID_HOB_DATA_SIZE (GuidHob),
+                 GET_GUID_HOB_DATA (GuidHob)
+                 );
+    return mFileDir;
+  }
+
+  QemuFwCfgSelectItem (QemuFwCfgItemFileDir);
+  Count = SwapBytes32 (QemuFwCfgRead32 ());
+  mFileDir = AllocatePool (
+               sizeof *mFileDir + (UINTN)Count * sizeof (QEMU_FW_CFG_FILE)
+               );
+  if (mFileDir == NULL) {
+    return NULL;
+  }
+
+  mFileDir->Count = Count;
+  InternalQemuFwCfgLoadFileDir (Count, (QEMU_FW_CFG_FILE *)(mFileDir + 1));
+  return mFileDir;
+}
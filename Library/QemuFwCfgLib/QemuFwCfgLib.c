@@ -238,6 +238,104 @@ QemuFwCfgRead64 (
 }
 
 
+/**
+  Read the fw_cfg file directory into a caller-provided buffer, and turn it
+  into a sorted index.
+
+  The directory entries are transferred with a single QemuFwCfgReadBytes ()
+  call, which is a single DMA transfer when the DMA access method is
+  available. Size and Select are converted to CPU byte order, and the entries
+  are sorted by name, so that InternalQemuFwCfgLookupFile () can bisect them.
+
+  @param[in]  Count   Number of directory entries that Files can hold, as
+                      returned by the first UINT32 of QemuFwCfgItemFileDir.
+
+  @param[out] Files   Array of Count elements to read the entries into.
+**/
+VOID
+InternalQemuFwCfgLoadFileDir (
+  IN  UINT32           Count,
+  OUT QEMU_FW_CFG_FILE *Files
+  )
+{
+  UINT32           Idx;
+  UINT32           Pos;
+  QEMU_FW_CFG_FILE Entry;
+
+  QemuFwCfgSelectItem (QemuFwCfgItemFileDir);
+  QemuFwCfgSkipBytes (sizeof (UINT32));
+  QemuFwCfgReadBytes ((UINTN)Count * sizeof *Files, Files);
+
+  //
+  // QEMU already lists the files in name order (except for legacy machine
+  // types), so the insertion sort below normally finishes in a single pass.
+  //
+  for (Idx = 0; Idx < Count; ++Idx) {
+    CopyMem (&Entry, &Files[Idx], sizeof Entry);
+    Entry.Size   = SwapBytes32 (Entry.Size);
+    Entry.Select = SwapBytes16 (Entry.Select);
+    Entry.Name[QEMU_FW_CFG_FNAME_SIZE - 1] = '\0';
+
+    for (Pos = Idx;
+         Pos > 0 && AsciiStrCmp (Files[Pos - 1].Name, Entry.Name) > 0;
+         --Pos) {
+      CopyMem (&Files[Pos], &Files[Pos - 1], sizeof *Files);
+    }
+    CopyMem (&Files[Pos], &Entry, sizeof Entry);
+  }
+}
+
+
+/**
+  Look up a file in a directory index produced by
+  InternalQemuFwCfgLoadFileDir ().
+
+  @param[in]  FileDir  The sorted directory index.
+  @param[in]  Name     Name of file to look up.
+  @param[out] Item     Configuration item corresponding to the file.
+  @param[out] Size     Number of bytes in the file.
+
+  @retval RETURN_SUCCESS    The file has been found.
+  @retval RETURN_NOT_FOUND  The file is not present in FileDir.
+**/
+STATIC
+RETURN_STATUS
+InternalQemuFwCfgLookupFile (
+  IN  CONST QEMU_FW_CFG_FILE_DIR *FileDir,
+  IN  CONST CHAR8                *Name,
+  OUT FIRMWARE_CONFIG_ITEM       *Item,
+  OUT UINTN                      *Size
+  )
+{
+  CONST QEMU_FW_CFG_FILE *Files;
+  UINT32                 Low;
+  UINT32                 High;
+  UINT32                 Middle;
+  INTN                   Order;
+
+  Files = (CONST QEMU_FW_CFG_FILE *)(FileDir + 1);
+  Low   = 0;
+  High  = FileDir->Count;
+
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    Order  = AsciiStrCmp (Name, Files[Middle].Name);
+    if (Order == 0) {
+      *Item = (FIRMWARE_CONFIG_ITEM)Files[Middle].Select;
+      *Size = Files[Middle].Size;
+      return RETURN_SUCCESS;
+    }
+    if (Order < 0) {
+      High = Middle;
+    } else {
+      Low = Middle + 1;
+    }
+  }
+
+  return RETURN_NOT_FOUND;
+}
+
+
 /**
   Find the configuration item corresponding to the firmware configuration file.
 
@@ -259,13 +357,22 @@ QemuFwCfgFindFile (
   OUT  UINTN                 *Size
   )
 {
-  UINT32 Count;
-  UINT32 Idx;
+  CONST QEMU_FW_CFG_FILE_DIR *FileDir;
+  UINT32                     Count;
+  UINT32                     Idx;
 
   if (!InternalQemuFwCfgIsAvailable ()) {
     return RETURN_UNSUPPORTED;
   }
 
+  FileDir = InternalQemuFwCfgGetFileDir ();
+  if (FileDir != NULL) {
+    return InternalQemuFwCfgLookupFile (FileDir, Name, Item, Size);
+  }
+
+  //
+  // No directory index is available in this phase; scan the directory.
+  //
   QemuFwCfgSelectItem (QemuFwCfgItemFileDir);
   Count = SwapBytes32 (QemuFwCfgRead32 ());
 
@@ -11,6 +11,8 @@
 #ifndef __QEMU_FW_CFG_LIB_INTERNAL_H__
 #define __QEMU_FW_CFG_LIB_INTERNAL_H__
 
+#include <Guid/QemuFwCfgFileDir.h>
+
 /**
   Returns a boolean indicating if the firmware configuration interface is
   available for library-internal purposes.
@@ -60,4 +62,33 @@ InternalQemuFwCfgDmaBytes (
   IN     UINT32   Control
   );
 
+/**
+  Return the sorted fw_cfg file directory index of the current boot phase.
+
+  The index is built at most once per phase, with
+  InternalQemuFwCfgLoadFileDir (). Library instances that cannot keep state
+  return NULL, and QemuFwCfgFindFile () scans the directory instead.
+
+  @return  The directory index, or NULL if no index is available.
+**/
+CONST QEMU_FW_CFG_FILE_DIR *
+InternalQemuFwCfgGetFileDir (
+  VOID
+  );
+
+/**
+  Read the fw_cfg file directory into a caller-provided buffer, and turn it
+  into a sorted index.
+
+  @param[in]  Count   Number of directory entries that Files can hold, as
+                      returned by the first UINT32 of QemuFwCfgItemFileDir.
+
+  @param[out] Files   Array of Count elements to read the entries into.
+**/
+VOID
+InternalQemuFwCfgLoadFileDir (
+  IN  UINT32           Count,
+  OUT QEMU_FW_CFG_FILE *Files
+  );
+
 #endif
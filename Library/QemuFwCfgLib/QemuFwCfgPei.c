@@ -9,9 +9,12 @@
   SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
+#include <PiPei.h>
+
 #include <Library/BaseLib.h>
 #include <Library/IoLib.h>
 #include <Library/DebugLib.h>
+#include <Library/HobLib.h>
 #include <Library/QemuFwCfgLib.h>
 #include <Library/MemEncryptSevLib.h>
 
@@ -20,6 +23,12 @@
 STATIC BOOLEAN mQemuFwCfgSupported = FALSE;
 STATIC BOOLEAN mQemuFwCfgDmaSupported;
 
+//
+// The largest payload that BuildGuidHob () accepts.
+//
+#define QEMU_FW_CFG_FILE_DIR_HOB_MAX_SIZE \
+  (0xFFF8 - sizeof (EFI_HOB_GUID_TYPE))
+
 
 /**
   Returns a boolean indicating if the firmware configuration interface
@@ -199,3 +208,50 @@ InternalQemuFwCfgDmaBytes (
   MemoryFence ();
 }
 
+
+/**
+  Return the sorted fw_cfg file directory index of the current boot phase.
+
+  In PEI, the index is kept in a GUID HOB, so that all PEIMs, and all DXE
+  modules later, share the copy that the first lookup has read. The HOB is
+  located on every call rather than remembered in a global variable, because
+  the HOB list is migrated when permanent PEI memory is installed.
+
+  @return  The directory index, or NULL if the directory is too large for a
+           HOB, or the HOB could not be allocated.
+**/
+CONST QEMU_FW_CFG_FILE_DIR *
+InternalQemuFwCfgGetFileDir (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE    *GuidHob;
+  QEMU_FW_CFG_FILE_DIR *FileDir;
+  UINT32               Count;
+  UINTN                DataSize;
+
+  GuidHob = GetFirstGuidHob (&gQemuFwCfgFileDirHobGuid);
+  if (GuidHob != NULL) {
+    return GET_GUID_HOB_DATA (GuidHob);
+  }
+
+  QemuFwCfgSelectItem (QemuFwCfgItemFileDir);
+  Count = SwapBytes32 (QemuFwCfgRead32 ());
+  if (Count > (QEMU_FW_CFG_FILE_DIR_HOB_MAX_SIZE - sizeof *FileDir) /
+                sizeof (QEMU_FW_CFG_FILE)) {
+    DEBUG ((DEBUG_WARN, "%a: %u fw_cfg files don't fit in a HOB\n",
+      __FUNCTION__, Count));
+    return NULL;
+  }
+
+  DataSize = sizeof *FileDir + Count * sizeof (QEMU_FW_CFG_FILE);
+  FileDir  = BuildGuidHob (&gQemuFwCfgFileDirHobGuid, DataSize);
+  if (FileDir == NULL) {
+    return NULL;
+  }
+
+  FileDir->Count = Count;
+  InternalQemuFwCfgLoadFileDir (Count, (QEMU_FW_CFG_FILE *)(FileDir + 1));
+  DEBUG ((DEBUG_INFO, "%a: indexed %u fw_cfg files\n", __FUNCTION__, Count));
+  return FileDir;
+}
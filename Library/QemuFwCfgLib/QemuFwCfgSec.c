@@ -119,3 +119,19 @@ InternalQemuFwCfgDmaBytes (
   ASSERT (FALSE);
   CpuDeadLoop ();
 }
+
+/**
+  Return the sorted fw_cfg file directory index of the current boot phase.
+
+  SEC runs from flash and has neither writable globals nor a HOB list, so
+  QemuFwCfgFindFile () always scans the directory in this phase.
+
+  @return  NULL.
+**/
+CONST QEMU_FW_CFG_FILE_DIR *
+InternalQemuFwCfgGetFileDir (
+  VOID
+  )
+{
+  return NULL;
+}
@@ -544,6 +544,7 @@ BmGetNextLoadOptionBufferWithAppleFix (
     return FileBuffer;
   }
 
+  BootTimelineBegin ("BmAppleFix");
   DEBUG ((DEBUG_INFO, "[Bds AppleFix] Apple Device Path: Attempting to fix DP Nodes\n"));
   FixedFilePath = DuplicateDevicePath (FilePath);
   ASSERT (FixedFilePath != NULL);
@@ -565,11 +566,13 @@ BmGetNextLoadOptionBufferWithAppleFix (
   }
 
 done_success:
+  BootTimelineEnd ("BmAppleFix");
   FreePool (FixedFilePath);
   DEBUG ((DEBUG_INFO, "[Bds AppleFix] Apple DevicePath fixes apply successful\n"));
   return FileBuffer;
 
 done_fail:
+  BootTimelineEnd ("BmAppleFix");
   FreePool (FixedFilePath);
   DEBUG ((DEBUG_INFO, "[Bds AppleFix] Apple DevicePath fixes apply fail\n"));
   return NULL;
@@ -2019,6 +2019,11 @@ EfiBootManagerBoot (
     BmEndOfBdsPerfCode (NULL, NULL);
   );
 
+  //
+  // Hand the boot timeline over to the OS along with control.
+  //
+  BootTimelinePublish ();
+
   REPORT_STATUS_CODE (EFI_PROGRESS_CODE, PcdGet32 (PcdProgressCodeOsLoaderStart));
 
   Status = gBS->StartImage (ImageHandle, &BootOption->ExitDataSize, &BootOption->ExitData);
@@ -2201,7 +2206,7 @@ BmEnumerateBootOptions (
         continue;
       }
 
-      Description = BmGetBootDescription (Handles[Index]);
+      Description = BmGetCachedBootDescription (Handles[Index], BlkIo);
       BootOptions = ReallocatePool (
                       sizeof (EFI_BOOT_MANAGER_LOAD_OPTION) * (*BootOptionCount),
                       sizeof (EFI_BOOT_MANAGER_LOAD_OPTION) * (*BootOptionCount + 1),
@@ -2229,6 +2234,8 @@ BmEnumerateBootOptions (
     FreePool (Handles);
   }
 
+  BmSaveBootDescriptionCache ();
+
   //
   // Parse simple file system not based on block io
   //
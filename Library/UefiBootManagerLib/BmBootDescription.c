@@ -19,6 +19,17 @@ CHAR16       mBmUefiPrefix[] = L"UEFI ";
 
 LIST_ENTRY mPlatformBootDescriptionHandlers = INITIALIZE_LIST_HEAD_VARIABLE (mPlatformBootDescriptionHandlers);
 
+//
+// The boot description cache: as saved in L"BootDescriptionCache", and as
+// built by the BmGetCachedBootDescription() calls of the current enumeration.
+//
+EFI_GUID   mBmBootDescriptionCacheGuid = { 0x553bc5c0, 0x89f2, 0x434d, { 0xbf, 0x0a, 0x65, 0x1e, 0xa6, 0xd4, 0x85, 0x81 } };
+BOOLEAN    mBmSavedDescriptionCacheLoaded = FALSE;
+UINT8      *mBmSavedDescriptionCache      = NULL;
+UINTN      mBmSavedDescriptionCacheSize   = 0;
+UINT8      *mBmDescriptionCache           = NULL;
+UINTN      mBmDescriptionCacheSize        = 0;
+
 /**
   For a bootable Device path, return its boot type.
 
@@ -814,6 +825,175 @@ BmGetBootDescription (
   return DefaultDescription;
 }
 
+/**
+  Find the entry of a block device in the saved boot description cache.
+
+  @param DevicePath            The device path of the block device.
+  @param DevicePathSize        The size of DevicePath.
+  @param Media                 The media of the block device.
+
+  @return  The cache entry, or NULL if the device is not cached with the same
+           media.
+**/
+BM_BOOT_DESCRIPTION_CACHE_ENTRY *
+BmFindBootDescriptionCacheEntry (
+  IN EFI_DEVICE_PATH_PROTOCOL    *DevicePath,
+  IN UINTN                       DevicePathSize,
+  IN EFI_BLOCK_IO_MEDIA          *Media
+  )
+{
+  UINTN                            Offset;
+  BM_BOOT_DESCRIPTION_CACHE_ENTRY  *Entry;
+  CHAR16                           *Description;
+
+  if (!mBmSavedDescriptionCacheLoaded) {
+    mBmSavedDescriptionCacheLoaded = TRUE;
+    GetVariable2 (
+      L"BootDescriptionCache",
+      &mBmBootDescriptionCacheGuid,
+      (VOID **) &mBmSavedDescriptionCache,
+      &mBmSavedDescriptionCacheSize
+      );
+  }
+
+  for ( Offset = 0
+      ; Offset + sizeof (*Entry) <= mBmSavedDescriptionCacheSize
+      ; Offset += Entry->Size
+      ) {
+    Entry = (BM_BOOT_DESCRIPTION_CACHE_ENTRY *) (mBmSavedDescriptionCache + Offset);
+    if (Entry->Size < sizeof (*Entry) + Entry->DevicePathSize + Entry->DescriptionSize ||
+        Entry->Size > mBmSavedDescriptionCacheSize - Offset) {
+      //
+      // Corrupt cache, ignore the rest.
+      //
+      return NULL;
+    }
+
+    Description = (CHAR16 *) ((UINT8 *) (Entry + 1) + Entry->DevicePathSize);
+    if (Entry->MediaId == Media->MediaId &&
+        Entry->LastBlock == Media->LastBlock &&
+        Entry->BlockSize == Media->BlockSize &&
+        Entry->DevicePathSize == DevicePathSize &&
+        CompareMem (Entry + 1, DevicePath, DevicePathSize) == 0 &&
+        Entry->DescriptionSize >= sizeof (CHAR16) &&
+        Entry->DescriptionSize % sizeof (CHAR16) == 0 &&
+        ReadUnaligned16 ((UINT16 *) ((UINT8 *) Description + Entry->DescriptionSize) - 1) == L'\0') {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Return the boot description for a block device, from the boot description
+  cache if the device path and the media are the same as when it was cached.
+  Otherwise get it with BmGetBootDescription(), and add it to the cache.
+
+  @param Handle                Block device handle.
+  @param BlockIo               The Block I/O protocol on Handle.
+
+  @return  The description string.
+**/
+CHAR16 *
+BmGetCachedBootDescription (
+  IN EFI_HANDLE                  Handle,
+  IN EFI_BLOCK_IO_PROTOCOL       *BlockIo
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL         *DevicePath;
+  UINTN                            DevicePathSize;
+  BM_BOOT_DESCRIPTION_CACHE_ENTRY  *Entry;
+  CHAR16                           *Description;
+  UINTN                            DescriptionSize;
+  UINTN                            EntrySize;
+
+  DevicePath = DevicePathFromHandle (Handle);
+  if (DevicePath == NULL) {
+    return BmGetBootDescription (Handle);
+  }
+  DevicePathSize = GetDevicePathSize (DevicePath);
+
+  Entry = BmFindBootDescriptionCacheEntry (DevicePath, DevicePathSize, BlockIo->Media);
+  if (Entry != NULL) {
+    Description = AllocateCopyPool (
+                    Entry->DescriptionSize,
+                    (UINT8 *) (Entry + 1) + Entry->DevicePathSize
+                    );
+    ASSERT (Description != NULL);
+  } else {
+    Description = BmGetBootDescription (Handle);
+  }
+
+  //
+  // Add the device to the cache being built, unless it is full.
+  //
+  DescriptionSize = StrSize (Description);
+  EntrySize       = sizeof (*Entry) + DevicePathSize + DescriptionSize;
+  if (mBmDescriptionCache == NULL) {
+    mBmDescriptionCache = AllocatePool (BM_BOOT_DESCRIPTION_CACHE_MAX_SIZE);
+  }
+  if (mBmDescriptionCache != NULL &&
+      mBmDescriptionCacheSize + EntrySize <= BM_BOOT_DESCRIPTION_CACHE_MAX_SIZE) {
+    Entry = (BM_BOOT_DESCRIPTION_CACHE_ENTRY *) (mBmDescriptionCache + mBmDescriptionCacheSize);
+    Entry->Size            = (UINT32) EntrySize;
+    Entry->MediaId         = BlockIo->Media->MediaId;
+    Entry->LastBlock       = BlockIo->Media->LastBlock;
+    Entry->BlockSize       = BlockIo->Media->BlockSize;
+    Entry->DevicePathSize  = (UINT16) DevicePathSize;
+    Entry->DescriptionSize = (UINT16) DescriptionSize;
+    CopyMem (Entry + 1, DevicePath, DevicePathSize);
+    CopyMem ((UINT8 *) (Entry + 1) + DevicePathSize, Description, DescriptionSize);
+    mBmDescriptionCacheSize += EntrySize;
+  }
+
+  return Description;
+}
+
+/**
+  Save the boot description cache built by the BmGetCachedBootDescription()
+  calls since the last call, if it differs from the saved one. Devices that
+  were not looked up are dropped from the cache.
+**/
+VOID
+BmSaveBootDescriptionCache (
+  VOID
+  )
+{
+  EFI_STATUS                       Status;
+
+  if (mBmDescriptionCache == NULL) {
+    return;
+  }
+
+  if (mBmDescriptionCacheSize != mBmSavedDescriptionCacheSize ||
+      CompareMem (mBmDescriptionCache, mBmSavedDescriptionCache, mBmDescriptionCacheSize) != 0) {
+    //
+    // Boot services access only: the OS must not be able to plant
+    // descriptions.
+    //
+    Status = gRT->SetVariable (
+                    L"BootDescriptionCache",
+                    &mBmBootDescriptionCacheGuid,
+                    EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                    mBmDescriptionCacheSize,
+                    mBmDescriptionCache
+                    );
+    DEBUG ((DEBUG_INFO, "[Bds] Save boot description cache (%Lu bytes) - %r\n", (UINT64) mBmDescriptionCacheSize, Status));
+  }
+
+  //
+  // The cache just built is the saved one from now on.
+  //
+  if (mBmSavedDescriptionCache != NULL) {
+    FreePool (mBmSavedDescriptionCache);
+  }
+  mBmSavedDescriptionCache     = mBmDescriptionCache;
+  mBmSavedDescriptionCacheSize = mBmDescriptionCacheSize;
+  mBmDescriptionCache          = NULL;
+  mBmDescriptionCacheSize      = 0;
+}
+
 /**
   Enumerate all boot option descriptions and append " 2"/" 3"/... to make
   unique description.
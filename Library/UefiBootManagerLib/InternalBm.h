@@ -52,6 +52,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/StatusCodeDataTypeVariable.h>
 
 #include <Library/PrintLib.h>
+#include <Library/BootTimelineLib.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -147,6 +148,25 @@ typedef struct {
   EFI_BOOT_MANAGER_BOOT_DESCRIPTION_HANDLER Handler;
 } BM_BOOT_DESCRIPTION_ENTRY;
 
+//
+// An entry of the boot description cache, followed by the device path of the
+// block device and by its description. The cache is the concatenation of the
+// entries of the block devices found by the last enumeration, in the same
+// order, and is kept in the L"BootDescriptionCache" variable.
+//
+#pragma pack(1)
+typedef struct {
+  UINT32                                    Size;
+  UINT32                                    MediaId;
+  UINT64                                    LastBlock;
+  UINT32                                    BlockSize;
+  UINT16                                    DevicePathSize;
+  UINT16                                    DescriptionSize;
+} BM_BOOT_DESCRIPTION_CACHE_ENTRY;
+#pragma pack()
+
+#define BM_BOOT_DESCRIPTION_CACHE_MAX_SIZE  SIZE_4KB
+
 /**
   Repair all the controllers according to the Driver Health status queried.
 
@@ -369,6 +389,32 @@ BmGetBootDescription (
   IN EFI_HANDLE                  Handle
   );
 
+/**
+  Return the boot description for a block device, from the boot description
+  cache if the device path and the media are the same as when it was cached.
+  Otherwise get it with BmGetBootDescription(), and add it to the cache.
+
+  @param Handle                Block device handle.
+  @param BlockIo               The Block I/O protocol on Handle.
+
+  @return  The description string.
+**/
+CHAR16 *
+BmGetCachedBootDescription (
+  IN EFI_HANDLE                  Handle,
+  IN EFI_BLOCK_IO_PROTOCOL       *BlockIo
+  );
+
+/**
+  Save the boot description cache built by the BmGetCachedBootDescription()
+  calls since the last call, if it differs from the saved one. Devices that
+  were not looked up are dropped from the cache.
+**/
+VOID
+BmSaveBootDescriptionCache (
+  VOID
+  );
+
 /**
   Enumerate all boot option descriptions and append " 2"/" 3"/... to make
   unique description.
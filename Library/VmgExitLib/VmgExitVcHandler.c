@@ -11,6 +11,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/LocalApicLib.h>
 #include <Library/MemEncryptSevLib.h>
+#include <Library/PcdLib.h>
 #include <Library/VmgExitLib.h>
 #include <Register/Amd/Msr.h>
 #include <Register/Intel/Cpuid.h>
@@ -1760,8 +1761,14 @@ InternalVmgExitHandleVc (
   UINT64                    ExitCode, Status;
   EFI_STATUS                VcRet;
   BOOLEAN                   InterruptState;
+  UINT64                    StartTsc;
 
   VcRet = EFI_SUCCESS;
+  StartTsc = 0;
+
+  if (FeaturePcdGet (PcdVcHandlerProfile)) {
+    StartTsc = AsmReadTsc ();
+  }
 
   Regs = SystemContext.SystemContextX64;
 
@@ -1851,6 +1858,14 @@ InternalVmgExitHandleVc (
 
   VmgDone (Ghcb, InterruptState);
 
+  if (FeaturePcdGet (PcdVcHandlerProfile)) {
+    SEV_ES_PER_CPU_DATA  *SevEsData;
+
+    SevEsData = (SEV_ES_PER_CPU_DATA *) (Ghcb + 1);
+    SevEsData->VcHandled++;
+    SevEsData->VcCycles += AsmReadTsc () - StartTsc;
+  }
+
   return VcRet;
 }
 
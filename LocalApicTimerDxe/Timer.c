@@ -0,0 +1,589 @@
+/** @file
+  Timer Architectural Protocol as defined in the DXE CIS, on the local APIC
+  timer.
+
+  When the CPU supports TSC-deadline mode and the TSC frequency is known (the
+  TSC Timer Library only publishes it for an invariant TSC), every interrupt
+  arms the next deadline one period after the previous one, and reports the
+  time that actually passed since the last interrupt, as measured by the TSC.
+  Late or lost interrupts therefore neither slow down nor shift the DXE Core's
+  timer events. Otherwise the local APIC timer runs in periodic mode, at a
+  frequency calibrated against the Timer Library.
+
+  Unlike the 8254 driver, this one touches neither the PIT nor the 8259: the
+  EOI goes to the local APIC, which is not a port I/O exit.
+
+Copyright (c) 2005 - 2018, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2019, Citrix Systems, Inc.
+Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Timer.h"
+
+//
+// The handle onto which the Timer Architectural Protocol will be installed
+//
+EFI_HANDLE                mTimerHandle = NULL;
+
+//
+// The Timer Architectural Protocol that this driver produces
+//
+EFI_TIMER_ARCH_PROTOCOL   mTimer = {
+  TimerDriverRegisterHandler,
+  TimerDriverSetTimerPeriod,
+  TimerDriverGetTimerPeriod,
+  TimerDriverGenerateSoftInterrupt
+};
+
+//
+// Pointer to the CPU Architectural Protocol instance
+//
+EFI_CPU_ARCH_PROTOCOL     *mCpu;
+
+//
+// The notification function to call on every timer interrupt.
+// A bug in the compiler prevents us from initializing this here.
+//
+EFI_TIMER_NOTIFY mTimerNotifyFunction;
+
+//
+// The current period of the timer interrupt
+//
+volatile UINT64           mTimerPeriod = 0;
+
+//
+// TSC ticks per second if the timer runs in TSC-deadline mode, zero if it
+// runs in periodic mode.
+//
+UINT64                    mTscFrequency;
+
+//
+// The timer period in TSC ticks, the TSC value the timer is armed for, and
+// the TSC value up to which time has been reported to the DXE Core.
+//
+UINT64                    mTscPeriod;
+UINT64                    mTscDeadline;
+UINT64                    mTscReported;
+
+//
+// Local APIC timer ticks per second, with a divide value of 1. Used in
+// periodic mode only.
+//
+UINT32                    mApicTimerFrequency;
+
+//
+// Worker Functions
+//
+/**
+  Return the time that passed since the previous call, in 100 ns units, as
+  measured by the TSC. The fraction of 100 ns that is not returned is carried
+  over into the next call, so the reported times add up to the real one.
+
+  @param Now             The current TSC value.
+
+  @return  The elapsed time in 100 ns units.
+**/
+UINT64
+TimerDriverTscElapsedTime (
+  IN UINT64  Now
+  )
+{
+  UINT64  Elapsed;
+
+  Elapsed = DivU64x64Remainder (
+              MultU64x32 (Now - mTscReported, 10000000),
+              mTscFrequency,
+              NULL
+              );
+  mTscReported += DivU64x32 (MultU64x64 (Elapsed, mTscFrequency), 10000000);
+  return Elapsed;
+}
+
+/**
+  Arm the TSC deadline for the next timer interrupt, one period after the
+  previous deadline. If that has already passed, the interrupts in between
+  are skipped; TimerDriverTscElapsedTime() accounts for the time.
+
+  @param Now             The current TSC value.
+**/
+VOID
+TimerDriverArmTscDeadline (
+  IN UINT64  Now
+  )
+{
+  mTscDeadline += mTscPeriod;
+  if (mTscDeadline <= Now) {
+    mTscDeadline = Now + mTscPeriod;
+  }
+  AsmWriteMsr64 (MSR_IA32_TSC_DEADLINE, mTscDeadline);
+}
+
+/**
+  Check whether the local APIC timer can run in TSC-deadline mode, and return
+  the TSC frequency if so.
+
+  @return  The TSC frequency in Hz, or zero if TSC-deadline mode is not
+           supported or the TSC frequency is unknown.
+**/
+UINT64
+TimerDriverGetTscDeadlineFrequency (
+  VOID
+  )
+{
+  CPUID_VERSION_INFO_ECX  VersionInfoEcx;
+  EFI_HOB_GUID_TYPE       *GuidHob;
+
+  AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &VersionInfoEcx.Uint32, NULL);
+  if (VersionInfoEcx.Bits.TSC_Deadline == 0) {
+    return 0;
+  }
+
+  GuidHob = GetFirstGuidHob (&gOvmfTscFrequencyHobGuid);
+  if (GuidHob == NULL) {
+    return 0;
+  }
+  return *(UINT64 *)GET_GUID_HOB_DATA (GuidHob);
+}
+
+/**
+  Switch the local APIC timer to TSC-deadline mode, with the interrupt
+  masked and no deadline armed.
+**/
+VOID
+TimerDriverEnableTscDeadlineMode (
+  VOID
+  )
+{
+  UINT32  LvtTimer;
+
+  LvtTimer  = ReadLocalApicReg (XAPIC_LVT_TIMER_OFFSET);
+  LvtTimer &= ~(UINT32)(LVT_TIMER_MODE_MASK | 0xFF);
+  LvtTimer |= LVT_TIMER_MODE_TSC_DEADLINE | BIT16 | LOCAL_APIC_TIMER_VECTOR;
+  WriteLocalApicReg (XAPIC_LVT_TIMER_OFFSET, LvtTimer);
+
+  //
+  // The SDM asks for a fence between the LVT write that selects TSC-deadline
+  // mode and the first write to IA32_TSC_DEADLINE.
+  //
+  MemoryFence ();
+  AsmWriteMsr64 (MSR_IA32_TSC_DEADLINE, 0);
+}
+
+/**
+  Measure the local APIC timer frequency, with a divide value of 1, against
+  the Timer Library.
+
+  @return  The local APIC timer frequency in Hz.
+**/
+UINT32
+TimerDriverCalibrateApicTimer (
+  VOID
+  )
+{
+  UINT32  StartCount;
+  UINT32  EndCount;
+  UINT64  StartTime;
+  UINT64  EndTime;
+  UINT64  NanoSeconds;
+
+  DisableApicTimerInterrupt ();
+  InitializeApicTimer (1, MAX_UINT32, FALSE, LOCAL_APIC_TIMER_VECTOR);
+
+  StartTime  = GetPerformanceCounter ();
+  StartCount = GetApicTimerCurrentCount ();
+  MicroSecondDelay (APIC_TIMER_CALIBRATION_TIME);
+  EndCount   = GetApicTimerCurrentCount ();
+  EndTime    = GetPerformanceCounter ();
+
+  InitializeApicTimer (1, 0, FALSE, LOCAL_APIC_TIMER_VECTOR);
+
+  NanoSeconds = GetTimeInNanoSecond (EndTime - StartTime);
+  if (NanoSeconds == 0) {
+    NanoSeconds = APIC_TIMER_CALIBRATION_TIME * 1000;
+  }
+  return (UINT32)DivU64x64Remainder (
+                   MultU64x32 (StartCount - EndCount, 1000000000),
+                   NanoSeconds,
+                   NULL
+                   );
+}
+
+/**
+  Interrupt Handler.
+
+  @param InterruptType    The type of interrupt that occurred
+  @param SystemContext    A pointer to the system context when the interrupt occurred
+**/
+VOID
+EFIAPI
+TimerInterruptHandler (
+  IN EFI_EXCEPTION_TYPE   InterruptType,
+  IN EFI_SYSTEM_CONTEXT   SystemContext
+  )
+{
+  EFI_TPL OriginalTPL;
+  UINT64  Now;
+  UINT64  Elapsed;
+
+  OriginalTPL = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+
+  if (mTscFrequency != 0) {
+    Now = AsmReadTsc ();
+    TimerDriverArmTscDeadline (Now);
+    Elapsed = TimerDriverTscElapsedTime (Now);
+  } else {
+    //
+    // @bug : This does not handle missed timer interrupts
+    //
+    Elapsed = mTimerPeriod;
+  }
+
+  if (mTimerNotifyFunction != NULL && Elapsed != 0) {
+    mTimerNotifyFunction (Elapsed);
+  }
+
+  gBS->RestoreTPL (OriginalTPL);
+
+  DisableInterrupts ();
+  SendApicEoi ();
+}
+
+/**
+
+  This function registers the handler NotifyFunction so it is called every time
+  the timer interrupt fires.  It also passes the amount of time since the last
+  handler call to the NotifyFunction.  If NotifyFunction is NULL, then the
+  handler is unregistered.  If the handler is registered, then EFI_SUCCESS is
+  returned.  If the CPU does not support registering a timer interrupt handler,
+  then EFI_UNSUPPORTED is returned.  If an attempt is made to register a handler
+  when a handler is already registered, then EFI_ALREADY_STARTED is returned.
+  If an attempt is made to unregister a handler when a handler is not registered,
+  then EFI_INVALID_PARAMETER is returned.  If an error occurs attempting to
+  register the NotifyFunction with the timer interrupt, then EFI_DEVICE_ERROR
+  is returned.
+
+
+  @param This             The EFI_TIMER_ARCH_PROTOCOL instance.
+  @param NotifyFunction   The function to call when a timer interrupt fires.  This
+                          function executes at TPL_HIGH_LEVEL.  The DXE Core will
+                          register a handler for the timer interrupt, so it can know
+                          how much time has passed.  This information is used to
+                          signal timer based events.  NULL will unregister the handler.
+
+  @retval        EFI_SUCCESS            The timer handler was registered.
+  @retval        EFI_UNSUPPORTED        The platform does not support timer interrupts.
+  @retval        EFI_ALREADY_STARTED    NotifyFunction is not NULL, and a handler is already
+                                        registered.
+  @retval        EFI_INVALID_PARAMETER  NotifyFunction is NULL, and a handler was not
+                                        previously registered.
+  @retval        EFI_DEVICE_ERROR       The timer handler could not be registered.
+
+**/
+EFI_STATUS
+EFIAPI
+TimerDriverRegisterHandler (
+  IN EFI_TIMER_ARCH_PROTOCOL  *This,
+  IN EFI_TIMER_NOTIFY         NotifyFunction
+  )
+{
+  //
+  // Check for invalid parameters
+  //
+  if (NotifyFunction == NULL && mTimerNotifyFunction == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (NotifyFunction != NULL && mTimerNotifyFunction != NULL) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  mTimerNotifyFunction = NotifyFunction;
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  This function adjusts the period of timer interrupts to the value specified
+  by TimerPeriod.  If the timer period is updated, then the selected timer
+  period is stored in EFI_TIMER.TimerPeriod, and EFI_SUCCESS is returned.  If
+  the timer hardware is not programmable, then EFI_UNSUPPORTED is returned.
+  If an error occurs while attempting to update the timer period, then the
+  timer hardware will be put back in its state prior to this call, and
+  EFI_DEVICE_ERROR is returned.  If TimerPeriod is 0, then the timer interrupt
+  is disabled.  This is not the same as disabling the CPU's interrupts.
+  Instead, it must either turn off the timer hardware, or it must adjust the
+  interrupt controller so that a CPU interrupt is not generated when the timer
+  interrupt fires.
+
+
+  @param This            The EFI_TIMER_ARCH_PROTOCOL instance.
+  @param TimerPeriod     The rate to program the timer interrupt in 100 nS units.  If
+                         the timer hardware is not programmable, then EFI_UNSUPPORTED is
+                         returned.  If the timer is programmable, then the timer period
+                         will be rounded up to the nearest timer period that is supported
+                         by the timer hardware.  If TimerPeriod is set to 0, then the
+                         timer interrupts will be disabled.
+
+  @retval        EFI_SUCCESS       The timer period was changed.
+  @retval        EFI_UNSUPPORTED   The platform cannot change the period of the timer interrupt.
+  @retval        EFI_DEVICE_ERROR  The timer period could not be changed due to a device error.
+
+**/
+EFI_STATUS
+EFIAPI
+TimerDriverSetTimerPeriod (
+  IN EFI_TIMER_ARCH_PROTOCOL  *This,
+  IN UINT64                   TimerPeriod
+  )
+{
+  UINT64  TimerCount;
+  UINTN   DivideValue = 1;
+  UINT64  Now;
+
+  if (TimerPeriod == 0) {
+    //
+    // Disable timer interrupt for a TimerPeriod of 0
+    //
+    DisableApicTimerInterrupt ();
+    if (mTscFrequency != 0) {
+      AsmWriteMsr64 (MSR_IA32_TSC_DEADLINE, 0);
+    }
+  } else if (mTscFrequency != 0) {
+    //
+    // Convert TimerPeriod into TSC ticks
+    //
+    mTscPeriod = DivU64x32 (MultU64x64 (TimerPeriod, mTscFrequency),
+                   10000000);
+    if (mTscPeriod == 0) {
+      mTscPeriod = 1;
+    }
+
+    //
+    // Time starts counting from here if the timer was disabled; otherwise
+    // the time up to the next interrupt is still reported.
+    //
+    Now = AsmReadTsc ();
+    if (mTimerPeriod == 0) {
+      mTscReported = Now;
+    }
+    mTscDeadline = Now;
+    TimerDriverArmTscDeadline (Now);
+
+    //
+    // Enable timer interrupt
+    //
+    EnableApicTimerInterrupt ();
+  } else {
+    //
+    // Convert TimerPeriod into local APIC counts
+    //
+    // TimerPeriod is in 100ns
+    // TimerPeriod/10000000 will be in seconds.
+    TimerCount = DivU64x32 (MultU64x32 (TimerPeriod, mApicTimerFrequency),
+                            10000000);
+
+    // Check for overflow
+    if (TimerCount > MAX_UINT32) {
+      TimerCount = MAX_UINT32;
+      TimerPeriod = DivU64x32 (MultU64x32 (10000000, MAX_UINT32),
+                      mApicTimerFrequency);
+    }
+    if (TimerCount == 0) {
+      TimerCount = 1;
+    }
+
+    //
+    // Program the timer with the new count value
+    //
+    InitializeApicTimer (DivideValue, (UINT32)TimerCount, TRUE,
+      LOCAL_APIC_TIMER_VECTOR);
+
+    //
+    // Enable timer interrupt
+    //
+    EnableApicTimerInterrupt ();
+  }
+  //
+  // Save the new timer period
+  //
+  mTimerPeriod = TimerPeriod;
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  This function retrieves the period of timer interrupts in 100 ns units,
+  returns that value in TimerPeriod, and returns EFI_SUCCESS.  If TimerPeriod
+  is NULL, then EFI_INVALID_PARAMETER is returned.  If a TimerPeriod of 0 is
+  returned, then the timer is currently disabled.
+
+
+  @param This            The EFI_TIMER_ARCH_PROTOCOL instance.
+  @param TimerPeriod     A pointer to the timer period to retrieve in 100 ns units.  If
+                         0 is returned, then the timer is currently disabled.
+
+  @retval EFI_SUCCESS            The timer period was returned in TimerPeriod.
+  @retval EFI_INVALID_PARAMETER  TimerPeriod is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+TimerDriverGetTimerPeriod (
+  IN EFI_TIMER_ARCH_PROTOCOL   *This,
+  OUT UINT64                   *TimerPeriod
+  )
+{
+  if (TimerPeriod == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *TimerPeriod = mTimerPeriod;
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  This function generates a soft timer interrupt. If the platform does not support soft
+  timer interrupts, then EFI_UNSUPPORTED is returned. Otherwise, EFI_SUCCESS is returned.
+  If a handler has been registered through the EFI_TIMER_ARCH_PROTOCOL.RegisterHandler()
+  service, then a soft timer interrupt will be generated. If the timer interrupt is
+  enabled when this service is called, then the registered handler will be invoked. The
+  registered handler should not be able to distinguish a hardware-generated timer
+  interrupt from a software-generated timer interrupt.
+
+
+  @param This              The EFI_TIMER_ARCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS       The soft timer interrupt was generated.
+  @retval EFI_UNSUPPORTED   The platform does not support the generation of soft timer interrupts.
+
+**/
+EFI_STATUS
+EFIAPI
+TimerDriverGenerateSoftInterrupt (
+  IN EFI_TIMER_ARCH_PROTOCOL  *This
+  )
+{
+  EFI_TPL     OriginalTPL;
+  UINT64      Elapsed;
+
+  if (GetApicTimerInterruptState ()) {
+    //
+    // Invoke the registered handler
+    //
+    OriginalTPL = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+
+    if (mTscFrequency != 0) {
+      Elapsed = TimerDriverTscElapsedTime (AsmReadTsc ());
+    } else {
+      //
+      // @bug : This does not handle missed timer interrupts
+      //
+      Elapsed = mTimerPeriod;
+    }
+
+    if (mTimerNotifyFunction != NULL && Elapsed != 0) {
+      mTimerNotifyFunction (Elapsed);
+    }
+
+    gBS->RestoreTPL (OriginalTPL);
+  } else {
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Initialize the Timer Architectural Protocol driver
+
+  @param ImageHandle     ImageHandle of the loaded driver
+  @param SystemTable     Pointer to the System Table
+
+  @retval EFI_SUCCESS            Timer Architectural Protocol created
+  @retval EFI_OUT_OF_RESOURCES   Not enough resources available to initialize driver.
+  @retval EFI_DEVICE_ERROR       A device error occurred attempting to initialize the driver.
+
+**/
+EFI_STATUS
+EFIAPI
+TimerDriverInitialize (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+
+  //
+  // Initialize the pointer to our notify function.
+  //
+  mTimerNotifyFunction = NULL;
+
+  //
+  // Make sure the Timer Architectural Protocol is not already installed in the system
+  //
+  ASSERT_PROTOCOL_ALREADY_INSTALLED (NULL, &gEfiTimerArchProtocolGuid);
+
+  //
+  // Find the CPU architectural protocol.
+  //
+  Status = gBS->LocateProtocol (&gEfiCpuArchProtocolGuid, NULL, (VOID **) &mCpu);
+  ASSERT_EFI_ERROR (Status);
+
+  //
+  // Pick the timer mode
+  //
+  mTscFrequency = TimerDriverGetTscDeadlineFrequency ();
+  if (mTscFrequency != 0) {
+    TimerDriverEnableTscDeadlineMode ();
+    DEBUG ((DEBUG_INFO, "%a: TSC-deadline mode, TSC at %Lu Hz\n",
+      __FUNCTION__, mTscFrequency));
+  } else {
+    mApicTimerFrequency = TimerDriverCalibrateApicTimer ();
+    if (mApicTimerFrequency == 0) {
+      DEBUG ((DEBUG_ERROR, "%a: local APIC timer is not running\n",
+        __FUNCTION__));
+      return EFI_DEVICE_ERROR;
+    }
+    DEBUG ((DEBUG_INFO, "%a: periodic mode, local APIC timer at %u Hz\n",
+      __FUNCTION__, mApicTimerFrequency));
+  }
+
+  //
+  // Force the timer to be disabled
+  //
+  Status = TimerDriverSetTimerPeriod (&mTimer, 0);
+  ASSERT_EFI_ERROR (Status);
+
+  //
+  // Install interrupt handler for Local APIC Timer
+  //
+  Status = mCpu->RegisterInterruptHandler (mCpu, LOCAL_APIC_TIMER_VECTOR,
+                                           TimerInterruptHandler);
+  ASSERT_EFI_ERROR (Status);
+
+  //
+  // Force the timer to be enabled at its default period
+  //
+  Status = TimerDriverSetTimerPeriod (&mTimer, DEFAULT_TIMER_TICK_DURATION);
+  ASSERT_EFI_ERROR (Status);
+
+  //
+  // Install the Timer Architectural Protocol onto a new handle
+  //
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &mTimerHandle,
+                  &gEfiTimerArchProtocolGuid, &mTimer,
+                  NULL
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  return Status;
+}
+
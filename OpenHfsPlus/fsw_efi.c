@@ -230,6 +230,65 @@ EFI_STATUS EFIAPI fsw_efi_DriverBinding_Supported(IN EFI_DRIVER_BINDING_PROTOCOL
     return Status;
 }
 
+/**
+ * Close the Disk I/O 2 protocol opened by fsw_efi_open_disk_io2, along with
+ * the events of the read tokens. Does nothing if it was not opened.
+ */
+
+static void fsw_efi_close_disk_io2(IN FSW_VOLUME_DATA *Volume,
+                                   IN EFI_HANDLE DriverBindingHandle)
+{
+    UINTN               i;
+    
+    if (Volume->DiskIo2 == NULL)
+        return;
+    
+    for (i = 0; i < FSW_EFI_MAX_ASYNC_READS; i++) {
+        if (Volume->ReadTokens[i].Event != NULL) {
+            BS->CloseEvent(Volume->ReadTokens[i].Event);
+            Volume->ReadTokens[i].Event = NULL;
+        }
+    }
+    BS->CloseProtocol(Volume->Handle,
+                      &gEfiDiskIo2ProtocolGuid,
+                      DriverBindingHandle,
+                      Volume->Handle);
+    Volume->DiskIo2 = NULL;
+}
+
+/**
+ * Open the Disk I/O 2 protocol on the volume's device, if it has one, and
+ * create the events of the read tokens. Large file reads then go straight
+ * from the disk to the caller's buffer through it, see fsw_efi_file_read;
+ * everything else still uses Disk I/O and the FSW block cache.
+ */
+
+static void fsw_efi_open_disk_io2(IN FSW_VOLUME_DATA *Volume,
+                                  IN EFI_HANDLE DriverBindingHandle)
+{
+    EFI_STATUS          Status;
+    UINTN               i;
+    
+    Status = BS->OpenProtocol(Volume->Handle,
+                              &gEfiDiskIo2ProtocolGuid,
+                              (VOID **) &Volume->DiskIo2,
+                              DriverBindingHandle,
+                              Volume->Handle,
+                              EFI_OPEN_PROTOCOL_BY_DRIVER);
+    if (EFI_ERROR(Status)) {
+        Volume->DiskIo2 = NULL;
+        return;
+    }
+    
+    for (i = 0; i < FSW_EFI_MAX_ASYNC_READS; i++) {
+        Status = BS->CreateEvent(0, 0, NULL, NULL, &Volume->ReadTokens[i].Event);
+        if (EFI_ERROR(Status)) {
+            fsw_efi_close_disk_io2(Volume, DriverBindingHandle);
+            return;
+        }
+    }
+}
+
 /**
  * Driver Binding EFI protocol, Start function. This function is called by EFI
  * to start driving the given device. It is still possible at this point to
@@ -238,7 +297,8 @@ EFI_STATUS EFIAPI fsw_efi_DriverBinding_Supported(IN EFI_DRIVER_BINDING_PROTOCOL
  *
  * This function allocates memory for a per-volume structure, opens the
  * required protocols (just Disk I/O in our case, Block I/O is only looked
- * at to get the MediaId field), and lets the FSW core mount the file system.
+ * at to get the MediaId field; Disk I/O 2 is used when present), and lets
+ * the FSW core mount the file system.
  * If successful, an EFI Simple File System protocol is exported on the
  * device handle.
  */
@@ -286,11 +346,14 @@ EFI_STATUS EFIAPI fsw_efi_DriverBinding_Start(IN EFI_DRIVER_BINDING_PROTOCOL  *T
     Volume->DiskIo          = DiskIo;
     Volume->MediaId         = BlockIo->Media->MediaId;
     Volume->LastIOStatus    = EFI_SUCCESS;
+    fsw_efi_open_disk_io2(Volume, This->DriverBindingHandle);
     
     // mount the filesystem
+    BootTimelineBegin("HfsPlusMount");
     Status = fsw_efi_map_status(fsw_mount(Volume, &fsw_efi_host_table,
                                           &FSW_FSTYPE_TABLE_NAME(FSTYPE), &Volume->vol),
                                 Volume);
+    BootTimelineEnd("HfsPlusMount");
     
     if (!EFI_ERROR(Status)) {
         // register the SimpleFileSystem protocol
@@ -307,6 +370,7 @@ EFI_STATUS EFIAPI fsw_efi_DriverBinding_Start(IN EFI_DRIVER_BINDING_PROTOCOL  *T
     if (EFI_ERROR(Status)) {
         if (Volume->vol != NULL)
             fsw_unmount(Volume->vol);
+        fsw_efi_close_disk_io2(Volume, This->DriverBindingHandle);
         FreePool(Volume);
         
         BS->CloseProtocol(ControllerHandle,
@@ -369,6 +433,7 @@ EFI_STATUS EFIAPI fsw_efi_DriverBinding_Stop(IN  EFI_DRIVER_BINDING_PROTOCOL  *T
     // release private data structure
     if (Volume->vol != NULL)
         fsw_unmount(Volume->vol);
+    fsw_efi_close_disk_io2(Volume, This->DriverBindingHandle);
     FreePool(Volume);
     
     // close the consumed protocols
@@ -711,8 +776,160 @@ EFI_STATUS fsw_efi_dnode_to_FileHandle(IN struct fsw_dnode *dno,
     return EFI_SUCCESS;
 }
 
+/** Reads at least this large go through fsw_efi_file_read_async when possible. */
+#define FSW_EFI_ASYNC_READ_MIN  (64 * 1024)
+
+/**
+ * Check whether the caller runs at TPL_APPLICATION, so that it may wait for
+ * Disk I/O 2 reads to complete.
+ */
+
+static BOOLEAN fsw_efi_can_wait(void)
+{
+    EFI_TPL             OldTpl;
+    
+    OldTpl = BS->RaiseTPL(TPL_HIGH_LEVEL);
+    BS->RestoreTPL(OldTpl);
+    return (BOOLEAN)(OldTpl == TPL_APPLICATION);
+}
+
 /**
- * Data read function for regular files. Calls through to fsw_shandle_read.
+ * Wait for the first Count read tokens of the volume to complete. Returns the
+ * first error reported by any of them.
+ */
+
+static EFI_STATUS fsw_efi_wait_reads(IN FSW_VOLUME_DATA *Volume,
+                                     IN UINTN Count)
+{
+    EFI_STATUS          Status, WaitStatus;
+    UINTN               i, Index;
+    
+    Status = EFI_SUCCESS;
+    for (i = 0; i < Count; i++) {
+        WaitStatus = BS->WaitForEvent(1, &Volume->ReadTokens[i].Event, &Index);
+        if (EFI_ERROR(WaitStatus) && !EFI_ERROR(Status))
+            Status = WaitStatus;
+        if (EFI_ERROR(Volume->ReadTokens[i].TransactionStatus) && !EFI_ERROR(Status))
+            Status = Volume->ReadTokens[i].TransactionStatus;
+    }
+    return Status;
+}
+
+/**
+ * Data read function for regular files through Disk I/O 2. Walks the extents
+ * of the requested range like fsw_shandle_read, but issues every on-disk
+ * extent as one ReadDiskEx request straight into the caller's buffer, with up
+ * to FSW_EFI_MAX_ASYNC_READS of them in flight, and waits for them together.
+ * The file position only moves if all of them succeed.
+ */
+
+static EFI_STATUS fsw_efi_file_read_async(IN FSW_FILE_DATA *File,
+                                          IN OUT fsw_u32 *BufferSize,
+                                          OUT VOID *Buffer)
+{
+    EFI_STATUS          Status, WaitStatus;
+    fsw_status_t        fsw_status;
+    struct fsw_shandle  *shand = &File->shand;
+    struct fsw_dnode    *dno = shand->dnode;
+    struct fsw_volume   *vol = dno->vol;
+    FSW_VOLUME_DATA     *Volume = (FSW_VOLUME_DATA *)vol->host_data;
+    fsw_u8              *buffer;
+    fsw_u32             buflen, copylen, pos;
+    fsw_u32             log_bno, pos_in_extent;
+    UINTN               Pending;
+    
+    if (shand->pos >= dno->size) {   // already at EOF
+        *BufferSize = 0;
+        return EFI_SUCCESS;
+    }
+    
+    // initialize vars
+    buffer = Buffer;
+    buflen = *BufferSize;
+    pos = (fsw_u32)shand->pos;
+    // restrict read to file size
+    if (buflen > dno->size - pos)
+        buflen = (fsw_u32)(dno->size - pos);
+    
+    Status = EFI_SUCCESS;
+    Pending = 0;
+    while (buflen > 0) {
+        // get extent for the current logical block
+        log_bno = pos / vol->log_blocksize;
+        if (shand->extent.type == FSW_EXTENT_TYPE_INVALID ||
+            log_bno < shand->extent.log_start ||
+            log_bno >= shand->extent.log_start + shand->extent.log_count) {
+            
+            if (shand->extent.type == FSW_EXTENT_TYPE_BUFFER)
+                fsw_free(shand->extent.buffer);
+            
+            // ask the file system for the proper extent
+            shand->extent.log_start = log_bno;
+            fsw_status = vol->fstype_table->get_extent(vol, dno, &shand->extent);
+            if (fsw_status) {
+                shand->extent.type = FSW_EXTENT_TYPE_INVALID;
+                Status = fsw_efi_map_status(fsw_status, Volume);
+                break;
+            }
+        }
+        
+        pos_in_extent = pos - shand->extent.log_start * vol->log_blocksize;
+        copylen = shand->extent.log_count * vol->log_blocksize - pos_in_extent;
+        if (copylen > buflen)
+            copylen = buflen;
+        
+        // dispatch by extent type
+        if (shand->extent.type == FSW_EXTENT_TYPE_PHYSBLOCK) {
+            // make room for one more request
+            if (Pending == FSW_EFI_MAX_ASYNC_READS) {
+                Status = fsw_efi_wait_reads(Volume, Pending);
+                Pending = 0;
+                if (EFI_ERROR(Status))
+                    break;
+            }
+            
+            // read the rest of the extent, up to the end of the request
+            Volume->ReadTokens[Pending].TransactionStatus = EFI_SUCCESS;
+            Status = Volume->DiskIo2->ReadDiskEx(Volume->DiskIo2, Volume->MediaId,
+                                                 (UINT64)shand->extent.phys_start * vol->phys_blocksize + pos_in_extent,
+                                                 &Volume->ReadTokens[Pending],
+                                                 copylen,
+                                                 buffer);
+            if (EFI_ERROR(Status))
+                break;
+            Pending++;
+            
+        } else if (shand->extent.type == FSW_EXTENT_TYPE_BUFFER) {
+            fsw_memcpy(buffer, (fsw_u8 *)shand->extent.buffer + pos_in_extent, copylen);
+            
+        } else {   // _SPARSE or _INVALID
+            fsw_memzero(buffer, copylen);
+            
+        }
+        
+        buffer += copylen;
+        buflen -= copylen;
+        pos    += copylen;
+    }
+    
+    // the requests in flight write to the caller's buffer, always wait for them
+    WaitStatus = fsw_efi_wait_reads(Volume, Pending);
+    if (!EFI_ERROR(Status))
+        Status = WaitStatus;
+    if (EFI_ERROR(Status)) {
+        Volume->LastIOStatus = Status;
+        return Status;
+    }
+    
+    *BufferSize = (fsw_u32)(pos - shand->pos);
+    shand->pos = pos;
+    
+    return EFI_SUCCESS;
+}
+
+/**
+ * Data read function for regular files. Large reads on a device with Disk I/O 2
+ * go through fsw_efi_file_read_async, everything else through fsw_shandle_read.
  */
 
 EFI_STATUS fsw_efi_file_read(IN FSW_FILE_DATA *File,
@@ -721,14 +938,19 @@ EFI_STATUS fsw_efi_file_read(IN FSW_FILE_DATA *File,
 {
     EFI_STATUS          Status;
     fsw_u32             buffer_size;
+    FSW_VOLUME_DATA     *Volume = (FSW_VOLUME_DATA *)File->shand.dnode->vol->host_data;
     
 #if DEBUG_LEVEL
     Print(L"fsw_efi_file_read %d bytes\n", *BufferSize);
 #endif
     
     buffer_size = (fsw_u32) *BufferSize;
-    Status = fsw_efi_map_status(fsw_shandle_read(&File->shand, &buffer_size, Buffer),
-                                (FSW_VOLUME_DATA *)File->shand.dnode->vol->host_data);
+    if (Volume->DiskIo2 != NULL && buffer_size >= FSW_EFI_ASYNC_READ_MIN && fsw_efi_can_wait()) {
+        Status = fsw_efi_file_read_async(File, &buffer_size, Buffer);
+    } else {
+        Status = fsw_efi_map_status(fsw_shandle_read(&File->shand, &buffer_size, Buffer),
+                                    Volume);
+    }
     *BufferSize = buffer_size;
     
     return Status;
@@ -42,6 +42,9 @@
 #include "fsw_core.h"
 
 
+/** Maximum number of Disk I/O 2 reads a file read keeps in flight. */
+#define FSW_EFI_MAX_ASYNC_READS  (32)
+
 /**
  * EFI Host: Private per-volume structure.
  */
@@ -53,6 +56,8 @@ typedef struct {
     
     EFI_HANDLE                  Handle;         //!< The device handle the protocol is attached to
     EFI_DISK_IO                 *DiskIo;        //!< The Disk I/O protocol we use for disk access
+    EFI_DISK_IO2_PROTOCOL       *DiskIo2;       //!< The Disk I/O 2 protocol for file data, or NULL
+    EFI_DISK_IO2_TOKEN          ReadTokens[FSW_EFI_MAX_ASYNC_READS];  //!< Tokens for the Disk I/O 2 reads
     UINT32                      MediaId;        //!< The media ID from the Block I/O protocol
     EFI_STATUS                  LastIOStatus;   //!< Last status from Disk I/O
     
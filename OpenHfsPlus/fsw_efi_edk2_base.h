@@ -43,6 +43,7 @@
 # include <Uefi.h>
 # include <Library/DebugLib.h>
 # include <Library/BaseLib.h>
+# include <Library/BootTimelineLib.h>
 # include <Protocol/DriverBinding.h>
 # include <Library/BaseMemoryLib.h>
 # include <Library/UefiRuntimeServicesTableLib.h>
@@ -59,6 +60,7 @@
 # include <Protocol/SimpleFileSystem.h>
 # include <Protocol/BlockIo.h>
 # include <Protocol/DiskIo.h>
+# include <Protocol/DiskIo2.h>
 # include <Guid/FileSystemInfo.h>
 # include <Guid/FileInfo.h>
 # include <Guid/FileSystemVolumeLabelInfo.h>
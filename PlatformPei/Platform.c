@@ -17,6 +17,7 @@
 // The Library classes this module consumes
 //
 #include <Library/BaseLib.h>
+#include <Library/BootTimelineLib.h>
 #include <Library/DebugLib.h>
 #include <Library/HobLib.h>
 #include <Library/IoLib.h>
@@ -699,6 +700,7 @@ InitializePlatform (
 {
   EFI_STATUS    Status;
 
+  BootTimelineBegin ("PlatformPei");
   DEBUG ((DEBUG_INFO, "Platform PEIM Loaded\n"));
 
   DebugDumpCmos ();
@@ -755,5 +757,6 @@ InitializePlatform (
   MiscInitialization ();
   InstallFeatureControlCallback ();
 
+  BootTimelineEnd ("PlatformPei");
   return EFI_SUCCESS;
 }
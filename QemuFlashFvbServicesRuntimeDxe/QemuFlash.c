@@ -19,17 +19,59 @@
 #define CLEAR_STATUS_CMD         0x50
 #define READ_STATUS_CMD          0x70
 #define READ_DEVID_CMD           0x90
+#define CFI_QUERY_CMD            0x98
 #define BLOCK_ERASE_CONFIRM_CMD  0xd0
+#define WRITE_BUFFER_CMD         0xe8
+#define WRITE_BUFFER_CONFIRM_CMD 0xd0
 #define READ_ARRAY_CMD           0xff
 
 #define CLEARED_ARRAY_STATUS  0x00
 
+//
+// CFI query table offsets (for an 8-bit bank), see the Common Flash Interface
+// specification.
+//
+#define CFI_QUERY_SIGNATURE_OFFSET     0x10
+#define CFI_QUERY_WRITE_BUFFER_OFFSET  0x2a
+
+//
+// The word count of the buffered program command is a single byte on an 8-bit
+// bank, which limits one command to 256 bytes.
+//
+#define MAX_WRITE_BUFFER_SIZE  256
+
+//
+// Runs of differing bytes that are separated by fewer matching bytes than this
+// are programmed with one buffered program command. Reprogramming a matching
+// byte costs one MMIO write, while starting a new command costs four: the
+// command, the word count, the confirmation and the return to read array mode.
+//
+#define MAX_MERGED_MATCHING_BYTES  4
+
+//
+// Running totals of the work done by QemuFlashWrite() during this boot.
+//
+typedef struct {
+  UINT64 BytesRequested;
+  UINT64 BytesSkipped;
+  UINT64 BytesProgrammed;
+  UINT64 MmioWrites;
+  UINT64 MmioWritesSaved;
+} QEMU_FLASH_WRITE_STATS;
+
 
 UINT8 *mFlashBase;
 
 STATIC UINTN       mFdBlockSize = 0;
 STATIC UINTN       mFdBlockCount = 0;
 
+//
+// The size of the write buffer of the flash device, or zero if the buffered
+// program command is not used.
+//
+STATIC UINTN                  mWriteBufferSize = 0;
+STATIC QEMU_FLASH_WRITE_STATS mWriteStats;
+
 STATIC
 volatile UINT8*
 QemuFlashPtr (
@@ -124,6 +166,99 @@ QemuFlashDetected (
 }
 
 
+/**
+  Query the size of the write buffer of the flash device, for the buffered
+  program command, through the Common Flash Interface.
+
+  @return  The size of the write buffer in bytes, or zero if the device does
+           not support buffered programming.
+
+**/
+STATIC
+UINTN
+QemuFlashQueryWriteBufferSize (
+  VOID
+  )
+{
+  volatile UINT8 *Ptr;
+  UINT8          BufferSizeShift;
+  UINTN          BufferSize;
+
+  Ptr = QemuFlashPtr (0, 0);
+  QemuFlashPtrWrite (Ptr, CFI_QUERY_CMD);
+  if (Ptr[CFI_QUERY_SIGNATURE_OFFSET] != 'Q' ||
+      Ptr[CFI_QUERY_SIGNATURE_OFFSET + 1] != 'R' ||
+      Ptr[CFI_QUERY_SIGNATURE_OFFSET + 2] != 'Y') {
+    QemuFlashPtrWrite (Ptr, READ_ARRAY_CMD);
+    return 0;
+  }
+  BufferSizeShift = Ptr[CFI_QUERY_WRITE_BUFFER_OFFSET];
+  QemuFlashPtrWrite (Ptr, READ_ARRAY_CMD);
+
+  if (BufferSizeShift == 0 || BufferSizeShift >= 16) {
+    return 0;
+  }
+  BufferSize = MIN ((UINTN)1 << BufferSizeShift, MAX_WRITE_BUFFER_SIZE);
+
+  //
+  // A buffered program command must stay within one aligned buffer-sized
+  // window; a block must consist of whole windows.
+  //
+  if (mFdBlockSize % BufferSize != 0) {
+    return 0;
+  }
+  return BufferSize;
+}
+
+
+/**
+  Program a run of bytes, and return the flash to read array mode.
+
+  The run must not cross a write buffer window if the buffered program command
+  is used.
+
+  @param[in] Ptr     The flash location to start programming at.
+  @param[in] Buffer  The data to program.
+  @param[in] Length  The number of bytes to program; at least one.
+
+  @return  The number of MMIO writes issued.
+
+**/
+STATIC
+UINTN
+QemuFlashProgramRun (
+  IN volatile UINT8 *Ptr,
+  IN CONST UINT8    *Buffer,
+  IN UINTN          Length
+  )
+{
+  UINTN Loop;
+
+  //
+  // Programming byte by byte costs two MMIO writes per byte, while the
+  // buffered program command costs one per byte plus three for the command.
+  //
+  if (mWriteBufferSize == 0 || Length < 4) {
+    for (Loop = 0; Loop < Length; Loop++) {
+      QemuFlashPtrWrite (Ptr + Loop, WRITE_BYTE_CMD);
+      QemuFlashPtrWrite (Ptr + Loop, Buffer[Loop]);
+    }
+    QemuFlashPtrWrite (Ptr + Length - 1, READ_ARRAY_CMD);
+    return 2 * Length + 1;
+  }
+
+  ASSERT (Length <= mWriteBufferSize);
+  QemuFlashPtrWrite (Ptr, WRITE_BUFFER_CMD);
+  QemuFlashPtrWrite (Ptr, (UINT8)(Length - 1));
+  for (Loop = 0; Loop < Length; Loop++) {
+    QemuFlashPtrWrite (Ptr + Loop, Buffer[Loop]);
+  }
+  QemuFlashPtrWrite (Ptr, WRITE_BUFFER_CONFIRM_CMD);
+  QemuFlashPtrWrite (Ptr, READ_ARRAY_CMD);
+  return Length + 4;
+}
+
+
 /**
   Read from QEMU Flash
 
@@ -183,6 +318,10 @@ QemuFlashWrite (
 {
   volatile UINT8  *Ptr;
   UINTN           Loop;
+  UINTN           Start;
+  UINTN           End;
+  UINTN           Limit;
+  UINTN           MmioWrites;
 
   //
   // Only write to the first 64k. We don't bother saving the FTW Spare
@@ -192,23 +331,83 @@ QemuFlashWrite (
     return EFI_INVALID_PARAMETER;
   }
 
+  Ptr = QemuFlashPtr (Lba, Offset);
+  MmioWrites = 0;
+
   //
-  // Program flash
+  // Flash programming can only clear bits. If the new data needs any bit set,
+  // program every byte as requested, the way the device has always been
+  // written to.
   //
-  Ptr = QemuFlashPtr (Lba, Offset);
   for (Loop = 0; Loop < *NumBytes; Loop++) {
-    QemuFlashPtrWrite (Ptr, WRITE_BYTE_CMD);
-    QemuFlashPtrWrite (Ptr, Buffer[Loop]);
-
-    Ptr++;
+    if ((Ptr[Loop] & Buffer[Loop]) != Buffer[Loop]) {
+      break;
+    }
+  }
+  if (Loop < *NumBytes) {
+    DEBUG ((DEBUG_VERBOSE, "%a: Lba=0x%Lx Offset=0x%Lx sets bits, writing "
+      "bytewise\n", __FUNCTION__, (UINT64)Lba, (UINT64)Offset));
+    for (Loop = 0; Loop < *NumBytes; Loop++) {
+      QemuFlashPtrWrite (Ptr + Loop, WRITE_BYTE_CMD);
+      QemuFlashPtrWrite (Ptr + Loop, Buffer[Loop]);
+    }
+    if (*NumBytes > 0) {
+      QemuFlashPtrWrite (Ptr + *NumBytes - 1, READ_ARRAY_CMD);
+      MmioWrites = 2 * *NumBytes + 1;
+    }
+    mWriteStats.BytesProgrammed += *NumBytes;
+  } else {
+    //
+    // Program only the runs of bytes that differ from the flash contents.
+    // Reading the flash in read array mode causes no MMIO exits.
+    //
+    Start = 0;
+    while (Start < *NumBytes) {
+      if (Ptr[Start] == Buffer[Start]) {
+        Start++;
+        mWriteStats.BytesSkipped++;
+        continue;
+      }
+
+      //
+      // Extend the run up to the end of the write buffer window, while the
+      // matching bytes in between are cheaper to reprogram than to skip.
+      //
+      Limit = *NumBytes;
+      if (mWriteBufferSize != 0) {
+        Limit = MIN (Limit,
+                  Start + mWriteBufferSize -
+                  ((UINTN)(Ptr + Start - mFlashBase) % mWriteBufferSize));
+      }
+      End = Start + 1;
+      for (Loop = End; Loop < Limit; Loop++) {
+        if (Ptr[Loop] != Buffer[Loop]) {
+          End = Loop + 1;
+        } else if (Loop - End + 1 >= MAX_MERGED_MATCHING_BYTES) {
+          break;
+        }
+      }
+
+      MmioWrites += QemuFlashProgramRun (Ptr + Start, Buffer + Start,
+                      End - Start);
+      mWriteStats.BytesProgrammed += End - Start;
+      Start = End;
+    }
   }
 
+  mWriteStats.BytesRequested  += *NumBytes;
+  mWriteStats.MmioWrites      += MmioWrites;
   //
-  // Restore flash to read mode
+  // Byte programming costs two MMIO writes per byte, plus one for returning
+  // to read array mode.
   //
-  if (*NumBytes > 0) {
-    QemuFlashPtrWrite (Ptr - 1, READ_ARRAY_CMD);
+  if (*NumBytes > 0 && 2 * *NumBytes + 1 > MmioWrites) {
+    mWriteStats.MmioWritesSaved += 2 * *NumBytes + 1 - MmioWrites;
   }
+  DEBUG ((DEBUG_VERBOSE, "%a: requested=%Lu skipped=%Lu programmed=%Lu "
+    "mmio=%Lu saved=%Lu\n", __FUNCTION__, mWriteStats.BytesRequested,
+    mWriteStats.BytesSkipped, mWriteStats.BytesProgrammed,
+    mWriteStats.MmioWrites, mWriteStats.MmioWritesSaved));
 
   return EFI_SUCCESS;
 }
@@ -269,6 +468,17 @@ QemuFlashInitialize (
     return EFI_WRITE_PROTECTED;
   }
 
+  //
+  // With SEV-ES, the flash is only ever written through VMGEXIT (see
+  // QemuFlashDetected()), and it cannot be read in query mode; stick with
+  // byte programming.
+  //
+  if (!MemEncryptSevEsIsEnabled ()) {
+    mWriteBufferSize = QemuFlashQueryWriteBufferSize ();
+  }
+  DEBUG ((DEBUG_INFO, "QEMU Flash: write buffer size %Lu\n",
+    (UINT64)mWriteBufferSize));
+
   return EFI_SUCCESS;
 }
 
@@ -21,6 +21,7 @@
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/QemuFwCfgLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Protocol/DevicePath.h>
@@ -44,7 +45,11 @@ typedef struct {
     UINT32                      Size;
   }                             FwCfgItem[2];
   UINT32                        Size;
-  UINT8                         *Data;
+  UINT8                         *Data;         // Cached copy of the blob,
+                                               // or NULL.
+  UINT64                        TransferBytes; // Bytes read from fw_cfg.
+  UINT64                        TransferTicks; // Performance counter ticks
+                                               // spent reading them.
 } KERNEL_BLOB;
 
 STATIC KERNEL_BLOB mKernelBlob[KernelBlobTypeMax] = {
@@ -64,6 +69,14 @@ STATIC KERNEL_BLOB mKernelBlob[KernelBlobTypeMax] = {
 
 STATIC UINT64 mTotalBlobBytes;
 
+//
+// Set if fw_cfg offers the DMA access method. Only then are blobs read
+// straight from fw_cfg into the callers' buffers, at any offset; without DMA,
+// QemuFwCfgSkipBytes() would have to read and drop the data before the offset
+// through the IO port.
+//
+STATIC BOOLEAN mFwCfgDmaAvailable;
+
 //
 // Device path for the handle that incorporates our "EFI stub filesystem".
 //
@@ -100,6 +113,221 @@ STATIC CONST SINGLE_VENMEDIA_NODE_DEVPATH mInitrdDevicePath = {
   }
 };
 
+//
+// On-demand access to the blob contents.
+//
+
+/**
+  Return the number of performance counter ticks between two counter values,
+  allowing for at most one rollover of the counter.
+
+  @param[in] StartTick  Counter value at the start of the interval.
+  @param[in] EndTick    Counter value at the end of the interval.
+
+  @return  The length of the interval in ticks.
+**/
+STATIC
+UINT64
+GetElapsedTicks (
+  IN UINT64 StartTick,
+  IN UINT64 EndTick
+  )
+{
+  UINT64 CounterStart;
+  UINT64 CounterEnd;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart < CounterEnd) {
+    if (EndTick >= StartTick) {
+      return EndTick - StartTick;
+    }
+    return (CounterEnd - StartTick) + (EndTick - CounterStart) + 1;
+  }
+
+  if (StartTick >= EndTick) {
+    return StartTick - EndTick;
+  }
+  return (StartTick - CounterEnd) + (CounterStart - EndTick) + 1;
+}
+
+/**
+  Log how many bytes have been read from fw_cfg for a blob so far, and at what
+  bandwidth.
+
+  @param[in] Blob  The KERNEL_BLOB to report on.
+**/
+STATIC
+VOID
+LogBlobTransfer (
+  IN CONST KERNEL_BLOB *Blob
+  )
+{
+  UINT64 MicroSeconds;
+  UINT64 KibPerSecond;
+
+  MicroSeconds = DivU64x32 (GetTimeInNanoSecond (Blob->TransferTicks), 1000);
+  KibPerSecond = 0;
+  if (MicroSeconds > 0) {
+    KibPerSecond = DivU64x64Remainder (
+                     MultU64x32 (Blob->TransferBytes, 1000000),
+                     MultU64x32 (MicroSeconds, SIZE_1KB),
+                     NULL
+                     );
+  }
+
+  DEBUG ((DEBUG_INFO, "%a: \"%s\": %Lu bytes in %Lu us (%Lu KB/s)\n",
+    __FUNCTION__, Blob->Name, Blob->TransferBytes, MicroSeconds,
+    KibPerSecond));
+}
+
+/**
+  Read a range of a blob from fw_cfg into a buffer.
+
+  The fw_cfg items making up the blob are selected afresh, so the read does not
+  depend on the state that other fw_cfg users may have left behind.
+
+  @param[in,out] Blob    The KERNEL_BLOB to read from. Its transfer statistics
+                         are updated.
+  @param[in]     Offset  Offset of the range in the blob.
+  @param[in]     Size    Size of the range. Offset + Size must not exceed the
+                         size of the blob.
+  @param[out]    Buffer  The buffer to read the range into.
+**/
+STATIC
+VOID
+ReadBlobBytes (
+  IN OUT KERNEL_BLOB *Blob,
+  IN     UINT64      Offset,
+  IN     UINTN       Size,
+  OUT    UINT8       *Buffer
+  )
+{
+  UINTN  Idx;
+  UINTN  Left;
+  UINTN  ItemLeft;
+  UINTN  Chunk;
+  UINT64 StartTick;
+
+  ASSERT (Offset + Size <= Blob->Size);
+
+  Left = Size;
+  for (Idx = 0; Idx < ARRAY_SIZE (Blob->FwCfgItem) && Left > 0; Idx++) {
+    if (Blob->FwCfgItem[Idx].DataKey == 0) {
+      break;
+    }
+    if (Offset >= Blob->FwCfgItem[Idx].Size) {
+      Offset -= Blob->FwCfgItem[Idx].Size;
+      continue;
+    }
+
+    QemuFwCfgSelectItem (Blob->FwCfgItem[Idx].DataKey);
+    QemuFwCfgSkipBytes ((UINTN)Offset);
+
+    ItemLeft = (UINTN)MIN (Left, Blob->FwCfgItem[Idx].Size - Offset);
+    Left    -= ItemLeft;
+    Offset   = 0;
+    while (ItemLeft > 0) {
+      Chunk = MIN (ItemLeft, SIZE_1MB);
+
+      StartTick = GetPerformanceCounter ();
+      QemuFwCfgReadBytes (Chunk, Buffer);
+      Blob->TransferTicks += GetElapsedTicks (StartTick,
+                               GetPerformanceCounter ());
+      Blob->TransferBytes += Chunk;
+
+      Buffer   += Chunk;
+      ItemLeft -= Chunk;
+      DEBUG ((DEBUG_VERBOSE, "%a: %Ld bytes remaining for \"%s\" (%d)\n",
+        __FUNCTION__, (INT64)(ItemLeft + Left), Blob->Name, (INT32)Idx));
+    }
+  }
+}
+
+/**
+  Populate the cached copy of a blob in mKernelBlob.
+
+  param[in,out] Blob  Pointer to the KERNEL_BLOB element in mKernelBlob that is
+                      to be filled from fw_cfg.
+
+  @retval EFI_SUCCESS           Blob->Data has been populated, or it had been
+                                populated before.
+
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory for Blob->Data.
+**/
+STATIC
+EFI_STATUS
+FetchBlob (
+  IN OUT KERNEL_BLOB *Blob
+  )
+{
+  if (Blob->Data != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Blob->Data = AllocatePages (EFI_SIZE_TO_PAGES ((UINTN)Blob->Size));
+  if (Blob->Data == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a: failed to allocate %Ld bytes for \"%s\"\n",
+      __FUNCTION__, (INT64)Blob->Size, Blob->Name));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  DEBUG ((DEBUG_INFO, "%a: loading %Ld bytes for \"%s\"\n", __FUNCTION__,
+    (INT64)Blob->Size, Blob->Name));
+
+  ReadBlobBytes (Blob, 0, Blob->Size, Blob->Data);
+  LogBlobTransfer (Blob);
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy a range of a blob into a caller-provided buffer.
+
+  If fw_cfg offers DMA, the range is transferred from fw_cfg straight into
+  Buffer, wherever it starts: the data before Offset is skipped with a DMA
+  skip operation, so seeking back to data that has been read before does not
+  transfer anything twice. Without DMA, the read is served from the cached
+  copy of the blob, which is fetched in full on first need.
+
+  @param[in,out] Blob    The KERNEL_BLOB to read from.
+  @param[in]     Offset  Offset of the range in the blob.
+  @param[in]     Size    Size of the range. Offset + Size must not exceed the
+                         size of the blob.
+  @param[out]    Buffer  The buffer to read the range into.
+
+  @retval EFI_SUCCESS           The range has been read.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory for the cached copy.
+**/
+STATIC
+EFI_STATUS
+ReadBlob (
+  IN OUT KERNEL_BLOB *Blob,
+  IN     UINT64      Offset,
+  IN     UINTN       Size,
+  OUT    VOID        *Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  if (Size == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (Blob->Data == NULL && mFwCfgDmaAvailable) {
+    ReadBlobBytes (Blob, Offset, Size, Buffer);
+    if (Offset + Size == Blob->Size) {
+      LogBlobTransfer (Blob);
+    }
+    return EFI_SUCCESS;
+  }
+
+  Status = FetchBlob (Blob);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  CopyMem (Buffer, Blob->Data + Offset, Size);
+  return EFI_SUCCESS;
+}
+
 //
 // The "file in the EFI stub filesystem" abstraction.
 //
@@ -352,8 +580,9 @@ StubFileRead (
   )
 {
   STUB_FILE         *StubFile;
-  CONST KERNEL_BLOB *Blob;
+  KERNEL_BLOB       *Blob;
   UINT64            Left;
+  EFI_STATUS        Status;
 
   StubFile = STUB_FILE_FROM_FILE (This);
 
@@ -361,8 +590,6 @@ StubFileRead (
   // Scanning the root directory?
   //
   if (StubFile->BlobType == KernelBlobTypeMax) {
-    EFI_STATUS Status;
-
     if (StubFile->Position == KernelBlobTypeMax) {
       //
       // Scanning complete.
@@ -395,8 +622,9 @@ StubFileRead (
   if (*BufferSize > Left) {
     *BufferSize = (UINTN)Left;
   }
-  if (Blob->Data != NULL) {
-    CopyMem (Buffer, Blob->Data + StubFile->Position, *BufferSize);
+  Status = ReadBlob (Blob, StubFile->Position, *BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
   StubFile->Position += *BufferSize;
   return EFI_SUCCESS;
@@ -871,7 +1099,8 @@ InitrdLoadFile2 (
   OUT     VOID                          *Buffer     OPTIONAL
   )
 {
-  CONST KERNEL_BLOB   *InitrdBlob = &mKernelBlob[KernelBlobTypeInitrd];
+  KERNEL_BLOB         *InitrdBlob = &mKernelBlob[KernelBlobTypeInitrd];
+  EFI_STATUS          Status;
 
   ASSERT (InitrdBlob->Size > 0);
 
@@ -893,7 +1122,10 @@ InitrdLoadFile2 (
     return EFI_BUFFER_TOO_SMALL;
   }
 
-  CopyMem (Buffer, InitrdBlob->Data, InitrdBlob->Size);
+  Status = ReadBlob (InitrdBlob, 0, InitrdBlob->Size, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
   *BufferSize = InitrdBlob->Size;
   return EFI_SUCCESS;
@@ -908,30 +1140,21 @@ STATIC CONST EFI_LOAD_FILE2_PROTOCOL     mInitrdLoadFile2 = {
 //
 
 /**
-  Populate a blob in mKernelBlob.
+  Read the size of a blob in mKernelBlob from fw_cfg.
 
-  param[in,out] Blob  Pointer to the KERNEL_BLOB element in mKernelBlob that is
-                      to be filled from fw_cfg.
+  The contents of the blob are fetched on demand, by ReadBlob().
 
-  @retval EFI_SUCCESS           Blob has been populated. If fw_cfg reported a
-                                size of zero for the blob, then Blob->Data has
-                                been left unchanged.
-
-  @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory for Blob->Data.
+  param[in,out] Blob  Pointer to the KERNEL_BLOB element in mKernelBlob whose
+                      size is to be read from fw_cfg.
 **/
 STATIC
-EFI_STATUS
-FetchBlob (
+VOID
+FetchBlobSize (
   IN OUT KERNEL_BLOB *Blob
   )
 {
-  UINT32 Left;
-  UINTN  Idx;
-  UINT8  *ChunkData;
+  UINTN Idx;
 
-  //
-  // Read blob size.
-  //
   Blob->Size = 0;
   for (Idx = 0; Idx < ARRAY_SIZE (Blob->FwCfgItem); Idx++) {
     if (Blob->FwCfgItem[Idx].SizeKey == 0) {
@@ -941,45 +1164,6 @@ FetchBlob (
     Blob->FwCfgItem[Idx].Size = QemuFwCfgRead32 ();
     Blob->Size += Blob->FwCfgItem[Idx].Size;
   }
-  if (Blob->Size == 0) {
-    return EFI_SUCCESS;
-  }
-
-  //
-  // Read blob.
-  //
-  Blob->Data = AllocatePages (EFI_SIZE_TO_PAGES ((UINTN)Blob->Size));
-  if (Blob->Data == NULL) {
-    DEBUG ((DEBUG_ERROR, "%a: failed to allocate %Ld bytes for \"%s\"\n",
-      __FUNCTION__, (INT64)Blob->Size, Blob->Name));
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  DEBUG ((DEBUG_INFO, "%a: loading %Ld bytes for \"%s\"\n", __FUNCTION__,
-    (INT64)Blob->Size, Blob->Name));
-
-  ChunkData = Blob->Data;
-  for (Idx = 0; Idx < ARRAY_SIZE (Blob->FwCfgItem); Idx++) {
-    if (Blob->FwCfgItem[Idx].DataKey == 0) {
-      break;
-    }
-    QemuFwCfgSelectItem (Blob->FwCfgItem[Idx].DataKey);
-
-    Left = Blob->FwCfgItem[Idx].Size;
-    while (Left > 0) {
-      UINT32 Chunk;
-
-      Chunk = (Left < SIZE_1MB) ? Left : SIZE_1MB;
-      QemuFwCfgReadBytes (Chunk, ChunkData + Blob->FwCfgItem[Idx].Size - Left);
-      Left -= Chunk;
-      DEBUG ((DEBUG_VERBOSE, "%a: %Ld bytes remaining for \"%s\" (%d)\n",
-        __FUNCTION__, (INT64)Left, Blob->Name, (INT32)Idx));
-    }
-
-    ChunkData += Blob->FwCfgItem[Idx].Size;
-  }
-
-  return EFI_SUCCESS;
 }
 
 
@@ -1011,6 +1195,7 @@ QemuKernelLoaderFsDxeEntrypoint (
   KERNEL_BLOB               *CurrentBlob;
   KERNEL_BLOB               *KernelBlob;
   EFI_STATUS                Status;
+  EFI_STATUS                UninstallStatus;
   EFI_HANDLE                FileSystemHandle;
   EFI_HANDLE                InitrdLoadFile2Handle;
 
@@ -1024,22 +1209,21 @@ QemuKernelLoaderFsDxeEntrypoint (
     return Status;
   }
 
+  QemuFwCfgSelectItem (QemuFwCfgItemInterfaceVersion);
+  mFwCfgDmaAvailable = (QemuFwCfgRead32 () & FW_CFG_F_DMA) != 0;
+
   //
-  // Fetch all blobs.
+  // Size all blobs. Their contents are fetched when first read.
   //
   for (BlobType = 0; BlobType < KernelBlobTypeMax; ++BlobType) {
     CurrentBlob = &mKernelBlob[BlobType];
-    Status = FetchBlob (CurrentBlob);
-    if (EFI_ERROR (Status)) {
-      goto FreeBlobs;
-    }
+    FetchBlobSize (CurrentBlob);
     mTotalBlobBytes += CurrentBlob->Size;
   }
   KernelBlob      = &mKernelBlob[KernelBlobTypeKernel];
 
-  if (KernelBlob->Data == NULL) {
-    Status = EFI_NOT_FOUND;
-    goto FreeBlobs;
+  if (KernelBlob->Size == 0) {
+    return EFI_NOT_FOUND;
   }
 
   //
@@ -1054,7 +1238,7 @@ QemuKernelLoaderFsDxeEntrypoint (
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: InstallMultipleProtocolInterfaces(): %r\n",
       __FUNCTION__, Status));
-    goto FreeBlobs;
+    return Status;
   }
 
   if (KernelBlob[KernelBlobTypeInitrd].Size > 0) {
@@ -1073,22 +1257,11 @@ QemuKernelLoaderFsDxeEntrypoint (
   return EFI_SUCCESS;
 
 UninstallFileSystemHandle:
-  Status = gBS->UninstallMultipleProtocolInterfaces (FileSystemHandle,
-                  &gEfiDevicePathProtocolGuid,       &mFileSystemDevicePath,
-                  &gEfiSimpleFileSystemProtocolGuid, &mFileSystem,
-                  NULL);
-  ASSERT_EFI_ERROR (Status);
-
-FreeBlobs:
-  while (BlobType > 0) {
-    CurrentBlob = &mKernelBlob[--BlobType];
-    if (CurrentBlob->Data != NULL) {
-      FreePages (CurrentBlob->Data,
-        EFI_SIZE_TO_PAGES ((UINTN)CurrentBlob->Size));
-      CurrentBlob->Size = 0;
-      CurrentBlob->Data = NULL;
-    }
-  }
+  UninstallStatus = gBS->UninstallMultipleProtocolInterfaces (FileSystemHandle,
+                           &gEfiDevicePathProtocolGuid, &mFileSystemDevicePath,
+                           &gEfiSimpleFileSystemProtocolGuid, &mFileSystem,
+                           NULL);
+  ASSERT_EFI_ERROR (UninstallStatus);
 
   return Status;
 }
@@ -27,6 +27,7 @@
 #include <Library/LocalApicLib.h>
 #include <Library/CpuExceptionHandlerLib.h>
 #include <Library/MemEncryptSevLib.h>
+#include <Guid/BootTimeline.h>
 #include <Register/Amd/Ghcb.h>
 #include <Register/Amd/Msr.h>
 
@@ -532,11 +533,45 @@ GetS3ResumePeiFv (
 }
 
 
+/**
+  Record a boot timeline probe for PEI to import.
+
+  SEC runs in place from flash, so the records are kept on the stack, in the
+  PPI that SecStartupPhase2() hands over to the PEI core.
+
+  @param[in,out]  Timeline  The records taken so far.
+  @param[in]      Type      BOOT_TIMELINE_BEGIN or BOOT_TIMELINE_END.
+  @param[in]      Name      The name of the probe.
+
+**/
+STATIC
+VOID
+SecBootTimelineRecord (
+  IN OUT BOOT_TIMELINE_SEC_PPI  *Timeline,
+  IN     UINT32                 Type,
+  IN     CONST CHAR8            *Name
+  )
+{
+  BOOT_TIMELINE_RECORD  *Record;
+
+  if (!FeaturePcdGet (PcdBootTimelineEnable) ||
+      Timeline->Header.Count == Timeline->Header.Capacity) {
+    return;
+  }
+
+  Record = &Timeline->Records[Timeline->Header.Count++];
+  Record->Tsc  = AsmReadTsc ();
+  Record->Type = Type;
+  AsciiStrnCpyS (Record->Name, sizeof Record->Name, Name,
+    sizeof Record->Name - 1);
+}
+
 /**
   Locates the PEI Core entry point address
 
   @param[in,out]  Fv                 The firmware volume to search
   @param[out]     PeiCoreEntryPoint  The entry point of the PEI Core image
+  @param[in,out]  Timeline           The boot timeline records of SEC
 
   @retval EFI_SUCCESS           The file and section was found
   @retval EFI_NOT_FOUND         The file and section was not found
@@ -546,7 +581,8 @@ GetS3ResumePeiFv (
 VOID
 FindPeiCoreImageBase (
   IN OUT  EFI_FIRMWARE_VOLUME_HEADER       **BootFv,
-     OUT  EFI_PHYSICAL_ADDRESS             *PeiCoreImageBase
+     OUT  EFI_PHYSICAL_ADDRESS             *PeiCoreImageBase,
+  IN OUT  BOOT_TIMELINE_SEC_PPI            *Timeline
   )
 {
   BOOLEAN S3Resume;
@@ -570,7 +606,9 @@ FindPeiCoreImageBase (
       S3Resume ? "S3 resume (with PEI decompression)" : "Normal boot"));
     FindMainFv (BootFv);
 
+    SecBootTimelineRecord (Timeline, BOOT_TIMELINE_BEGIN, "DecompressMemFvs");
     DecompressMemFvs (BootFv);
+    SecBootTimelineRecord (Timeline, BOOT_TIMELINE_END, "DecompressMemFvs");
   }
 
   FindPeiCoreImageBaseInFv (*BootFv, PeiCoreImageBase);
@@ -675,7 +713,8 @@ FindImageBase (
 VOID
 FindAndReportEntryPoints (
   IN  EFI_FIRMWARE_VOLUME_HEADER       **BootFirmwareVolumePtr,
-  OUT EFI_PEI_CORE_ENTRY_POINT         *PeiCoreEntryPoint
+  OUT EFI_PEI_CORE_ENTRY_POINT         *PeiCoreEntryPoint,
+  IN OUT BOOT_TIMELINE_SEC_PPI         *Timeline
   )
 {
   EFI_STATUS                       Status;
@@ -689,7 +728,7 @@ FindAndReportEntryPoints (
   Status = FindImageBase (*BootFirmwareVolumePtr, &SecCoreImageBase);
   ASSERT_EFI_ERROR (Status);
 
-  FindPeiCoreImageBase (BootFirmwareVolumePtr, &PeiCoreImageBase);
+  FindPeiCoreImageBase (BootFirmwareVolumePtr, &PeiCoreImageBase, Timeline);
 
   ZeroMem ((VOID *) &ImageContext, sizeof (PE_COFF_LOADER_IMAGE_CONTEXT));
   //
@@ -1001,22 +1040,41 @@ SecStartupPhase2(
   EFI_SEC_PEI_HAND_OFF        *SecCoreData;
   EFI_FIRMWARE_VOLUME_HEADER  *BootFv;
   EFI_PEI_CORE_ENTRY_POINT    PeiCoreEntryPoint;
+  BOOT_TIMELINE_SEC_PPI       Timeline;
+  EFI_PEI_PPI_DESCRIPTOR      PpiList[2];
 
   SecCoreData = (EFI_SEC_PEI_HAND_OFF *) Context;
 
+  ZeroMem (&Timeline, sizeof (Timeline));
+  Timeline.Header.Signature = BOOT_TIMELINE_SIGNATURE;
+  Timeline.Header.Revision  = BOOT_TIMELINE_REVISION;
+  Timeline.Header.Capacity  = BOOT_TIMELINE_SEC_RECORDS;
+
   //
   // Find PEI Core entry point. It will report SEC and Pei Core debug information if remote debug
   // is enabled.
   //
   BootFv = (EFI_FIRMWARE_VOLUME_HEADER *)SecCoreData->BootFirmwareVolumeBase;
-  FindAndReportEntryPoints (&BootFv, &PeiCoreEntryPoint);
+  FindAndReportEntryPoints (&BootFv, &PeiCoreEntryPoint, &Timeline);
   SecCoreData->BootFirmwareVolumeBase = BootFv;
   SecCoreData->BootFirmwareVolumeSize = (UINTN) BootFv->FvLength;
 
   //
-  // Transfer the control to the PEI core
+  // Transfer the control to the PEI core. This function does not return, so
+  // the timeline records on its stack stay valid; the PEI core relocates the
+  // PPI along with the stack when it migrates to permanent memory.
   //
-  (*PeiCoreEntryPoint) (SecCoreData, (EFI_PEI_PPI_DESCRIPTOR *)&mPrivateDispatchTable);
+  if (FeaturePcdGet (PcdBootTimelineEnable)) {
+    CopyMem (&PpiList[0], mPrivateDispatchTable, sizeof (PpiList[0]));
+    PpiList[0].Flags = EFI_PEI_PPI_DESCRIPTOR_PPI;
+    PpiList[1].Flags = EFI_PEI_PPI_DESCRIPTOR_PPI |
+                       EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
+    PpiList[1].Guid  = &gOvmfBootTimelineSecPpiGuid;
+    PpiList[1].Ppi   = &Timeline;
+    (*PeiCoreEntryPoint) (SecCoreData, PpiList);
+  } else {
+    (*PeiCoreEntryPoint) (SecCoreData, (EFI_PEI_PPI_DESCRIPTOR *)&mPrivateDispatchTable);
+  }
 
   //
   // If we get here then the PEI Core returned, which is not recoverable.
@@ -0,0 +1,16 @@
+/** @file
+  Stand-in for the AutoGen.h that the EDK II build force-includes in every
+  module source file.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_AUTOGEN_H_
+#define HOST_AUTOGEN_H_
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+
+#endif // HOST_AUTOGEN_H_
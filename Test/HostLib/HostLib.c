@@ -0,0 +1,1285 @@
+/** @file
+  Host instances of the library classes and boot services that the package
+  sources built by the host harnesses under Test/ call.
+
+  Boot services that the benchmarks never reach fail with EFI_UNSUPPORTED.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OrderedCollectionLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "HostLib.h"
+
+//
+// Waits longer than this sleep in the kernel first; the rest is spun.
+//
+#define HOST_SPIN_NS  200000
+
+volatile UINT64 gHostStallCalls;
+
+UINT64
+HostNowNs (
+  VOID
+  )
+{
+  struct timespec Now;
+
+  clock_gettime (CLOCK_MONOTONIC, &Now);
+  return (UINT64)Now.tv_sec * 1000000000 + (UINT64)Now.tv_nsec;
+}
+
+VOID
+HostDelayUntil (
+  IN UINT64 Deadline
+  )
+{
+  UINT64          Now;
+  struct timespec Sleep;
+
+  Now = HostNowNs ();
+  if (Now + HOST_SPIN_NS < Deadline) {
+    Sleep.tv_sec  = (Deadline - HOST_SPIN_NS - Now) / 1000000000;
+    Sleep.tv_nsec = (Deadline - HOST_SPIN_NS - Now) % 1000000000;
+    nanosleep (&Sleep, NULL);
+  }
+  while (HostNowNs () < Deadline) {
+    sched_yield ();
+  }
+}
+
+//
+// BaseLib
+//
+
+VOID
+EFIAPI
+MemoryFence (
+  VOID
+  )
+{
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+}
+
+VOID
+EFIAPI
+CpuPause (
+  VOID
+  )
+{
+  sched_yield ();
+}
+
+UINT64
+EFIAPI
+LShiftU64 (
+  IN UINT64 Operand,
+  IN UINTN  Count
+  )
+{
+  ASSERT (Count < 64);
+  return Operand << Count;
+}
+
+UINT64
+EFIAPI
+RShiftU64 (
+  IN UINT64 Operand,
+  IN UINTN  Count
+  )
+{
+  ASSERT (Count < 64);
+  return Operand >> Count;
+}
+
+UINT64
+EFIAPI
+MultU64x32 (
+  IN UINT64 Multiplicand,
+  IN UINT32 Multiplier
+  )
+{
+  return Multiplicand * Multiplier;
+}
+
+UINT64
+EFIAPI
+MultU64x64 (
+  IN UINT64 Multiplicand,
+  IN UINT64 Multiplier
+  )
+{
+  return Multiplicand * Multiplier;
+}
+
+UINT64
+EFIAPI
+DivU64x32 (
+  IN UINT64 Dividend,
+  IN UINT32 Divisor
+  )
+{
+  ASSERT (Divisor != 0);
+  return Dividend / Divisor;
+}
+
+UINT32
+EFIAPI
+ModU64x32 (
+  IN UINT64 Dividend,
+  IN UINT32 Divisor
+  )
+{
+  ASSERT (Divisor != 0);
+  return (UINT32)(Dividend % Divisor);
+}
+
+UINT64
+EFIAPI
+DivU64x32Remainder (
+  IN  UINT64 Dividend,
+  IN  UINT32 Divisor,
+  OUT UINT32 *Remainder OPTIONAL
+  )
+{
+  ASSERT (Divisor != 0);
+  if (Remainder != NULL) {
+    *Remainder = (UINT32)(Dividend % Divisor);
+  }
+  return Dividend / Divisor;
+}
+
+UINT64
+EFIAPI
+DivU64x64Remainder (
+  IN  UINT64 Dividend,
+  IN  UINT64 Divisor,
+  OUT UINT64 *Remainder OPTIONAL
+  )
+{
+  ASSERT (Divisor != 0);
+  if (Remainder != NULL) {
+    *Remainder = Dividend % Divisor;
+  }
+  return Dividend / Divisor;
+}
+
+UINTN
+EFIAPI
+StrLen (
+  IN CONST CHAR16 *String
+  )
+{
+  UINTN Length;
+
+  for (Length = 0; String[Length] != L'\0'; Length++) {
+  }
+  return Length;
+}
+
+INTN
+EFIAPI
+StrCmp (
+  IN CONST CHAR16 *FirstString,
+  IN CONST CHAR16 *SecondString
+  )
+{
+  while (*FirstString != L'\0' && *FirstString == *SecondString) {
+    FirstString++;
+    SecondString++;
+  }
+  return *FirstString - *SecondString;
+}
+
+INTN
+EFIAPI
+StrnCmp (
+  IN CONST CHAR16 *FirstString,
+  IN CONST CHAR16 *SecondString,
+  IN UINTN        Length
+  )
+{
+  if (Length == 0) {
+    return 0;
+  }
+  while (*FirstString != L'\0' && *FirstString == *SecondString &&
+         Length > 1) {
+    FirstString++;
+    SecondString++;
+    Length--;
+  }
+  return *FirstString - *SecondString;
+}
+
+UINTN
+EFIAPI
+AsciiStrLen (
+  IN CONST CHAR8 *String
+  )
+{
+  return strlen (String);
+}
+
+INTN
+EFIAPI
+AsciiStrCmp (
+  IN CONST CHAR8 *FirstString,
+  IN CONST CHAR8 *SecondString
+  )
+{
+  return strcmp (FirstString, SecondString);
+}
+
+CHAR8 *
+EFIAPI
+AsciiStrStr (
+  IN CONST CHAR8 *String,
+  IN CONST CHAR8 *SearchString
+  )
+{
+  return strstr (String, SearchString);
+}
+
+UINT32
+EFIAPI
+ReadUnaligned32 (
+  IN CONST UINT32 *Buffer
+  )
+{
+  UINT32 Value;
+
+  memcpy (&Value, Buffer, sizeof Value);
+  return Value;
+}
+
+UINT32
+EFIAPI
+AsmCpuid (
+  IN  UINT32 Index,
+  OUT UINT32 *RegisterEax OPTIONAL,
+  OUT UINT32 *RegisterEbx OPTIONAL,
+  OUT UINT32 *RegisterEcx OPTIONAL,
+  OUT UINT32 *RegisterEdx OPTIONAL
+  )
+{
+  UINT32 Eax;
+  UINT32 Ebx;
+  UINT32 Ecx;
+  UINT32 Edx;
+
+  __asm__ __volatile__ (
+    "cpuid"
+    : "=a" (Eax), "=b" (Ebx), "=c" (Ecx), "=d" (Edx)
+    : "a" (Index), "c" (0)
+    );
+  if (RegisterEax != NULL) {
+    *RegisterEax = Eax;
+  }
+  if (RegisterEbx != NULL) {
+    *RegisterEbx = Ebx;
+  }
+  if (RegisterEcx != NULL) {
+    *RegisterEcx = Ecx;
+  }
+  if (RegisterEdx != NULL) {
+    *RegisterEdx = Edx;
+  }
+  return Index;
+}
+
+UINT64
+EFIAPI
+AsmReadTsc (
+  VOID
+  )
+{
+  return __builtin_ia32_rdtsc ();
+}
+
+//
+// BaseMemoryLib
+//
+
+VOID *
+EFIAPI
+CopyMem (
+  OUT VOID       *DestinationBuffer,
+  IN  CONST VOID *SourceBuffer,
+  IN  UINTN      Length
+  )
+{
+  return memmove (DestinationBuffer, SourceBuffer, Length);
+}
+
+VOID *
+EFIAPI
+SetMem (
+  OUT VOID  *Buffer,
+  IN  UINTN Length,
+  IN  UINT8 Value
+  )
+{
+  return memset (Buffer, Value, Length);
+}
+
+VOID *
+EFIAPI
+ZeroMem (
+  OUT VOID  *Buffer,
+  IN  UINTN Length
+  )
+{
+  return memset (Buffer, 0, Length);
+}
+
+INTN
+EFIAPI
+CompareMem (
+  IN CONST VOID *DestinationBuffer,
+  IN CONST VOID *SourceBuffer,
+  IN UINTN      Length
+  )
+{
+  return memcmp (DestinationBuffer, SourceBuffer, Length);
+}
+
+BOOLEAN
+EFIAPI
+CompareGuid (
+  IN CONST GUID *Guid1,
+  IN CONST GUID *Guid2
+  )
+{
+  return (BOOLEAN)(memcmp (Guid1, Guid2, sizeof *Guid1) == 0);
+}
+
+VOID *
+EFIAPI
+ScanMem8 (
+  IN CONST VOID *Buffer,
+  IN UINTN      Length,
+  IN UINT8      Value
+  )
+{
+  return memchr (Buffer, Value, Length);
+}
+
+//
+// MemoryAllocationLib
+//
+
+VOID *
+EFIAPI
+AllocatePool (
+  IN UINTN AllocationSize
+  )
+{
+  return malloc (AllocationSize);
+}
+
+VOID *
+EFIAPI
+AllocateZeroPool (
+  IN UINTN AllocationSize
+  )
+{
+  return calloc (1, AllocationSize);
+}
+
+VOID *
+EFIAPI
+AllocateCopyPool (
+  IN UINTN      AllocationSize,
+  IN CONST VOID *Buffer
+  )
+{
+  VOID *Memory;
+
+  Memory = malloc (AllocationSize);
+  if (Memory != NULL) {
+    memcpy (Memory, Buffer, AllocationSize);
+  }
+  return Memory;
+}
+
+VOID *
+EFIAPI
+ReallocatePool (
+  IN UINTN OldSize,
+  IN UINTN NewSize,
+  IN VOID  *OldBuffer OPTIONAL
+  )
+{
+  return realloc (OldBuffer, NewSize);
+}
+
+VOID
+EFIAPI
+FreePool (
+  IN VOID *Buffer
+  )
+{
+  free (Buffer);
+}
+
+VOID *
+EFIAPI
+AllocatePages (
+  IN UINTN Pages
+  )
+{
+  VOID *Memory;
+
+  if (Pages == 0 ||
+      posix_memalign (&Memory, EFI_PAGE_SIZE, EFI_PAGES_TO_SIZE (Pages)) != 0) {
+    return NULL;
+  }
+  return Memory;
+}
+
+VOID
+EFIAPI
+FreePages (
+  IN VOID  *Buffer,
+  IN UINTN Pages
+  )
+{
+  free (Buffer);
+}
+
+//
+// DebugLib
+//
+
+VOID
+EFIAPI
+DebugPrint (
+  IN UINTN       ErrorLevel,
+  IN CONST CHAR8 *Format,
+  ...
+  )
+{
+  //
+  // The EDK II format specifiers (%a, %s, %r, ...) differ from the C library
+  // ones, so print the format string only.
+  //
+  if ((ErrorLevel & DEBUG_ERROR) != 0) {
+    fprintf (stderr, "DEBUG_ERROR: %s", Format);
+  }
+}
+
+VOID
+EFIAPI
+DebugAssert (
+  IN CONST CHAR8 *FileName,
+  IN UINTN       LineNumber,
+  IN CONST CHAR8 *Description
+  )
+{
+  fprintf (
+    stderr,
+    "ASSERT %s(%lu): %s\n",
+    FileName,
+    (unsigned long)LineNumber,
+    Description
+    );
+  abort ();
+}
+
+//
+// OrderedCollectionLib
+//
+// A sorted, doubly linked list. The collections of the benchmarked drivers
+// hold a few dozen entries at most, which a balanced tree would not speed up
+// noticeably.
+//
+
+struct ORDERED_COLLECTION_ENTRY {
+  VOID                     *UserStruct;
+  ORDERED_COLLECTION_ENTRY *Prev;
+  ORDERED_COLLECTION_ENTRY *Next;
+};
+
+struct ORDERED_COLLECTION {
+  ORDERED_COLLECTION_USER_COMPARE UserStructCompare;
+  ORDERED_COLLECTION_KEY_COMPARE  KeyCompare;
+  ORDERED_COLLECTION_ENTRY        *Head;
+};
+
+VOID *
+EFIAPI
+OrderedCollectionUserStruct (
+  IN CONST ORDERED_COLLECTION_ENTRY *Entry
+  )
+{
+  return Entry->UserStruct;
+}
+
+ORDERED_COLLECTION *
+EFIAPI
+OrderedCollectionInit (
+  IN ORDERED_COLLECTION_USER_COMPARE UserStructCompare,
+  IN ORDERED_COLLECTION_KEY_COMPARE  KeyCompare
+  )
+{
+  ORDERED_COLLECTION *Collection;
+
+  Collection = AllocateZeroPool (sizeof *Collection);
+  if (Collection != NULL) {
+    Collection->UserStructCompare = UserStructCompare;
+    Collection->KeyCompare        = KeyCompare;
+  }
+  return Collection;
+}
+
+BOOLEAN
+EFIAPI
+OrderedCollectionIsEmpty (
+  IN CONST ORDERED_COLLECTION *Collection
+  )
+{
+  return (BOOLEAN)(Collection->Head == NULL);
+}
+
+VOID
+EFIAPI
+OrderedCollectionUninit (
+  IN ORDERED_COLLECTION *Collection
+  )
+{
+  ASSERT (OrderedCollectionIsEmpty (Collection));
+  FreePool (Collection);
+}
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionFind (
+  IN CONST ORDERED_COLLECTION *Collection,
+  IN CONST VOID               *StandaloneKey
+  )
+{
+  ORDERED_COLLECTION_ENTRY *Entry;
+  INTN                     Result;
+
+  for (Entry = Collection->Head; Entry != NULL; Entry = Entry->Next) {
+    Result = Collection->KeyCompare (StandaloneKey, Entry->UserStruct);
+    if (Result == 0) {
+      return Entry;
+    }
+    if (Result < 0) {
+      break;
+    }
+  }
+  return NULL;
+}
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionMin (
+  IN CONST ORDERED_COLLECTION *Collection
+  )
+{
+  return Collection->Head;
+}
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionNext (
+  IN CONST ORDERED_COLLECTION_ENTRY *Entry
+  )
+{
+  return (Entry == NULL) ? NULL : Entry->Next;
+}
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionPrev (
+  IN CONST ORDERED_COLLECTION_ENTRY *Entry
+  )
+{
+  return (Entry == NULL) ? NULL : Entry->Prev;
+}
+
+RETURN_STATUS
+EFIAPI
+OrderedCollectionInsert (
+  IN OUT ORDERED_COLLECTION       *Collection,
+  OUT    ORDERED_COLLECTION_ENTRY **Entry      OPTIONAL,
+  IN     VOID                     *UserStruct
+  )
+{
+  ORDERED_COLLECTION_ENTRY **Link;
+  ORDERED_COLLECTION_ENTRY *Prev;
+  ORDERED_COLLECTION_ENTRY *NewEntry;
+  INTN                     Result;
+
+  Prev = NULL;
+  for (Link = &Collection->Head; *Link != NULL; Link = &(*Link)->Next) {
+    Result = Collection->UserStructCompare (UserStruct, (*Link)->UserStruct);
+    if (Result == 0) {
+      if (Entry != NULL) {
+        *Entry = *Link;
+      }
+      return RETURN_ALREADY_STARTED;
+    }
+    if (Result < 0) {
+      break;
+    }
+    Prev = *Link;
+  }
+
+  NewEntry = AllocatePool (sizeof *NewEntry);
+  if (NewEntry == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+  NewEntry->UserStruct = UserStruct;
+  NewEntry->Prev       = Prev;
+  NewEntry->Next       = *Link;
+  if (NewEntry->Next != NULL) {
+    NewEntry->Next->Prev = NewEntry;
+  }
+  *Link                = NewEntry;
+  if (Entry != NULL) {
+    *Entry = NewEntry;
+  }
+  return RETURN_SUCCESS;
+}
+
+VOID
+EFIAPI
+OrderedCollectionDelete (
+  IN OUT ORDERED_COLLECTION       *Collection,
+  IN     ORDERED_COLLECTION_ENTRY *Entry,
+  OUT    VOID                     **UserStruct OPTIONAL
+  )
+{
+  ORDERED_COLLECTION_ENTRY **Link;
+
+  for (Link = &Collection->Head; *Link != Entry; Link = &(*Link)->Next) {
+    ASSERT (*Link != NULL);
+  }
+  *Link = Entry->Next;
+  if (Entry->Next != NULL) {
+    Entry->Next->Prev = Entry->Prev;
+  }
+  if (UserStruct != NULL) {
+    *UserStruct = Entry->UserStruct;
+  }
+  FreePool (Entry);
+}
+
+//
+// PrintLib
+//
+
+typedef struct {
+  CHAR16 *Buffer;
+  UINTN  Length;
+  UINTN  MaxLength;
+} HOST_PRINT_BUFFER;
+
+STATIC
+VOID
+HostPrintPut (
+  IN OUT HOST_PRINT_BUFFER *Out,
+  IN     CHAR16            Char
+  )
+{
+  if (Out->Length < Out->MaxLength) {
+    Out->Buffer[Out->Length++] = Char;
+  }
+}
+
+STATIC
+VOID
+HostPrintField (
+  IN OUT HOST_PRINT_BUFFER *Out,
+  IN     CONST CHAR8       *Ascii  OPTIONAL,
+  IN     CONST CHAR16      *Unicode OPTIONAL,
+  IN     UINTN             Width,
+  IN     BOOLEAN           LeftJustify
+  )
+{
+  UINTN Length;
+  UINTN Index;
+
+  Length = (Ascii != NULL) ? strlen (Ascii) : StrLen (Unicode);
+  for (Index = Length; !LeftJustify && Index < Width; Index++) {
+    HostPrintPut (Out, L' ');
+  }
+  for (Index = 0; Index < Length; Index++) {
+    HostPrintPut (Out, (Ascii != NULL) ? (UINT8)Ascii[Index] : Unicode[Index]);
+  }
+  for (Index = Length; LeftJustify && Index < Width; Index++) {
+    HostPrintPut (Out, L' ');
+  }
+}
+
+UINTN
+EFIAPI
+UnicodeVSPrintAsciiFormat (
+  OUT CHAR16      *StartOfBuffer,
+  IN  UINTN       BufferSize,
+  IN  CONST CHAR8 *FormatString,
+  IN  VA_LIST     Marker
+  )
+{
+  HOST_PRINT_BUFFER Out;
+  CONST CHAR8       *Format;
+  BOOLEAN           LeftJustify;
+  BOOLEAN           ZeroPad;
+  BOOLEAN           Long;
+  UINTN             Width;
+  CHAR8             Text[64];
+  CONST CHAR8       *Ascii;
+  CONST CHAR16      *Unicode;
+  CONST GUID        *Guid;
+
+  if (BufferSize < sizeof (CHAR16)) {
+    return 0;
+  }
+  Out.Buffer    = StartOfBuffer;
+  Out.Length    = 0;
+  Out.MaxLength = BufferSize / sizeof (CHAR16) - 1;
+
+  for (Format = FormatString; *Format != '\0'; Format++) {
+    if (*Format != '%') {
+      HostPrintPut (&Out, (UINT8)*Format);
+      continue;
+    }
+
+    LeftJustify = FALSE;
+    ZeroPad     = FALSE;
+    Long        = FALSE;
+    Width       = 0;
+    for (Format++; ; Format++) {
+      if (*Format == '-') {
+        LeftJustify = TRUE;
+      } else if (*Format == '0' && Width == 0) {
+        ZeroPad = TRUE;
+      } else if (*Format >= '0' && *Format <= '9') {
+        Width = Width * 10 + (*Format - '0');
+      } else if (*Format == '*') {
+        Width = va_arg (Marker, UINTN);
+      } else if (*Format == 'L' || *Format == 'l') {
+        Long = TRUE;
+      } else {
+        break;
+      }
+    }
+
+    Ascii   = Text;
+    Unicode = NULL;
+    switch (*Format) {
+      case 'a':
+        Ascii = va_arg (Marker, CONST CHAR8 *);
+        if (Ascii == NULL) {
+          Ascii = "<null string>";
+        }
+        break;
+      case 's':
+      case 'S':
+        Unicode = va_arg (Marker, CONST CHAR16 *);
+        Ascii   = NULL;
+        if (Unicode == NULL) {
+          Unicode = L"<null string>";
+        }
+        break;
+      case 'c':
+        Text[0] = (CHAR8)va_arg (Marker, int);
+        Text[1] = '\0';
+        break;
+      case 'd':
+        snprintf (Text, sizeof Text, ZeroPad ? "%0*lld" : "%*lld", (int)Width,
+          Long ? (long long)va_arg (Marker, INT64) : va_arg (Marker, int));
+        break;
+      case 'u':
+        snprintf (Text, sizeof Text, ZeroPad ? "%0*llu" : "%*llu", (int)Width,
+          Long ? (unsigned long long)va_arg (Marker, UINT64) :
+                 va_arg (Marker, unsigned));
+        break;
+      case 'X':
+        //
+        // As in BasePrintLib, %X is zero-padded to the size of its argument.
+        //
+        if (Width == 0) {
+          Width = Long ? 16 : 8;
+        }
+        ZeroPad = TRUE;
+        //
+        // Fall through.
+        //
+      case 'x':
+        snprintf (Text, sizeof Text, ZeroPad ? "%0*llX" : "%*llX", (int)Width,
+          Long ? (unsigned long long)va_arg (Marker, UINT64) :
+                 va_arg (Marker, unsigned));
+        break;
+      case 'g':
+        Guid = va_arg (Marker, CONST GUID *);
+        snprintf (Text, sizeof Text,
+          "%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+          Guid->Data1, Guid->Data2, Guid->Data3, Guid->Data4[0],
+          Guid->Data4[1], Guid->Data4[2], Guid->Data4[3], Guid->Data4[4],
+          Guid->Data4[5], Guid->Data4[6], Guid->Data4[7]);
+        break;
+      case '%':
+        Text[0] = '%';
+        Text[1] = '\0';
+        break;
+      default:
+        ASSERT (FALSE);
+        Text[0] = '\0';
+        if (*Format == '\0') {
+          Format--;
+        }
+        break;
+    }
+    HostPrintField (&Out, Ascii, Unicode, Width, LeftJustify);
+  }
+
+  Out.Buffer[Out.Length] = L'\0';
+  return Out.Length;
+}
+
+UINTN
+EFIAPI
+UnicodeSPrintAsciiFormat (
+  OUT CHAR16      *StartOfBuffer,
+  IN  UINTN       BufferSize,
+  IN  CONST CHAR8 *FormatString,
+  ...
+  )
+{
+  VA_LIST Marker;
+  UINTN   Length;
+
+  va_start (Marker, FormatString);
+  Length = UnicodeVSPrintAsciiFormat (StartOfBuffer, BufferSize, FormatString,
+             Marker);
+  va_end (Marker);
+  return Length;
+}
+
+//
+// DevicePathLib
+//
+
+UINT8
+EFIAPI
+DevicePathType (
+  IN CONST VOID *Node
+  )
+{
+  return ((CONST EFI_DEVICE_PATH_PROTOCOL *)Node)->Type;
+}
+
+UINT8
+EFIAPI
+DevicePathSubType (
+  IN CONST VOID *Node
+  )
+{
+  return ((CONST EFI_DEVICE_PATH_PROTOCOL *)Node)->SubType;
+}
+
+UINTN
+EFIAPI
+DevicePathNodeLength (
+  IN CONST VOID *Node
+  )
+{
+  CONST EFI_DEVICE_PATH_PROTOCOL *Header;
+
+  Header = Node;
+  return Header->Length[0] | (Header->Length[1] << 8);
+}
+
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+NextDevicePathNode (
+  IN CONST VOID *Node
+  )
+{
+  return (EFI_DEVICE_PATH_PROTOCOL *)((UINT8 *)Node +
+                                      DevicePathNodeLength (Node));
+}
+
+BOOLEAN
+EFIAPI
+IsDevicePathEnd (
+  IN CONST VOID *Node
+  )
+{
+  return (BOOLEAN)(DevicePathType (Node) == END_DEVICE_PATH_TYPE &&
+                   DevicePathSubType (Node) == END_ENTIRE_DEVICE_PATH_SUBTYPE);
+}
+
+UINT16
+EFIAPI
+SetDevicePathNodeLength (
+  IN OUT VOID  *Node,
+  IN     UINTN Length
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL *Header;
+
+  ASSERT (Length >= sizeof *Header && Length <= MAX_UINT16);
+  Header = Node;
+  Header->Length[0] = (UINT8)Length;
+  Header->Length[1] = (UINT8)(Length >> 8);
+  return (UINT16)Length;
+}
+
+VOID
+EFIAPI
+SetDevicePathEndNode (
+  OUT VOID *Node
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL *Header;
+
+  Header = Node;
+  Header->Type    = END_DEVICE_PATH_TYPE;
+  Header->SubType = END_ENTIRE_DEVICE_PATH_SUBTYPE;
+  SetDevicePathNodeLength (Header, END_DEVICE_PATH_LENGTH);
+}
+
+UINTN
+EFIAPI
+GetDevicePathSize (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath
+  )
+{
+  CONST EFI_DEVICE_PATH_PROTOCOL *Node;
+
+  for (Node = DevicePath; !IsDevicePathEnd (Node);
+       Node = NextDevicePathNode (Node)) {
+  }
+  return (UINTN)((CONST UINT8 *)Node - (CONST UINT8 *)DevicePath) +
+         END_DEVICE_PATH_LENGTH;
+}
+
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+DuplicateDevicePath (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath
+  )
+{
+  if (DevicePath == NULL) {
+    return NULL;
+  }
+  return AllocateCopyPool (GetDevicePathSize (DevicePath), DevicePath);
+}
+
+STATIC
+UINTN
+HostDevicePathNodeToText (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL *Node,
+  OUT CHAR16                         *Text,
+  IN  UINTN                          TextSize
+  )
+{
+  CONST UINT8 *Data;
+  UINTN       DataSize;
+  UINTN       Length;
+  UINTN       Index;
+
+  switch (DevicePathType (Node) << 8 | DevicePathSubType (Node)) {
+    case HARDWARE_DEVICE_PATH << 8 | HW_PCI_DP:
+      return UnicodeSPrintAsciiFormat (Text, TextSize, "Pci(0x%x,0x%x)",
+               ((CONST PCI_DEVICE_PATH *)Node)->Device,
+               ((CONST PCI_DEVICE_PATH *)Node)->Function);
+
+    case HARDWARE_DEVICE_PATH << 8 | HW_VENDOR_DP:
+      Length = UnicodeSPrintAsciiFormat (Text, TextSize, "VenHw(%g",
+                 &((CONST VENDOR_DEVICE_PATH *)Node)->Guid);
+      Data     = (CONST UINT8 *)Node + sizeof (VENDOR_DEVICE_PATH);
+      DataSize = DevicePathNodeLength (Node) - sizeof (VENDOR_DEVICE_PATH);
+      if (DataSize > 0) {
+        Length += UnicodeSPrintAsciiFormat (Text + Length,
+                    TextSize - Length * sizeof *Text, ",");
+      }
+      for (Index = 0; Index < DataSize; Index++) {
+        Length += UnicodeSPrintAsciiFormat (Text + Length,
+                    TextSize - Length * sizeof *Text, "%02x", Data[Index]);
+      }
+      return Length + UnicodeSPrintAsciiFormat (Text + Length,
+                        TextSize - Length * sizeof *Text, ")");
+
+    case ACPI_DEVICE_PATH << 8 | ACPI_DP:
+      if (((CONST ACPI_HID_DEVICE_PATH *)Node)->HID == EISA_PNP_ID (0x0a03)) {
+        return UnicodeSPrintAsciiFormat (Text, TextSize, "PciRoot(0x%x)",
+                 ((CONST ACPI_HID_DEVICE_PATH *)Node)->UID);
+      }
+      return UnicodeSPrintAsciiFormat (Text, TextSize, "Acpi(0x%08x,0x%x)",
+               ((CONST ACPI_HID_DEVICE_PATH *)Node)->HID,
+               ((CONST ACPI_HID_DEVICE_PATH *)Node)->UID);
+
+    case MESSAGING_DEVICE_PATH << 8 | MSG_SCSI_DP:
+      return UnicodeSPrintAsciiFormat (Text, TextSize, "Scsi(0x%x,0x%x)",
+               ((CONST SCSI_DEVICE_PATH *)Node)->Pun,
+               ((CONST SCSI_DEVICE_PATH *)Node)->Lun);
+
+    case MESSAGING_DEVICE_PATH << 8 | MSG_MAC_ADDR_DP:
+      Data   = ((CONST MAC_ADDR_DEVICE_PATH *)Node)->MacAddress.Addr;
+      Length = UnicodeSPrintAsciiFormat (Text, TextSize, "MAC(");
+      for (Index = 0; Index < 6; Index++) {
+        Length += UnicodeSPrintAsciiFormat (Text + Length,
+                    TextSize - Length * sizeof *Text, "%02x", Data[Index]);
+      }
+      return Length + UnicodeSPrintAsciiFormat (Text + Length,
+                        TextSize - Length * sizeof *Text, ",0x%x)",
+                        ((CONST MAC_ADDR_DEVICE_PATH *)Node)->IfType);
+
+    case MESSAGING_DEVICE_PATH << 8 | MSG_SATA_DP:
+      return UnicodeSPrintAsciiFormat (Text, TextSize, "Sata(0x%x,0x%x,0x%x)",
+               ((CONST SATA_DEVICE_PATH *)Node)->HBAPortNumber,
+               ((CONST SATA_DEVICE_PATH *)Node)->PortMultiplierPortNumber,
+               ((CONST SATA_DEVICE_PATH *)Node)->Lun);
+
+    case MEDIA_DEVICE_PATH << 8 | MEDIA_HARDDRIVE_DP:
+      if (((CONST HARDDRIVE_DEVICE_PATH *)Node)->SignatureType ==
+          SIGNATURE_TYPE_GUID) {
+        return UnicodeSPrintAsciiFormat (Text, TextSize,
+                 "HD(%d,GPT,%g,0x%lx,0x%lx)",
+                 ((CONST HARDDRIVE_DEVICE_PATH *)Node)->PartitionNumber,
+                 ((CONST HARDDRIVE_DEVICE_PATH *)Node)->Signature,
+                 ((CONST HARDDRIVE_DEVICE_PATH *)Node)->PartitionStart,
+                 ((CONST HARDDRIVE_DEVICE_PATH *)Node)->PartitionSize);
+      }
+      return UnicodeSPrintAsciiFormat (Text, TextSize,
+               "HD(%d,MBR,0x%08x,0x%lx,0x%lx)",
+               ((CONST HARDDRIVE_DEVICE_PATH *)Node)->PartitionNumber,
+               ReadUnaligned32 (
+                 (CONST UINT32 *)((CONST HARDDRIVE_DEVICE_PATH *)Node)->Signature
+                 ),
+               ((CONST HARDDRIVE_DEVICE_PATH *)Node)->PartitionStart,
+               ((CONST HARDDRIVE_DEVICE_PATH *)Node)->PartitionSize);
+
+    case MEDIA_DEVICE_PATH << 8 | MEDIA_FILEPATH_DP:
+      return UnicodeSPrintAsciiFormat (Text, TextSize, "%s",
+               ((CONST FILEPATH_DEVICE_PATH *)Node)->PathName);
+
+    case MEDIA_DEVICE_PATH << 8 | MEDIA_PIWG_FW_FILE_DP:
+      return UnicodeSPrintAsciiFormat (Text, TextSize, "FvFile(%g)",
+               &((CONST MEDIA_FW_VOL_FILEPATH_DEVICE_PATH *)Node)->FvFileName);
+
+    case MEDIA_DEVICE_PATH << 8 | MEDIA_PIWG_FW_VOL_DP:
+      return UnicodeSPrintAsciiFormat (Text, TextSize, "Fv(%g)",
+               &((CONST MEDIA_FW_VOL_DEVICE_PATH *)Node)->FvName);
+  }
+
+  Length = UnicodeSPrintAsciiFormat (Text, TextSize, "Path(%d,%d,",
+             DevicePathType (Node), DevicePathSubType (Node));
+  Data     = (CONST UINT8 *)(Node + 1);
+  DataSize = DevicePathNodeLength (Node) - sizeof *Node;
+  for (Index = 0; Index < DataSize; Index++) {
+    Length += UnicodeSPrintAsciiFormat (Text + Length,
+                TextSize - Length * sizeof *Text, "%02x", Data[Index]);
+  }
+  return Length + UnicodeSPrintAsciiFormat (Text + Length,
+                    TextSize - Length * sizeof *Text, ")");
+}
+
+CHAR16 *
+EFIAPI
+ConvertDevicePathToText (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath,
+  IN BOOLEAN                        DisplayOnly,
+  IN BOOLEAN                        AllowShortcuts
+  )
+{
+  CONST EFI_DEVICE_PATH_PROTOCOL *Node;
+  CHAR16                         NodeText[512];
+  UINTN                          NodeLength;
+  CHAR16                         *Text;
+  UINTN                          Length;
+  CHAR16                         *NewText;
+
+  Text   = NULL;
+  Length = 0;
+  for (Node = DevicePath; !IsDevicePathEnd (Node);
+       Node = NextDevicePathNode (Node)) {
+    NodeLength = HostDevicePathNodeToText (Node, NodeText, sizeof NodeText);
+    NewText = realloc (Text, (Length + 1 + NodeLength + 1) * sizeof *Text);
+    if (NewText == NULL) {
+      free (Text);
+      return NULL;
+    }
+    Text = NewText;
+    if (Length > 0) {
+      Text[Length++] = L'/';
+    }
+    memcpy (Text + Length, NodeText, NodeLength * sizeof *Text);
+    Length += NodeLength;
+  }
+
+  if (Text == NULL) {
+    Text = malloc (sizeof *Text);
+    if (Text == NULL) {
+      return NULL;
+    }
+  }
+  Text[Length] = L'\0';
+  return Text;
+}
+
+//
+// UefiBootServicesTableLib
+//
+
+STATIC
+EFI_TPL
+EFIAPI
+HostRaiseTpl (
+  IN EFI_TPL NewTpl
+  )
+{
+  return TPL_APPLICATION;
+}
+
+STATIC
+VOID
+EFIAPI
+HostRestoreTpl (
+  IN EFI_TPL OldTpl
+  )
+{
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostCreateEvent (
+  IN  UINT32           Type,
+  IN  EFI_TPL          NotifyTpl,
+  IN  EFI_EVENT_NOTIFY NotifyFunction OPTIONAL,
+  IN  VOID             *NotifyContext OPTIONAL,
+  OUT EFI_EVENT        *Event
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostCloseEvent (
+  IN EFI_EVENT Event
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostInstallProtocolInterface (
+  IN OUT EFI_HANDLE         *Handle,
+  IN     EFI_GUID           *Protocol,
+  IN     EFI_INTERFACE_TYPE InterfaceType,
+  IN     VOID               *Interface
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostUninstallProtocolInterface (
+  IN EFI_HANDLE Handle,
+  IN EFI_GUID   *Protocol,
+  IN VOID       *Interface
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostStall (
+  IN UINTN Microseconds
+  )
+{
+  __atomic_add_fetch (&gHostStallCalls, 1, __ATOMIC_RELAXED);
+  HostDelayUntil (HostNowNs () + (UINT64)Microseconds * 1000);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostOpenProtocol (
+  IN  EFI_HANDLE Handle,
+  IN  EFI_GUID   *Protocol,
+  OUT VOID       **Interface OPTIONAL,
+  IN  EFI_HANDLE AgentHandle,
+  IN  EFI_HANDLE ControllerHandle,
+  IN  UINT32     Attributes
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostCloseProtocol (
+  IN EFI_HANDLE Handle,
+  IN EFI_GUID   *Protocol,
+  IN EFI_HANDLE AgentHandle,
+  IN EFI_HANDLE ControllerHandle
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostConnectController (
+  IN EFI_HANDLE ControllerHandle,
+  IN EFI_HANDLE *DriverImageHandle OPTIONAL,
+  IN VOID       *RemainingDevicePath OPTIONAL,
+  IN BOOLEAN    Recursive
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+STATIC EFI_BOOT_SERVICES mHostBootServices = {
+  HostRaiseTpl,                   // RaiseTPL
+  HostRestoreTpl,                 // RestoreTPL
+  HostCreateEvent,                // CreateEvent
+  HostCloseEvent,                 // CloseEvent
+  HostInstallProtocolInterface,   // InstallProtocolInterface
+  HostUninstallProtocolInterface, // UninstallProtocolInterface
+  HostStall,                      // Stall
+  HostOpenProtocol,               // OpenProtocol
+  HostCloseProtocol,              // CloseProtocol
+  HostConnectController           // ConnectController
+};
+
+STATIC EFI_SYSTEM_TABLE mHostSystemTable = {
+  &mHostBootServices              // BootServices
+};
+
+EFI_HANDLE        gImageHandle = NULL;
+EFI_SYSTEM_TABLE  *gST         = &mHostSystemTable;
+EFI_BOOT_SERVICES *gBS         = &mHostBootServices;
@@ -0,0 +1,41 @@
+/** @file
+  Host services that the stub library instances in HostLib.c are built on.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_LIB_H_
+#define HOST_LIB_H_
+
+#include <Uefi.h>
+
+//
+// Number of gBS->Stall() calls made so far, by any thread. The drivers stall
+// only while polling a used ring, so this counts the polls of the guest.
+//
+extern volatile UINT64 gHostStallCalls;
+
+/**
+  @return  Nanoseconds on a monotonic clock.
+**/
+UINT64
+HostNowNs (
+  VOID
+  );
+
+/**
+  Busy-wait until HostNowNs() reaches Deadline.
+
+  The wait yields the CPU on every iteration, so that the guest and device
+  threads make progress even on a single CPU. Long waits sleep first.
+
+  @param[in] Deadline  The HostNowNs() value to wait for.
+**/
+VOID
+HostDelayUntil (
+  IN UINT64 Deadline
+  );
+
+#endif // HOST_LIB_H_
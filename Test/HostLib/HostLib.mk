@@ -0,0 +1,52 @@
+## @file
+#  Common rules of the host harnesses under Test/. A harness sets PROGRAM and
+#  SOURCES (paths relative to its directory) and includes this file. "make run"
+#  builds RUN_DEPS, if set, and passes ARGS and RUN_ARGS to the program.
+#
+#  Package sources are compiled as they are, against the stub headers in
+#  Include/ and the library instances in HostLib.c. Unreferenced functions
+#  are dropped at link time, so a module source can be compiled whole even
+#  if only some of its functions are exercised.
+#
+#  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+##
+
+HOST_LIB_DIR := $(patsubst %/,%,$(dir $(lastword $(MAKEFILE_LIST))))
+PKG_DIR      := $(HOST_LIB_DIR)/../..
+BUILD_DIR    := Build
+
+CC       ?= gcc
+CFLAGS   ?= -O2 -g
+CFLAGS   += -std=gnu11 -fshort-wchar -fno-strict-aliasing -Wall \
+            -ffunction-sections -fdata-sections -pthread
+CPPFLAGS += -include $(HOST_LIB_DIR)/AutoGen.h -I. -I$(HOST_LIB_DIR) \
+            -I$(HOST_LIB_DIR)/Include -I$(PKG_DIR)/Include
+LDFLAGS  += -pthread -Wl,--gc-sections
+
+SOURCES += $(HOST_LIB_DIR)/HostLib.c
+OBJECTS := $(addprefix $(BUILD_DIR)/,$(notdir $(SOURCES:.c=.o)))
+
+vpath %.c $(sort $(dir $(SOURCES)))
+
+.PHONY: all run clean
+
+all: $(BUILD_DIR)/$(PROGRAM)
+
+run: $(BUILD_DIR)/$(PROGRAM) $(RUN_DEPS)
+	$(BUILD_DIR)/$(PROGRAM) $(ARGS) $(RUN_ARGS)
+
+clean:
+	rm -rf $(BUILD_DIR)
+
+$(BUILD_DIR)/$(PROGRAM): $(OBJECTS)
+	$(CC) $(CFLAGS) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+$(BUILD_DIR)/%.o: %.c | $(BUILD_DIR)
+	$(CC) $(CPPFLAGS) $(CFLAGS) -MMD -MP -c -o $@ $<
+
+$(BUILD_DIR):
+	mkdir -p $@
+
+-include $(OBJECTS:.o=.d)
@@ -0,0 +1,229 @@
+/** @file
+  Host stand-in for MdePkg/Include/Base.h.
+
+  Only the types, macros and status codes that the package sources compiled by
+  the host harnesses rely on are provided. The definitions follow the X64 data
+  model of the firmware build (UINTN is 64 bits wide).
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_BASE_H_
+#define HOST_BASE_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint64_t       UINT64;
+typedef int64_t        INT64;
+typedef uint32_t       UINT32;
+typedef int32_t        INT32;
+typedef uint16_t       UINT16;
+typedef int16_t        INT16;
+typedef uint8_t        UINT8;
+typedef int8_t         INT8;
+typedef unsigned char  BOOLEAN;
+typedef char           CHAR8;
+typedef unsigned short CHAR16;   // L"" literals need -fshort-wchar
+typedef UINT64         UINTN;
+typedef INT64          INTN;
+
+#define VOID     void
+#define CONST    const
+#define STATIC   static
+#define IN
+#define OUT
+#define OPTIONAL
+#define EFIAPI
+
+#define GLOBAL_REMOVE_IF_UNREFERENCED
+
+#define TRUE   ((BOOLEAN)(1 == 1))
+#define FALSE  ((BOOLEAN)(0 == 1))
+
+#ifndef NULL
+#define NULL  ((VOID *) 0)
+#endif
+
+#define MAX_INT8    ((INT8)0x7F)
+#define MAX_UINT8   ((UINT8)0xFF)
+#define MAX_INT16   ((INT16)0x7FFF)
+#define MAX_UINT16  ((UINT16)0xFFFF)
+#define MAX_INT32   ((INT32)0x7FFFFFFF)
+#define MAX_UINT32  ((UINT32)0xFFFFFFFF)
+#define MAX_INT64   ((INT64)0x7FFFFFFFFFFFFFFFULL)
+#define MAX_UINT64  ((UINT64)0xFFFFFFFFFFFFFFFFULL)
+#define MAX_INTN    ((INTN)MAX_INT64)
+#define MAX_UINTN   ((UINTN)MAX_UINT64)
+#define MAX_ADDRESS MAX_UINTN
+#define MAX_BIT     0x8000000000000000ULL
+
+#define BIT0   0x00000001
+#define BIT1   0x00000002
+#define BIT2   0x00000004
+#define BIT3   0x00000008
+#define BIT4   0x00000010
+#define BIT5   0x00000020
+#define BIT6   0x00000040
+#define BIT7   0x00000080
+#define BIT8   0x00000100
+#define BIT9   0x00000200
+#define BIT10  0x00000400
+#define BIT11  0x00000800
+#define BIT12  0x00001000
+#define BIT13  0x00002000
+#define BIT14  0x00004000
+#define BIT15  0x00008000
+#define BIT16  0x00010000
+#define BIT17  0x00020000
+#define BIT18  0x00040000
+#define BIT19  0x00080000
+#define BIT20  0x00100000
+#define BIT21  0x00200000
+#define BIT22  0x00400000
+#define BIT23  0x00800000
+#define BIT24  0x01000000
+#define BIT25  0x02000000
+#define BIT26  0x04000000
+#define BIT27  0x08000000
+#define BIT28  0x10000000
+#define BIT29  0x20000000
+#define BIT30  0x40000000
+#define BIT31  0x80000000
+#define BIT32  0x0000000100000000ULL
+#define BIT33  0x0000000200000000ULL
+#define BIT34  0x0000000400000000ULL
+#define BIT35  0x0000000800000000ULL
+#define BIT36  0x0000001000000000ULL
+#define BIT37  0x0000002000000000ULL
+#define BIT38  0x0000004000000000ULL
+#define BIT39  0x0000008000000000ULL
+#define BIT40  0x0000010000000000ULL
+#define BIT41  0x0000020000000000ULL
+#define BIT42  0x0000040000000000ULL
+#define BIT43  0x0000080000000000ULL
+#define BIT44  0x0000100000000000ULL
+#define BIT45  0x0000200000000000ULL
+#define BIT46  0x0000400000000000ULL
+#define BIT47  0x0000800000000000ULL
+#define BIT48  0x0001000000000000ULL
+#define BIT49  0x0002000000000000ULL
+#define BIT50  0x0004000000000000ULL
+#define BIT51  0x0008000000000000ULL
+#define BIT52  0x0010000000000000ULL
+#define BIT53  0x0020000000000000ULL
+#define BIT54  0x0040000000000000ULL
+#define BIT55  0x0080000000000000ULL
+#define BIT56  0x0100000000000000ULL
+#define BIT57  0x0200000000000000ULL
+#define BIT58  0x0400000000000000ULL
+#define BIT59  0x0800000000000000ULL
+#define BIT60  0x1000000000000000ULL
+#define BIT61  0x2000000000000000ULL
+#define BIT62  0x4000000000000000ULL
+#define BIT63  0x8000000000000000ULL
+
+#define SIZE_512   0x00000200
+#define SIZE_1KB   0x00000400
+#define SIZE_2KB   0x00000800
+#define SIZE_4KB   0x00001000
+#define SIZE_8KB   0x00002000
+#define SIZE_16KB  0x00004000
+#define SIZE_32KB  0x00008000
+#define SIZE_64KB  0x00010000
+#define SIZE_128KB 0x00020000
+#define SIZE_256KB 0x00040000
+#define SIZE_1MB   0x00100000
+#define SIZE_2MB   0x00200000
+#define SIZE_16MB  0x01000000
+#define SIZE_1GB   0x40000000
+#define SIZE_4GB   0x0000000100000000ULL
+
+#define BASE_4GB   SIZE_4GB
+
+#define OFFSET_OF(TYPE, Field)  ((UINTN) offsetof (TYPE, Field))
+
+#define BASE_CR(Record, TYPE, Field) \
+  ((TYPE *) ((CHAR8 *) (Record) - OFFSET_OF (TYPE, Field)))
+
+#define ARRAY_SIZE(Array)  (sizeof (Array) / sizeof ((Array)[0]))
+
+#define MIN(a, b)  (((a) < (b)) ? (a) : (b))
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+
+#define ALIGN_VALUE(Value, Alignment) \
+  ((Value) + (((Alignment) - (Value)) & ((Alignment) - 1)))
+
+#define ALIGN_POINTER(Pointer, Alignment) \
+  ((VOID *) (ALIGN_VALUE ((UINTN)(Pointer), (Alignment))))
+
+#define SIGNATURE_16(A, B)  ((A) | (B << 8))
+#define SIGNATURE_32(A, B, C, D) \
+  (SIGNATURE_16 (A, B) | (SIGNATURE_16 (C, D) << 16))
+#define SIGNATURE_64(A, B, C, D, E, F, G, H) \
+  (SIGNATURE_32 (A, B, C, D) | ((UINT64) (SIGNATURE_32 (E, F, G, H)) << 32))
+
+#define STATIC_ASSERT  _Static_assert
+
+#define VA_LIST   va_list
+#define VA_START  va_start
+#define VA_ARG    va_arg
+#define VA_END    va_end
+
+typedef struct {
+  UINT32 Data1;
+  UINT16 Data2;
+  UINT16 Data3;
+  UINT8  Data4[8];
+} GUID;
+
+typedef struct _LIST_ENTRY LIST_ENTRY;
+
+struct _LIST_ENTRY {
+  LIST_ENTRY *ForwardLink;
+  LIST_ENTRY *BackLink;
+};
+
+typedef UINTN RETURN_STATUS;
+
+#define ENCODE_ERROR(StatusCode)    ((RETURN_STATUS)(MAX_BIT | (StatusCode)))
+#define ENCODE_WARNING(StatusCode)  ((RETURN_STATUS)(StatusCode))
+#define RETURN_ERROR(StatusCode)    (((INTN)(RETURN_STATUS)(StatusCode)) < 0)
+
+#define RETURN_SUCCESS               0
+#define RETURN_LOAD_ERROR            ENCODE_ERROR (1)
+#define RETURN_INVALID_PARAMETER     ENCODE_ERROR (2)
+#define RETURN_UNSUPPORTED           ENCODE_ERROR (3)
+#define RETURN_BAD_BUFFER_SIZE       ENCODE_ERROR (4)
+#define RETURN_BUFFER_TOO_SMALL      ENCODE_ERROR (5)
+#define RETURN_NOT_READY             ENCODE_ERROR (6)
+#define RETURN_DEVICE_ERROR          ENCODE_ERROR (7)
+#define RETURN_WRITE_PROTECTED       ENCODE_ERROR (8)
+#define RETURN_OUT_OF_RESOURCES      ENCODE_ERROR (9)
+#define RETURN_VOLUME_CORRUPTED      ENCODE_ERROR (10)
+#define RETURN_VOLUME_FULL           ENCODE_ERROR (11)
+#define RETURN_NO_MEDIA              ENCODE_ERROR (12)
+#define RETURN_MEDIA_CHANGED         ENCODE_ERROR (13)
+#define RETURN_NOT_FOUND             ENCODE_ERROR (14)
+#define RETURN_ACCESS_DENIED         ENCODE_ERROR (15)
+#define RETURN_NO_RESPONSE           ENCODE_ERROR (16)
+#define RETURN_NO_MAPPING            ENCODE_ERROR (17)
+#define RETURN_TIMEOUT               ENCODE_ERROR (18)
+#define RETURN_NOT_STARTED           ENCODE_ERROR (19)
+#define RETURN_ALREADY_STARTED       ENCODE_ERROR (20)
+#define RETURN_ABORTED               ENCODE_ERROR (21)
+#define RETURN_ICMP_ERROR            ENCODE_ERROR (22)
+#define RETURN_TFTP_ERROR            ENCODE_ERROR (23)
+#define RETURN_PROTOCOL_ERROR        ENCODE_ERROR (24)
+#define RETURN_INCOMPATIBLE_VERSION  ENCODE_ERROR (25)
+#define RETURN_SECURITY_VIOLATION    ENCODE_ERROR (26)
+#define RETURN_CRC_ERROR             ENCODE_ERROR (27)
+#define RETURN_END_OF_MEDIA          ENCODE_ERROR (28)
+#define RETURN_END_OF_FILE           ENCODE_ERROR (31)
+#define RETURN_INVALID_LANGUAGE      ENCODE_ERROR (32)
+#define RETURN_COMPROMISED_DATA      ENCODE_ERROR (33)
+
+#endif // HOST_BASE_H_
@@ -0,0 +1,29 @@
+/** @file
+  Host stand-in for MdePkg/Include/Guid/FileInfo.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_FILE_INFO_H_
+#define HOST_FILE_INFO_H_
+
+#include <Uefi.h>
+
+typedef struct {
+  UINT64   Size;
+  UINT64   FileSize;
+  UINT64   PhysicalSize;
+  EFI_TIME CreateTime;
+  EFI_TIME LastAccessTime;
+  EFI_TIME ModificationTime;
+  UINT64   Attribute;
+  CHAR16   FileName[1];
+} EFI_FILE_INFO;
+
+#define SIZE_OF_EFI_FILE_INFO  OFFSET_OF (EFI_FILE_INFO, FileName)
+
+extern EFI_GUID gEfiFileInfoGuid;
+
+#endif // HOST_FILE_INFO_H_
@@ -0,0 +1,19 @@
+/** @file
+  Host stand-in for MdePkg/Include/Guid/GlobalVariable.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_GLOBAL_VARIABLE_H_
+#define HOST_GLOBAL_VARIABLE_H_
+
+#include <Uefi/UefiBaseType.h>
+
+#define EFI_GLOBAL_VARIABLE \
+  { 0x8BE4DF61, 0x93CA, 0x11d2, { 0xAA, 0x0D, 0x00, 0xE0, 0x98, 0x03, 0x2B, 0x8C } }
+
+extern EFI_GUID gEfiGlobalVariableGuid;
+
+#endif // HOST_GLOBAL_VARIABLE_H_
@@ -0,0 +1,19 @@
+/** @file
+  Host stand-in for MdePkg/Include/IndustryStandard/Acpi.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_ACPI_H_
+#define HOST_ACPI_H_
+
+#include <Base.h>
+
+//
+// The frequency of the ACPI PM timer, in Hz.
+//
+#define ACPI_TIMER_FREQUENCY  3579545
+
+#endif // HOST_ACPI_H_
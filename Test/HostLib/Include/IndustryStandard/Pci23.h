@@ -0,0 +1,28 @@
+/** @file
+  Host stand-in for MdePkg/Include/IndustryStandard/Pci23.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_PCI23_H_
+#define HOST_PCI23_H_
+
+#include <Base.h>
+
+#pragma pack(1)
+
+typedef struct {
+  UINT8 CapabilityID;
+  UINT8 NextItemPtr;
+} EFI_PCI_CAPABILITY_HDR;
+
+typedef struct {
+  EFI_PCI_CAPABILITY_HDR Hdr;
+  UINT8                  Length;
+} EFI_PCI_CAPABILITY_VENDOR_HDR;
+
+#pragma pack()
+
+#endif // HOST_PCI23_H_
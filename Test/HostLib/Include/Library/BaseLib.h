@@ -0,0 +1,147 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/BaseLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_BASE_LIB_H_
+#define HOST_BASE_LIB_H_
+
+#include <Base.h>
+
+VOID
+EFIAPI
+MemoryFence (
+  VOID
+  );
+
+VOID
+EFIAPI
+CpuPause (
+  VOID
+  );
+
+UINT64
+EFIAPI
+LShiftU64 (
+  IN UINT64 Operand,
+  IN UINTN  Count
+  );
+
+UINT64
+EFIAPI
+RShiftU64 (
+  IN UINT64 Operand,
+  IN UINTN  Count
+  );
+
+UINT64
+EFIAPI
+MultU64x32 (
+  IN UINT64 Multiplicand,
+  IN UINT32 Multiplier
+  );
+
+UINT64
+EFIAPI
+MultU64x64 (
+  IN UINT64 Multiplicand,
+  IN UINT64 Multiplier
+  );
+
+UINT64
+EFIAPI
+DivU64x32 (
+  IN UINT64 Dividend,
+  IN UINT32 Divisor
+  );
+
+UINT32
+EFIAPI
+ModU64x32 (
+  IN UINT64 Dividend,
+  IN UINT32 Divisor
+  );
+
+UINT64
+EFIAPI
+DivU64x32Remainder (
+  IN  UINT64 Dividend,
+  IN  UINT32 Divisor,
+  OUT UINT32 *Remainder OPTIONAL
+  );
+
+UINT64
+EFIAPI
+DivU64x64Remainder (
+  IN  UINT64 Dividend,
+  IN  UINT64 Divisor,
+  OUT UINT64 *Remainder OPTIONAL
+  );
+
+UINTN
+EFIAPI
+StrLen (
+  IN CONST CHAR16 *String
+  );
+
+INTN
+EFIAPI
+StrCmp (
+  IN CONST CHAR16 *FirstString,
+  IN CONST CHAR16 *SecondString
+  );
+
+INTN
+EFIAPI
+StrnCmp (
+  IN CONST CHAR16 *FirstString,
+  IN CONST CHAR16 *SecondString,
+  IN UINTN        Length
+  );
+
+UINTN
+EFIAPI
+AsciiStrLen (
+  IN CONST CHAR8 *String
+  );
+
+INTN
+EFIAPI
+AsciiStrCmp (
+  IN CONST CHAR8 *FirstString,
+  IN CONST CHAR8 *SecondString
+  );
+
+CHAR8 *
+EFIAPI
+AsciiStrStr (
+  IN CONST CHAR8 *String,
+  IN CONST CHAR8 *SearchString
+  );
+
+UINT32
+EFIAPI
+ReadUnaligned32 (
+  IN CONST UINT32 *Buffer
+  );
+
+UINT32
+EFIAPI
+AsmCpuid (
+  IN  UINT32 Index,
+  OUT UINT32 *RegisterEax OPTIONAL,
+  OUT UINT32 *RegisterEbx OPTIONAL,
+  OUT UINT32 *RegisterEcx OPTIONAL,
+  OUT UINT32 *RegisterEdx OPTIONAL
+  );
+
+UINT64
+EFIAPI
+AsmReadTsc (
+  VOID
+  );
+
+#endif // HOST_BASE_LIB_H_
@@ -0,0 +1,60 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/BaseMemoryLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_BASE_MEMORY_LIB_H_
+#define HOST_BASE_MEMORY_LIB_H_
+
+#include <Base.h>
+
+VOID *
+EFIAPI
+CopyMem (
+  OUT VOID       *DestinationBuffer,
+  IN  CONST VOID *SourceBuffer,
+  IN  UINTN      Length
+  );
+
+VOID *
+EFIAPI
+SetMem (
+  OUT VOID  *Buffer,
+  IN  UINTN Length,
+  IN  UINT8 Value
+  );
+
+VOID *
+EFIAPI
+ZeroMem (
+  OUT VOID  *Buffer,
+  IN  UINTN Length
+  );
+
+INTN
+EFIAPI
+CompareMem (
+  IN CONST VOID *DestinationBuffer,
+  IN CONST VOID *SourceBuffer,
+  IN UINTN      Length
+  );
+
+BOOLEAN
+EFIAPI
+CompareGuid (
+  IN CONST GUID *Guid1,
+  IN CONST GUID *Guid2
+  );
+
+VOID *
+EFIAPI
+ScanMem8 (
+  IN CONST VOID *Buffer,
+  IN UINTN      Length,
+  IN UINT8      Value
+  );
+
+#endif // HOST_BASE_MEMORY_LIB_H_
@@ -0,0 +1,83 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/DebugLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_DEBUG_LIB_H_
+#define HOST_DEBUG_LIB_H_
+
+#include <Base.h>
+
+#define DEBUG_INIT      0x00000001
+#define DEBUG_WARN      0x00000002
+#define DEBUG_LOAD      0x00000004
+#define DEBUG_FS        0x00000008
+#define DEBUG_POOL      0x00000010
+#define DEBUG_PAGE      0x00000020
+#define DEBUG_INFO      0x00000040
+#define DEBUG_DISPATCH  0x00000080
+#define DEBUG_VARIABLE  0x00000100
+#define DEBUG_BM        0x00000400
+#define DEBUG_BLKIO     0x00001000
+#define DEBUG_NET       0x00004000
+#define DEBUG_UNDI      0x00010000
+#define DEBUG_LOADFILE  0x00020000
+#define DEBUG_EVENT     0x00080000
+#define DEBUG_GCD       0x00100000
+#define DEBUG_CACHE     0x00200000
+#define DEBUG_VERBOSE   0x00400000
+#define DEBUG_ERROR     0x80000000
+
+//
+// The format strings use the EDK II conversion specifiers (%a, %s, %r, ...),
+// which the host printf() family does not know. DebugPrint() therefore only
+// reports the format string of DEBUG_ERROR messages.
+//
+VOID
+EFIAPI
+DebugPrint (
+  IN UINTN       ErrorLevel,
+  IN CONST CHAR8 *Format,
+  ...
+  );
+
+VOID
+EFIAPI
+DebugAssert (
+  IN CONST CHAR8 *FileName,
+  IN UINTN       LineNumber,
+  IN CONST CHAR8 *Description
+  );
+
+#define DEBUG(Expression)  DebugPrint Expression
+
+#define ASSERT(Expression)                                  \
+  do {                                                      \
+    if (!(Expression)) {                                    \
+      DebugAssert (__FILE__, __LINE__, #Expression);        \
+    }                                                       \
+  } while (FALSE)
+
+#define ASSERT_EFI_ERROR(StatusParameter)                   \
+  do {                                                      \
+    if (RETURN_ERROR (StatusParameter)) {                   \
+      DebugAssert (__FILE__, __LINE__, #StatusParameter);   \
+    }                                                       \
+  } while (FALSE)
+
+#define ASSERT_RETURN_ERROR(StatusParameter) \
+  ASSERT_EFI_ERROR (StatusParameter)
+
+#define DEBUG_CODE_BEGIN()  do {
+#define DEBUG_CODE_END()    } while (FALSE)
+
+#define CR(Record, TYPE, Field, TestSignature)              \
+  (((BASE_CR (Record, TYPE, Field))->Signature != (TestSignature)) ? \
+   (DebugAssert (__FILE__, __LINE__, "CR has Bad Signature"), \
+    BASE_CR (Record, TYPE, Field)) :                        \
+   BASE_CR (Record, TYPE, Field))
+
+#endif // HOST_DEBUG_LIB_H_
@@ -0,0 +1,92 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/DevicePathLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_DEVICE_PATH_LIB_H_
+#define HOST_DEVICE_PATH_LIB_H_
+
+#include <Uefi.h>
+#include <Protocol/DevicePath.h>
+
+UINT8
+EFIAPI
+DevicePathType (
+  IN CONST VOID *Node
+  );
+
+UINT8
+EFIAPI
+DevicePathSubType (
+  IN CONST VOID *Node
+  );
+
+UINTN
+EFIAPI
+DevicePathNodeLength (
+  IN CONST VOID *Node
+  );
+
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+NextDevicePathNode (
+  IN CONST VOID *Node
+  );
+
+BOOLEAN
+EFIAPI
+IsDevicePathEnd (
+  IN CONST VOID *Node
+  );
+
+UINT16
+EFIAPI
+SetDevicePathNodeLength (
+  IN OUT VOID  *Node,
+  IN     UINTN Length
+  );
+
+VOID
+EFIAPI
+SetDevicePathEndNode (
+  OUT VOID *Node
+  );
+
+UINTN
+EFIAPI
+GetDevicePathSize (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath
+  );
+
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+DuplicateDevicePath (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath
+  );
+
+//
+// Converts the node types that Protocol/DevicePath.h declares, in the text
+// format of DevicePathToText.c; other nodes become Path(Type,SubType,Data).
+// DisplayOnly and AllowShortcuts are ignored.
+//
+CHAR16 *
+EFIAPI
+ConvertDevicePathToText (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath,
+  IN BOOLEAN                        DisplayOnly,
+  IN BOOLEAN                        AllowShortcuts
+  );
+
+//
+// Declared for the sources that reference it; not implemented on the host.
+//
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+ConvertTextToDevicePath (
+  IN CONST CHAR16 *TextDevicePath
+  );
+
+#endif // HOST_DEVICE_PATH_LIB_H_
@@ -0,0 +1,40 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/ExtractGuidedSectionLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_EXTRACT_GUIDED_SECTION_LIB_H_
+#define HOST_EXTRACT_GUIDED_SECTION_LIB_H_
+
+#include <Base.h>
+
+typedef
+RETURN_STATUS
+(EFIAPI *EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER)(
+  IN  CONST VOID *InputSection,
+  OUT UINT32     *OutputBufferSize,
+  OUT UINT32     *ScratchBufferSize,
+  OUT UINT16     *SectionAttribute
+  );
+
+typedef
+RETURN_STATUS
+(EFIAPI *EXTRACT_GUIDED_SECTION_DECODE_HANDLER)(
+  IN CONST  VOID   *InputSection,
+  OUT       VOID   **OutputBuffer,
+  IN        VOID   *ScratchBuffer,        OPTIONAL
+  OUT       UINT32 *AuthenticationStatus
+  );
+
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionRegisterHandlers (
+  IN CONST GUID                            *SectionGuid,
+  IN EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER GetInfoHandler,
+  IN EXTRACT_GUIDED_SECTION_DECODE_HANDLER   DecodeHandler
+  );
+
+#endif // HOST_EXTRACT_GUIDED_SECTION_LIB_H_
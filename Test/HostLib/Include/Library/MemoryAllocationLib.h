@@ -0,0 +1,60 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/MemoryAllocationLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_MEMORY_ALLOCATION_LIB_H_
+#define HOST_MEMORY_ALLOCATION_LIB_H_
+
+#include <Base.h>
+
+VOID *
+EFIAPI
+AllocatePool (
+  IN UINTN AllocationSize
+  );
+
+VOID *
+EFIAPI
+AllocateZeroPool (
+  IN UINTN AllocationSize
+  );
+
+VOID *
+EFIAPI
+AllocateCopyPool (
+  IN UINTN      AllocationSize,
+  IN CONST VOID *Buffer
+  );
+
+VOID *
+EFIAPI
+ReallocatePool (
+  IN UINTN OldSize,
+  IN UINTN NewSize,
+  IN VOID  *OldBuffer OPTIONAL
+  );
+
+VOID
+EFIAPI
+FreePool (
+  IN VOID *Buffer
+  );
+
+VOID *
+EFIAPI
+AllocatePages (
+  IN UINTN Pages
+  );
+
+VOID
+EFIAPI
+FreePages (
+  IN VOID  *Buffer,
+  IN UINTN Pages
+  );
+
+#endif // HOST_MEMORY_ALLOCATION_LIB_H_
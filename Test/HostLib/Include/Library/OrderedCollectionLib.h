@@ -0,0 +1,97 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/OrderedCollectionLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_ORDERED_COLLECTION_LIB_H_
+#define HOST_ORDERED_COLLECTION_LIB_H_
+
+#include <Base.h>
+
+typedef struct ORDERED_COLLECTION       ORDERED_COLLECTION;
+typedef struct ORDERED_COLLECTION_ENTRY ORDERED_COLLECTION_ENTRY;
+
+typedef
+INTN
+(EFIAPI *ORDERED_COLLECTION_USER_COMPARE)(
+  IN CONST VOID *UserStruct1,
+  IN CONST VOID *UserStruct2
+  );
+
+typedef
+INTN
+(EFIAPI *ORDERED_COLLECTION_KEY_COMPARE)(
+  IN CONST VOID *StandaloneKey,
+  IN CONST VOID *UserStruct
+  );
+
+VOID *
+EFIAPI
+OrderedCollectionUserStruct (
+  IN CONST ORDERED_COLLECTION_ENTRY *Entry
+  );
+
+ORDERED_COLLECTION *
+EFIAPI
+OrderedCollectionInit (
+  IN ORDERED_COLLECTION_USER_COMPARE UserStructCompare,
+  IN ORDERED_COLLECTION_KEY_COMPARE  KeyCompare
+  );
+
+BOOLEAN
+EFIAPI
+OrderedCollectionIsEmpty (
+  IN CONST ORDERED_COLLECTION *Collection
+  );
+
+VOID
+EFIAPI
+OrderedCollectionUninit (
+  IN ORDERED_COLLECTION *Collection
+  );
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionFind (
+  IN CONST ORDERED_COLLECTION *Collection,
+  IN CONST VOID               *StandaloneKey
+  );
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionMin (
+  IN CONST ORDERED_COLLECTION *Collection
+  );
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionNext (
+  IN CONST ORDERED_COLLECTION_ENTRY *Entry
+  );
+
+ORDERED_COLLECTION_ENTRY *
+EFIAPI
+OrderedCollectionPrev (
+  IN CONST ORDERED_COLLECTION_ENTRY *Entry
+  );
+
+RETURN_STATUS
+EFIAPI
+OrderedCollectionInsert (
+  IN OUT ORDERED_COLLECTION       *Collection,
+  OUT    ORDERED_COLLECTION_ENTRY **Entry      OPTIONAL,
+  IN     VOID                     *UserStruct
+  );
+
+VOID
+EFIAPI
+OrderedCollectionDelete (
+  IN OUT ORDERED_COLLECTION       *Collection,
+  IN     ORDERED_COLLECTION_ENTRY *Entry,
+  OUT    VOID                     **UserStruct OPTIONAL
+  );
+
+#endif // HOST_ORDERED_COLLECTION_LIB_H_
@@ -0,0 +1,21 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/PcdLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_PCD_LIB_H_
+#define HOST_PCD_LIB_H_
+
+//
+// As in the AutoGen.h of a module, a harness defines the macros that these
+// expand to, for the PCDs that the module under test reads.
+//
+#define FeaturePcdGet(TokenName)  _PCD_GET_MODE_BOOL_##TokenName
+#define FixedPcdGet32(TokenName)  _PCD_VALUE_##TokenName
+#define PcdGet16(TokenName)       _PCD_GET_MODE_16_##TokenName
+#define PcdGet32(TokenName)       _PCD_GET_MODE_32_##TokenName
+
+#endif // HOST_PCD_LIB_H_
@@ -0,0 +1,36 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/PrintLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_PRINT_LIB_H_
+#define HOST_PRINT_LIB_H_
+
+#include <Base.h>
+
+//
+// Supports the flags '-' and '0', a field width, the 'L' and 'l' modifiers,
+// and the %a, %s, %c, %d, %u, %x, %X, %g and %% conversions.
+//
+UINTN
+EFIAPI
+UnicodeSPrintAsciiFormat (
+  OUT CHAR16      *StartOfBuffer,
+  IN  UINTN       BufferSize,
+  IN  CONST CHAR8 *FormatString,
+  ...
+  );
+
+UINTN
+EFIAPI
+UnicodeVSPrintAsciiFormat (
+  OUT CHAR16      *StartOfBuffer,
+  IN  UINTN       BufferSize,
+  IN  CONST CHAR8 *FormatString,
+  IN  VA_LIST     Marker
+  );
+
+#endif // HOST_PRINT_LIB_H_
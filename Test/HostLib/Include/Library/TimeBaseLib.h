@@ -0,0 +1,33 @@
+/** @file
+  Host stand-in for EmbeddedPkg/Include/Library/TimeBaseLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_TIME_BASE_LIB_H_
+#define HOST_TIME_BASE_LIB_H_
+
+#include <Uefi/UefiBaseType.h>
+
+VOID
+EFIAPI
+EpochToEfiTime (
+  IN  UINTN    EpochSeconds,
+  OUT EFI_TIME *Time
+  );
+
+UINTN
+EFIAPI
+EfiTimeToEpoch (
+  IN EFI_TIME *Time
+  );
+
+BOOLEAN
+EFIAPI
+IsTimeValid (
+  IN CONST EFI_TIME *Time
+  );
+
+#endif // HOST_TIME_BASE_LIB_H_
@@ -0,0 +1,67 @@
+/** @file
+  Host stand-in for MdeModulePkg/Include/Library/UefiBootManagerLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_UEFI_BOOT_MANAGER_LIB_H_
+#define HOST_UEFI_BOOT_MANAGER_LIB_H_
+
+#include <Uefi.h>
+#include <Protocol/DevicePath.h>
+
+typedef enum {
+  LoadOptionTypeDriver,
+  LoadOptionTypeSysPrep,
+  LoadOptionTypeBoot,
+  LoadOptionTypePlatformRecovery,
+  LoadOptionTypeMax
+} EFI_BOOT_MANAGER_LOAD_OPTION_TYPE;
+
+typedef struct {
+  UINTN                             OptionNumber;
+  EFI_BOOT_MANAGER_LOAD_OPTION_TYPE OptionType;
+  UINT32                            Attributes;
+  CHAR16                            *Description;
+  EFI_DEVICE_PATH_PROTOCOL          *FilePath;
+  UINT8                             *OptionalData;
+  UINT32                            OptionalDataSize;
+  EFI_GUID                          VendorGuid;
+  EFI_STATUS                        Status;
+} EFI_BOOT_MANAGER_LOAD_OPTION;
+
+//
+// The harnesses that use UefiBootManagerLib implement these functions.
+//
+EFI_BOOT_MANAGER_LOAD_OPTION *
+EFIAPI
+EfiBootManagerGetLoadOptions (
+  OUT UINTN                             *LoadOptionCount,
+  IN  EFI_BOOT_MANAGER_LOAD_OPTION_TYPE LoadOptionType
+  );
+
+EFI_STATUS
+EFIAPI
+EfiBootManagerFreeLoadOptions (
+  IN EFI_BOOT_MANAGER_LOAD_OPTION *LoadOptions,
+  IN UINTN                        LoadOptionCount
+  );
+
+VOID *
+EFIAPI
+EfiBootManagerGetLoadOptionBuffer (
+  IN  EFI_DEVICE_PATH_PROTOCOL *FilePath,
+  OUT EFI_DEVICE_PATH_PROTOCOL **FullPath,
+  OUT UINTN                    *FileSize
+  );
+
+EFI_STATUS
+EFIAPI
+EfiBootManagerConnectDevicePath (
+  IN  EFI_DEVICE_PATH_PROTOCOL *DevicePathToConnect,
+  OUT EFI_HANDLE               *MatchingHandle OPTIONAL
+  );
+
+#endif // HOST_UEFI_BOOT_MANAGER_LIB_H_
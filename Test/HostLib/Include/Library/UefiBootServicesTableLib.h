@@ -0,0 +1,18 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/UefiBootServicesTableLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_UEFI_BOOT_SERVICES_TABLE_LIB_H_
+#define HOST_UEFI_BOOT_SERVICES_TABLE_LIB_H_
+
+#include <Uefi.h>
+
+extern EFI_HANDLE        gImageHandle;
+extern EFI_SYSTEM_TABLE  *gST;
+extern EFI_BOOT_SERVICES *gBS;
+
+#endif // HOST_UEFI_BOOT_SERVICES_TABLE_LIB_H_
@@ -0,0 +1,43 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/UefiLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_UEFI_LIB_H_
+#define HOST_UEFI_LIB_H_
+
+#include <Uefi.h>
+#include <Protocol/ComponentName.h>
+#include <Protocol/ComponentName2.h>
+#include <Protocol/DriverBinding.h>
+
+typedef struct {
+  CHAR8  *Language;
+  CHAR16 *UnicodeString;
+} EFI_UNICODE_STRING_TABLE;
+
+EFI_STATUS
+EFIAPI
+LookupUnicodeString2 (
+  IN  CONST CHAR8                    *Language,
+  IN  CONST CHAR8                    *SupportedLanguages,
+  IN  CONST EFI_UNICODE_STRING_TABLE *UnicodeStringTable,
+  OUT CHAR16                         **UnicodeString,
+  IN  BOOLEAN                        Iso639Language
+  );
+
+EFI_STATUS
+EFIAPI
+EfiLibInstallDriverBindingComponentName2 (
+  IN CONST EFI_HANDLE                   ImageHandle,
+  IN CONST EFI_SYSTEM_TABLE             *SystemTable,
+  IN EFI_DRIVER_BINDING_PROTOCOL        *DriverBinding,
+  IN EFI_HANDLE                         DriverBindingHandle,
+  IN CONST EFI_COMPONENT_NAME_PROTOCOL  *ComponentName,  OPTIONAL
+  IN CONST EFI_COMPONENT_NAME2_PROTOCOL *ComponentName2  OPTIONAL
+  );
+
+#endif // HOST_UEFI_LIB_H_
@@ -0,0 +1,19 @@
+/** @file
+  Host stand-in for MdePkg/Include/Library/UefiRuntimeServicesTableLib.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_UEFI_RUNTIME_SERVICES_TABLE_LIB_H_
+#define HOST_UEFI_RUNTIME_SERVICES_TABLE_LIB_H_
+
+#include <Uefi.h>
+
+//
+// Defined by the harnesses that use it, with their own variable services.
+//
+extern EFI_RUNTIME_SERVICES *gRT;
+
+#endif // HOST_UEFI_RUNTIME_SERVICES_TABLE_LIB_H_
@@ -0,0 +1,59 @@
+/** @file
+  Host stand-in for MdePkg/Include/PiPei.h.
+
+  Only the GUIDed section definitions of Pi/PiFirmwareFile.h are provided.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_PI_PEI_H_
+#define HOST_PI_PEI_H_
+
+#include <Uefi/UefiBaseType.h>
+
+#define EFI_SECTION_GUID_DEFINED  0x02
+
+#define EFI_GUIDED_SECTION_PROCESSING_REQUIRED  0x01
+#define EFI_GUIDED_SECTION_AUTH_STATUS_VALID    0x02
+
+#define MAX_SECTION_SIZE  0x1000000
+
+#pragma pack (1)
+typedef struct {
+  UINT8 Size[3];
+  UINT8 Type;
+} EFI_COMMON_SECTION_HEADER;
+
+typedef struct {
+  UINT8  Size[3];
+  UINT8  Type;
+  UINT32 ExtendedSize;
+} EFI_COMMON_SECTION_HEADER2;
+
+typedef struct {
+  EFI_COMMON_SECTION_HEADER CommonHeader;
+  EFI_GUID                  SectionDefinitionGuid;
+  UINT16                    DataOffset;
+  UINT16                    Attributes;
+} EFI_GUID_DEFINED_SECTION;
+
+typedef struct {
+  EFI_COMMON_SECTION_HEADER2 CommonHeader;
+  EFI_GUID                   SectionDefinitionGuid;
+  UINT16                     DataOffset;
+  UINT16                     Attributes;
+} EFI_GUID_DEFINED_SECTION2;
+#pragma pack ()
+
+#define IS_SECTION2(SectionHeaderPtr) \
+    ((UINT32) (*((UINT32 *) ((EFI_COMMON_SECTION_HEADER *) (UINTN) SectionHeaderPtr)->Size) & 0x00ffffff) == 0x00ffffff)
+
+#define SECTION_SIZE(SectionHeaderPtr) \
+    ((UINT32) (*((UINT32 *) ((EFI_COMMON_SECTION_HEADER *) (UINTN) SectionHeaderPtr)->Size) & 0x00ffffff))
+
+#define SECTION2_SIZE(SectionHeaderPtr) \
+    (((EFI_COMMON_SECTION_HEADER2 *) (UINTN) SectionHeaderPtr)->ExtendedSize)
+
+#endif // HOST_PI_PEI_H_
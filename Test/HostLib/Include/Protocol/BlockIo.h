@@ -0,0 +1,78 @@
+/** @file
+  Host stand-in for MdePkg/Include/Protocol/BlockIo.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_BLOCK_IO_H_
+#define HOST_BLOCK_IO_H_
+
+#include <Uefi.h>
+
+typedef struct _EFI_BLOCK_IO_PROTOCOL EFI_BLOCK_IO_PROTOCOL;
+
+#define EFI_BLOCK_IO_PROTOCOL_REVISION2  0x00020001
+#define EFI_BLOCK_IO_PROTOCOL_REVISION3  0x0002001F
+
+typedef
+EFI_STATUS
+(EFIAPI *EFI_BLOCK_RESET)(
+  IN EFI_BLOCK_IO_PROTOCOL *This,
+  IN BOOLEAN               ExtendedVerification
+  );
+
+typedef
+EFI_STATUS
+(EFIAPI *EFI_BLOCK_READ)(
+  IN  EFI_BLOCK_IO_PROTOCOL *This,
+  IN  UINT32                MediaId,
+  IN  EFI_LBA               Lba,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  );
+
+typedef
+EFI_STATUS
+(EFIAPI *EFI_BLOCK_WRITE)(
+  IN EFI_BLOCK_IO_PROTOCOL *This,
+  IN UINT32                MediaId,
+  IN EFI_LBA               Lba,
+  IN UINTN                 BufferSize,
+  IN VOID                  *Buffer
+  );
+
+typedef
+EFI_STATUS
+(EFIAPI *EFI_BLOCK_FLUSH)(
+  IN EFI_BLOCK_IO_PROTOCOL *This
+  );
+
+typedef struct {
+  UINT32  MediaId;
+  BOOLEAN RemovableMedia;
+  BOOLEAN MediaPresent;
+  BOOLEAN LogicalPartition;
+  BOOLEAN ReadOnly;
+  BOOLEAN WriteCaching;
+  UINT32  BlockSize;
+  UINT32  IoAlign;
+  EFI_LBA LastBlock;
+  EFI_LBA LowestAlignedLba;
+  UINT32  LogicalBlocksPerPhysicalBlock;
+  UINT32  OptimalTransferLengthGranularity;
+} EFI_BLOCK_IO_MEDIA;
+
+struct _EFI_BLOCK_IO_PROTOCOL {
+  UINT64             Revision;
+  EFI_BLOCK_IO_MEDIA *Media;
+  EFI_BLOCK_RESET    Reset;
+  EFI_BLOCK_READ     ReadBlocks;
+  EFI_BLOCK_WRITE    WriteBlocks;
+  EFI_BLOCK_FLUSH    FlushBlocks;
+};
+
+extern EFI_GUID gEfiBlockIoProtocolGuid;
+
+#endif // HOST_BLOCK_IO_H_
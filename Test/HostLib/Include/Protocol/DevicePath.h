@@ -0,0 +1,123 @@
+/** @file
+  Host stand-in for MdePkg/Include/Protocol/DevicePath.h.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_DEVICE_PATH_H_
+#define HOST_DEVICE_PATH_H_
+
+#include <Uefi/UefiBaseType.h>
+
+#pragma pack(1)
+
+typedef struct {
+  UINT8 Type;
+  UINT8 SubType;
+  UINT8 Length[2];
+} EFI_DEVICE_PATH_PROTOCOL;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  UINT8                    Function;
+  UINT8                    Device;
+} PCI_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  EFI_GUID                 Guid;
+} VENDOR_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  UINT32                   HID;
+  UINT32                   UID;
+} ACPI_HID_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  UINT16                   Pun;
+  UINT16                   Lun;
+} SCSI_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  EFI_MAC_ADDRESS          MacAddress;
+  UINT8                    IfType;
+} MAC_ADDR_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  UINT16                   HBAPortNumber;
+  UINT16                   PortMultiplierPortNumber;
+  UINT16                   Lun;
+} SATA_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  UINT32                   PartitionNumber;
+  UINT64                   PartitionStart;
+  UINT64                   PartitionSize;
+  UINT8                    Signature[16];
+  UINT8                    MBRType;
+  UINT8                    SignatureType;
+} HARDDRIVE_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  CHAR16                   PathName[1];
+} FILEPATH_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  EFI_GUID                 FvFileName;
+} MEDIA_FW_VOL_FILEPATH_DEVICE_PATH;
+
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL Header;
+  EFI_GUID                 FvName;
+} MEDIA_FW_VOL_DEVICE_PATH;
+
+#pragma pack()
+
+#define HARDWARE_DEVICE_PATH            0x01
+#define HW_PCI_DP                       0x01
+#define HW_VENDOR_DP                    0x04
+
+#define ACPI_DEVICE_PATH                0x02
+#define ACPI_DP                         0x01
+
+#define PNP_EISA_ID_CONST               0x41d0
+#define EISA_ID(_Name, _Num)            ((UINT32)((_Name) | (_Num) << 16))
+#define EISA_PNP_ID(_PNPId)             (EISA_ID(PNP_EISA_ID_CONST, (_PNPId)))
+#define PNP_EISA_ID_MASK                0xffff
+#define EISA_ID_TO_NUM(_Id)             ((_Id) >> 16)
+
+#define MESSAGING_DEVICE_PATH           0x03
+#define MSG_SCSI_DP                     0x02
+#define MSG_MAC_ADDR_DP                 0x0b
+#define MSG_USB_CLASS_DP                0x0f
+#define MSG_USB_WWID_DP                 0x10
+#define MSG_SATA_DP                     0x12
+#define MSG_URI_DP                      0x18
+
+#define MEDIA_DEVICE_PATH               0x04
+#define MEDIA_HARDDRIVE_DP              0x01
+#define MEDIA_FILEPATH_DP               0x04
+#define MEDIA_PIWG_FW_FILE_DP           0x06
+#define MEDIA_PIWG_FW_VOL_DP            0x07
+
+#define MBR_TYPE_PCAT                   0x01
+#define MBR_TYPE_EFI_PARTITION_TABLE_HEADER 0x02
+#define SIGNATURE_TYPE_MBR              0x01
+#define SIGNATURE_TYPE_GUID             0x02
+
+#define END_DEVICE_PATH_TYPE            0x7f
+#define END_ENTIRE_DEVICE_PATH_SUBTYPE  0xFF
+#define END_DEVICE_PATH_LENGTH          (sizeof (EFI_DEVICE_PATH_PROTOCOL))
+
+extern EFI_GUID gEfiDevicePathProtocolGuid;
+
+#endif // HOST_DEVICE_PATH_H_
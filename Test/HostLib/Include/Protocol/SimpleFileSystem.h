@@ -0,0 +1,53 @@
+/** @file
+  Host stand-in for MdePkg/Include/Protocol/SimpleFileSystem.h.
+
+  The EFI_FILE_PROTOCOL member functions are kept as untyped pointers; the
+  benchmark drives the FUSE request layer below them.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_SIMPLE_FILE_SYSTEM_H_
+#define HOST_SIMPLE_FILE_SYSTEM_H_
+
+#include <Uefi.h>
+
+typedef struct _EFI_SIMPLE_FILE_SYSTEM_PROTOCOL EFI_SIMPLE_FILE_SYSTEM_PROTOCOL;
+typedef struct _EFI_FILE_PROTOCOL               EFI_FILE_PROTOCOL;
+
+#define EFI_FILE_MODE_READ    0x0000000000000001ULL
+#define EFI_FILE_MODE_WRITE   0x0000000000000002ULL
+#define EFI_FILE_MODE_CREATE  0x8000000000000000ULL
+
+#define EFI_FILE_READ_ONLY   0x0000000000000001ULL
+#define EFI_FILE_HIDDEN      0x0000000000000002ULL
+#define EFI_FILE_SYSTEM      0x0000000000000004ULL
+#define EFI_FILE_RESERVED    0x0000000000000008ULL
+#define EFI_FILE_DIRECTORY   0x0000000000000010ULL
+#define EFI_FILE_ARCHIVE     0x0000000000000020ULL
+#define EFI_FILE_VALID_ATTR  0x0000000000000037ULL
+
+#define EFI_FILE_PROTOCOL_REVISION  0x00010000
+
+struct _EFI_FILE_PROTOCOL {
+  UINT64 Revision;
+  VOID   *Open;
+  VOID   *Close;
+  VOID   *Delete;
+  VOID   *Read;
+  VOID   *Write;
+  VOID   *GetPosition;
+  VOID   *SetPosition;
+  VOID   *GetInfo;
+  VOID   *SetInfo;
+  VOID   *Flush;
+};
+
+struct _EFI_SIMPLE_FILE_SYSTEM_PROTOCOL {
+  UINT64 Revision;
+  VOID   *OpenVolume;
+};
+
+#endif // HOST_SIMPLE_FILE_SYSTEM_H_
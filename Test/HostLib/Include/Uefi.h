@@ -0,0 +1,156 @@
+/** @file
+  Host stand-in for MdePkg/Include/Uefi.h.
+
+  EFI_BOOT_SERVICES only carries the services that the compiled driver sources
+  reference. HostLib.c implements the ones that the benchmarked request paths
+  actually call.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef HOST_UEFI_H_
+#define HOST_UEFI_H_
+
+#include <Uefi/UefiBaseType.h>
+#include <Protocol/DevicePath.h>
+
+#define TPL_APPLICATION  4
+#define TPL_CALLBACK     8
+#define TPL_NOTIFY       16
+#define TPL_HIGH_LEVEL   31
+
+#define EVT_TIMER                          0x80000000
+#define EVT_RUNTIME                        0x40000000
+#define EVT_NOTIFY_WAIT                    0x00000100
+#define EVT_NOTIFY_SIGNAL                  0x00000200
+#define EVT_SIGNAL_EXIT_BOOT_SERVICES      0x00000201
+#define EVT_SIGNAL_VIRTUAL_ADDRESS_CHANGE  0x60000202
+
+#define EFI_OPEN_PROTOCOL_BY_HANDLE_PROTOCOL  0x00000001
+#define EFI_OPEN_PROTOCOL_GET_PROTOCOL        0x00000002
+#define EFI_OPEN_PROTOCOL_TEST_PROTOCOL       0x00000004
+#define EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER 0x00000008
+#define EFI_OPEN_PROTOCOL_BY_DRIVER           0x00000010
+#define EFI_OPEN_PROTOCOL_EXCLUSIVE           0x00000020
+
+typedef enum {
+  EFI_NATIVE_INTERFACE
+} EFI_INTERFACE_TYPE;
+
+typedef
+VOID
+(EFIAPI *EFI_EVENT_NOTIFY)(
+  IN EFI_EVENT Event,
+  IN VOID      *Context
+  );
+
+typedef struct {
+  EFI_TPL
+  (EFIAPI *RaiseTPL)(
+    IN EFI_TPL NewTpl
+    );
+
+  VOID
+  (EFIAPI *RestoreTPL)(
+    IN EFI_TPL OldTpl
+    );
+
+  EFI_STATUS
+  (EFIAPI *CreateEvent)(
+    IN  UINT32           Type,
+    IN  EFI_TPL          NotifyTpl,
+    IN  EFI_EVENT_NOTIFY NotifyFunction OPTIONAL,
+    IN  VOID             *NotifyContext OPTIONAL,
+    OUT EFI_EVENT        *Event
+    );
+
+  EFI_STATUS
+  (EFIAPI *CloseEvent)(
+    IN EFI_EVENT Event
+    );
+
+  EFI_STATUS
+  (EFIAPI *InstallProtocolInterface)(
+    IN OUT EFI_HANDLE         *Handle,
+    IN     EFI_GUID           *Protocol,
+    IN     EFI_INTERFACE_TYPE InterfaceType,
+    IN     VOID               *Interface
+    );
+
+  EFI_STATUS
+  (EFIAPI *UninstallProtocolInterface)(
+    IN EFI_HANDLE Handle,
+    IN EFI_GUID   *Protocol,
+    IN VOID       *Interface
+    );
+
+  EFI_STATUS
+  (EFIAPI *Stall)(
+    IN UINTN Microseconds
+    );
+
+  EFI_STATUS
+  (EFIAPI *OpenProtocol)(
+    IN  EFI_HANDLE Handle,
+    IN  EFI_GUID   *Protocol,
+    OUT VOID       **Interface OPTIONAL,
+    IN  EFI_HANDLE AgentHandle,
+    IN  EFI_HANDLE ControllerHandle,
+    IN  UINT32     Attributes
+    );
+
+  EFI_STATUS
+  (EFIAPI *CloseProtocol)(
+    IN EFI_HANDLE Handle,
+    IN EFI_GUID   *Protocol,
+    IN EFI_HANDLE AgentHandle,
+    IN EFI_HANDLE ControllerHandle
+    );
+
+  EFI_STATUS
+  (EFIAPI *ConnectController)(
+    IN EFI_HANDLE ControllerHandle,
+    IN EFI_HANDLE *DriverImageHandle OPTIONAL,
+    IN VOID       *RemainingDevicePath OPTIONAL,
+    IN BOOLEAN    Recursive
+    );
+} EFI_BOOT_SERVICES;
+
+#define EFI_VARIABLE_NON_VOLATILE        0x00000001
+#define EFI_VARIABLE_BOOTSERVICE_ACCESS  0x00000002
+#define EFI_VARIABLE_RUNTIME_ACCESS      0x00000004
+
+typedef struct {
+  EFI_STATUS
+  (EFIAPI *GetVariable)(
+    IN     CHAR16   *VariableName,
+    IN     EFI_GUID *VendorGuid,
+    OUT    UINT32   *Attributes OPTIONAL,
+    IN OUT UINTN    *DataSize,
+    OUT    VOID     *Data OPTIONAL
+    );
+
+  EFI_STATUS
+  (EFIAPI *SetVariable)(
+    IN CHAR16   *VariableName,
+    IN EFI_GUID *VendorGuid,
+    IN UINT32   Attributes,
+    IN UINTN    DataSize,
+    IN VOID     *Data
+    );
+} EFI_RUNTIME_SERVICES;
+
+#define LOAD_OPTION_ACTIVE            0x00000001
+#define LOAD_OPTION_FORCE_RECONNECT   0x00000002
+#define LOAD_OPTION_HIDDEN            0x00000008
+#define LOAD_OPTION_CATEGORY          0x00001F00
+#define LOAD_OPTION_CATEGORY_BOOT     0x00000000
+#define LOAD_OPTION_CATEGORY_APP      0x00000100
+
+typedef struct {
+  EFI_BOOT_SERVICES *BootServices;
+} EFI_SYSTEM_TABLE;
+
+#endif // HOST_UEFI_H_
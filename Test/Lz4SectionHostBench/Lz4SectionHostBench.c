@@ -0,0 +1,405 @@
+/** @file
+  Host benchmark of the chunked LZ4 GUIDed section extraction against LZMA.
+
+  Usage: Lz4SectionHostBench [-n ITERATIONS] IMAGE LZ4C LZMA
+
+  IMAGE is the uncompressed data (for example a DXEFV.Fv), LZ4C the section
+  payload that Lz4ChunkCompress.py made of it, and LZMA the same data in the
+  LZMA-alone container that LzmaCustomDecompressLib reads.
+
+  The LZ4C payload is wrapped in a GUIDed section and decoded through the
+  handlers that Lz4ChunkedDecompressLibConstructor() registers, the way SEC
+  decodes FVMAIN_COMPACT. The LZMA reference is decoded by the host liblzma;
+  the LZMA SDK decoder of the firmware lives in MdeModulePkg, outside this
+  package. Every decode is checked against IMAGE.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lzma.h>
+
+#include <PiPei.h>
+#include <Guid/Lz4ChunkedSection.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "HostLib.h"
+
+//
+// The size of the LZMA-alone header: properties, dictionary size and
+// uncompressed size.
+//
+#define LZMA_ALONE_HEADER_SIZE  13
+
+typedef struct {
+  UINT8  *Data;
+  UINTN  Size;
+} BENCH_FILE;
+
+typedef struct {
+  CONST CHAR8 *Name;
+  UINTN       SectionSize;
+  UINT64      MinNs;
+  UINT64      MedianNs;
+  UINT64      Errors;
+} BENCH_RESULT;
+
+EFI_GUID gLz4ChunkedCustomDecompressGuid = LZ4_CHUNKED_CUSTOM_DECOMPRESS_GUID;
+
+RETURN_STATUS
+EFIAPI
+Lz4ChunkedDecompressLibConstructor (
+  VOID
+  );
+
+STATIC EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER mGetInfoHandler;
+STATIC EXTRACT_GUIDED_SECTION_DECODE_HANDLER   mDecodeHandler;
+
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionRegisterHandlers (
+  IN CONST GUID                              *SectionGuid,
+  IN EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER GetInfoHandler,
+  IN EXTRACT_GUIDED_SECTION_DECODE_HANDLER   DecodeHandler
+  )
+{
+  if (!CompareGuid (SectionGuid, &gLz4ChunkedCustomDecompressGuid)) {
+    return RETURN_UNSUPPORTED;
+  }
+  mGetInfoHandler = GetInfoHandler;
+  mDecodeHandler  = DecodeHandler;
+  return RETURN_SUCCESS;
+}
+
+STATIC
+BOOLEAN
+BenchReadFile (
+  IN  CONST CHAR8 *Path,
+  OUT BENCH_FILE  *File
+  )
+{
+  FILE *Stream;
+  long Size;
+
+  Stream = fopen (Path, "rb");
+  if (Stream == NULL) {
+    perror (Path);
+    return FALSE;
+  }
+  if (fseek (Stream, 0, SEEK_END) != 0 || (Size = ftell (Stream)) <= 0 ||
+      fseek (Stream, 0, SEEK_SET) != 0) {
+    fprintf (stderr, "%s: cannot determine the size\n", Path);
+    fclose (Stream);
+    return FALSE;
+  }
+  File->Size = (UINTN)Size;
+  File->Data = AllocatePool (File->Size);
+  if (File->Data == NULL ||
+      fread (File->Data, 1, File->Size, Stream) != File->Size) {
+    fprintf (stderr, "%s: read failed\n", Path);
+    fclose (Stream);
+    return FALSE;
+  }
+  fclose (Stream);
+  return TRUE;
+}
+
+/**
+  Wrap a payload in a GUIDed section, as GenFds does. Payloads of 16MB and
+  more get the extended (EFI_COMMON_SECTION_HEADER2) header.
+
+  @return  The section, or NULL if out of memory.
+**/
+STATIC
+VOID *
+BenchMakeSection (
+  IN  CONST BENCH_FILE *Payload,
+  IN  CONST EFI_GUID   *Guid,
+  OUT UINTN            *SectionSize
+  )
+{
+  EFI_GUID_DEFINED_SECTION  *Section;
+  EFI_GUID_DEFINED_SECTION2 *Section2;
+  UINTN                     HeaderSize;
+
+  HeaderSize   = sizeof *Section;
+  *SectionSize = HeaderSize + Payload->Size;
+  if (*SectionSize >= MAX_SECTION_SIZE) {
+    HeaderSize   = sizeof *Section2;
+    *SectionSize = HeaderSize + Payload->Size;
+  }
+
+  Section = AllocateZeroPool (*SectionSize);
+  if (Section == NULL) {
+    return NULL;
+  }
+  if (HeaderSize == sizeof *Section2) {
+    Section2 = (EFI_GUID_DEFINED_SECTION2 *)Section;
+    SetMem (Section2->CommonHeader.Size, 3, 0xFF);
+    Section2->CommonHeader.Type         = EFI_SECTION_GUID_DEFINED;
+    Section2->CommonHeader.ExtendedSize = (UINT32)*SectionSize;
+    CopyMem (&Section2->SectionDefinitionGuid, Guid, sizeof *Guid);
+    Section2->DataOffset = (UINT16)HeaderSize;
+    Section2->Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED;
+  } else {
+    Section->CommonHeader.Size[0] = (UINT8)*SectionSize;
+    Section->CommonHeader.Size[1] = (UINT8)(*SectionSize >> 8);
+    Section->CommonHeader.Size[2] = (UINT8)(*SectionSize >> 16);
+    Section->CommonHeader.Type    = EFI_SECTION_GUID_DEFINED;
+    CopyMem (&Section->SectionDefinitionGuid, Guid, sizeof *Guid);
+    Section->DataOffset = (UINT16)HeaderSize;
+    Section->Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED;
+  }
+  CopyMem ((UINT8 *)Section + HeaderSize, Payload->Data, Payload->Size);
+  return Section;
+}
+
+STATIC
+int
+BenchCompareU64 (
+  IN CONST VOID *Left,
+  IN CONST VOID *Right
+  )
+{
+  UINT64 L;
+  UINT64 R;
+
+  L = *(CONST UINT64 *)Left;
+  R = *(CONST UINT64 *)Right;
+  return (L > R) - (L < R);
+}
+
+STATIC
+VOID
+BenchSummarize (
+  IN OUT UINT64       *Samples,
+  IN     UINTN        Count,
+  IN OUT BENCH_RESULT *Result
+  )
+{
+  qsort (Samples, Count, sizeof *Samples, BenchCompareU64);
+  Result->MinNs    = Samples[0];
+  Result->MedianNs = Samples[Count / 2];
+}
+
+STATIC
+VOID
+BenchLz4Chunked (
+  IN     CONST BENCH_FILE *Image,
+  IN     CONST BENCH_FILE *Payload,
+  IN     UINTN            Iterations,
+  IN OUT UINT64           *Samples,
+  OUT    BENCH_RESULT     *Result
+  )
+{
+  VOID          *Section;
+  UINT32        OutputSize;
+  UINT32        ScratchSize;
+  UINT16        Attributes;
+  UINT32        AuthenticationStatus;
+  VOID          *Output;
+  VOID          *Scratch;
+  UINTN         Idx;
+  UINT64        Start;
+  RETURN_STATUS Status;
+
+  Result->Name = "lz4-chunked";
+  Section      = BenchMakeSection (Payload, &gLz4ChunkedCustomDecompressGuid,
+                   &Result->SectionSize);
+  if (Section == NULL) {
+    Result->Errors++;
+    return;
+  }
+
+  Status = mGetInfoHandler (Section, &OutputSize, &ScratchSize, &Attributes);
+  if (RETURN_ERROR (Status) || OutputSize != Image->Size) {
+    fprintf (stderr, "%s: GetInfo: status 0x%llx, size %u\n", Result->Name,
+      (unsigned long long)Status, OutputSize);
+    Result->Errors++;
+    FreePool (Section);
+    return;
+  }
+
+  Output  = AllocatePool (OutputSize);
+  Scratch = AllocatePool (MAX (ScratchSize, 1));
+  for (Idx = 0; Idx < Iterations && Output != NULL && Scratch != NULL; Idx++) {
+    ZeroMem (Output, OutputSize);
+    Start  = HostNowNs ();
+    Status = mDecodeHandler (Section, &Output, Scratch, &AuthenticationStatus);
+    Samples[Idx] = HostNowNs () - Start;
+
+    if (RETURN_ERROR (Status) ||
+        CompareMem (Output, Image->Data, Image->Size) != 0) {
+      Result->Errors++;
+    }
+  }
+  if (Output == NULL || Scratch == NULL) {
+    Result->Errors++;
+  } else {
+    BenchSummarize (Samples, Iterations, Result);
+  }
+
+  if (Output != NULL) {
+    FreePool (Output);
+  }
+  if (Scratch != NULL) {
+    FreePool (Scratch);
+  }
+  FreePool (Section);
+}
+
+STATIC
+VOID
+BenchLzma (
+  IN     CONST BENCH_FILE *Image,
+  IN     CONST BENCH_FILE *Payload,
+  IN     UINTN            Iterations,
+  IN OUT UINT64           *Samples,
+  OUT    BENCH_RESULT     *Result
+  )
+{
+  UINT8       *Output;
+  UINTN       Idx;
+  UINT64      Start;
+  lzma_stream Stream = LZMA_STREAM_INIT;
+  lzma_ret    Ret;
+
+  Result->Name        = "lzma";
+  Result->SectionSize = sizeof (EFI_GUID_DEFINED_SECTION) + Payload->Size;
+  if (Payload->Size < LZMA_ALONE_HEADER_SIZE) {
+    Result->Errors++;
+    return;
+  }
+
+  Output = AllocatePool (Image->Size);
+  for (Idx = 0; Idx < Iterations && Output != NULL; Idx++) {
+    ZeroMem (Output, Image->Size);
+    Start = HostNowNs ();
+    Ret   = lzma_alone_decoder (&Stream, UINT64_MAX);
+    if (Ret == LZMA_OK) {
+      Stream.next_in   = Payload->Data;
+      Stream.avail_in  = Payload->Size;
+      Stream.next_out  = Output;
+      Stream.avail_out = Image->Size;
+      Ret = lzma_code (&Stream, LZMA_FINISH);
+    }
+    lzma_end (&Stream);
+    Samples[Idx] = HostNowNs () - Start;
+
+    if (Ret != LZMA_STREAM_END || Stream.total_out != Image->Size ||
+        CompareMem (Output, Image->Data, Image->Size) != 0) {
+      Result->Errors++;
+    }
+  }
+  if (Output == NULL) {
+    Result->Errors++;
+    return;
+  }
+  BenchSummarize (Samples, Iterations, Result);
+  FreePool (Output);
+}
+
+STATIC
+VOID
+BenchReport (
+  IN CONST BENCH_FILE   *Image,
+  IN CONST BENCH_RESULT *Result
+  )
+{
+  printf ("%-12s %10llu %6.1f%% %9.2f %9.2f %9.1f %6llu\n",
+    Result->Name,
+    (unsigned long long)Result->SectionSize,
+    100.0 * Result->SectionSize / Image->Size,
+    Result->MinNs / 1e6,
+    Result->MedianNs / 1e6,
+    (Result->MedianNs > 0) ? Image->Size * 1e3 / Result->MedianNs : 0,
+    (unsigned long long)Result->Errors);
+}
+
+STATIC
+VOID
+BenchUsage (
+  IN CONST CHAR8 *Program
+  )
+{
+  fprintf (stderr,
+    "Usage: %s [-n ITERATIONS] IMAGE LZ4C LZMA\n"
+    "\n"
+    "  IMAGE  the uncompressed data, for example Build/.../FV/DXEFV.Fv\n"
+    "  LZ4C   IMAGE encoded by Lz4ChunkCompress.py -e\n"
+    "  LZMA   IMAGE in the LZMA-alone container\n"
+    "  -n     decodes per format (default 20)\n",
+    Program);
+}
+
+int
+main (
+  int  argc,
+  char **argv
+  )
+{
+  UINTN        Iterations;
+  int          Opt;
+  BENCH_FILE   Image;
+  BENCH_FILE   Lz4Payload;
+  BENCH_FILE   LzmaPayload;
+  UINT64       *Samples;
+  BENCH_RESULT Lz4Result;
+  BENCH_RESULT LzmaResult;
+
+  Iterations = 20;
+  while ((Opt = getopt (argc, argv, "n:h")) != -1) {
+    switch (Opt) {
+      case 'n':
+        Iterations = strtoul (optarg, NULL, 0);
+        break;
+      default:
+        BenchUsage (argv[0]);
+        return 2;
+    }
+  }
+  if (Iterations == 0 || argc - optind != 3) {
+    BenchUsage (argv[0]);
+    return 2;
+  }
+
+  if (!BenchReadFile (argv[optind], &Image) ||
+      !BenchReadFile (argv[optind + 1], &Lz4Payload) ||
+      !BenchReadFile (argv[optind + 2], &LzmaPayload)) {
+    return 1;
+  }
+
+  if (RETURN_ERROR (Lz4ChunkedDecompressLibConstructor ()) ||
+      mGetInfoHandler == NULL || mDecodeHandler == NULL) {
+    fprintf (stderr, "the LZ4 section handlers were not registered\n");
+    return 1;
+  }
+
+  Samples = AllocatePool (Iterations * sizeof *Samples);
+  if (Samples == NULL) {
+    fprintf (stderr, "out of memory\n");
+    return 1;
+  }
+
+  ZeroMem (&Lz4Result, sizeof Lz4Result);
+  ZeroMem (&LzmaResult, sizeof LzmaResult);
+  BenchLz4Chunked (&Image, &Lz4Payload, Iterations, Samples, &Lz4Result);
+  BenchLzma (&Image, &LzmaPayload, Iterations, Samples, &LzmaResult);
+
+  printf ("%s: %llu bytes, %llu decodes per format\n", argv[optind],
+    (unsigned long long)Image.Size, (unsigned long long)Iterations);
+  printf ("%-12s %10s %7s %9s %9s %9s %6s\n",
+    "format", "section", "ratio", "min ms", "p50 ms", "MB/s", "errors");
+  BenchReport (&Image, &Lz4Result);
+  BenchReport (&Image, &LzmaResult);
+
+  return (Lz4Result.Errors + LzmaResult.Errors > 0) ? 1 : 0;
+}
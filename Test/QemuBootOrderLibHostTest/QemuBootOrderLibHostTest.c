@@ -0,0 +1,1007 @@
+/** @file
+  Host test of the boot option matching in QemuBootOrderLib.
+
+  Usage: QemuBootOrderLibHostTest [-s SEEDS] [-d DEVICES]
+
+  QemuBootOrderLib.c is included whole, so that the test reaches its STATIC
+  functions. For each of SEEDS pseudo-random virtual machines of up to DEVICES
+  boot devices, the test builds the boot options and the QEMU "bootorder"
+  fw_cfg file, then computes the BootOrder twice:
+
+  - with SetBootOrderFromQemu(), which matches each path that
+    TranslateOfwPath() produces through AppendMatchingOptions() and the index
+    of the active boot options;
+
+  - with the loop that SetBootOrderFromQemu() used before the index: every
+    translated path against every active boot option not appended yet, each
+    comparison converting (and expanding) the option's device path again.
+
+  The test fails if the two BootOrders differ. For the largest machine it
+  prints the time, the device path conversions and the short-form expansions
+  of both.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <Library/PcdLib.h>
+
+#define _PCD_GET_MODE_BOOL_PcdQemuBootOrderPciTranslation   TRUE
+#define _PCD_GET_MODE_BOOL_PcdQemuBootOrderMmioTranslation  FALSE
+#define _PCD_GET_MODE_16_PcdPlatformBootTimeOut             0
+
+#include "QemuBootOrderLib.c"
+
+#include "HostLib.h"
+
+//
+// The PCI bus number of the extra root bus with serial number 1, as if it
+// were a pxb-pcie device with bus_nr=0x20.
+//
+#define TEST_EXTRA_ROOT_BUS  0x20
+
+#define TEST_MAX_DEVICES     224
+#define TEST_MAX_OPTIONS     (3 * TEST_MAX_DEVICES + 2)
+#define TEST_MAX_PATH_SIZE   256
+#define TEST_FW_CFG_SIZE     (TEST_MAX_DEVICES * 64 + 256)
+
+typedef enum {
+  TestDeviceVirtioBlk,
+  TestDeviceVirtioScsi,
+  TestDeviceAhci,
+  TestDeviceNic,
+  TestDeviceKindMax
+} TEST_DEVICE_KIND;
+
+typedef struct {
+  UINT8 Data[TEST_MAX_PATH_SIZE];
+  UINTN Size;
+} TEST_PATH;
+
+//
+// A disk partition. EfiBootManagerGetLoadOptionBuffer() expands short-form
+// HD() device paths to its full device path.
+//
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL *Partition;
+} TEST_DISK;
+
+struct EXTRA_ROOT_BUS_MAP_STRUCT {
+  UINT32 BusNumber;
+};
+
+typedef struct {
+  UINT64 Ns;
+  UINT64 Conversions;
+  UINT64 Expansions;
+} TEST_COST;
+
+EFI_GUID gEfiGlobalVariableGuid   = EFI_GLOBAL_VARIABLE;
+EFI_GUID gVirtioMmioTransportGuid = VIRTIO_MMIO_TRANSPORT_GUID;
+
+STATIC EFI_BOOT_MANAGER_LOAD_OPTION mOptions[TEST_MAX_OPTIONS];
+STATIC UINTN                        mOptionCount;
+STATIC TEST_DISK                    mDisks[TEST_MAX_OPTIONS];
+STATIC UINTN                        mDiskCount;
+STATIC CHAR8                        mFwCfg[TEST_FW_CFG_SIZE];
+STATIC UINTN                        mFwCfgSize;
+STATIC UINTN                        mFwCfgOffset;
+STATIC UINT16                       mBootOrder[TEST_MAX_OPTIONS];
+STATIC UINTN                        mBootOrderCount;
+STATIC UINT64                       mRandom;
+STATIC UINT64                       mConversions;
+STATIC UINT64                       mExpansions;
+
+CHAR16 *
+EFIAPI
+__real_ConvertDevicePathToText (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath,
+  IN BOOLEAN                        DisplayOnly,
+  IN BOOLEAN                        AllowShortcuts
+  );
+
+//
+// Linked with --wrap=ConvertDevicePathToText, to count the conversions.
+//
+CHAR16 *
+EFIAPI
+__wrap_ConvertDevicePathToText (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath,
+  IN BOOLEAN                        DisplayOnly,
+  IN BOOLEAN                        AllowShortcuts
+  )
+{
+  mConversions++;
+  return __real_ConvertDevicePathToText (DevicePath, DisplayOnly,
+           AllowShortcuts);
+}
+
+//
+// ExtraRootBusMap.c, for a machine with one extra root bus.
+//
+
+EFI_STATUS
+CreateExtraRootBusMap (
+  OUT EXTRA_ROOT_BUS_MAP **ExtraRootBusMap
+  )
+{
+  *ExtraRootBusMap = AllocatePool (sizeof **ExtraRootBusMap);
+  if (*ExtraRootBusMap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  (*ExtraRootBusMap)->BusNumber = TEST_EXTRA_ROOT_BUS;
+  return EFI_SUCCESS;
+}
+
+VOID
+DestroyExtraRootBusMap (
+  IN EXTRA_ROOT_BUS_MAP *ExtraRootBusMap
+  )
+{
+  FreePool (ExtraRootBusMap);
+}
+
+EFI_STATUS
+MapRootBusPosToBusNr (
+  IN  CONST EXTRA_ROOT_BUS_MAP *ExtraRootBusMap,
+  IN  UINT64                   RootBusPos,
+  OUT UINT32                   *RootBusNr
+  )
+{
+  if (RootBusPos != 1) {
+    return EFI_NOT_FOUND;
+  }
+  *RootBusNr = ExtraRootBusMap->BusNumber;
+  return EFI_SUCCESS;
+}
+
+//
+// QemuFwCfgLib, serving the "bootorder" file only.
+//
+
+RETURN_STATUS
+EFIAPI
+QemuFwCfgFindFile (
+  IN   CONST CHAR8           *Name,
+  OUT  FIRMWARE_CONFIG_ITEM  *Item,
+  OUT  UINTN                 *Size
+  )
+{
+  if (AsciiStrCmp (Name, "bootorder") != 0) {
+    return RETURN_NOT_FOUND;
+  }
+  *Item = 0x20;
+  *Size = mFwCfgSize;
+  return RETURN_SUCCESS;
+}
+
+VOID
+EFIAPI
+QemuFwCfgSelectItem (
+  IN FIRMWARE_CONFIG_ITEM QemuFwCfgItem
+  )
+{
+  mFwCfgOffset = 0;
+}
+
+VOID
+EFIAPI
+QemuFwCfgReadBytes (
+  IN UINTN Size,
+  IN VOID  *Buffer
+  )
+{
+  ASSERT (mFwCfgOffset + Size <= mFwCfgSize);
+  CopyMem (Buffer, mFwCfg + mFwCfgOffset, Size);
+  mFwCfgOffset += Size;
+}
+
+UINT16
+EFIAPI
+QemuFwCfgRead16 (
+  VOID
+  )
+{
+  return 0;
+}
+
+//
+// UefiBootManagerLib
+//
+
+EFI_BOOT_MANAGER_LOAD_OPTION *
+EFIAPI
+EfiBootManagerGetLoadOptions (
+  OUT UINTN                             *LoadOptionCount,
+  IN  EFI_BOOT_MANAGER_LOAD_OPTION_TYPE LoadOptionType
+  )
+{
+  ASSERT (LoadOptionType == LoadOptionTypeBoot);
+  *LoadOptionCount = mOptionCount;
+  return mOptions;
+}
+
+EFI_STATUS
+EFIAPI
+EfiBootManagerFreeLoadOptions (
+  IN EFI_BOOT_MANAGER_LOAD_OPTION *LoadOptions,
+  IN UINTN                        LoadOptionCount
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Expand a short-form HD() device path against the disks of the machine.
+**/
+VOID *
+EFIAPI
+EfiBootManagerGetLoadOptionBuffer (
+  IN  EFI_DEVICE_PATH_PROTOCOL *FilePath,
+  OUT EFI_DEVICE_PATH_PROTOCOL **FullPath,
+  OUT UINTN                    *FileSize
+  )
+{
+  UINTN                    Index;
+  EFI_DEVICE_PATH_PROTOCOL *Node;
+  UINTN                    PrefixSize;
+  UINTN                    RestSize;
+  UINT8                    *Path;
+
+  mExpansions++;
+  if (DevicePathType (FilePath) != MEDIA_DEVICE_PATH ||
+      DevicePathSubType (FilePath) != MEDIA_HARDDRIVE_DP) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < mDiskCount; Index++) {
+    for (Node = mDisks[Index].Partition;
+         !IsDevicePathEnd (NextDevicePathNode (Node));
+         Node = NextDevicePathNode (Node)) {
+    }
+    if (DevicePathNodeLength (Node) == DevicePathNodeLength (FilePath) &&
+        CompareMem (Node, FilePath, DevicePathNodeLength (Node)) == 0) {
+      break;
+    }
+  }
+  if (Index == mDiskCount) {
+    return NULL;
+  }
+
+  PrefixSize = (UINT8 *)Node - (UINT8 *)mDisks[Index].Partition;
+  RestSize   = GetDevicePathSize (FilePath);
+  Path       = AllocatePool (PrefixSize + RestSize);
+  ASSERT (Path != NULL);
+  CopyMem (Path, mDisks[Index].Partition, PrefixSize);
+  CopyMem (Path + PrefixSize, FilePath, RestSize);
+  *FullPath = (EFI_DEVICE_PATH_PROTOCOL *)Path;
+  *FileSize = 1;
+  return AllocateZeroPool (*FileSize);
+}
+
+EFI_STATUS
+EFIAPI
+EfiBootManagerConnectDevicePath (
+  IN  EFI_DEVICE_PATH_PROTOCOL *DevicePathToConnect,
+  OUT EFI_HANDLE               *MatchingHandle OPTIONAL
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+//
+// UefiRuntimeServicesTableLib, recording the BootOrder that is set.
+//
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestGetVariable (
+  IN     CHAR16   *VariableName,
+  IN     EFI_GUID *VendorGuid,
+  OUT    UINT32   *Attributes OPTIONAL,
+  IN OUT UINTN    *DataSize,
+  OUT    VOID     *Data OPTIONAL
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetVariable (
+  IN CHAR16   *VariableName,
+  IN EFI_GUID *VendorGuid,
+  IN UINT32   Attributes,
+  IN UINTN    DataSize,
+  IN VOID     *Data
+  )
+{
+  if (StrCmp (VariableName, L"BootOrder") == 0) {
+    ASSERT (DataSize <= sizeof mBootOrder);
+    CopyMem (mBootOrder, Data, DataSize);
+    mBootOrderCount = DataSize / sizeof *mBootOrder;
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_RUNTIME_SERVICES mTestRuntimeServices = {
+  TestGetVariable,  // GetVariable
+  TestSetVariable   // SetVariable
+};
+
+EFI_RUNTIME_SERVICES *gRT = &mTestRuntimeServices;
+
+//
+// The machine
+//
+
+STATIC
+UINT32
+TestRandom (
+  IN UINT32 Limit
+  )
+{
+  mRandom = mRandom * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (UINT32)((mRandom >> 33) % Limit);
+}
+
+STATIC
+VOID *
+TestPathAdd (
+  IN OUT TEST_PATH *Path,
+  IN     UINT8     Type,
+  IN     UINT8     SubType,
+  IN     UINTN     Length
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL *Node;
+
+  ASSERT (Path->Size + Length + END_DEVICE_PATH_LENGTH <= sizeof Path->Data);
+  Node = (EFI_DEVICE_PATH_PROTOCOL *)(Path->Data + Path->Size);
+  ZeroMem (Node, Length);
+  Node->Type    = Type;
+  Node->SubType = SubType;
+  SetDevicePathNodeLength (Node, Length);
+  Path->Size += Length;
+  return Node;
+}
+
+STATIC
+EFI_DEVICE_PATH_PROTOCOL *
+TestPathFinish (
+  IN TEST_PATH *Path
+  )
+{
+  SetDevicePathEndNode (Path->Data + Path->Size);
+  return AllocateCopyPool (Path->Size + END_DEVICE_PATH_LENGTH, Path->Data);
+}
+
+STATIC
+VOID
+TestPathAddPci (
+  IN OUT TEST_PATH *Path,
+  IN     UINT8     Device,
+  IN     UINT8     Function
+  )
+{
+  PCI_DEVICE_PATH *Pci;
+
+  Pci = TestPathAdd (Path, HARDWARE_DEVICE_PATH, HW_PCI_DP, sizeof *Pci);
+  Pci->Device   = Device;
+  Pci->Function = Function;
+}
+
+STATIC
+VOID
+TestPathAddHd (
+  IN OUT TEST_PATH *Path,
+  IN     UINT32    DiskNumber,
+  IN     UINT32    PartitionNumber
+  )
+{
+  HARDDRIVE_DEVICE_PATH *Hd;
+  UINT32                Signature;
+
+  Hd = TestPathAdd (Path, MEDIA_DEVICE_PATH, MEDIA_HARDDRIVE_DP, sizeof *Hd);
+  Hd->PartitionNumber = PartitionNumber;
+  Hd->PartitionStart  = 0x800 * PartitionNumber;
+  Hd->PartitionSize   = 0x100000;
+  Signature           = 0x51E00000 | DiskNumber;
+  CopyMem (Hd->Signature, &Signature, sizeof Signature);
+  Hd->Signature[15]   = (UINT8)PartitionNumber;
+  Hd->MBRType         = MBR_TYPE_EFI_PARTITION_TABLE_HEADER;
+  Hd->SignatureType   = SIGNATURE_TYPE_GUID;
+}
+
+STATIC
+VOID
+TestPathAddFile (
+  IN OUT TEST_PATH    *Path,
+  IN     CONST CHAR16 *Name
+  )
+{
+  FILEPATH_DEVICE_PATH *File;
+  UINTN                Size;
+
+  Size = (StrLen (Name) + 1) * sizeof *Name;
+  File = TestPathAdd (Path, MEDIA_DEVICE_PATH, MEDIA_FILEPATH_DP,
+           OFFSET_OF (FILEPATH_DEVICE_PATH, PathName) + Size);
+  CopyMem (File->PathName, Name, Size);
+}
+
+STATIC
+VOID
+TestAddOption (
+  IN EFI_DEVICE_PATH_PROTOCOL *FilePath,
+  IN BOOLEAN                  Active
+  )
+{
+  EFI_BOOT_MANAGER_LOAD_OPTION *Option;
+
+  ASSERT (mOptionCount < TEST_MAX_OPTIONS);
+  Option = &mOptions[mOptionCount++];
+  ZeroMem (Option, sizeof *Option);
+  Option->OptionType = LoadOptionTypeBoot;
+  Option->Attributes = Active ? LOAD_OPTION_ACTIVE : 0;
+  Option->FilePath   = FilePath;
+}
+
+/**
+  Add a boot device: its OpenFirmware path to the "bootorder" file, if
+  InBootOrder, and one to three boot options for it.
+**/
+STATIC
+VOID
+TestAddDevice (
+  IN UINT32  DeviceNumber,
+  IN BOOLEAN InBootOrder
+  )
+{
+  TEST_DEVICE_KIND Kind;
+  TEST_PATH        Device;
+  TEST_PATH        Path;
+  CHAR8            Ofw[64];
+  CHAR8            *OfwNext;
+  UINT8            Slot;
+  UINT8            Function;
+  UINT32           Partition;
+  UINT32           PartitionCount;
+  EFI_DEVICE_PATH_PROTOCOL *Partial;
+
+  Kind     = (TEST_DEVICE_KIND)TestRandom (TestDeviceKindMax);
+  Slot     = (UINT8)(2 + DeviceNumber % 28);
+  Function = (UINT8)(DeviceNumber / 28);
+
+  //
+  // The root bus, and maybe a bridge.
+  //
+  Device.Size = 0;
+  OfwNext = Ofw;
+  if (DeviceNumber % 5 == 4) {
+    ACPI_HID_DEVICE_PATH *Acpi;
+
+    Acpi = TestPathAdd (&Device, ACPI_DEVICE_PATH, ACPI_DP, sizeof *Acpi);
+    Acpi->HID = EISA_PNP_ID (0x0a03);
+    Acpi->UID = TEST_EXTRA_ROOT_BUS;
+    OfwNext += sprintf (OfwNext, "/pci@i0cf8,1");
+  } else {
+    ACPI_HID_DEVICE_PATH *Acpi;
+
+    Acpi = TestPathAdd (&Device, ACPI_DEVICE_PATH, ACPI_DP, sizeof *Acpi);
+    Acpi->HID = EISA_PNP_ID (0x0a03);
+    Acpi->UID = 0;
+    OfwNext += sprintf (OfwNext, "/pci@i0cf8");
+  }
+  if (DeviceNumber % 7 == 3) {
+    TestPathAddPci (&Device, 0x1e, 0);
+    OfwNext += sprintf (OfwNext, "/pci-bridge@1e");
+  }
+
+  switch (Kind) {
+    case TestDeviceVirtioBlk:
+      TestPathAddPci (&Device, Slot, Function);
+      OfwNext += sprintf (OfwNext, "/scsi@%x,%x/disk@0,0", Slot, Function);
+      break;
+
+    case TestDeviceVirtioScsi:
+      {
+        SCSI_DEVICE_PATH *Scsi;
+
+        TestPathAddPci (&Device, Slot, Function);
+        Scsi = TestPathAdd (&Device, MESSAGING_DEVICE_PATH, MSG_SCSI_DP,
+                 sizeof *Scsi);
+        Scsi->Pun = (UINT16)TestRandom (4);
+        OfwNext += sprintf (OfwNext, "/scsi@%x,%x/channel@0/disk@%x,0", Slot,
+                     Function, Scsi->Pun);
+      }
+      break;
+
+    case TestDeviceAhci:
+      {
+        SATA_DEVICE_PATH *Sata;
+
+        TestPathAddPci (&Device, 0x1f, 2);
+        Sata = TestPathAdd (&Device, MESSAGING_DEVICE_PATH, MSG_SATA_DP,
+                 sizeof *Sata);
+        Sata->HBAPortNumber            = (UINT16)(DeviceNumber % 6);
+        Sata->PortMultiplierPortNumber = 0xFFFF;
+        OfwNext += sprintf (OfwNext, "/pci8086,2922@1f,2/drive@%x/disk@0",
+                     Sata->HBAPortNumber);
+      }
+      break;
+
+    default:
+      {
+        MAC_ADDR_DEVICE_PATH *Mac;
+
+        TestPathAddPci (&Device, Slot, Function);
+        OfwNext += sprintf (OfwNext, "/ethernet@%x,%x", Slot, Function);
+        Mac = TestPathAdd (&Device, MESSAGING_DEVICE_PATH, MSG_MAC_ADDR_DP,
+                sizeof *Mac);
+        Mac->MacAddress.Addr[0] = 0x52;
+        Mac->MacAddress.Addr[1] = 0x54;
+        Mac->MacAddress.Addr[5] = (UINT8)DeviceNumber;
+        Mac->IfType             = 1;
+        TestAddOption (TestPathFinish (&Device), TRUE);
+      }
+      break;
+  }
+
+  if (InBootOrder) {
+    mFwCfgSize += sprintf (mFwCfg + mFwCfgSize, "%s\n", Ofw);
+    ASSERT (mFwCfgSize < sizeof mFwCfg);
+  }
+  if (Kind == TestDeviceNic) {
+    return;
+  }
+
+  //
+  // A disk: a full-path option for each partition; the partitions after the
+  // first one also get a short-form HD() option, or an inactive one.
+  //
+  PartitionCount = 1 + TestRandom (3);
+  for (Partition = 1; Partition <= PartitionCount; Partition++) {
+    Path = Device;
+    TestPathAddHd (&Path, DeviceNumber, Partition);
+    Partial = TestPathFinish (&Path);
+    ASSERT (mDiskCount < ARRAY_SIZE (mDisks));
+    mDisks[mDiskCount++].Partition = Partial;
+
+    TestPathAddFile (&Path, L"\\EFI\\BOOT\\BOOTX64.EFI");
+    TestAddOption (TestPathFinish (&Path), TRUE);
+
+    if (Partition > 1) {
+      Path.Size = 0;
+      TestPathAddHd (&Path, DeviceNumber, Partition);
+      TestPathAddFile (&Path, L"\\System\\Library\\CoreServices\\boot.efi");
+      TestAddOption (TestPathFinish (&Path), TestRandom (4) != 0);
+    }
+  }
+}
+
+STATIC
+VOID
+TestFreeMachine (
+  VOID
+  )
+{
+  UINTN Index;
+
+  for (Index = 0; Index < mOptionCount; Index++) {
+    FreePool (mOptions[Index].FilePath);
+  }
+  for (Index = 0; Index < mDiskCount; Index++) {
+    FreePool (mDisks[Index].Partition);
+  }
+  mOptionCount = 0;
+  mDiskCount   = 0;
+  mFwCfgSize   = 0;
+}
+
+/**
+  Build a machine of DeviceCount boot devices. About one in eight is left out
+  of the "bootorder" file, which also names a device that has no boot option
+  and a floppy drive, which cannot be translated. The boot options are
+  shuffled.
+**/
+STATIC
+VOID
+TestBuildMachine (
+  IN UINT32 DeviceCount
+  )
+{
+  UINT32                       *Order;
+  UINT32                       Index;
+  UINT32                       Other;
+  UINT32                       Swap;
+  EFI_BOOT_MANAGER_LOAD_OPTION Option;
+  TEST_PATH                    Path;
+  MEDIA_FW_VOL_DEVICE_PATH     *Fv;
+  MEDIA_FW_VOL_FILEPATH_DEVICE_PATH *FvFile;
+
+  Order = AllocatePool (DeviceCount * sizeof *Order);
+  ASSERT (Order != NULL);
+  for (Index = 0; Index < DeviceCount; Index++) {
+    Order[Index] = Index;
+  }
+  for (Index = DeviceCount; Index > 1; Index--) {
+    Other = TestRandom (Index);
+    Swap = Order[Index - 1];
+    Order[Index - 1] = Order[Other];
+    Order[Other] = Swap;
+  }
+
+  for (Index = 0; Index < DeviceCount; Index++) {
+    TestAddDevice (Order[Index], TestRandom (8) != 0);
+    if (Index == DeviceCount / 2) {
+      mFwCfgSize += sprintf (mFwCfg + mFwCfgSize,
+                      "/pci@i0cf8/isa@1/fdc@03f0/floppy@0\n"
+                      "/pci@i0cf8/scsi@1f,7/disk@0,0\n");
+    }
+  }
+  mFwCfgSize += sprintf (mFwCfg + mFwCfgSize, "HALT");
+  mFwCfg[mFwCfgSize++] = '\0';
+  FreePool (Order);
+
+  //
+  // The UEFI Shell, which BootOrderComplete() keeps.
+  //
+  Path.Size = 0;
+  Fv = TestPathAdd (&Path, MEDIA_DEVICE_PATH, MEDIA_PIWG_FW_VOL_DP,
+         sizeof *Fv);
+  Fv->FvName.Data1 = 0x7CB8BDC9;
+  FvFile = TestPathAdd (&Path, MEDIA_DEVICE_PATH, MEDIA_PIWG_FW_FILE_DP,
+             sizeof *FvFile);
+  FvFile->FvFileName.Data1 = 0x7C04A583;
+  TestAddOption (TestPathFinish (&Path), TRUE);
+
+  for (Index = mOptionCount; Index > 1; Index--) {
+    Other = TestRandom (Index);
+    Option = mOptions[Index - 1];
+    mOptions[Index - 1] = mOptions[Other];
+    mOptions[Other] = Option;
+  }
+  for (Index = 0; Index < mOptionCount; Index++) {
+    mOptions[Index].OptionNumber = Index;
+  }
+}
+
+//
+// The BootOrder computations
+//
+
+/**
+  Match() as QemuBootOrderLib.c had it before the index of active boot
+  options: convert DevicePath, expanding a short-form one, and check if
+  Translated is a prefix of the text.
+**/
+STATIC
+BOOLEAN
+TestMatch (
+  IN  CONST CHAR16                           *Translated,
+  IN  UINTN                                  TranslatedLength,
+  IN  EFI_DEVICE_PATH_PROTOCOL               *DevicePath
+  )
+{
+  CHAR16                   *Converted;
+  BOOLEAN                  Result;
+  VOID                     *FileBuffer;
+  UINTN                    FileSize;
+  EFI_DEVICE_PATH_PROTOCOL *AbsDevicePath;
+  CHAR16                   *AbsConverted;
+  BOOLEAN                  Shortform;
+  EFI_DEVICE_PATH_PROTOCOL *Node;
+
+  Converted = ConvertDevicePathToText (
+                DevicePath,
+                FALSE, // DisplayOnly
+                FALSE  // AllowShortcuts
+                );
+  if (Converted == NULL) {
+    return FALSE;
+  }
+
+  Result = FALSE;
+  Shortform = FALSE;
+  //
+  // Expand the short-form device path to full device path
+  //
+  if ((DevicePathType (DevicePath) == MEDIA_DEVICE_PATH) &&
+      (DevicePathSubType (DevicePath) == MEDIA_HARDDRIVE_DP)) {
+    //
+    // Harddrive shortform device path
+    //
+    Shortform = TRUE;
+  } else if ((DevicePathType (DevicePath) == MEDIA_DEVICE_PATH) &&
+             (DevicePathSubType (DevicePath) == MEDIA_FILEPATH_DP)) {
+    //
+    // File-path shortform device path
+    //
+    Shortform = TRUE;
+  } else if ((DevicePathType (DevicePath) == MESSAGING_DEVICE_PATH) &&
+             (DevicePathSubType (DevicePath) == MSG_URI_DP)) {
+    //
+    // URI shortform device path
+    //
+    Shortform = TRUE;
+  } else {
+    for ( Node = DevicePath
+        ; !IsDevicePathEnd (Node)
+        ; Node = NextDevicePathNode (Node)
+        ) {
+      if ((DevicePathType (Node) == MESSAGING_DEVICE_PATH) &&
+          ((DevicePathSubType (Node) == MSG_USB_CLASS_DP) ||
+           (DevicePathSubType (Node) == MSG_USB_WWID_DP))) {
+        Shortform = TRUE;
+        break;
+      }
+    }
+  }
+
+  //
+  // Attempt to expand any relative UEFI device path to
+  // an absolute device path first.
+  //
+  if (Shortform) {
+    FileBuffer = EfiBootManagerGetLoadOptionBuffer (
+                   DevicePath, &AbsDevicePath, &FileSize
+                   );
+    if (FileBuffer == NULL) {
+      goto Exit;
+    }
+    FreePool (FileBuffer);
+    AbsConverted = ConvertDevicePathToText (AbsDevicePath, FALSE, FALSE);
+    FreePool (AbsDevicePath);
+    if (AbsConverted == NULL) {
+      goto Exit;
+    }
+    DEBUG ((DEBUG_VERBOSE,
+      "%a: expanded relative device path \"%s\" for prefix matching\n",
+      __FUNCTION__, Converted));
+    FreePool (Converted);
+    Converted = AbsConverted;
+  }
+
+  //
+  // Is Translated a prefix of Converted?
+  //
+  Result = (BOOLEAN)(StrnCmp (Converted, Translated, TranslatedLength) == 0);
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "%a: against \"%s\": %a\n",
+    __FUNCTION__,
+    Converted,
+    Result ? "match" : "no match"
+    ));
+Exit:
+  FreePool (Converted);
+  return Result;
+}
+
+/**
+  SetBootOrderFromQemu() with the matching loop it had before the index of
+  active boot options, returning the BootOrder in mBootOrder.
+**/
+STATIC
+RETURN_STATUS
+TestReferenceBootOrder (
+  VOID
+  )
+{
+  RETURN_STATUS                Status;
+  CONST CHAR8                  *FwCfgPtr;
+  BOOT_ORDER                   BootOrder;
+  EFI_BOOT_MANAGER_LOAD_OPTION *BootOptions;
+  UINTN                        BootOptionCount;
+  ACTIVE_OPTION                *ActiveOption;
+  UINTN                        ActiveCount;
+  EXTRA_ROOT_BUS_MAP           *ExtraPciRoots;
+  UINTN                        TranslatedSize;
+  CHAR16                       Translated[TRANSLATION_OUTPUT_SIZE];
+  UINTN                        Idx;
+
+  BootOrder.Produced  = 0;
+  BootOrder.Allocated = 1;
+  BootOrder.Data      = AllocatePool (sizeof *BootOrder.Data);
+  BootOptions = EfiBootManagerGetLoadOptions (&BootOptionCount,
+                  LoadOptionTypeBoot);
+  Status = CollectActiveOptions (BootOptions, BootOptionCount, &ActiveOption,
+             &ActiveCount);
+  ASSERT_RETURN_ERROR (Status);
+  Status = CreateExtraRootBusMap (&ExtraPciRoots);
+  ASSERT_RETURN_ERROR (Status);
+
+  FwCfgPtr = mFwCfg;
+  TranslatedSize = ARRAY_SIZE (Translated);
+  Status = TranslateOfwPath (&FwCfgPtr, ExtraPciRoots, Translated,
+             &TranslatedSize);
+  while (Status == RETURN_SUCCESS ||
+         Status == RETURN_UNSUPPORTED ||
+         Status == RETURN_PROTOCOL_ERROR ||
+         Status == RETURN_BUFFER_TOO_SMALL) {
+    if (Status == RETURN_SUCCESS) {
+      for (Idx = 0; Idx < ActiveCount; ++Idx) {
+        if (!ActiveOption[Idx].Appended &&
+            TestMatch (Translated, TranslatedSize,
+              ActiveOption[Idx].BootOption->FilePath)) {
+          Status = BootOrderAppend (&BootOrder, &ActiveOption[Idx]);
+          ASSERT_RETURN_ERROR (Status);
+        }
+      }
+    }
+    TranslatedSize = ARRAY_SIZE (Translated);
+    Status = TranslateOfwPath (&FwCfgPtr, ExtraPciRoots, Translated,
+               &TranslatedSize);
+  }
+
+  mBootOrderCount = 0;
+  if (Status == RETURN_NOT_FOUND && BootOrder.Produced > 0) {
+    Status = BootOrderComplete (&BootOrder, ActiveOption, ActiveCount);
+    ASSERT_RETURN_ERROR (Status);
+    CopyMem (mBootOrder, BootOrder.Data,
+      BootOrder.Produced * sizeof *BootOrder.Data);
+    mBootOrderCount = BootOrder.Produced;
+  }
+
+  DestroyExtraRootBusMap (ExtraPciRoots);
+  FreePool (ActiveOption);
+  FreePool (BootOrder.Data);
+  return Status;
+}
+
+STATIC
+VOID
+TestCostStart (
+  OUT TEST_COST *Cost
+  )
+{
+  Cost->Conversions = mConversions;
+  Cost->Expansions  = mExpansions;
+  Cost->Ns          = HostNowNs ();
+}
+
+STATIC
+VOID
+TestCostStop (
+  IN OUT TEST_COST *Cost
+  )
+{
+  Cost->Ns          = HostNowNs () - Cost->Ns;
+  Cost->Conversions = mConversions - Cost->Conversions;
+  Cost->Expansions  = mExpansions - Cost->Expansions;
+}
+
+STATIC
+VOID
+TestReportCost (
+  IN CONST CHAR8     *Name,
+  IN CONST TEST_COST *Cost
+  )
+{
+  printf ("%-10s %10.3f %12llu %12llu\n", Name, Cost->Ns / 1e6,
+    (unsigned long long)Cost->Conversions,
+    (unsigned long long)Cost->Expansions);
+}
+
+STATIC
+VOID
+TestUsage (
+  IN CONST CHAR8 *Program
+  )
+{
+  fprintf (stderr,
+    "Usage: %s [-s SEEDS] [-d DEVICES]\n"
+    "\n"
+    "  -s  machines per size (default 50)\n"
+    "  -d  boot devices of the largest machine, at most %u (default %u)\n",
+    Program, TEST_MAX_DEVICES, TEST_MAX_DEVICES);
+}
+
+int
+main (
+  int  argc,
+  char **argv
+  )
+{
+  UINTN         Seeds;
+  UINT32        MaxDevices;
+  int           Opt;
+  UINT32        Devices;
+  UINTN         Seed;
+  UINTN         Machines;
+  UINTN         Failures;
+  UINTN         OptionCount;
+  UINTN         Ordered;
+  RETURN_STATUS Status;
+  UINT16        Expected[TEST_MAX_OPTIONS];
+  UINTN         ExpectedCount;
+  TEST_COST     IndexedCost;
+  TEST_COST     ReferenceCost;
+
+  Seeds      = 50;
+  MaxDevices = TEST_MAX_DEVICES;
+  while ((Opt = getopt (argc, argv, "s:d:h")) != -1) {
+    switch (Opt) {
+      case 's':
+        Seeds = strtoul (optarg, NULL, 0);
+        break;
+      case 'd':
+        MaxDevices = strtoul (optarg, NULL, 0);
+        break;
+      default:
+        TestUsage (argv[0]);
+        return 2;
+    }
+  }
+  if (Seeds == 0 || MaxDevices == 0 || MaxDevices > TEST_MAX_DEVICES ||
+      optind != argc) {
+    TestUsage (argv[0]);
+    return 2;
+  }
+
+  Machines = 0;
+  Ordered  = 0;
+  Failures = 0;
+  for (Devices = 1; ; Devices = MIN (Devices * 4, MaxDevices)) {
+    for (Seed = 1; Seed <= Seeds; Seed++) {
+      mRandom = Devices * 1000003ULL + Seed;
+      TestBuildMachine (Devices);
+
+      TestCostStart (&ReferenceCost);
+      Status = TestReferenceBootOrder ();
+      TestCostStop (&ReferenceCost);
+      CopyMem (Expected, mBootOrder, mBootOrderCount * sizeof *mBootOrder);
+      ExpectedCount = mBootOrderCount;
+      if (RETURN_ERROR (Status) && Status != RETURN_NOT_FOUND) {
+        fprintf (stderr, "%u devices, seed %llu: bootorder not parsed\n",
+          Devices, (unsigned long long)Seed);
+        Failures++;
+      }
+      if (ExpectedCount > 0) {
+        Ordered++;
+      }
+
+      mBootOrderCount = 0;
+      TestCostStart (&IndexedCost);
+      if (SetBootOrderFromQemu () != Status) {
+        fprintf (stderr, "%u devices, seed %llu: status differs\n", Devices,
+          (unsigned long long)Seed);
+        Failures++;
+      }
+      TestCostStop (&IndexedCost);
+
+      if (mBootOrderCount != ExpectedCount ||
+          CompareMem (mBootOrder, Expected,
+            ExpectedCount * sizeof *Expected) != 0) {
+        fprintf (stderr, "%u devices, seed %llu: BootOrder differs\n",
+          Devices, (unsigned long long)Seed);
+        Failures++;
+      }
+      Machines++;
+      OptionCount = mOptionCount;
+      TestFreeMachine ();
+    }
+    if (Devices == MaxDevices) {
+      break;
+    }
+  }
+
+  printf ("%llu machines of 1 to %u boot devices, %llu with a BootOrder, "
+    "%llu failures\n", (unsigned long long)Machines, MaxDevices,
+    (unsigned long long)Ordered, (unsigned long long)Failures);
+  printf ("last machine: %llu boot options, %llu in BootOrder\n",
+    (unsigned long long)OptionCount, (unsigned long long)ExpectedCount);
+  printf ("%-10s %10s %12s %12s\n", "matching", "ms", "conversions",
+    "expansions");
+  TestReportCost ("reference", &ReferenceCost);
+  TestReportCost ("indexed", &IndexedCost);
+
+  return (Failures > 0) ? 1 : 0;
+}
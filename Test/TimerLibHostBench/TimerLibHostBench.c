@@ -0,0 +1,298 @@
+/** @file
+  Host benchmark of the TSC Timer Library instance against the ACPI one.
+
+  Usage: TimerLibHostBench [-n OPS] [-x NSEC]
+
+  The real AcpiTimerLib.c and TscTimerLib.c are compiled side by side, with
+  their public functions renamed to Acpi* and Tsc* by the GNUmakefile. Both
+  delay on the real AcpiTimerDelay.c. InternalAcpiGetTimerTick(), which the
+  "Dxe" instance implements with an IoRead32() of the PM timer port, is
+  provided here: it derives a 3.579545 MHz, 24-bit count from the host's
+  monotonic clock and counts each call as one port read, that is, one VM
+  exit in a guest. -x spins NSEC nanoseconds in every read, to model the
+  cost of the exit.
+
+  The TSC instance is set up as its constructors do it: the frequency comes
+  from CPUID if the host reports it, and is measured against the simulated
+  PM timer otherwise. The benchmark fails if the TSC is invariant and the
+  two frequencies differ by more than 1%.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <IndustryStandard/Acpi.h>
+#include <Library/BaseMemoryLib.h>
+
+#include "HostLib.h"
+#include "AcpiTimerLib.h"
+#include "TscTimerLib.h"
+
+//
+// The ACPI Time is a 24-bit counter
+//
+#define ACPI_TIMER_COUNT_SIZE  BIT24
+
+//
+// GetPerformanceCounter() calls per OPS.
+//
+#define BENCH_COUNTER_CALLS  1000
+
+typedef struct {
+  CONST CHAR8 *Name;
+  UINTN       (EFIAPI *MicroSecondDelay) (UINTN MicroSeconds);
+  UINT64      (EFIAPI *GetPerformanceCounter) (VOID);
+} BENCH_TIMER_LIB;
+
+typedef struct {
+  UINT64 Calls;
+  UINT64 TotalNs;
+  UINT64 MinNs;
+  UINT64 PortReads;
+} BENCH_RESULT;
+
+UINTN
+EFIAPI
+AcpiMicroSecondDelay (
+  IN UINTN MicroSeconds
+  );
+
+UINT64
+EFIAPI
+AcpiGetPerformanceCounter (
+  VOID
+  );
+
+UINTN
+EFIAPI
+TscMicroSecondDelay (
+  IN UINTN MicroSeconds
+  );
+
+UINT64
+EFIAPI
+TscGetPerformanceCounter (
+  VOID
+  );
+
+STATIC CONST BENCH_TIMER_LIB mTimerLibs[] = {
+  { "acpi", AcpiMicroSecondDelay, AcpiGetPerformanceCounter },
+  { "tsc",  TscMicroSecondDelay,  TscGetPerformanceCounter  },
+};
+
+STATIC CONST UINTN mDelays[] = { 1, 10, 100 };
+
+STATIC UINT64 mPmTimerEpoch;
+STATIC UINT64 mPmTimerReads;
+STATIC UINT64 mExitCostNs;
+
+/**
+  The stand-in for DxeAcpiTimerLib.c: starts the simulated PM timer.
+
+  @retval RETURN_SUCCESS  Always.
+**/
+RETURN_STATUS
+EFIAPI
+AcpiTimerLibConstructor (
+  VOID
+  )
+{
+  mPmTimerEpoch = HostNowNs ();
+  return RETURN_SUCCESS;
+}
+
+/**
+  Read the simulated PM timer. Each call is one port read.
+
+  @return The 24-bit tick count.
+**/
+UINT32
+InternalAcpiGetTimerTick (
+  VOID
+  )
+{
+  UINT64 Now;
+
+  mPmTimerReads++;
+  Now = HostNowNs ();
+  if (mExitCostNs != 0) {
+    while (HostNowNs () - Now < mExitCostNs) {
+    }
+  }
+
+  Now -= mPmTimerEpoch;
+  return (UINT32)((Now / 1000000000 * ACPI_TIMER_FREQUENCY +
+                   Now % 1000000000 * ACPI_TIMER_FREQUENCY / 1000000000) &
+                  (ACPI_TIMER_COUNT_SIZE - 1));
+}
+
+STATIC
+VOID
+BenchRecord (
+  IN OUT BENCH_RESULT *Result,
+  IN     UINT64       ElapsedNs
+  )
+{
+  Result->Calls++;
+  Result->TotalNs += ElapsedNs;
+  if (Result->Calls == 1 || ElapsedNs < Result->MinNs) {
+    Result->MinNs = ElapsedNs;
+  }
+}
+
+STATIC
+VOID
+BenchCounter (
+  IN  CONST BENCH_TIMER_LIB *TimerLib,
+  IN  UINTN                 Ops,
+  OUT BENCH_RESULT          *Result
+  )
+{
+  UINTN  Index;
+  UINTN  Call;
+  UINT64 Start;
+  UINT64 Reads;
+
+  ZeroMem (Result, sizeof *Result);
+  Reads = mPmTimerReads;
+  for (Index = 0; Index < Ops; Index++) {
+    Start = HostNowNs ();
+    for (Call = 0; Call < BENCH_COUNTER_CALLS; Call++) {
+      TimerLib->GetPerformanceCounter ();
+    }
+    BenchRecord (Result, HostNowNs () - Start);
+  }
+  Result->Calls    *= BENCH_COUNTER_CALLS;
+  Result->MinNs    /= BENCH_COUNTER_CALLS;
+  Result->PortReads = mPmTimerReads - Reads;
+}
+
+STATIC
+VOID
+BenchDelay (
+  IN  CONST BENCH_TIMER_LIB *TimerLib,
+  IN  UINTN                 MicroSeconds,
+  IN  UINTN                 Ops,
+  OUT BENCH_RESULT          *Result
+  )
+{
+  UINTN  Index;
+  UINT64 Start;
+  UINT64 Reads;
+
+  ZeroMem (Result, sizeof *Result);
+  Reads = mPmTimerReads;
+  for (Index = 0; Index < Ops; Index++) {
+    Start = HostNowNs ();
+    TimerLib->MicroSecondDelay (MicroSeconds);
+    BenchRecord (Result, HostNowNs () - Start);
+  }
+  Result->PortReads = mPmTimerReads - Reads;
+}
+
+STATIC
+VOID
+BenchReport (
+  IN CONST BENCH_TIMER_LIB *TimerLib,
+  IN CONST CHAR8           *Call,
+  IN CONST BENCH_RESULT    *Result
+  )
+{
+  printf ("%-5s %-24s %10.1f %10.1f %10.2f\n",
+    TimerLib->Name,
+    Call,
+    (double)Result->TotalNs / Result->Calls,
+    (double)Result->MinNs,
+    (double)Result->PortReads / Result->Calls);
+}
+
+STATIC
+VOID
+BenchUsage (
+  IN CONST CHAR8 *Program
+  )
+{
+  fprintf (stderr,
+    "Usage: %s [-n OPS] [-x NSEC]\n"
+    "\n"
+    "  -n  MicroSecondDelay() calls per delay, and thousands of\n"
+    "      GetPerformanceCounter() calls (default 1000)\n"
+    "  -x  cost of a PM timer port read in nanoseconds (default 0)\n",
+    Program);
+}
+
+int
+main (
+  int  argc,
+  char **argv
+  )
+{
+  UINTN        Ops;
+  int          Opt;
+  UINT64       CpuidFrequency;
+  UINT64       CalibratedFrequency;
+  int          ExitStatus;
+  UINTN        Lib;
+  UINTN        Delay;
+  CHAR8        Call[32];
+  BENCH_RESULT Result;
+
+  Ops = 1000;
+  while ((Opt = getopt (argc, argv, "n:x:h")) != -1) {
+    switch (Opt) {
+      case 'n':
+        Ops = strtoul (optarg, NULL, 0);
+        break;
+      case 'x':
+        mExitCostNs = strtoull (optarg, NULL, 0);
+        break;
+      default:
+        BenchUsage (argv[0]);
+        return 2;
+    }
+  }
+  if (Ops == 0 || optind != argc) {
+    BenchUsage (argv[0]);
+    return 2;
+  }
+
+  ExitStatus = 0;
+  AcpiTimerLibConstructor ();
+  if (InternalTscIsInvariant ()) {
+    CpuidFrequency      = InternalTscGetCpuidFrequency ();
+    CalibratedFrequency = InternalTscCalibrate ();
+    printf ("TSC: %llu Hz from CPUID, %llu Hz calibrated\n",
+      (unsigned long long)CpuidFrequency,
+      (unsigned long long)CalibratedFrequency);
+    if (CpuidFrequency != 0 &&
+        (CalibratedFrequency < CpuidFrequency - CpuidFrequency / 100 ||
+         CalibratedFrequency > CpuidFrequency + CpuidFrequency / 100)) {
+      fprintf (stderr, "the calibrated TSC frequency is off by more than 1%%\n");
+      ExitStatus = 1;
+    }
+    mTscTimerFrequency = (CpuidFrequency != 0) ?
+                         CpuidFrequency : CalibratedFrequency;
+  } else {
+    printf ("TSC: not invariant, the TSC instance counts PM timer ticks\n");
+  }
+
+  printf ("%-5s %-24s %10s %10s %10s\n",
+    "lib", "call", "mean ns", "min ns", "reads");
+  for (Lib = 0; Lib < ARRAY_SIZE (mTimerLibs); Lib++) {
+    BenchCounter (&mTimerLibs[Lib], Ops, &Result);
+    BenchReport (&mTimerLibs[Lib], "GetPerformanceCounter()", &Result);
+    for (Delay = 0; Delay < ARRAY_SIZE (mDelays); Delay++) {
+      BenchDelay (&mTimerLibs[Lib], mDelays[Delay], Ops, &Result);
+      snprintf (Call, sizeof Call, "MicroSecondDelay(%llu)",
+        (unsigned long long)mDelays[Delay]);
+      BenchReport (&mTimerLibs[Lib], Call, &Result);
+    }
+  }
+
+  return ExitStatus;
+}
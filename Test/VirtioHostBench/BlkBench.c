@@ -0,0 +1,207 @@
+/** @file
+  virtio-blk benchmarks: VirtioBlkReadBlocks() / VirtioBlkWriteBlocks(), that
+  is, SynchronousRequest(), against a fake disk.
+
+  VirtioBlk.c is included rather than linked, so that its static functions
+  (VirtioBlkInit(), VirtioBlkUninit()) are reachable without the driver
+  binding protocol.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "../../VirtioBlkDxe/VirtioBlk.c"
+
+#include "HostLib.h"
+#include "VirtioHostBench.h"
+
+#define BLK_BENCH_CAPACITY  (64 * SIZE_1MB)
+#define BLK_BENCH_IO_SIZE   SIZE_4KB
+
+//
+// The fake disk holds the test pattern: reads return it, and writes are
+// expected to carry it.
+//
+typedef struct {
+  UINT64 Errors;
+} BLK_BENCH_DISK;
+
+STATIC
+UINT32
+BlkBenchHandleRequest (
+  IN VOID                    *Context,
+  IN UINT16                  QueueIdx,
+  IN CONST FAKE_VIRTIO_CHAIN *Chain
+  )
+{
+  BLK_BENCH_DISK           *Disk;
+  CONST VIRTIO_BLK_REQ     *Request;
+  CONST FAKE_VIRTIO_BUFFER *Data;
+  UINT64                   Offset;
+  UINT8                    HostStatus;
+  UINT32                   Written;
+
+  Disk = Context;
+
+  //
+  // SynchronousRequest() sends header, data and status descriptors.
+  //
+  if (Chain->NumBuffers != 3 ||
+      Chain->Buffers[0].DeviceWritable ||
+      Chain->Buffers[0].Len != sizeof *Request ||
+      !Chain->Buffers[2].DeviceWritable ||
+      Chain->Buffers[2].Len != 1) {
+    __atomic_add_fetch (&Disk->Errors, 1, __ATOMIC_RELAXED);
+    return 0;
+  }
+
+  Request    = Chain->Buffers[0].Buffer;
+  Data       = &Chain->Buffers[1];
+  Offset     = Request->Sector * 512;
+  HostStatus = VIRTIO_BLK_S_IOERR;
+  Written    = 0;
+
+  if (Offset + Data->Len > BLK_BENCH_CAPACITY) {
+    __atomic_add_fetch (&Disk->Errors, 1, __ATOMIC_RELAXED);
+  } else if (Request->Type == VIRTIO_BLK_T_IN && Data->DeviceWritable) {
+    BenchFillPattern (Data->Buffer, Data->Len, Offset);
+    Written    = Data->Len;
+    HostStatus = VIRTIO_BLK_S_OK;
+  } else if (Request->Type == VIRTIO_BLK_T_OUT && !Data->DeviceWritable) {
+    if (BenchCheckPattern (Data->Buffer, Data->Len, Offset)) {
+      HostStatus = VIRTIO_BLK_S_OK;
+    } else {
+      __atomic_add_fetch (&Disk->Errors, 1, __ATOMIC_RELAXED);
+    }
+  } else {
+    HostStatus = VIRTIO_BLK_S_UNSUPP;
+    __atomic_add_fetch (&Disk->Errors, 1, __ATOMIC_RELAXED);
+  }
+
+  *(UINT8 *)Chain->Buffers[2].Buffer = HostStatus;
+  return Written + 1;
+}
+
+STATIC
+EFI_STATUS
+BlkBenchRun (
+  IN  CONST BENCH_OPTIONS *Options,
+  IN  BOOLEAN             IsWrite,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  BLK_BENCH_DISK            Disk;
+  VIRTIO_BLK_CONFIG         BlkConfig;
+  FAKE_VIRTIO_DEVICE_CONFIG Config;
+  FAKE_VIRTIO_DEVICE        *Device;
+  VBLK_DEV                  Dev;
+  UINT32                    IoSize;
+  UINT64                    NumSlots;
+  VOID                      *Buffer;
+  UINT64                    Op;
+  EFI_LBA                   Lba;
+  UINT64                    Start;
+  UINT64                    Polls;
+  UINT64                    Notifications;
+  EFI_STATUS                Status;
+
+  IoSize = (Options->IoSize == 0) ? BLK_BENCH_IO_SIZE : Options->IoSize;
+  if (IoSize % 512 != 0 || IoSize > BLK_BENCH_CAPACITY) {
+    return EFI_INVALID_PARAMETER;
+  }
+  NumSlots = BLK_BENCH_CAPACITY / IoSize;
+
+  ZeroMem (&Disk, sizeof Disk);
+  ZeroMem (&BlkConfig, sizeof BlkConfig);
+  BlkConfig.Capacity = BLK_BENCH_CAPACITY / 512;
+
+  ZeroMem (&Config, sizeof Config);
+  Config.Revision          = Options->Legacy ?
+                             VIRTIO_SPEC_REVISION (0, 9, 5) :
+                             VIRTIO_SPEC_REVISION (1, 0, 0);
+  Config.SubSystemDeviceId = VIRTIO_SUBSYSTEM_BLOCK_DEVICE;
+  Config.Features          = Options->Legacy ? 0 : VIRTIO_F_VERSION_1;
+  Config.Config            = &BlkConfig;
+  Config.ConfigSize        = sizeof BlkConfig;
+  Config.NumQueues         = 1;
+  Config.QueueNumMax       = Options->QueueSize;
+  Config.LatencyNs         = Options->LatencyNs;
+  Config.Polling           = Options->Polling;
+  Config.Handler           = BlkBenchHandleRequest;
+  Config.Context           = &Disk;
+
+  Status = FakeVirtioDeviceCreate (&Config, &Device);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&Dev, sizeof Dev);
+  Dev.Signature = VBLK_SIG;
+  Dev.VirtIo    = FakeVirtioDeviceProtocol (Device);
+  Status = VirtioBlkInit (&Dev);
+  if (EFI_ERROR (Status)) {
+    goto DestroyDevice;
+  }
+
+  Buffer = AllocatePool (IoSize);
+  if (Buffer == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto UninitDev;
+  }
+
+  Notifications = BenchNotifications (Device, 1);
+  Polls         = gHostStallCalls;
+  Start         = HostNowNs ();
+  for (Op = 0; Op < Options->Ops; Op++) {
+    Lba = (Op % NumSlots) * (IoSize / 512);
+    if (IsWrite) {
+      BenchFillPattern (Buffer, IoSize, Lba * 512);
+      Result->LatencyNs[Op] = HostNowNs ();
+      Status = VirtioBlkWriteBlocks (&Dev.BlockIo, 0, Lba, IoSize, Buffer);
+    } else {
+      Result->LatencyNs[Op] = HostNowNs ();
+      Status = VirtioBlkReadBlocks (&Dev.BlockIo, 0, Lba, IoSize, Buffer);
+    }
+    Result->LatencyNs[Op] = HostNowNs () - Result->LatencyNs[Op];
+
+    if (EFI_ERROR (Status) ||
+        (!IsWrite && !BenchCheckPattern (Buffer, IoSize, Lba * 512))) {
+      Result->Errors++;
+    }
+  }
+  Result->ElapsedNs     = HostNowNs () - Start;
+  Result->Ops           = Options->Ops;
+  Result->Bytes         = Options->Ops * IoSize;
+  Result->Notifications = BenchNotifications (Device, 1) - Notifications;
+  Result->Polls         = gHostStallCalls - Polls;
+  Status                = EFI_SUCCESS;
+
+  FreePool (Buffer);
+
+UninitDev:
+  VirtioBlkUninit (&Dev);
+
+DestroyDevice:
+  Result->Errors += Disk.Errors + FakeVirtioDeviceLiveMappings (Device);
+  FakeVirtioDeviceDestroy (Device);
+  return Status;
+}
+
+EFI_STATUS
+BlkBenchRead (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  return BlkBenchRun (Options, FALSE, Result);
+}
+
+EFI_STATUS
+BlkBenchWrite (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  return BlkBenchRun (Options, TRUE, Result);
+}
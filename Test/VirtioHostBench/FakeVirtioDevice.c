@@ -0,0 +1,721 @@
+/** @file
+  A host-side VIRTIO_DEVICE_PROTOCOL whose device half runs in threads.
+
+  Chains that the device finds on the available ring in one pass are taken to
+  have arrived together; each of them completes LatencyNs after that, in ring
+  order. The device therefore overlaps the latency of everything the driver
+  keeps in flight, and a driver that submits one request at a time pays the
+  full latency per request.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <IndustryStandard/Virtio.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "FakeVirtioDevice.h"
+#include "HostLib.h"
+
+typedef struct {
+  FAKE_VIRTIO_DEVICE *Device;
+  UINT16             Index;
+  BOOLEAN            Gated;
+  pthread_t          Thread;
+  pthread_cond_t     Wake;
+  //
+  // The fields below are protected by FAKE_VIRTIO_DEVICE.Lock, except that the
+  // device thread owns LastAvail and UsedIdx while Busy is set, and that
+  // Completions is updated atomically.
+  //
+  VRING              *Ring;
+  UINT16             LastAvail;
+  UINT16             UsedIdx;
+  BOOLEAN            Kicked;
+  BOOLEAN            Busy;
+  UINT64             Credits;
+  UINT64             Notifications;
+  UINT64             Completions;
+} FAKE_VIRTQUEUE;
+
+struct FAKE_VIRTIO_DEVICE {
+  VIRTIO_DEVICE_PROTOCOL    VirtIo;
+  FAKE_VIRTIO_DEVICE_CONFIG Config;
+  UINT8                     *ConfigSpace;
+  UINT64                    GuestFeatures;
+  UINT8                     Status;
+  UINT16                    QueueSel;
+  BOOLEAN                   Stopping;
+  UINTN                     LiveMappings;
+  pthread_mutex_t           Lock;
+  pthread_cond_t            Idle;
+  FAKE_VIRTQUEUE            Queues[FAKE_VIRTIO_MAX_QUEUES];
+};
+
+#define FAKE_VIRTIO_FROM_VIRTIO(VirtIoPointer) \
+          BASE_CR (VirtIoPointer, FAKE_VIRTIO_DEVICE, VirtIo)
+
+STATIC
+VOID
+FakeVirtioDeviceFatal (
+  IN CONST FAKE_VIRTQUEUE *Queue,
+  IN CONST CHAR8          *Message
+  )
+{
+  fprintf (stderr, "FakeVirtioDevice: queue %u: %s\n", Queue->Index, Message);
+  abort ();
+}
+
+/**
+  Collect the descriptor chain that starts at HeadDescIdx.
+**/
+STATIC
+VOID
+FakeVirtioDeviceWalkChain (
+  IN  CONST FAKE_VIRTQUEUE *Queue,
+  IN  UINT16               HeadDescIdx,
+  OUT FAKE_VIRTIO_CHAIN    *Chain
+  )
+{
+  VRING               *Ring;
+  UINT16              DescIdx;
+  volatile VRING_DESC *Desc;
+
+  Ring = Queue->Ring;
+  Chain->HeadDescIdx = HeadDescIdx;
+  Chain->NumBuffers  = 0;
+
+  DescIdx = HeadDescIdx;
+  for (;;) {
+    if (DescIdx >= Ring->QueueSize) {
+      FakeVirtioDeviceFatal (Queue, "descriptor index out of range");
+    }
+    if (Chain->NumBuffers == FAKE_VIRTIO_MAX_CHAIN) {
+      FakeVirtioDeviceFatal (Queue, "descriptor chain too long");
+    }
+    Desc = &Ring->Desc[DescIdx];
+    if ((Desc->Flags & VRING_DESC_F_INDIRECT) != 0) {
+      FakeVirtioDeviceFatal (Queue, "indirect descriptor not negotiated");
+    }
+    if (Desc->Addr == 0 || Desc->Len == 0) {
+      FakeVirtioDeviceFatal (Queue, "empty descriptor");
+    }
+    Chain->Buffers[Chain->NumBuffers].Buffer         = (VOID *)(UINTN)Desc->Addr;
+    Chain->Buffers[Chain->NumBuffers].Len            = Desc->Len;
+    Chain->Buffers[Chain->NumBuffers].DeviceWritable =
+      (BOOLEAN)((Desc->Flags & VRING_DESC_F_WRITE) != 0);
+    Chain->NumBuffers++;
+
+    if ((Desc->Flags & VRING_DESC_F_NEXT) == 0) {
+      break;
+    }
+    DescIdx = Desc->Next;
+  }
+}
+
+/**
+  Complete the chains that are on the available ring, and the ones that show
+  up meanwhile. Called with the device lock released.
+
+  @return  The number of chains completed.
+**/
+STATIC
+UINT64
+FakeVirtioDeviceDrain (
+  IN FAKE_VIRTQUEUE *Queue
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+  VRING              *Ring;
+  UINT16             AvailIdx;
+  UINT64             Arrival;
+  UINT64             Completed;
+  UINT16             HeadDescIdx;
+  FAKE_VIRTIO_CHAIN  Chain;
+  UINT32             Len;
+
+  Device    = Queue->Device;
+  Ring      = Queue->Ring;
+  Completed = 0;
+
+  for (;;) {
+    AvailIdx = *Ring->Avail.Idx;
+    Arrival  = HostNowNs ();
+    MemoryFence ();
+    if (Queue->LastAvail == AvailIdx) {
+      break;
+    }
+    if ((UINT16)(AvailIdx - Queue->LastAvail) > Ring->QueueSize) {
+      FakeVirtioDeviceFatal (Queue, "available index ran ahead of the ring");
+    }
+
+    while (Queue->LastAvail != AvailIdx) {
+      if (Queue->Gated) {
+        pthread_mutex_lock (&Device->Lock);
+        if (Queue->Credits == 0) {
+          pthread_mutex_unlock (&Device->Lock);
+          return Completed;
+        }
+        Queue->Credits--;
+        pthread_mutex_unlock (&Device->Lock);
+      }
+
+      HeadDescIdx = Ring->Avail.Ring[Queue->LastAvail % Ring->QueueSize];
+      FakeVirtioDeviceWalkChain (Queue, HeadDescIdx, &Chain);
+
+      HostDelayUntil (Arrival + Device->Config.LatencyNs);
+      Len = Device->Config.Handler (Device->Config.Context, Queue->Index, &Chain);
+
+      Ring->Used.UsedElem[Queue->UsedIdx % Ring->QueueSize].Id  = HeadDescIdx;
+      Ring->Used.UsedElem[Queue->UsedIdx % Ring->QueueSize].Len = Len;
+      MemoryFence ();
+      Queue->UsedIdx++;
+      *Ring->Used.Idx = Queue->UsedIdx;
+      MemoryFence ();
+
+      Queue->LastAvail++;
+      __atomic_add_fetch (&Queue->Completions, 1, __ATOMIC_RELAXED);
+      Completed++;
+    }
+  }
+  return Completed;
+}
+
+STATIC
+VOID *
+FakeVirtioDeviceQueueThread (
+  IN VOID *Context
+  )
+{
+  FAKE_VIRTQUEUE     *Queue;
+  FAKE_VIRTIO_DEVICE *Device;
+  BOOLEAN            Polling;
+  UINT64             Completed;
+
+  Queue   = Context;
+  Device  = Queue->Device;
+  Polling = Device->Config.Polling;
+
+  pthread_mutex_lock (&Device->Lock);
+  for (;;) {
+    while (!Device->Stopping &&
+           (Queue->Ring == NULL ||
+            (Device->Status & VSTAT_DRIVER_OK) == 0 ||
+            !(Polling || Queue->Kicked))) {
+      pthread_cond_wait (&Queue->Wake, &Device->Lock);
+    }
+    if (Device->Stopping) {
+      break;
+    }
+    Queue->Kicked = FALSE;
+    Queue->Busy   = TRUE;
+    pthread_mutex_unlock (&Device->Lock);
+
+    Completed = FakeVirtioDeviceDrain (Queue);
+
+    pthread_mutex_lock (&Device->Lock);
+    Queue->Busy = FALSE;
+    pthread_cond_broadcast (&Device->Idle);
+    if (Polling && Completed == 0) {
+      pthread_mutex_unlock (&Device->Lock);
+      sched_yield ();
+      pthread_mutex_lock (&Device->Lock);
+    }
+  }
+  pthread_mutex_unlock (&Device->Lock);
+  return NULL;
+}
+
+STATIC
+VOID
+FakeVirtioDeviceWakeAll (
+  IN FAKE_VIRTIO_DEVICE *Device
+  )
+{
+  UINT16 Index;
+
+  for (Index = 0; Index < Device->Config.NumQueues; Index++) {
+    pthread_cond_signal (&Device->Queues[Index].Wake);
+  }
+}
+
+//
+// VIRTIO_DEVICE_PROTOCOL member functions.
+//
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioGetDeviceFeatures (
+  IN  VIRTIO_DEVICE_PROTOCOL *This,
+  OUT UINT64                 *DeviceFeatures
+  )
+{
+  *DeviceFeatures = FAKE_VIRTIO_FROM_VIRTIO (This)->Config.Features;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetGuestFeatures (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINT64                 Features
+  )
+{
+  FAKE_VIRTIO_FROM_VIRTIO (This)->GuestFeatures = Features;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetQueueAddress (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN VRING                  *Ring,
+  IN UINT64                 RingBaseShift
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+  FAKE_VIRTQUEUE     *Queue;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  if (Device->QueueSel >= Device->Config.NumQueues || RingBaseShift != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Queue = &Device->Queues[Device->QueueSel];
+  pthread_mutex_lock (&Device->Lock);
+  Queue->Ring      = Ring;
+  Queue->LastAvail = 0;
+  Queue->UsedIdx   = 0;
+  Queue->Kicked    = FALSE;
+  if (Device->Config.Polling) {
+    *Ring->Used.Flags = VRING_USED_F_NO_NOTIFY;
+  }
+  pthread_mutex_unlock (&Device->Lock);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetQueueSel (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINT16                 Index
+  )
+{
+  FAKE_VIRTIO_FROM_VIRTIO (This)->QueueSel = Index;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetQueueNotify (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINT16                 Index
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+  FAKE_VIRTQUEUE     *Queue;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  if (Index >= Device->Config.NumQueues) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Queue = &Device->Queues[Index];
+  pthread_mutex_lock (&Device->Lock);
+  Queue->Notifications++;
+  Queue->Kicked = TRUE;
+  pthread_cond_signal (&Queue->Wake);
+  pthread_mutex_unlock (&Device->Lock);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetQueueAlign (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINT32                 Alignment
+  )
+{
+  return (Alignment == EFI_PAGE_SIZE) ? EFI_SUCCESS : EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetPageSize (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINT32                 PageSize
+  )
+{
+  return (PageSize == EFI_PAGE_SIZE) ? EFI_SUCCESS : EFI_UNSUPPORTED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioGetQueueNumMax (
+  IN  VIRTIO_DEVICE_PROTOCOL *This,
+  OUT UINT16                 *QueueNumMax
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  *QueueNumMax = (Device->QueueSel < Device->Config.NumQueues) ?
+                 Device->Config.QueueNumMax : 0;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetQueueNum (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINT16                 QueueSize
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  if (QueueSize == 0 || QueueSize > Device->Config.QueueNumMax) {
+    return EFI_UNSUPPORTED;
+  }
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioGetDeviceStatus (
+  IN  VIRTIO_DEVICE_PROTOCOL *This,
+  OUT UINT8                  *DeviceStatus
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  pthread_mutex_lock (&Device->Lock);
+  *DeviceStatus = Device->Status;
+  pthread_mutex_unlock (&Device->Lock);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioSetDeviceStatus (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINT8                  DeviceStatus
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+  FAKE_VIRTQUEUE     *Queue;
+  UINT16             Index;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  pthread_mutex_lock (&Device->Lock);
+
+  if (DeviceStatus == 0) {
+    //
+    // Reset: let the queue threads finish what they hold, then forget the
+    // rings, which the driver is about to release.
+    //
+    Device->Status        = 0;
+    Device->GuestFeatures = 0;
+    for (Index = 0; Index < Device->Config.NumQueues; Index++) {
+      Queue = &Device->Queues[Index];
+      while (Queue->Busy) {
+        pthread_cond_wait (&Device->Idle, &Device->Lock);
+      }
+      Queue->Ring    = NULL;
+      Queue->Kicked  = FALSE;
+      Queue->Credits = 0;
+    }
+    pthread_mutex_unlock (&Device->Lock);
+    return EFI_SUCCESS;
+  }
+
+  if ((DeviceStatus & VSTAT_FEATURES_OK) != 0 &&
+      (Device->GuestFeatures & ~Device->Config.Features) != 0) {
+    DeviceStatus &= (UINT8)~VSTAT_FEATURES_OK;
+  }
+  Device->Status = DeviceStatus;
+  if ((DeviceStatus & VSTAT_DRIVER_OK) != 0) {
+    FakeVirtioDeviceWakeAll (Device);
+  }
+  pthread_mutex_unlock (&Device->Lock);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioWriteDevice (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINTN                  FieldOffset,
+  IN UINTN                  FieldSize,
+  IN UINT64                 Value
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  if (FieldSize > sizeof Value ||
+      FieldOffset + FieldSize > Device->Config.ConfigSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+  CopyMem (Device->ConfigSpace + FieldOffset, &Value, FieldSize);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioReadDevice (
+  IN  VIRTIO_DEVICE_PROTOCOL *This,
+  IN  UINTN                  FieldOffset,
+  IN  UINTN                  FieldSize,
+  IN  UINTN                  BufferSize,
+  OUT VOID                   *Buffer
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  if (BufferSize < FieldSize ||
+      FieldOffset + BufferSize > Device->Config.ConfigSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+  CopyMem (Buffer, Device->ConfigSpace + FieldOffset, BufferSize);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioAllocateSharedPages (
+  IN  VIRTIO_DEVICE_PROTOCOL *This,
+  IN  UINTN                  Pages,
+  OUT VOID                   **HostAddress
+  )
+{
+  *HostAddress = AllocatePages (Pages);
+  return (*HostAddress == NULL) ? EFI_OUT_OF_RESOURCES : EFI_SUCCESS;
+}
+
+STATIC
+VOID
+EFIAPI
+FakeVirtioFreeSharedPages (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN UINTN                  Pages,
+  IN VOID                   *HostAddress
+  )
+{
+  FreePages (HostAddress, Pages);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioMapSharedBuffer (
+  IN     VIRTIO_DEVICE_PROTOCOL *This,
+  IN     VIRTIO_MAP_OPERATION   Operation,
+  IN     VOID                   *HostAddress,
+  IN OUT UINTN                  *NumberOfBytes,
+  OUT    EFI_PHYSICAL_ADDRESS   *DeviceAddress,
+  OUT    VOID                   **Mapping
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  __atomic_add_fetch (&Device->LiveMappings, 1, __ATOMIC_RELAXED);
+  *DeviceAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)HostAddress;
+  *Mapping       = HostAddress;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeVirtioUnmapSharedBuffer (
+  IN VIRTIO_DEVICE_PROTOCOL *This,
+  IN VOID                   *Mapping
+  )
+{
+  FAKE_VIRTIO_DEVICE *Device;
+
+  Device = FAKE_VIRTIO_FROM_VIRTIO (This);
+  __atomic_sub_fetch (&Device->LiveMappings, 1, __ATOMIC_RELAXED);
+  return EFI_SUCCESS;
+}
+
+STATIC CONST VIRTIO_DEVICE_PROTOCOL mFakeVirtioTemplate = {
+  0,                              // Revision
+  0,                              // SubSystemDeviceId
+  FakeVirtioGetDeviceFeatures,    // GetDeviceFeatures
+  FakeVirtioSetGuestFeatures,     // SetGuestFeatures
+  FakeVirtioSetQueueAddress,      // SetQueueAddress
+  FakeVirtioSetQueueSel,          // SetQueueSel
+  FakeVirtioSetQueueNotify,       // SetQueueNotify
+  FakeVirtioSetQueueAlign,        // SetQueueAlign
+  FakeVirtioSetPageSize,          // SetPageSize
+  FakeVirtioGetQueueNumMax,       // GetQueueNumMax
+  FakeVirtioSetQueueNum,          // SetQueueNum
+  FakeVirtioGetDeviceStatus,      // GetDeviceStatus
+  FakeVirtioSetDeviceStatus,      // SetDeviceStatus
+  FakeVirtioWriteDevice,          // WriteDevice
+  FakeVirtioReadDevice,           // ReadDevice
+  FakeVirtioAllocateSharedPages,  // AllocateSharedPages
+  FakeVirtioFreeSharedPages,      // FreeSharedPages
+  FakeVirtioMapSharedBuffer,      // MapSharedBuffer
+  FakeVirtioUnmapSharedBuffer     // UnmapSharedBuffer
+};
+
+//
+// Public functions.
+//
+
+EFI_STATUS
+FakeVirtioDeviceCreate (
+  IN  CONST FAKE_VIRTIO_DEVICE_CONFIG *Config,
+  OUT FAKE_VIRTIO_DEVICE              **Device
+  )
+{
+  FAKE_VIRTIO_DEVICE *NewDevice;
+  FAKE_VIRTQUEUE     *Queue;
+  UINT16             Index;
+
+  if (Config->NumQueues == 0 || Config->NumQueues > FAKE_VIRTIO_MAX_QUEUES ||
+      Config->Handler == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  NewDevice = AllocateZeroPool (sizeof *NewDevice);
+  if (NewDevice == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  NewDevice->ConfigSpace = AllocateCopyPool (Config->ConfigSize, Config->Config);
+  if (NewDevice->ConfigSpace == NULL) {
+    FreePool (NewDevice);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (&NewDevice->VirtIo, &mFakeVirtioTemplate, sizeof NewDevice->VirtIo);
+  NewDevice->VirtIo.Revision          = Config->Revision;
+  NewDevice->VirtIo.SubSystemDeviceId = Config->SubSystemDeviceId;
+  CopyMem (&NewDevice->Config, Config, sizeof NewDevice->Config);
+  pthread_mutex_init (&NewDevice->Lock, NULL);
+  pthread_cond_init (&NewDevice->Idle, NULL);
+
+  for (Index = 0; Index < Config->NumQueues; Index++) {
+    Queue = &NewDevice->Queues[Index];
+    Queue->Device = NewDevice;
+    Queue->Index  = Index;
+    Queue->Gated  = (BOOLEAN)((Config->GatedQueues & (1u << Index)) != 0);
+    pthread_cond_init (&Queue->Wake, NULL);
+    if (pthread_create (&Queue->Thread, NULL, FakeVirtioDeviceQueueThread,
+          Queue) != 0) {
+      //
+      // Let FakeVirtioDeviceDestroy() reap the threads started so far.
+      //
+      pthread_cond_destroy (&Queue->Wake);
+      NewDevice->Config.NumQueues = Index;
+      FakeVirtioDeviceDestroy (NewDevice);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  *Device = NewDevice;
+  return EFI_SUCCESS;
+}
+
+VOID
+FakeVirtioDeviceDestroy (
+  IN FAKE_VIRTIO_DEVICE *Device
+  )
+{
+  UINT16 Index;
+
+  pthread_mutex_lock (&Device->Lock);
+  Device->Stopping = TRUE;
+  FakeVirtioDeviceWakeAll (Device);
+  pthread_mutex_unlock (&Device->Lock);
+
+  for (Index = 0; Index < Device->Config.NumQueues; Index++) {
+    pthread_join (Device->Queues[Index].Thread, NULL);
+    pthread_cond_destroy (&Device->Queues[Index].Wake);
+  }
+  pthread_cond_destroy (&Device->Idle);
+  pthread_mutex_destroy (&Device->Lock);
+  FreePool (Device->ConfigSpace);
+  FreePool (Device);
+}
+
+VIRTIO_DEVICE_PROTOCOL *
+FakeVirtioDeviceProtocol (
+  IN FAKE_VIRTIO_DEVICE *Device
+  )
+{
+  return &Device->VirtIo;
+}
+
+VOID
+FakeVirtioDeviceInject (
+  IN FAKE_VIRTIO_DEVICE *Device,
+  IN UINT16             QueueIdx,
+  IN UINT64             Count
+  )
+{
+  FAKE_VIRTQUEUE *Queue;
+
+  ASSERT (QueueIdx < Device->Config.NumQueues);
+  Queue = &Device->Queues[QueueIdx];
+  ASSERT (Queue->Gated);
+
+  pthread_mutex_lock (&Device->Lock);
+  Queue->Credits += Count;
+  Queue->Kicked   = TRUE;
+  pthread_cond_signal (&Queue->Wake);
+  pthread_mutex_unlock (&Device->Lock);
+}
+
+VOID
+FakeVirtioDeviceGetStats (
+  IN  FAKE_VIRTIO_DEVICE      *Device,
+  IN  UINT16                  QueueIdx,
+  OUT FAKE_VIRTIO_QUEUE_STATS *Stats
+  )
+{
+  ASSERT (QueueIdx < Device->Config.NumQueues);
+  pthread_mutex_lock (&Device->Lock);
+  Stats->Notifications = Device->Queues[QueueIdx].Notifications;
+  Stats->Completions   = __atomic_load_n (
+                           &Device->Queues[QueueIdx].Completions,
+                           __ATOMIC_RELAXED
+                           );
+  pthread_mutex_unlock (&Device->Lock);
+}
+
+UINTN
+FakeVirtioDeviceLiveMappings (
+  IN FAKE_VIRTIO_DEVICE *Device
+  )
+{
+  return __atomic_load_n (&Device->LiveMappings, __ATOMIC_RELAXED);
+}
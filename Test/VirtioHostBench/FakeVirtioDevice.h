@@ -0,0 +1,175 @@
+/** @file
+  A host-side VIRTIO_DEVICE_PROTOCOL whose device half runs in threads.
+
+  Every virtqueue of the fake device is served by a thread of its own. The
+  thread sleeps until the driver notifies the queue (or keeps polling the
+  available ring, if so configured), then walks each new descriptor chain,
+  waits for the configured completion latency, lets the device model handle
+  the chain, and puts it on the used ring. Shared memory is identity mapped:
+  device addresses are host pointers.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef FAKE_VIRTIO_DEVICE_H_
+#define FAKE_VIRTIO_DEVICE_H_
+
+#include <Protocol/VirtioDevice.h>
+
+#define FAKE_VIRTIO_MAX_QUEUES  8
+#define FAKE_VIRTIO_MAX_CHAIN   64
+
+typedef struct FAKE_VIRTIO_DEVICE FAKE_VIRTIO_DEVICE;
+
+//
+// One buffer of a descriptor chain, as seen by the device.
+//
+typedef struct {
+  VOID    *Buffer;
+  UINT32  Len;
+  BOOLEAN DeviceWritable;
+} FAKE_VIRTIO_BUFFER;
+
+typedef struct {
+  UINT16             HeadDescIdx;
+  UINTN              NumBuffers;
+  FAKE_VIRTIO_BUFFER Buffers[FAKE_VIRTIO_MAX_CHAIN];
+} FAKE_VIRTIO_CHAIN;
+
+/**
+  Device model callback: process one descriptor chain.
+
+  Called from the thread of the queue, after the completion latency has
+  elapsed.
+
+  @param[in] Context   FAKE_VIRTIO_DEVICE_CONFIG.Context.
+  @param[in] QueueIdx  The queue that the chain was made available on.
+  @param[in] Chain     The buffers of the chain, in order.
+
+  @return  The number of bytes written to the device-writable buffers; it is
+           reported in the used ring element.
+**/
+typedef
+UINT32
+(*FAKE_VIRTIO_HANDLER)(
+  IN VOID                    *Context,
+  IN UINT16                  QueueIdx,
+  IN CONST FAKE_VIRTIO_CHAIN *Chain
+  );
+
+typedef struct {
+  //
+  // Identity of the device, as exposed through VIRTIO_DEVICE_PROTOCOL.
+  //
+  UINT32              Revision;
+  INT32               SubSystemDeviceId;
+  UINT64              Features;
+  CONST VOID          *Config;
+  UINTN               ConfigSize;
+  //
+  // Queues 0 .. NumQueues-1 exist, each with QueueNumMax descriptors at most.
+  // A queue whose bit is set in GatedQueues completes a chain only when a
+  // FakeVirtioDeviceInject() credit is available for it; this models
+  // device-initiated traffic, such as packet reception.
+  //
+  UINT16              NumQueues;
+  UINT16              QueueNumMax;
+  UINT32              GatedQueues;
+  //
+  // Time from picking up a chain to completing it.
+  //
+  UINT64              LatencyNs;
+  //
+  // Poll the available rings instead of waiting for notifications. The device
+  // then sets VRING_USED_F_NO_NOTIFY in the used rings.
+  //
+  BOOLEAN             Polling;
+  FAKE_VIRTIO_HANDLER Handler;
+  VOID                *Context;
+} FAKE_VIRTIO_DEVICE_CONFIG;
+
+typedef struct {
+  UINT64 Notifications;
+  UINT64 Completions;
+} FAKE_VIRTIO_QUEUE_STATS;
+
+/**
+  Create a fake virtio device and start the threads of its queues.
+
+  @param[in] Config   The device configuration. Config->Config is copied.
+  @param[out] Device  The new device.
+
+  @retval EFI_SUCCESS            The device has been created.
+  @retval EFI_INVALID_PARAMETER  Config->NumQueues is zero or exceeds
+                                 FAKE_VIRTIO_MAX_QUEUES.
+  @retval EFI_OUT_OF_RESOURCES   Memory or thread allocation failed.
+**/
+EFI_STATUS
+FakeVirtioDeviceCreate (
+  IN  CONST FAKE_VIRTIO_DEVICE_CONFIG *Config,
+  OUT FAKE_VIRTIO_DEVICE              **Device
+  );
+
+/**
+  Stop the queue threads and free the device.
+
+  @param[in] Device  The device to destroy.
+**/
+VOID
+FakeVirtioDeviceDestroy (
+  IN FAKE_VIRTIO_DEVICE *Device
+  );
+
+/**
+  @param[in] Device  The fake device.
+
+  @return  The VIRTIO_DEVICE_PROTOCOL interface for the driver to use.
+**/
+VIRTIO_DEVICE_PROTOCOL *
+FakeVirtioDeviceProtocol (
+  IN FAKE_VIRTIO_DEVICE *Device
+  );
+
+/**
+  Grant a gated queue credits for completing Count more chains, and wake its
+  thread.
+
+  @param[in] Device    The fake device.
+  @param[in] QueueIdx  The gated queue.
+  @param[in] Count     The number of credits to add.
+**/
+VOID
+FakeVirtioDeviceInject (
+  IN FAKE_VIRTIO_DEVICE *Device,
+  IN UINT16             QueueIdx,
+  IN UINT64             Count
+  );
+
+/**
+  Read the counters of a queue.
+
+  @param[in] Device    The fake device.
+  @param[in] QueueIdx  The queue whose counters to read.
+  @param[out] Stats    The counters since the device was created.
+**/
+VOID
+FakeVirtioDeviceGetStats (
+  IN  FAKE_VIRTIO_DEVICE      *Device,
+  IN  UINT16                  QueueIdx,
+  OUT FAKE_VIRTIO_QUEUE_STATS *Stats
+  );
+
+/**
+  @param[in] Device  The fake device.
+
+  @return  The number of shared buffer mappings that have not been unmapped
+           yet.
+**/
+UINTN
+FakeVirtioDeviceLiveMappings (
+  IN FAKE_VIRTIO_DEVICE *Device
+  );
+
+#endif // FAKE_VIRTIO_DEVICE_H_
@@ -0,0 +1,309 @@
+/** @file
+  virtio-fs benchmarks: FUSE_READ through VirtioFsSgListsSubmit() (one request
+  at a time) and through VirtioFsSgListsSubmitBatch() (pipelined, spread over
+  the request queues), against a fake FUSE server exporting one large file.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "../../VirtioFsDxe/VirtioFsDxe.h"
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "HostLib.h"
+#include "VirtioHostBench.h"
+
+#define FS_BENCH_FILE_SIZE       (256 * SIZE_1MB)
+#define FS_BENCH_NODE_ID         42
+#define FS_BENCH_FUSE_HANDLE     7
+#define FS_BENCH_MAX_PAGES       32
+#define FS_BENCH_READ_SIZE       SIZE_4KB
+#define FS_BENCH_READ_FILE_SIZE  SIZE_1MB
+#define FS_BENCH_ENOSYS          (-38)
+
+typedef struct {
+  UINT64 Errors;
+} FS_BENCH_SERVER;
+
+/**
+  Copy Size bytes into the device-writable buffers of Chain, starting at byte
+  Position of the response. If Source is NULL, the test pattern of the file
+  at FileOffset is written instead.
+
+  @return  The number of bytes written; smaller than Size if the buffers are
+           exhausted.
+**/
+STATIC
+UINT32
+FsBenchScatter (
+  IN CONST FAKE_VIRTIO_CHAIN *Chain,
+  IN UINT32                  Position,
+  IN CONST VOID              *Source OPTIONAL,
+  IN UINT64                  FileOffset,
+  IN UINT32                  Size
+  )
+{
+  UINTN  Idx;
+  UINT32 Skip;
+  UINT32 Chunk;
+  UINT32 Written;
+
+  Skip    = Position;
+  Written = 0;
+  for (Idx = 0; Idx < Chain->NumBuffers && Written < Size; Idx++) {
+    if (!Chain->Buffers[Idx].DeviceWritable) {
+      continue;
+    }
+    if (Skip >= Chain->Buffers[Idx].Len) {
+      Skip -= Chain->Buffers[Idx].Len;
+      continue;
+    }
+    Chunk = MIN (Chain->Buffers[Idx].Len - Skip, Size - Written);
+    if (Source != NULL) {
+      CopyMem ((UINT8 *)Chain->Buffers[Idx].Buffer + Skip,
+        (CONST UINT8 *)Source + Written, Chunk);
+    } else {
+      BenchFillPattern ((UINT8 *)Chain->Buffers[Idx].Buffer + Skip, Chunk,
+        FileOffset + Written);
+    }
+    Written += Chunk;
+    Skip     = 0;
+  }
+  return Written;
+}
+
+STATIC
+UINT32
+FsBenchHandleRequest (
+  IN VOID                    *Context,
+  IN UINT16                  QueueIdx,
+  IN CONST FAKE_VIRTIO_CHAIN *Chain
+  )
+{
+  FS_BENCH_SERVER              *Server;
+  UINT8                        Request[256];
+  UINT32                       RequestSize;
+  UINT32                       ResponseSpace;
+  UINTN                        Idx;
+  VIRTIO_FS_FUSE_REQUEST       *CommonReq;
+  VIRTIO_FS_FUSE_READ_REQUEST  *ReadReq;
+  VIRTIO_FS_FUSE_RESPONSE      CommonResp;
+  VIRTIO_FS_FUSE_INIT_RESPONSE InitResp;
+  UINT32                       Size;
+
+  Server = Context;
+
+  //
+  // Gather the request; the device-readable buffers come first.
+  //
+  RequestSize   = 0;
+  ResponseSpace = 0;
+  for (Idx = 0; Idx < Chain->NumBuffers; Idx++) {
+    if (Chain->Buffers[Idx].DeviceWritable) {
+      ResponseSpace += Chain->Buffers[Idx].Len;
+      continue;
+    }
+    if (ResponseSpace > 0 ||
+        RequestSize + Chain->Buffers[Idx].Len > sizeof Request) {
+      goto Malformed;
+    }
+    CopyMem (Request + RequestSize, Chain->Buffers[Idx].Buffer,
+      Chain->Buffers[Idx].Len);
+    RequestSize += Chain->Buffers[Idx].Len;
+  }
+
+  CommonReq = (VIRTIO_FS_FUSE_REQUEST *)Request;
+  if (RequestSize < sizeof *CommonReq || CommonReq->Len != RequestSize ||
+      ResponseSpace < sizeof CommonResp || QueueIdx < VIRTIO_FS_REQUEST_QUEUE) {
+    goto Malformed;
+  }
+
+  CommonResp.Error  = 0;
+  CommonResp.Unique = CommonReq->Unique;
+  Size              = 0;
+
+  switch (CommonReq->Opcode) {
+    case VirtioFsFuseOpInit:
+      ZeroMem (&InitResp, sizeof InitResp);
+      InitResp.Major        = VIRTIO_FS_FUSE_MAJOR;
+      InitResp.Minor        = VIRTIO_FS_FUSE_MINOR;
+      InitResp.MaxReadahead = VIRTIO_FS_READAHEAD_SIZE;
+      InitResp.Flags        = VIRTIO_FS_FUSE_INIT_REQ_F_DO_READDIRPLUS |
+                              VIRTIO_FS_FUSE_INIT_REQ_F_MAX_PAGES;
+      InitResp.MaxWrite     = SIZE_128KB;
+      InitResp.MaxPages     = FS_BENCH_MAX_PAGES;
+      Size = FsBenchScatter (Chain, sizeof CommonResp, &InitResp, 0,
+               sizeof InitResp);
+      break;
+
+    case VirtioFsFuseOpRead:
+      ReadReq = (VIRTIO_FS_FUSE_READ_REQUEST *)(CommonReq + 1);
+      if (RequestSize != sizeof *CommonReq + sizeof *ReadReq ||
+          CommonReq->NodeId != FS_BENCH_NODE_ID ||
+          ReadReq->FileHandle != FS_BENCH_FUSE_HANDLE ||
+          ReadReq->Size > ResponseSpace - sizeof CommonResp ||
+          ReadReq->Size > EFI_PAGES_TO_SIZE (FS_BENCH_MAX_PAGES)) {
+        goto Malformed;
+      }
+      if (ReadReq->Offset < FS_BENCH_FILE_SIZE) {
+        Size = (UINT32)MIN ((UINT64)ReadReq->Size,
+                         FS_BENCH_FILE_SIZE - ReadReq->Offset);
+        FsBenchScatter (Chain, sizeof CommonResp, NULL, ReadReq->Offset,
+          Size);
+      }
+      break;
+
+    default:
+      CommonResp.Error = FS_BENCH_ENOSYS;
+      break;
+  }
+
+  CommonResp.Len = (UINT32)(sizeof CommonResp + Size);
+  FsBenchScatter (Chain, 0, &CommonResp, 0, sizeof CommonResp);
+  return CommonResp.Len;
+
+Malformed:
+  __atomic_add_fetch (&Server->Errors, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+STATIC
+EFI_STATUS
+FsBenchRun (
+  IN  CONST BENCH_OPTIONS *Options,
+  IN  BOOLEAN             Pipelined,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  FS_BENCH_SERVER           Server;
+  VIRTIO_FS_CONFIG          FsConfig;
+  FAKE_VIRTIO_DEVICE_CONFIG Config;
+  FAKE_VIRTIO_DEVICE        *Device;
+  VIRTIO_FS                 VirtioFs;
+  UINT32                    IoSize;
+  UINT64                    NumSlots;
+  VOID                      *Buffer;
+  UINT64                    Op;
+  UINT64                    Offset;
+  UINT32                    Size32;
+  UINTN                     Size;
+  UINT64                    Start;
+  UINT64                    Polls;
+  UINT64                    Notifications;
+  EFI_STATUS                Status;
+
+  IoSize = Options->IoSize;
+  if (IoSize == 0) {
+    IoSize = Pipelined ? FS_BENCH_READ_FILE_SIZE : FS_BENCH_READ_SIZE;
+  }
+  if (IoSize > FS_BENCH_FILE_SIZE ||
+      (!Pipelined && IoSize > EFI_PAGES_TO_SIZE (FS_BENCH_MAX_PAGES)) ||
+      Options->FsQueues == 0 ||
+      Options->FsQueues > FAKE_VIRTIO_MAX_QUEUES - VIRTIO_FS_REQUEST_QUEUE) {
+    return EFI_INVALID_PARAMETER;
+  }
+  NumSlots = FS_BENCH_FILE_SIZE / IoSize;
+
+  ZeroMem (&Server, sizeof Server);
+  ZeroMem (&FsConfig, sizeof FsConfig);
+  CopyMem (FsConfig.Tag, "hostbench", sizeof "hostbench");
+  FsConfig.NumReqQueues = Options->FsQueues;
+
+  ZeroMem (&Config, sizeof Config);
+  Config.Revision          = VIRTIO_SPEC_REVISION (1, 0, 0);
+  Config.SubSystemDeviceId = VIRTIO_SUBSYSTEM_FILESYSTEM;
+  Config.Features          = VIRTIO_F_VERSION_1;
+  Config.Config            = &FsConfig;
+  Config.ConfigSize        = sizeof FsConfig;
+  Config.NumQueues         = VIRTIO_FS_REQUEST_QUEUE + Options->FsQueues;
+  Config.QueueNumMax       = Options->QueueSize;
+  Config.LatencyNs         = Options->LatencyNs;
+  Config.Polling           = Options->Polling;
+  Config.Handler           = FsBenchHandleRequest;
+  Config.Context           = &Server;
+
+  Status = FakeVirtioDeviceCreate (&Config, &Device);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&VirtioFs, sizeof VirtioFs);
+  VirtioFs.Signature = VIRTIO_FS_SIG;
+  VirtioFs.Virtio    = FakeVirtioDeviceProtocol (Device);
+  Status = VirtioFsInit (&VirtioFs);
+  if (EFI_ERROR (Status)) {
+    goto DestroyDevice;
+  }
+  Status = VirtioFsFuseInitSession (&VirtioFs);
+  if (EFI_ERROR (Status)) {
+    goto UninitVirtioFs;
+  }
+
+  Buffer = AllocatePool (IoSize);
+  if (Buffer == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto UninitVirtioFs;
+  }
+
+  Notifications = BenchNotifications (Device, Config.NumQueues);
+  Polls         = gHostStallCalls;
+  Start         = HostNowNs ();
+  for (Op = 0; Op < Options->Ops; Op++) {
+    Offset = (Op % NumSlots) * IoSize;
+    Result->LatencyNs[Op] = HostNowNs ();
+    if (Pipelined) {
+      Size = IoSize;
+      Status = VirtioFsFuseReadFile (&VirtioFs, FS_BENCH_NODE_ID,
+                 FS_BENCH_FUSE_HANDLE, Offset, &Size, Buffer);
+    } else {
+      Size32 = IoSize;
+      Status = VirtioFsFuseReadFileOrDir (&VirtioFs, FS_BENCH_NODE_ID,
+                 FS_BENCH_FUSE_HANDLE, FALSE, Offset, &Size32, Buffer);
+      Size = Size32;
+    }
+    Result->LatencyNs[Op] = HostNowNs () - Result->LatencyNs[Op];
+
+    if (EFI_ERROR (Status) || Size != IoSize ||
+        !BenchCheckPattern (Buffer, IoSize, Offset)) {
+      Result->Errors++;
+    }
+  }
+  Result->ElapsedNs     = HostNowNs () - Start;
+  Result->Ops           = Options->Ops;
+  Result->Bytes         = Options->Ops * IoSize;
+  Result->Notifications = BenchNotifications (Device, Config.NumQueues) -
+                          Notifications;
+  Result->Polls         = gHostStallCalls - Polls;
+  Status                = EFI_SUCCESS;
+
+  FreePool (Buffer);
+
+UninitVirtioFs:
+  VirtioFsUninit (&VirtioFs);
+
+DestroyDevice:
+  Result->Errors += Server.Errors + FakeVirtioDeviceLiveMappings (Device);
+  FakeVirtioDeviceDestroy (Device);
+  return Status;
+}
+
+EFI_STATUS
+FsBenchRead (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  return FsBenchRun (Options, FALSE, Result);
+}
+
+EFI_STATUS
+FsBenchReadFile (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  return FsBenchRun (Options, TRUE, Result);
+}
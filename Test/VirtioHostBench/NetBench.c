@@ -0,0 +1,454 @@
+/** @file
+  virtio-net benchmarks: VirtioNetTransmit() with VirtioNetGetStatus()
+  reaping, and VirtioNetReceive() of frames that the fake device injects.
+
+  Every frame carries its sequence number after the Ethernet header, followed
+  by the test pattern; both ends check the frames in order.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <sched.h>
+
+#include "../../VirtioNetDxe/VirtioNet.h"
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "HostLib.h"
+#include "VirtioHostBench.h"
+
+#define NET_BENCH_FRAME_SIZE  1514
+#define NET_BENCH_ETHER_TYPE  0x88B5  // IEEE 802 local experimental
+
+STATIC CONST UINT8 mNetBenchGuestMac[6] = { 0x52, 0x54, 0x00, 0x12, 0x34, 0x56 };
+STATIC CONST UINT8 mNetBenchPeerMac[6]  = { 0x52, 0x54, 0x00, 0x65, 0x43, 0x21 };
+
+typedef struct {
+  UINT32 FrameSize;
+  UINT32 NetReqSize;
+  UINT64 TxSeq;
+  UINT64 RxSeq;
+  UINT64 Errors;
+} NET_BENCH_WIRE;
+
+STATIC
+VOID
+NetBenchBuildFrame (
+  OUT UINT8       *Frame,
+  IN  UINT32      FrameSize,
+  IN  CONST UINT8 *Dest,
+  IN  CONST UINT8 *Src,
+  IN  UINT64      Seq
+  )
+{
+  CopyMem (Frame, Dest, 6);
+  CopyMem (Frame + 6, Src, 6);
+  Frame[12] = (UINT8)(NET_BENCH_ETHER_TYPE >> 8);
+  Frame[13] = (UINT8)NET_BENCH_ETHER_TYPE;
+  CopyMem (Frame + 14, &Seq, sizeof Seq);
+  BenchFillPattern (Frame + 22, FrameSize - 22, Seq * FrameSize);
+}
+
+STATIC
+BOOLEAN
+NetBenchCheckFrame (
+  IN CONST UINT8 *Frame,
+  IN UINT32      FrameSize,
+  IN CONST UINT8 *Dest,
+  IN CONST UINT8 *Src,
+  IN UINT64      Seq
+  )
+{
+  return (BOOLEAN)(
+           CompareMem (Frame, Dest, 6) == 0 &&
+           CompareMem (Frame + 6, Src, 6) == 0 &&
+           Frame[12] == (UINT8)(NET_BENCH_ETHER_TYPE >> 8) &&
+           Frame[13] == (UINT8)NET_BENCH_ETHER_TYPE &&
+           CompareMem (Frame + 14, &Seq, sizeof Seq) == 0 &&
+           BenchCheckPattern (Frame + 22, FrameSize - 22, Seq * FrameSize)
+           );
+}
+
+STATIC
+UINT32
+NetBenchHandlePacket (
+  IN VOID                    *Context,
+  IN UINT16                  QueueIdx,
+  IN CONST FAKE_VIRTIO_CHAIN *Chain
+  )
+{
+  NET_BENCH_WIRE           *Wire;
+  CONST FAKE_VIRTIO_BUFFER *Header;
+  CONST FAKE_VIRTIO_BUFFER *Frame;
+  BOOLEAN                  Receive;
+
+  Wire    = Context;
+  Receive = (BOOLEAN)(QueueIdx == VIRTIO_NET_Q_RX);
+
+  //
+  // Both directions use two-descriptor chains: the virtio-net header, then the
+  // Ethernet frame.
+  //
+  if (Chain->NumBuffers != 2) {
+    goto Malformed;
+  }
+  Header = &Chain->Buffers[0];
+  Frame  = &Chain->Buffers[1];
+  if (Header->DeviceWritable != Receive || Frame->DeviceWritable != Receive ||
+      Header->Len != Wire->NetReqSize) {
+    goto Malformed;
+  }
+
+  if (Receive) {
+    if (Frame->Len < Wire->FrameSize) {
+      goto Malformed;
+    }
+    ZeroMem (Header->Buffer, Header->Len);
+    NetBenchBuildFrame (Frame->Buffer, Wire->FrameSize, mNetBenchGuestMac,
+      mNetBenchPeerMac, Wire->RxSeq++);
+    return Wire->NetReqSize + Wire->FrameSize;
+  }
+
+  if (Frame->Len != Wire->FrameSize ||
+      !NetBenchCheckFrame (Frame->Buffer, Wire->FrameSize, mNetBenchPeerMac,
+         mNetBenchGuestMac, Wire->TxSeq++)) {
+    goto Malformed;
+  }
+  return 0;
+
+Malformed:
+  __atomic_add_fetch (&Wire->Errors, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+/**
+  Create the fake virtio-net device, and bring up the VirtioNetDxe instance
+  on it the way VirtioNetSnpPopulate() and the Start() / Initialize() calls of
+  an SNP client would.
+**/
+STATIC
+EFI_STATUS
+NetBenchSetup (
+  IN  CONST BENCH_OPTIONS *Options,
+  IN  NET_BENCH_WIRE      *Wire,
+  OUT FAKE_VIRTIO_DEVICE  **Device,
+  OUT VNET_DEV            *Dev
+  )
+{
+  VIRTIO_NET_CONFIG         NetConfig;
+  FAKE_VIRTIO_DEVICE_CONFIG Config;
+  EFI_STATUS                Status;
+
+  ZeroMem (&NetConfig, sizeof NetConfig);
+  CopyMem (NetConfig.Mac, mNetBenchGuestMac, sizeof NetConfig.Mac);
+
+  //
+  // Without VIRTIO_NET_F_STATUS, the driver does not read the link status on
+  // every VirtioNetGetStatus() call.
+  //
+  ZeroMem (&Config, sizeof Config);
+  Config.Revision          = Options->Legacy ?
+                             VIRTIO_SPEC_REVISION (0, 9, 5) :
+                             VIRTIO_SPEC_REVISION (1, 0, 0);
+  Config.SubSystemDeviceId = VIRTIO_SUBSYSTEM_NETWORK_CARD;
+  Config.Features          = VIRTIO_NET_F_MAC |
+                             (Options->Legacy ? 0 : VIRTIO_F_VERSION_1);
+  Config.Config            = &NetConfig;
+  Config.ConfigSize        = sizeof NetConfig;
+  Config.NumQueues         = 2;
+  Config.QueueNumMax       = Options->QueueSize;
+  Config.GatedQueues       = 1u << VIRTIO_NET_Q_RX;
+  Config.LatencyNs         = Options->LatencyNs;
+  Config.Polling           = Options->Polling;
+  Config.Handler           = NetBenchHandlePacket;
+  Config.Context           = Wire;
+
+  Wire->NetReqSize = Options->Legacy ?
+                     sizeof (VIRTIO_NET_REQ) :
+                     sizeof (VIRTIO_1_0_NET_REQ);
+
+  Status = FakeVirtioDeviceCreate (&Config, Device);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (Dev, sizeof *Dev);
+  Dev->Signature = VNET_SIG;
+  Dev->VirtIo    = FakeVirtioDeviceProtocol (*Device);
+  Dev->Snp.Mode  = &Dev->Snm;
+
+  Dev->Snm.State                 = EfiSimpleNetworkStarted;
+  Dev->Snm.HwAddressSize         = SIZE_OF_VNET (Mac);
+  Dev->Snm.MediaHeaderSize       = SIZE_OF_VNET (Mac) + SIZE_OF_VNET (Mac) + 2;
+  Dev->Snm.MaxPacketSize         = 1500;
+  Dev->Snm.IfType                = 1;
+  Dev->Snm.MultipleTxSupported   = TRUE;
+  Dev->Snm.MediaPresentSupported = FALSE;
+  Dev->Snm.MediaPresent          = TRUE;
+  CopyMem (&Dev->Snm.CurrentAddress, mNetBenchGuestMac, SIZE_OF_VNET (Mac));
+  CopyMem (&Dev->Snm.PermanentAddress, mNetBenchGuestMac, SIZE_OF_VNET (Mac));
+  SetMem (&Dev->Snm.BroadcastAddress, SIZE_OF_VNET (Mac), 0xFF);
+
+  Status = VirtioNetInitialize (&Dev->Snp, 0, 0);
+  if (EFI_ERROR (Status)) {
+    FakeVirtioDeviceDestroy (*Device);
+  }
+  return Status;
+}
+
+STATIC
+VOID
+NetBenchTeardown (
+  IN     FAKE_VIRTIO_DEVICE *Device,
+  IN     VNET_DEV           *Dev,
+  IN     NET_BENCH_WIRE     *Wire,
+  IN OUT BENCH_RESULT       *Result
+  )
+{
+  if (EFI_ERROR (VirtioNetShutdown (&Dev->Snp))) {
+    Result->Errors++;
+  }
+  Result->Errors += Wire->Errors + FakeVirtioDeviceLiveMappings (Device);
+  FakeVirtioDeviceDestroy (Device);
+}
+
+STATIC
+UINT32
+NetBenchFrameSize (
+  IN CONST BENCH_OPTIONS *Options
+  )
+{
+  if (Options->IoSize == 0) {
+    return NET_BENCH_FRAME_SIZE;
+  }
+  if (Options->IoSize < 22 || Options->IoSize > NET_BENCH_FRAME_SIZE) {
+    return 0;
+  }
+  return Options->IoSize;
+}
+
+EFI_STATUS
+NetBenchTransmit (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  NET_BENCH_WIRE     Wire;
+  FAKE_VIRTIO_DEVICE *Device;
+  VNET_DEV           Dev;
+  UINT32             Depth;
+  UINT8              *Frames;
+  UINT32             *FreeFrames;
+  UINT32             NumFree;
+  UINT64             *SubmitNs;
+  UINT32             FrameIdx;
+  VOID               *TxBuf;
+  UINT64             Seq;
+  UINT64             Done;
+  UINT64             Start;
+  UINT64             Notifications;
+  EFI_STATUS         Status;
+
+  ZeroMem (&Wire, sizeof Wire);
+  Wire.FrameSize = NetBenchFrameSize (Options);
+  if (Wire.FrameSize == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = NetBenchSetup (Options, &Wire, &Device, &Dev);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Seq   = 0;
+  Done  = 0;
+  Depth = Dev.TxMaxPending;
+  if (Options->Depth > 0 && Options->Depth < Depth) {
+    Depth = Options->Depth;
+  }
+
+  Frames     = AllocatePool ((UINTN)Depth * Wire.FrameSize);
+  FreeFrames = AllocatePool (Depth * sizeof *FreeFrames);
+  SubmitNs   = AllocatePool (Depth * sizeof *SubmitNs);
+  if (Frames == NULL || FreeFrames == NULL || SubmitNs == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeBuffers;
+  }
+  for (NumFree = 0; NumFree < Depth; NumFree++) {
+    FreeFrames[NumFree] = Depth - 1 - NumFree;
+  }
+
+  //
+  // Keep up to Depth frames in flight; reap completions only when the window
+  // is full or all frames have been sent.
+  //
+  Notifications = BenchNotifications (Device, 2);
+  Start         = HostNowNs ();
+  while (Done < Options->Ops) {
+    if (Seq < Options->Ops && NumFree > 0) {
+      FrameIdx = FreeFrames[--NumFree];
+      NetBenchBuildFrame (Frames + (UINTN)FrameIdx * Wire.FrameSize,
+        Wire.FrameSize, mNetBenchPeerMac, mNetBenchGuestMac, Seq);
+      SubmitNs[FrameIdx] = HostNowNs ();
+      Status = VirtioNetTransmit (&Dev.Snp, 0, Wire.FrameSize,
+                 Frames + (UINTN)FrameIdx * Wire.FrameSize, NULL, NULL, NULL);
+      if (EFI_ERROR (Status)) {
+        goto FreeBuffers;
+      }
+      Seq++;
+      continue;
+    }
+
+    Status = VirtioNetGetStatus (&Dev.Snp, NULL, &TxBuf);
+    if (EFI_ERROR (Status)) {
+      goto FreeBuffers;
+    }
+    if (TxBuf == NULL) {
+      Result->Polls++;
+      sched_yield ();
+      continue;
+    }
+    FrameIdx = (UINT32)(((UINT8 *)TxBuf - Frames) / Wire.FrameSize);
+    Result->LatencyNs[Done++] = HostNowNs () - SubmitNs[FrameIdx];
+    FreeFrames[NumFree++] = FrameIdx;
+  }
+  Result->ElapsedNs     = HostNowNs () - Start;
+  Result->Ops           = Done;
+  Result->Bytes         = Done * Wire.FrameSize;
+  Result->Notifications = BenchNotifications (Device, 2) - Notifications;
+  Status                = EFI_SUCCESS;
+
+FreeBuffers:
+  //
+  // Reclaim what is still in flight after a failure before the buffers go.
+  //
+  while (Seq > Done) {
+    if (EFI_ERROR (VirtioNetGetStatus (&Dev.Snp, NULL, &TxBuf))) {
+      break;
+    }
+    if (TxBuf != NULL) {
+      Done++;
+    }
+  }
+  NetBenchTeardown (Device, &Dev, &Wire, Result);
+  if (SubmitNs != NULL) {
+    FreePool (SubmitNs);
+  }
+  if (FreeFrames != NULL) {
+    FreePool (FreeFrames);
+  }
+  if (Frames != NULL) {
+    FreePool (Frames);
+  }
+  return Status;
+}
+
+EFI_STATUS
+NetBenchReceive (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  )
+{
+  NET_BENCH_WIRE     Wire;
+  FAKE_VIRTIO_DEVICE *Device;
+  VNET_DEV           Dev;
+  UINT32             Depth;
+  UINT8              *Frame;
+  UINT64             *InjectNs;
+  UINT64             Injected;
+  UINT64             Received;
+  UINT64             Batch;
+  UINT64             Idx;
+  UINT64             Now;
+  UINTN              HeaderSize;
+  UINTN              BufferSize;
+  UINT16             Protocol;
+  UINT64             Start;
+  UINT64             Notifications;
+  EFI_STATUS         Status;
+
+  ZeroMem (&Wire, sizeof Wire);
+  Wire.FrameSize = NetBenchFrameSize (Options);
+  if (Wire.FrameSize == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = NetBenchSetup (Options, &Wire, &Device, &Dev);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // VirtioNetInitRx() keeps this many receive buffers on the ring.
+  //
+  Depth = (UINT32)MIN (Dev.RxRing.QueueSize / 2, VNET_MAX_PENDING);
+  if (Options->Depth > 0 && Options->Depth < Depth) {
+    Depth = Options->Depth;
+  }
+
+  Frame    = AllocatePool (NET_BENCH_FRAME_SIZE);
+  InjectNs = AllocatePool (Depth * sizeof *InjectNs);
+  if (Frame == NULL || InjectNs == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeBuffers;
+  }
+
+  //
+  // Let the device deliver up to Depth frames ahead of the guest.
+  //
+  Injected      = 0;
+  Received      = 0;
+  Notifications = BenchNotifications (Device, 2);
+  Start         = HostNowNs ();
+  while (Received < Options->Ops) {
+    Batch = MIN (Options->Ops - Injected, Depth - (Injected - Received));
+    if (Batch > 0) {
+      Now = HostNowNs ();
+      for (Idx = 0; Idx < Batch; Idx++) {
+        InjectNs[(Injected + Idx) % Depth] = Now;
+      }
+      Injected += Batch;
+      FakeVirtioDeviceInject (Device, VIRTIO_NET_Q_RX, Batch);
+    }
+
+    BufferSize = NET_BENCH_FRAME_SIZE;
+    Status = VirtioNetReceive (&Dev.Snp, &HeaderSize, &BufferSize, Frame,
+               NULL, NULL, &Protocol);
+    if (Status == EFI_NOT_READY) {
+      Result->Polls++;
+      sched_yield ();
+      continue;
+    }
+    if (EFI_ERROR (Status)) {
+      goto FreeBuffers;
+    }
+    Result->LatencyNs[Received] = HostNowNs () -
+                                  InjectNs[Received % Depth];
+    if (HeaderSize != Dev.Snm.MediaHeaderSize ||
+        BufferSize != Wire.FrameSize ||
+        Protocol != NET_BENCH_ETHER_TYPE ||
+        !NetBenchCheckFrame (Frame, Wire.FrameSize, mNetBenchGuestMac,
+           mNetBenchPeerMac, Received)) {
+      Result->Errors++;
+    }
+    Received++;
+  }
+  Result->ElapsedNs     = HostNowNs () - Start;
+  Result->Ops           = Received;
+  Result->Bytes         = Received * Wire.FrameSize;
+  Result->Notifications = BenchNotifications (Device, 2) - Notifications;
+  Status                = EFI_SUCCESS;
+
+FreeBuffers:
+  NetBenchTeardown (Device, &Dev, &Wire, Result);
+  if (InjectNs != NULL) {
+    FreePool (InjectNs);
+  }
+  if (Frame != NULL) {
+    FreePool (Frame);
+  }
+  return Status;
+}
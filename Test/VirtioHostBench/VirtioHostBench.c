@@ -0,0 +1,303 @@
+/** @file
+  Host-side benchmarks of the virtio request paths of VirtioBlkDxe,
+  VirtioFsDxe and VirtioNetDxe, against FakeVirtioDevice.
+
+  Usage: VirtioHostBench [options] [benchmark...]
+
+  Each benchmark reports operations per second, notifications (queue kicks)
+  per operation, guest polls per operation and latency percentiles. The
+  process exits with status 1 if any data or protocol mismatch was detected,
+  so that it can serve as a regression test as well.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "VirtioHostBench.h"
+
+typedef struct {
+  CONST CHAR8    *Name;
+  BENCH_FUNCTION Function;
+  CONST CHAR8    *Description;
+} BENCH_ENTRY;
+
+STATIC CONST BENCH_ENTRY mBenchmarks[] = {
+  { "blk-read",    BlkBenchRead,     "VirtioBlkReadBlocks(), 4KB" },
+  { "blk-write",   BlkBenchWrite,    "VirtioBlkWriteBlocks(), 4KB" },
+  { "fs-read",     FsBenchRead,      "FUSE_READ via VirtioFsSgListsSubmit(), 4KB" },
+  { "fs-readfile", FsBenchReadFile,  "FUSE_READ via VirtioFsSgListsSubmitBatch(), 1MB" },
+  { "net-tx",      NetBenchTransmit, "VirtioNetTransmit() + GetStatus(), 1514B" },
+  { "net-rx",      NetBenchReceive,  "VirtioNetReceive(), 1514B" },
+};
+
+VOID
+BenchFillPattern (
+  OUT VOID   *Buffer,
+  IN  UINTN  Size,
+  IN  UINT64 Offset
+  )
+{
+  UINT8 *Bytes;
+  UINTN Idx;
+
+  Bytes = Buffer;
+  for (Idx = 0; Idx < Size; Idx++) {
+    Bytes[Idx] = BenchPatternByte (Offset + Idx);
+  }
+}
+
+BOOLEAN
+BenchCheckPattern (
+  IN CONST VOID *Buffer,
+  IN UINTN      Size,
+  IN UINT64     Offset
+  )
+{
+  CONST UINT8 *Bytes;
+  UINTN       Idx;
+
+  Bytes = Buffer;
+  for (Idx = 0; Idx < Size; Idx++) {
+    if (Bytes[Idx] != BenchPatternByte (Offset + Idx)) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+UINT64
+BenchNotifications (
+  IN FAKE_VIRTIO_DEVICE *Device,
+  IN UINT16             NumQueues
+  )
+{
+  FAKE_VIRTIO_QUEUE_STATS Stats;
+  UINT64                  Notifications;
+  UINT16                  QueueIdx;
+
+  Notifications = 0;
+  for (QueueIdx = 0; QueueIdx < NumQueues; QueueIdx++) {
+    FakeVirtioDeviceGetStats (Device, QueueIdx, &Stats);
+    Notifications += Stats.Notifications;
+  }
+  return Notifications;
+}
+
+STATIC
+int
+BenchCompareU64 (
+  IN CONST VOID *Left,
+  IN CONST VOID *Right
+  )
+{
+  UINT64 L;
+  UINT64 R;
+
+  L = *(CONST UINT64 *)Left;
+  R = *(CONST UINT64 *)Right;
+  return (L > R) - (L < R);
+}
+
+/**
+  @return  The Percent-th percentile of the sorted samples, in microseconds.
+**/
+STATIC
+double
+BenchPercentileUs (
+  IN CONST UINT64 *Sorted,
+  IN UINT64       Count,
+  IN UINT32       Percent
+  )
+{
+  UINT64 Idx;
+
+  if (Count == 0) {
+    return 0;
+  }
+  Idx = (Count * Percent + 99) / 100;
+  Idx = (Idx == 0) ? 0 : Idx - 1;
+  return Sorted[Idx] / 1000.0;
+}
+
+STATIC
+VOID
+BenchReport (
+  IN CONST CHAR8        *Name,
+  IN CONST BENCH_RESULT *Result
+  )
+{
+  double Seconds;
+  double Ops;
+
+  qsort (Result->LatencyNs, Result->Ops, sizeof *Result->LatencyNs,
+    BenchCompareU64);
+
+  Seconds = Result->ElapsedNs / 1e9;
+  Ops     = (Result->Ops == 0) ? 1 : (double)Result->Ops;
+  printf (
+    "%-12s %8llu %10.0f %9.1f %9.2f %9.2f %8.1f %8.1f %8.1f %8.1f %6llu\n",
+    Name,
+    (unsigned long long)Result->Ops,
+    (Seconds > 0) ? Result->Ops / Seconds : 0,
+    (Seconds > 0) ? Result->Bytes / Seconds / 1e6 : 0,
+    Result->Notifications / Ops,
+    Result->Polls / Ops,
+    BenchPercentileUs (Result->LatencyNs, Result->Ops, 50),
+    BenchPercentileUs (Result->LatencyNs, Result->Ops, 90),
+    BenchPercentileUs (Result->LatencyNs, Result->Ops, 99),
+    BenchPercentileUs (Result->LatencyNs, Result->Ops, 100),
+    (unsigned long long)Result->Errors
+    );
+}
+
+STATIC
+VOID
+BenchUsage (
+  IN CONST CHAR8 *Program
+  )
+{
+  UINTN Idx;
+
+  fprintf (stderr,
+    "Usage: %s [options] [benchmark...]\n"
+    "\n"
+    "Options:\n"
+    "  -n OPS    operations per benchmark (default 10000)\n"
+    "  -l USEC   device completion latency in microseconds (default 0)\n"
+    "  -s BYTES  bytes per operation (default: per benchmark, see below)\n"
+    "  -q SIZE   descriptors per virtqueue (default 256)\n"
+    "  -Q NUM    virtio-fs request queues (default 1)\n"
+    "  -w DEPTH  frames in flight for net-tx / net-rx (default: maximum)\n"
+    "  -p        the device polls the rings instead of waiting for kicks\n"
+    "  -L        offer a virtio 0.9.5 device to blk and net\n"
+    "\n"
+    "Benchmarks (default: all):\n",
+    Program);
+  for (Idx = 0; Idx < ARRAY_SIZE (mBenchmarks); Idx++) {
+    fprintf (stderr, "  %-12s %s\n", mBenchmarks[Idx].Name,
+      mBenchmarks[Idx].Description);
+  }
+}
+
+int
+main (
+  int  argc,
+  char **argv
+  )
+{
+  BENCH_OPTIONS Options;
+  BENCH_RESULT  Result;
+  BOOLEAN       Selected[ARRAY_SIZE (mBenchmarks)];
+  BOOLEAN       Any;
+  BOOLEAN       Failed;
+  UINTN         Idx;
+  int           Opt;
+  int           Arg;
+  EFI_STATUS    Status;
+
+  ZeroMem (&Options, sizeof Options);
+  Options.Ops       = 10000;
+  Options.QueueSize = 256;
+  Options.FsQueues  = 1;
+
+  while ((Opt = getopt (argc, argv, "n:l:s:q:Q:w:pLh")) != -1) {
+    switch (Opt) {
+      case 'n':
+        Options.Ops = strtoull (optarg, NULL, 0);
+        break;
+      case 'l':
+        Options.LatencyNs = strtoull (optarg, NULL, 0) * 1000;
+        break;
+      case 's':
+        Options.IoSize = (UINT32)strtoul (optarg, NULL, 0);
+        break;
+      case 'q':
+        Options.QueueSize = (UINT16)strtoul (optarg, NULL, 0);
+        break;
+      case 'Q':
+        Options.FsQueues = (UINT16)strtoul (optarg, NULL, 0);
+        break;
+      case 'w':
+        Options.Depth = (UINT32)strtoul (optarg, NULL, 0);
+        break;
+      case 'p':
+        Options.Polling = TRUE;
+        break;
+      case 'L':
+        Options.Legacy = TRUE;
+        break;
+      default:
+        BenchUsage (argv[0]);
+        return 2;
+    }
+  }
+  if (Options.Ops == 0 || Options.QueueSize == 0 ||
+      (Options.QueueSize & (Options.QueueSize - 1)) != 0) {
+    BenchUsage (argv[0]);
+    return 2;
+  }
+
+  ZeroMem (Selected, sizeof Selected);
+  Any = FALSE;
+  for (Arg = optind; Arg < argc; Arg++) {
+    for (Idx = 0; Idx < ARRAY_SIZE (mBenchmarks); Idx++) {
+      if (strcmp (argv[Arg], mBenchmarks[Idx].Name) == 0) {
+        Selected[Idx] = TRUE;
+        Any           = TRUE;
+        break;
+      }
+    }
+    if (Idx == ARRAY_SIZE (mBenchmarks)) {
+      BenchUsage (argv[0]);
+      return 2;
+    }
+  }
+  if (!Any) {
+    SetMem (Selected, sizeof Selected, TRUE);
+  }
+
+  printf ("latency %llu us, queue size %u, %s, virtio %s\n",
+    (unsigned long long)(Options.LatencyNs / 1000), Options.QueueSize,
+    Options.Polling ? "device polls" : "device waits for kicks",
+    Options.Legacy ? "0.9.5" : "1.0");
+  printf ("%-12s %8s %10s %9s %9s %9s %8s %8s %8s %8s %6s\n",
+    "benchmark", "ops", "ops/s", "MB/s", "notify/op", "polls/op",
+    "p50 us", "p90 us", "p99 us", "max us", "errors");
+
+  Failed = FALSE;
+  for (Idx = 0; Idx < ARRAY_SIZE (mBenchmarks); Idx++) {
+    if (!Selected[Idx]) {
+      continue;
+    }
+    ZeroMem (&Result, sizeof Result);
+    Result.LatencyNs = AllocateZeroPool (Options.Ops * sizeof *Result.LatencyNs);
+    if (Result.LatencyNs == NULL) {
+      fprintf (stderr, "%s: out of memory\n", mBenchmarks[Idx].Name);
+      return 1;
+    }
+
+    Status = mBenchmarks[Idx].Function (&Options, &Result);
+    if (EFI_ERROR (Status)) {
+      printf ("%-12s failed: status 0x%llx\n", mBenchmarks[Idx].Name,
+        (unsigned long long)Status);
+      Failed = TRUE;
+    } else {
+      BenchReport (mBenchmarks[Idx].Name, &Result);
+      if (Result.Errors > 0) {
+        Failed = TRUE;
+      }
+    }
+    FreePool (Result.LatencyNs);
+  }
+
+  return Failed ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+/** @file
+  Interfaces shared by the VirtioHostBench benchmarks.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef VIRTIO_HOST_BENCH_H_
+#define VIRTIO_HOST_BENCH_H_
+
+#include <Uefi.h>
+
+#include "FakeVirtioDevice.h"
+
+typedef struct {
+  UINT64  Ops;        // -n: operations to time
+  UINT64  LatencyNs;  // -l: device completion latency
+  UINT32  IoSize;     // -s: bytes per operation; 0 selects the default
+  UINT16  QueueSize;  // -q: descriptors per virtqueue
+  UINT16  FsQueues;   // -Q: virtio-fs request queues
+  UINT32  Depth;      // -w: operations in flight (net); 0 selects the maximum
+  BOOLEAN Polling;    // -p: the device polls the available rings
+  BOOLEAN Legacy;     // -L: virtio 0.9.5 instead of 1.0 (blk, net)
+} BENCH_OPTIONS;
+
+typedef struct {
+  //
+  // Filled in by the benchmark.
+  //
+  UINT64 Ops;           // operations completed
+  UINT64 Bytes;         // payload bytes moved
+  UINT64 ElapsedNs;     // wall clock time of the timed loop
+  UINT64 Notifications; // SetQueueNotify() calls during the timed loop
+  UINT64 Polls;         // guest polls that found no completion
+  UINT64 Errors;        // data or protocol mismatches
+  //
+  // Allocated by the caller, with room for Options->Ops samples; the
+  // benchmark stores the latency of each operation.
+  //
+  UINT64 *LatencyNs;
+} BENCH_RESULT;
+
+typedef
+EFI_STATUS
+(*BENCH_FUNCTION)(
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  );
+
+//
+// Test data. Byte number Offset of a disk, file or packet stream holds
+// BenchPatternByte (Offset), so that misplaced or stale data is detected.
+//
+#define BenchPatternByte(Offset) \
+          ((UINT8)((Offset) ^ ((Offset) >> 9) ^ ((Offset) >> 17)))
+
+VOID
+BenchFillPattern (
+  OUT VOID   *Buffer,
+  IN  UINTN  Size,
+  IN  UINT64 Offset
+  );
+
+BOOLEAN
+BenchCheckPattern (
+  IN CONST VOID *Buffer,
+  IN UINTN      Size,
+  IN UINT64     Offset
+  );
+
+/**
+  Sum the SetQueueNotify() calls of all queues of Device.
+**/
+UINT64
+BenchNotifications (
+  IN FAKE_VIRTIO_DEVICE *Device,
+  IN UINT16             NumQueues
+  );
+
+EFI_STATUS
+BlkBenchRead (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  );
+
+EFI_STATUS
+BlkBenchWrite (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  );
+
+EFI_STATUS
+FsBenchRead (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  );
+
+EFI_STATUS
+FsBenchReadFile (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  );
+
+EFI_STATUS
+NetBenchTransmit (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  );
+
+EFI_STATUS
+NetBenchReceive (
+  IN  CONST BENCH_OPTIONS *Options,
+  OUT BENCH_RESULT        *Result
+  );
+
+#endif // VIRTIO_HOST_BENCH_H_
@@ -20,6 +20,7 @@
 
 #include <IndustryStandard/VirtioBlk.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/BootTimelineLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -1087,7 +1088,9 @@ VirtioBlkDriverBindingStart (
   //
   // VirtIo access granted, configure virtio-blk device.
   //
+  BootTimelineBegin ("VirtioBlkInit");
   Status = VirtioBlkInit (Dev);
+  BootTimelineEnd ("VirtioBlkInit");
   if (EFI_ERROR (Status)) {
     goto CloseVirtIo;
   }
@@ -89,10 +89,12 @@ VirtioFsBindingStart (
     goto UninitVirtioFs;
   }
 
+  VirtioFsCacheInit (VirtioFs);
+
   Status = gBS->CreateEvent (EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_CALLBACK,
                   VirtioFsExitBoot, VirtioFs, &VirtioFs->ExitBoot);
   if (EFI_ERROR (Status)) {
-    goto UninitVirtioFs;
+    goto UninitCache;
   }
 
   InitializeListHead (&VirtioFs->OpenFiles);
@@ -112,6 +114,9 @@ CloseExitBoot:
   CloseStatus = gBS->CloseEvent (VirtioFs->ExitBoot);
   ASSERT_EFI_ERROR (CloseStatus);
 
+UninitCache:
+  VirtioFsCacheUninit (VirtioFs);
+
 UninitVirtioFs:
   VirtioFsUninit (VirtioFs);
 
@@ -163,6 +168,7 @@ VirtioFsBindingStop (
   Status = gBS->CloseEvent (VirtioFs->ExitBoot);
   ASSERT_EFI_ERROR (Status);
 
+  VirtioFsCacheUninit (VirtioFs);
   VirtioFsUninit (VirtioFs);
 
   Status = gBS->CloseProtocol (ControllerHandle, &gVirtioDeviceProtocolGuid,
@@ -77,6 +77,12 @@ VirtioFsFuseForget (
   //
   ForgetReq.NumberOfLookups = 1;
 
+  //
+  // The device may reuse NodeId for a different inode once its lookup count
+  // drops to zero; don't let the attribute cache outlive that.
+  //
+  VirtioFsCacheDropAttr (VirtioFs, NodeId);
+
   //
   // Submit the request. There's not going to be a response.
   //
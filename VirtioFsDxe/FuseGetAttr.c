@@ -24,7 +24,8 @@
                            retrieved.
 
   @param[out] FuseAttr     The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object
-                           describing the properties of the inode.
+                           describing the properties of the inode. FuseAttr is
+                           also stored in the attribute cache.
 
   @retval EFI_SUCCESS  FuseAttr has been filled in.
 
@@ -112,5 +113,10 @@ VirtioFsFuseGetAttr (
       __FUNCTION__, VirtioFs->Label, NodeId, CommonResp.Error));
     Status = VirtioFsErrnoToEfiStatus (CommonResp.Error);
   }
+  if (!EFI_ERROR (Status)) {
+    VirtioFsCacheStoreAttr (VirtioFs, NodeId, FuseAttr,
+      VirtioFsCacheExpiry (VirtioFs, GetAttrResp.AttrValid,
+        GetAttrResp.AttrValidNsec));
+  }
   return Status;
 }
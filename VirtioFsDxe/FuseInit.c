@@ -25,7 +25,11 @@
                            "VirtioFs->RequestId" is set to 1 on output. The
                            maximum write buffer size exposed in the FUSE_INIT
                            response is saved in "VirtioFs->MaxWrite", on
-                           output.
+                           output. The maximum size of a single FUSE_READ, the
+                           negotiated readahead window, and the number of
+                           FUSE_READ requests to keep in flight are saved in
+                           "VirtioFs->MaxRead", "VirtioFs->Readahead" and
+                           "VirtioFs->ReadDepth", respectively.
 
   @retval EFI_SUCCESS      The FUSE session has been started.
 
@@ -100,8 +104,9 @@ VirtioFsFuseInitSession (
   //
   InitReq.Major        = VIRTIO_FS_FUSE_MAJOR;
   InitReq.Minor        = VIRTIO_FS_FUSE_MINOR;
-  InitReq.MaxReadahead = 0;
-  InitReq.Flags        = VIRTIO_FS_FUSE_INIT_REQ_F_DO_READDIRPLUS;
+  InitReq.MaxReadahead = VIRTIO_FS_READAHEAD_SIZE;
+  InitReq.Flags        = VIRTIO_FS_FUSE_INIT_REQ_F_DO_READDIRPLUS |
+                         VIRTIO_FS_FUSE_INIT_REQ_F_MAX_PAGES;
 
   //
   // Submit the request.
@@ -138,5 +143,30 @@ VirtioFsFuseInitSession (
   // Save the maximum write buffer size for FUSE_WRITE requests.
   //
   VirtioFs->MaxWrite = InitResp.MaxWrite;
+
+  //
+  // Size the FUSE_READ requests of pipelined reads for the number of pages
+  // that the device accepts in a request. Each FUSE_READ takes four
+  // descriptors (two request headers, response header, data); keep as many
+  // of them in flight as fit on the request queues.
+  //
+  if ((InitResp.Flags & VIRTIO_FS_FUSE_INIT_REQ_F_MAX_PAGES) != 0 &&
+      InitResp.MaxPages > 0) {
+    VirtioFs->MaxRead = (UINT32)EFI_PAGES_TO_SIZE (InitResp.MaxPages);
+  } else {
+    VirtioFs->MaxRead =
+      (UINT32)EFI_PAGES_TO_SIZE (VIRTIO_FS_FUSE_DEFAULT_MAX_PAGES);
+  }
+  VirtioFs->Readahead = MIN (InitResp.MaxReadahead, InitReq.MaxReadahead);
+  VirtioFs->ReadDepth = (UINTN)VirtioFs->NumQueues * (VirtioFs->QueueSize / 4);
+  if (VirtioFs->ReadDepth > VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT) {
+    VirtioFs->ReadDepth = VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT;
+  } else if (VirtioFs->ReadDepth == 0) {
+    VirtioFs->ReadDepth = 1;
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "%a: Label=\"%s\" MaxRead=0x%x Readahead=0x%x "
+    "ReadDepth=%Lu\n", __FUNCTION__, VirtioFs->Label, VirtioFs->MaxRead,
+    VirtioFs->Readahead, (UINT64)VirtioFs->ReadDepth));
   return EFI_SUCCESS;
 }
@@ -34,6 +34,11 @@
 
   @param[out] FuseAttr     The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object
                            describing the properties of the resolved inode.
+                           FuseAttr is also stored in the attribute cache.
+
+  @param[out] EntryExpiry  The time, as calculated by VirtioFsCacheExpiry(),
+                           until which the device permits caching the
+                           resolution of Name to NodeId. Optional.
 
   @retval EFI_SUCCESS    Filename to inode resolution successful.
 
@@ -56,7 +61,8 @@ VirtioFsFuseLookup (
   IN     UINT64                             DirNodeId,
   IN     CHAR8                              *Name,
      OUT UINT64                             *NodeId,
-     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr,
+     OUT UINT64                             *EntryExpiry OPTIONAL
   )
 {
   VIRTIO_FS_FUSE_REQUEST        CommonReq;
@@ -141,6 +147,13 @@ VirtioFsFuseLookup (
   // Output the NodeId to which Name has been resolved to.
   //
   *NodeId = NodeResp.NodeId;
+  if (EntryExpiry != NULL) {
+    *EntryExpiry = VirtioFsCacheExpiry (VirtioFs, NodeResp.EntryValid,
+                     NodeResp.EntryValidNsec);
+  }
+  VirtioFsCacheStoreAttr (VirtioFs, NodeResp.NodeId, FuseAttr,
+    VirtioFsCacheExpiry (VirtioFs, NodeResp.AttrValid,
+      NodeResp.AttrValidNsec));
   return EFI_SUCCESS;
 
 Fail:
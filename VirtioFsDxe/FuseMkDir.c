@@ -112,6 +112,11 @@ VirtioFsFuseMkDir (
     return Status;
   }
 
+  //
+  // The parent directory's modification time may have changed.
+  //
+  VirtioFsCacheDropAttr (VirtioFs, ParentNodeId);
+
   //
   // Verify the response (all response buffers are fixed size).
   //
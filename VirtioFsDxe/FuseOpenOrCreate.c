@@ -131,6 +131,11 @@ VirtioFsFuseOpenOrCreate (
     return Status;
   }
 
+  //
+  // The parent directory's modification time may have changed.
+  //
+  VirtioFsCacheDropAttr (VirtioFs, ParentNodeId);
+
   //
   // Verify the response (all response buffers are fixed size).
   //
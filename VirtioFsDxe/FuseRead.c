@@ -6,8 +6,23 @@
   SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
+#include <Library/MemoryAllocationLib.h> // AllocatePool()
+
 #include "VirtioFsDxe.h"
 
+//
+// The request and response buffers of one FUSE_READ in a pipelined read.
+//
+typedef struct {
+  VIRTIO_FS_FUSE_REQUEST        CommonReq;
+  VIRTIO_FS_FUSE_READ_REQUEST   ReadReq;
+  VIRTIO_FS_IO_VECTOR           ReqIoVec[2];
+  VIRTIO_FS_SCATTER_GATHER_LIST ReqSgList;
+  VIRTIO_FS_FUSE_RESPONSE       CommonResp;
+  VIRTIO_FS_IO_VECTOR           RespIoVec[2];
+  VIRTIO_FS_SCATTER_GATHER_LIST RespSgList;
+} VIRTIO_FS_READ_SLOT;
+
 /**
   Read a chunk from a regular file or a directory stream, by sending the
   FUSE_READ / FUSE_READDIRPLUS request to the Virtio Filesystem device.
@@ -189,3 +204,180 @@ VirtioFsFuseReadFileOrDir (
   *Size = (UINT32)TailBufferFill;
   return EFI_SUCCESS;
 }
+
+/**
+  Read a range of a regular file, keeping several FUSE_READ requests in flight
+  on the request queues of the Virtio Filesystem device.
+
+  The range is split into pieces of "VirtioFs->MaxRead" bytes at most. Up to
+  "VirtioFs->ReadDepth" FUSE_READ requests are submitted at once with
+  VirtioFsSgListsSubmitBatch(), each one reading straight into its part of
+  Data. The responses are collected in file order; a short read marks EOF.
+
+  The function may only be called after VirtioFsFuseInitSession() returns
+  successfully and before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to send the FUSE_READ
+                           requests to. On output, the FUSE request counter
+                           "VirtioFs->RequestId" will have been incremented
+                           several times.
+
+  @param[in] NodeId        The inode number of the regular file to read from.
+
+  @param[in] FuseHandle    The open handle to the regular file to read from.
+
+  @param[in] Offset        The absolute file position at which to start
+                           reading.
+
+  @param[in,out] Size      On input, the number of bytes to read. On output
+                           (regardless of return value), the number of bytes
+                           actually read, which is smaller than the value on
+                           input if EOF has been reached or an error occurred.
+
+  @param[out] Data         Buffer to read the bytes from the regular file into.
+                           The caller is responsible for providing room for (at
+                           least) as many bytes in Data as Size is on input.
+
+  @retval EFI_SUCCESS           Some bytes have been read, or EOF has been
+                                reached, or Size was zero on input. The caller
+                                is responsible for checking Size to learn the
+                                actual byte count transferred.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       The "errno" value mapped to an EFI_STATUS
+                                code, if the Virtio Filesystem device
+                                explicitly reported an error for the first
+                                FUSE_READ request.
+
+  @return                       Error codes propagated from
+                                VirtioFsSgListsValidate(),
+                                VirtioFsFuseNewRequest(),
+                                VirtioFsSgListsSubmitBatch(),
+                                VirtioFsFuseCheckResponse(), if no bytes have
+                                been read.
+**/
+EFI_STATUS
+VirtioFsFuseReadFile (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId,
+  IN     UINT64    FuseHandle,
+  IN     UINT64    Offset,
+  IN OUT UINTN     *Size,
+     OUT VOID      *Data
+  )
+{
+  VIRTIO_FS_READ_SLOT *Slots;
+  VIRTIO_FS_READ_SLOT *Slot;
+  VIRTIO_FS_EXCHANGE  Exchanges[VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT];
+  UINTN               NumSlots;
+  UINTN               Idx;
+  UINTN               Transferred;
+  UINTN               Queued;
+  UINTN               TailBufferFill;
+  BOOLEAN             Done;
+  EFI_STATUS          Status;
+
+  ASSERT (VirtioFs->ReadDepth <= ARRAY_SIZE (Exchanges));
+
+  Slots = AllocatePool (VirtioFs->ReadDepth * sizeof *Slots);
+  if (Slots == NULL) {
+    *Size = 0;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status      = EFI_SUCCESS;
+  Transferred = 0;
+  Done        = FALSE;
+  while (!Done && Transferred < *Size) {
+    //
+    // Fill the pipeline with FUSE_READ requests for the next pieces.
+    //
+    Queued = Transferred;
+    for (NumSlots = 0;
+         NumSlots < VirtioFs->ReadDepth && Queued < *Size;
+         NumSlots++) {
+      Slot = &Slots[NumSlots];
+
+      Slot->ReqIoVec[0].Buffer = &Slot->CommonReq;
+      Slot->ReqIoVec[0].Size   = sizeof Slot->CommonReq;
+      Slot->ReqIoVec[1].Buffer = &Slot->ReadReq;
+      Slot->ReqIoVec[1].Size   = sizeof Slot->ReadReq;
+      Slot->ReqSgList.IoVec    = Slot->ReqIoVec;
+      Slot->ReqSgList.NumVec   = ARRAY_SIZE (Slot->ReqIoVec);
+
+      Slot->RespIoVec[0].Buffer = &Slot->CommonResp;
+      Slot->RespIoVec[0].Size   = sizeof Slot->CommonResp;
+      Slot->RespIoVec[1].Buffer = (UINT8 *)Data + Queued;
+      Slot->RespIoVec[1].Size   = MIN (*Size - Queued,
+                                    (UINTN)VirtioFs->MaxRead);
+      Slot->RespSgList.IoVec    = Slot->RespIoVec;
+      Slot->RespSgList.NumVec   = ARRAY_SIZE (Slot->RespIoVec);
+
+      Status = VirtioFsSgListsValidate (VirtioFs, &Slot->ReqSgList,
+                 &Slot->RespSgList);
+      if (EFI_ERROR (Status)) {
+        goto FreeSlots;
+      }
+
+      Status = VirtioFsFuseNewRequest (VirtioFs, &Slot->CommonReq,
+                 Slot->ReqSgList.TotalSize, VirtioFsFuseOpRead, NodeId);
+      if (EFI_ERROR (Status)) {
+        goto FreeSlots;
+      }
+
+      Slot->ReadReq.FileHandle = FuseHandle;
+      Slot->ReadReq.Offset     = Offset + Queued;
+      Slot->ReadReq.Size       = (UINT32)Slot->RespIoVec[1].Size;
+      Slot->ReadReq.ReadFlags  = 0;
+      Slot->ReadReq.LockOwner  = 0;
+      Slot->ReadReq.Flags      = 0;
+      Slot->ReadReq.Padding    = 0;
+
+      Exchanges[NumSlots].RequestSgList  = &Slot->ReqSgList;
+      Exchanges[NumSlots].ResponseSgList = &Slot->RespSgList;
+      Queued += Slot->RespIoVec[1].Size;
+    }
+
+    Status = VirtioFsSgListsSubmitBatch (VirtioFs, Exchanges, NumSlots);
+    if (EFI_ERROR (Status)) {
+      goto FreeSlots;
+    }
+
+    //
+    // Collect the responses in file order. After a short read (EOF) or a
+    // failed read, the data in the later pieces is not contiguous with what
+    // has been read, so it is dropped.
+    //
+    for (Idx = 0; Idx < NumSlots; Idx++) {
+      Slot = &Slots[Idx];
+      Status = VirtioFsFuseCheckResponse (&Slot->RespSgList,
+                 Slot->CommonReq.Unique, &TailBufferFill);
+      if (EFI_ERROR (Status)) {
+        if (Status == EFI_DEVICE_ERROR) {
+          DEBUG ((DEBUG_ERROR, "%a: Label=\"%s\" NodeId=%Lu FuseHandle=%Lu "
+            "Offset=0x%Lx Size=0x%x Errno=%d\n", __FUNCTION__,
+            VirtioFs->Label, NodeId, FuseHandle, Slot->ReadReq.Offset,
+            Slot->ReadReq.Size, Slot->CommonResp.Error));
+          Status = VirtioFsErrnoToEfiStatus (Slot->CommonResp.Error);
+        }
+        goto FreeSlots;
+      }
+      Transferred += TailBufferFill;
+      if (TailBufferFill < Slot->ReadReq.Size) {
+        Done = TRUE;
+        break;
+      }
+    }
+  }
+
+FreeSlots:
+  FreePool (Slots);
+
+  *Size = Transferred;
+  //
+  // If we managed to read some data, return success. Otherwise, return the
+  // error due to which zero bytes were transferred (if any).
+  //
+  return (Transferred > 0) ? EFI_SUCCESS : Status;
+}
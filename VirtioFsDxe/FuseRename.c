@@ -116,6 +116,11 @@ VirtioFsFuseRename (
     return Status;
   }
 
+  //
+  // The directory tree may have changed.
+  //
+  VirtioFsCacheInvalidate (VirtioFs);
+
   //
   // Verify the response (all response buffers are fixed size).
   //
@@ -148,6 +148,12 @@ VirtioFsFuseSetAttr (
     return Status;
   }
 
+  //
+  // The attributes, and with the size, the file contents may have changed.
+  //
+  VirtioFsCacheDropAttr (VirtioFs, NodeId);
+  VirtioFsCacheDropData (VirtioFs, NodeId);
+
   //
   // Verify the response (all response buffers are fixed size).
   //
@@ -100,6 +100,11 @@ VirtioFsFuseRemoveFileOrDir (
     return Status;
   }
 
+  //
+  // The directory tree may have changed.
+  //
+  VirtioFsCacheInvalidate (VirtioFs);
+
   //
   // Verify the response (all response buffers are fixed size).
   //
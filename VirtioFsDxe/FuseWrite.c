@@ -132,6 +132,12 @@ VirtioFsFuseWrite (
     return Status;
   }
 
+  //
+  // The file contents, size and modification time may have changed.
+  //
+  VirtioFsCacheDropAttr (VirtioFs, NodeId);
+  VirtioFsCacheDropData (VirtioFs, NodeId);
+
   //
   // Verify the response (all response buffers are fixed size).
   //
@@ -6,11 +6,12 @@
   SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
-#include <Library/BaseLib.h>             // StrLen()
-#include <Library/BaseMemoryLib.h>       // CopyMem()
-#include <Library/MemoryAllocationLib.h> // AllocatePool()
-#include <Library/TimeBaseLib.h>         // EpochToEfiTime()
-#include <Library/VirtioLib.h>           // Virtio10WriteFeatures()
+#include <Library/BaseLib.h>                  // StrLen()
+#include <Library/BaseMemoryLib.h>            // CopyMem()
+#include <Library/MemoryAllocationLib.h>      // AllocatePool()
+#include <Library/TimeBaseLib.h>              // EpochToEfiTime()
+#include <Library/UefiBootServicesTableLib.h> // gBS
+#include <Library/VirtioLib.h>                // Virtio10WriteFeatures()
 
 #include "VirtioFsDxe.h"
 
@@ -86,6 +87,8 @@ VirtioFsInit (
   UINT64           Features;
   VIRTIO_FS_CONFIG Config;
   UINTN            Idx;
+  UINT16           QueueIdx;
+  UINT16           QueueSize;
   UINT64           RingBaseShift;
 
   //
@@ -172,52 +175,65 @@ VirtioFsInit (
   VirtioFs->Label[Idx] = L'\0';
 
   //
-  // 7.b. We need one queue for sending normal priority requests.
+  // 7.b. We need one queue for sending normal priority requests. Further
+  // queues, up to VIRTIO_FS_MAX_REQUEST_QUEUES, let pipelined reads be
+  // processed by the device in parallel.
   //
   if (Config.NumReqQueues < 1) {
     Status = EFI_UNSUPPORTED;
     goto Failed;
   }
+  VirtioFs->NumQueues = (UINT16)MIN (Config.NumReqQueues,
+                                  VIRTIO_FS_MAX_REQUEST_QUEUES);
 
   //
-  // 7.c. Fetch and remember the number of descriptors we can place on the
-  // queue at once. We'll need two descriptors per request, as a minimum --
-  // request header, response header.
+  // The first queue that fails to set up causes all the others to be torn
+  // down as well.
   //
-  Status = VirtioFs->Virtio->SetQueueSel (VirtioFs->Virtio,
-                               VIRTIO_FS_REQUEST_QUEUE);
-  if (EFI_ERROR (Status)) {
-    goto Failed;
-  }
-  Status = VirtioFs->Virtio->GetQueueNumMax (VirtioFs->Virtio,
-                               &VirtioFs->QueueSize);
-  if (EFI_ERROR (Status)) {
-    goto Failed;
-  }
-  if (VirtioFs->QueueSize < 2) {
-    Status = EFI_UNSUPPORTED;
-    goto Failed;
-  }
+  VirtioFs->QueueSize = MAX_UINT16;
+  for (QueueIdx = 0; QueueIdx < VirtioFs->NumQueues; QueueIdx++) {
+    //
+    // 7.c. Fetch the number of descriptors we can place on the queue at once.
+    // We'll need two descriptors per request, as a minimum -- request header,
+    // response header. Remember the smallest such number across the queues.
+    //
+    Status = VirtioFs->Virtio->SetQueueSel (
+                                 VirtioFs->Virtio,
+                                 (UINT16)(VIRTIO_FS_REQUEST_QUEUE + QueueIdx)
+                                 );
+    if (EFI_ERROR (Status)) {
+      goto ReleaseQueues;
+    }
+    Status = VirtioFs->Virtio->GetQueueNumMax (VirtioFs->Virtio, &QueueSize);
+    if (EFI_ERROR (Status)) {
+      goto ReleaseQueues;
+    }
+    if (QueueSize < 2) {
+      Status = EFI_UNSUPPORTED;
+      goto ReleaseQueues;
+    }
+    VirtioFs->QueueSize = MIN (VirtioFs->QueueSize, QueueSize);
 
-  //
-  // 7.d. [...] population of virtqueues [...]
-  //
-  Status = VirtioRingInit (VirtioFs->Virtio, VirtioFs->QueueSize,
-             &VirtioFs->Ring);
-  if (EFI_ERROR (Status)) {
-    goto Failed;
-  }
+    //
+    // 7.d. [...] population of virtqueues [...]
+    //
+    Status = VirtioRingInit (VirtioFs->Virtio, QueueSize,
+               &VirtioFs->Ring[QueueIdx]);
+    if (EFI_ERROR (Status)) {
+      goto ReleaseQueues;
+    }
 
-  Status = VirtioRingMap (VirtioFs->Virtio, &VirtioFs->Ring, &RingBaseShift,
-             &VirtioFs->RingMap);
-  if (EFI_ERROR (Status)) {
-    goto ReleaseQueue;
-  }
+    Status = VirtioRingMap (VirtioFs->Virtio, &VirtioFs->Ring[QueueIdx],
+               &RingBaseShift, &VirtioFs->RingMap[QueueIdx]);
+    if (EFI_ERROR (Status)) {
+      goto ReleaseQueue;
+    }
 
-  Status = VirtioFs->Virtio->SetQueueAddress (VirtioFs->Virtio,
-                               &VirtioFs->Ring, RingBaseShift);
-  if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    Status = VirtioFs->Virtio->SetQueueAddress (VirtioFs->Virtio,
+                                 &VirtioFs->Ring[QueueIdx], RingBaseShift);
+    if (EFI_ERROR (Status)) {
+      goto UnmapQueue;
+    }
   }
 
   //
@@ -226,16 +242,25 @@ VirtioFsInit (
   NextDevStat |= VSTAT_DRIVER_OK;
   Status = VirtioFs->Virtio->SetDeviceStatus (VirtioFs->Virtio, NextDevStat);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto ReleaseQueues;
   }
 
   return EFI_SUCCESS;
 
 UnmapQueue:
-  VirtioFs->Virtio->UnmapSharedBuffer (VirtioFs->Virtio, VirtioFs->RingMap);
+  VirtioFs->Virtio->UnmapSharedBuffer (VirtioFs->Virtio,
+                      VirtioFs->RingMap[QueueIdx]);
 
 ReleaseQueue:
-  VirtioRingUninit (VirtioFs->Virtio, &VirtioFs->Ring);
+  VirtioRingUninit (VirtioFs->Virtio, &VirtioFs->Ring[QueueIdx]);
+
+ReleaseQueues:
+  while (QueueIdx > 0) {
+    --QueueIdx;
+    VirtioFs->Virtio->UnmapSharedBuffer (VirtioFs->Virtio,
+                        VirtioFs->RingMap[QueueIdx]);
+    VirtioRingUninit (VirtioFs->Virtio, &VirtioFs->Ring[QueueIdx]);
+  }
 
 Failed:
   //
@@ -265,13 +290,18 @@ VirtioFsUninit (
   IN OUT VIRTIO_FS *VirtioFs
   )
 {
+  UINT16 QueueIdx;
+
   //
   // Resetting the Virtio device makes it release its resources and forget its
   // configuration.
   //
   VirtioFs->Virtio->SetDeviceStatus (VirtioFs->Virtio, 0);
-  VirtioFs->Virtio->UnmapSharedBuffer (VirtioFs->Virtio, VirtioFs->RingMap);
-  VirtioRingUninit (VirtioFs->Virtio, &VirtioFs->Ring);
+  for (QueueIdx = 0; QueueIdx < VirtioFs->NumQueues; QueueIdx++) {
+    VirtioFs->Virtio->UnmapSharedBuffer (VirtioFs->Virtio,
+                        VirtioFs->RingMap[QueueIdx]);
+    VirtioRingUninit (VirtioFs->Virtio, &VirtioFs->Ring[QueueIdx]);
+  }
 }
 
 /**
@@ -454,85 +484,54 @@ VirtioFsSgListsValidate (
   return EFI_SUCCESS;
 }
 
-/**
-  Submit a validated pair of (request buffer list, response buffer list) to the
-  Virtio Filesystem device.
-
-  On input, the pair of VIRTIO_FS_SCATTER_GATHER_LIST objects must have been
-  validated together, using the VirtioFsSgListsValidate() function.
-
-  On output (on successful return), the following fields will be re-initialized
-  to zero (after temporarily setting them to different values):
-  - VIRTIO_FS_IO_VECTOR.Mapped,
-  - VIRTIO_FS_IO_VECTOR.MappedAddress,
-  - VIRTIO_FS_IO_VECTOR.Mapping.
+//
+// Mapping operations and descriptor flags for the two scatter-gather lists of
+// an exchange: the request is read, the response is written by the device.
+//
+STATIC CONST VIRTIO_MAP_OPERATION mSgListVirtioMapOp[] = {
+  VirtioOperationBusMasterRead,
+  VirtioOperationBusMasterWrite
+};
 
-  On output (on successful return), the following fields will be calculated:
-  - VIRTIO_FS_IO_VECTOR.Transferred.
+STATIC CONST UINT16 mSgListDescriptorFlag[] = {
+  0,
+  VRING_DESC_F_WRITE
+};
 
-  The function may only be called after VirtioFsInit() returns successfully and
-  before VirtioFsUninit() is called.
+/**
+  Map all IO Vectors of a validated request-response exchange for the Virtio
+  Filesystem device.
 
-  @param[in,out] VirtioFs        The Virtio Filesystem device that the
-                                 request-response exchange, expressed via
-                                 RequestSgList and ResponseSgList, should now
-                                 be submitted to.
+  @param[in] VirtioFs      The Virtio Filesystem device to map the IO Vectors
+                           for.
 
-  @param[in,out] RequestSgList   The scatter-gather list that describes the
-                                 request part of the exchange -- the buffers
-                                 that should be sent to the Virtio Filesystem
-                                 device in the virtio transfer.
+  @param[in,out] Exchange  The exchange whose IO Vectors should be mapped. On
+                           output, regardless of return value,
+                           VIRTIO_FS_IO_VECTOR.Mapped identifies the IO Vectors
+                           that VirtioFsExchangeUnmap() has to unmap.
 
-  @param[in,out] ResponseSgList  The scatter-gather list that describes the
-                                 response part of the exchange -- the buffers
-                                 that the Virtio Filesystem device should
-                                 populate in the virtio transfer. May be NULL
-                                 if and only if NULL was passed to
-                                 VirtioFsSgListsValidate() as ResponseSgList.
+  @retval EFI_SUCCESS  All IO Vectors have been mapped.
 
-  @retval EFI_SUCCESS       Transfer complete. The caller should investigate
-                            the VIRTIO_FS_IO_VECTOR.Transferred fields in
-                            ResponseSgList, to ensure coverage of the relevant
-                            response buffers. Subsequently, the caller should
-                            investigate the contents of those buffers.
-
-  @retval EFI_DEVICE_ERROR  The Virtio Filesystem device reported populating
-                            more response bytes than ResponseSgList->TotalSize.
-
-  @return                   Error codes propagated from
-                            VirtioMapAllBytesInSharedBuffer(), VirtioFlush(),
-                            or VirtioFs->Virtio->UnmapSharedBuffer().
+  @return              Error codes propagated from
+                       VirtioMapAllBytesInSharedBuffer().
 **/
+STATIC
 EFI_STATUS
-VirtioFsSgListsSubmit (
-  IN OUT VIRTIO_FS                     *VirtioFs,
-  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST *RequestSgList,
-  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST *ResponseSgList OPTIONAL
+VirtioFsExchangeMap (
+  IN     VIRTIO_FS          *VirtioFs,
+  IN OUT VIRTIO_FS_EXCHANGE *Exchange
   )
 {
   VIRTIO_FS_SCATTER_GATHER_LIST *SgListParam[2];
-  VIRTIO_MAP_OPERATION          SgListVirtioMapOp[ARRAY_SIZE (SgListParam)];
-  UINT16                        SgListDescriptorFlag[ARRAY_SIZE (SgListParam)];
   UINTN                         ListId;
   VIRTIO_FS_SCATTER_GATHER_LIST *SgList;
   UINTN                         IoVecIdx;
   VIRTIO_FS_IO_VECTOR           *IoVec;
   EFI_STATUS                    Status;
-  DESC_INDICES                  Indices;
-  UINT32                        TotalBytesWrittenByDevice;
-  UINT32                        BytesPermittedForWrite;
-
-  SgListParam[0]          = RequestSgList;
-  SgListVirtioMapOp[0]    = VirtioOperationBusMasterRead;
-  SgListDescriptorFlag[0] = 0;
 
-  SgListParam[1]          = ResponseSgList;
-  SgListVirtioMapOp[1]    = VirtioOperationBusMasterWrite;
-  SgListDescriptorFlag[1] = VRING_DESC_F_WRITE;
+  SgListParam[0] = Exchange->RequestSgList;
+  SgListParam[1] = Exchange->ResponseSgList;
 
-  //
-  // Map all IO Vectors.
-  //
   for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
     SgList = SgListParam[ListId];
     if (SgList == NULL) {
@@ -545,23 +544,52 @@ VirtioFsSgListsSubmit (
       //
       Status = VirtioMapAllBytesInSharedBuffer (
                  VirtioFs->Virtio,
-                 SgListVirtioMapOp[ListId],
+                 mSgListVirtioMapOp[ListId],
                  IoVec->Buffer,
                  IoVec->Size,
                  &IoVec->MappedAddress,
                  &IoVec->Mapping
                  );
       if (EFI_ERROR (Status)) {
-        goto Unmap;
+        return Status;
       }
       IoVec->Mapped = TRUE;
     }
   }
+  return EFI_SUCCESS;
+}
+
+/**
+  Append the descriptor chain of a mapped request-response exchange to a
+  virtio ring.
+
+  @param[in,out] Ring     The virtio ring to append the descriptor chain to.
+
+  @param[in] Exchange     The exchange whose IO Vectors have been mapped with
+                          VirtioFsExchangeMap().
+
+  @param[in,out] Indices  On input, Indices->NextDescIdx identifies the
+                          descriptor to carry the first IO Vector. On output,
+                          Indices->NextDescIdx identifies the descriptor after
+                          the last one appended.
+**/
+STATIC
+VOID
+VirtioFsExchangeAppend (
+  IN OUT VRING              *Ring,
+  IN     VIRTIO_FS_EXCHANGE *Exchange,
+  IN OUT DESC_INDICES       *Indices
+  )
+{
+  VIRTIO_FS_SCATTER_GATHER_LIST *SgListParam[2];
+  UINTN                         ListId;
+  VIRTIO_FS_SCATTER_GATHER_LIST *SgList;
+  UINTN                         IoVecIdx;
+  VIRTIO_FS_IO_VECTOR           *IoVec;
+
+  SgListParam[0] = Exchange->RequestSgList;
+  SgListParam[1] = Exchange->ResponseSgList;
 
-  //
-  // Compose the descriptor chain.
-  //
-  VirtioPrepare (&VirtioFs->Ring, &Indices);
   for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
     SgList = SgListParam[ListId];
     if (SgList == NULL) {
@@ -575,41 +603,67 @@ VirtioFsSgListsSubmit (
       // Set VRING_DESC_F_NEXT on all except the very last descriptor.
       //
       NextFlag = VRING_DESC_F_NEXT;
-      if (ListId == ARRAY_SIZE (SgListParam) - 1 &&
+      if ((ListId == ARRAY_SIZE (SgListParam) - 1 ||
+           SgListParam[ListId + 1] == NULL) &&
           IoVecIdx == SgList->NumVec - 1) {
         NextFlag = 0;
       }
       VirtioAppendDesc (
-        &VirtioFs->Ring,
+        Ring,
         IoVec->MappedAddress,
         (UINT32)IoVec->Size,
-        SgListDescriptorFlag[ListId] | NextFlag,
-        &Indices
+        mSgListDescriptorFlag[ListId] | NextFlag,
+        Indices
         );
     }
   }
+}
 
-  //
-  // Submit the descriptor chain.
-  //
-  Status = VirtioFlush (VirtioFs->Virtio, VIRTIO_FS_REQUEST_QUEUE,
-             &VirtioFs->Ring, &Indices, &TotalBytesWrittenByDevice);
-  if (EFI_ERROR (Status)) {
-    goto Unmap;
-  }
+/**
+  Calculate the transfer sizes in the IO Vectors of a request-response
+  exchange that the Virtio Filesystem device has processed.
+
+  @param[in,out] Exchange               The exchange processed by the device.
+
+  @param[in] TotalBytesWrittenByDevice  The total number of bytes that the
+                                        device reported writing, across all
+                                        response buffers.
+
+  @retval EFI_SUCCESS       VIRTIO_FS_IO_VECTOR.Transferred has been set in all
+                            IO Vectors.
+
+  @retval EFI_DEVICE_ERROR  The Virtio Filesystem device reported populating
+                            more response bytes than the response buffers
+                            could hold.
+**/
+STATIC
+EFI_STATUS
+VirtioFsExchangeComplete (
+  IN OUT VIRTIO_FS_EXCHANGE *Exchange,
+  IN     UINT32             TotalBytesWrittenByDevice
+  )
+{
+  VIRTIO_FS_SCATTER_GATHER_LIST *SgListParam[2];
+  UINTN                         ListId;
+  VIRTIO_FS_SCATTER_GATHER_LIST *SgList;
+  UINTN                         IoVecIdx;
+  VIRTIO_FS_IO_VECTOR           *IoVec;
+  UINT32                        BytesPermittedForWrite;
+
+  SgListParam[0] = Exchange->RequestSgList;
+  SgListParam[1] = Exchange->ResponseSgList;
 
   //
   // Sanity-check: the Virtio Filesystem device should not have written more
   // bytes than what we offered buffers for.
   //
-  if (ResponseSgList == NULL) {
+  if (Exchange->ResponseSgList == NULL) {
     BytesPermittedForWrite = 0;
   } else {
-    BytesPermittedForWrite = ResponseSgList->TotalSize;
+    BytesPermittedForWrite = Exchange->ResponseSgList->TotalSize;
   }
   if (TotalBytesWrittenByDevice > BytesPermittedForWrite) {
-    Status = EFI_DEVICE_ERROR;
-    goto Unmap;
+    return EFI_DEVICE_ERROR;
   }
 
   //
@@ -622,7 +676,7 @@ VirtioFsSgListsSubmit (
     }
     for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
       IoVec = &SgList->IoVec[IoVecIdx];
-      if (SgListVirtioMapOp[ListId] == VirtioOperationBusMasterRead) {
+      if (mSgListVirtioMapOp[ListId] == VirtioOperationBusMasterRead) {
         //
         // We report that the Virtio Filesystem device has read all buffers in
         // the request.
@@ -632,7 +686,7 @@ VirtioFsSgListsSubmit (
         //
         // Regarding the response, calculate how much of the current IO Vector
         // has been populated by the Virtio Filesystem device. In
-        // "TotalBytesWrittenByDevice", VirtioFlush() reported the total count
+        // "TotalBytesWrittenByDevice", the device reported the total count
         // across all device-writeable descriptors, in the order they were
         // chained on the ring.
         //
@@ -647,14 +701,42 @@ VirtioFsSgListsSubmit (
   // By now, "TotalBytesWrittenByDevice" has been exhausted.
   //
   ASSERT (TotalBytesWrittenByDevice == 0);
+  return EFI_SUCCESS;
+}
+
+/**
+  Unmap the mapped IO Vectors of a request-response exchange.
+
+  @param[in] VirtioFs      The Virtio Filesystem device that the IO Vectors
+                           have been mapped for.
+
+  @param[in,out] Exchange  The exchange whose IO Vectors should be unmapped.
+
+  @param[in] Status        The status of the exchange so far.
+
+  @return  Status, if it is an error code already, or if all IO Vectors could
+           be unmapped. Otherwise, the error code propagated from
+           VirtioFs->Virtio->UnmapSharedBuffer().
+**/
+STATIC
+EFI_STATUS
+VirtioFsExchangeUnmap (
+  IN     VIRTIO_FS          *VirtioFs,
+  IN OUT VIRTIO_FS_EXCHANGE *Exchange,
+  IN     EFI_STATUS         Status
+  )
+{
+  VIRTIO_FS_SCATTER_GATHER_LIST *SgListParam[2];
+  UINTN                         ListId;
+  VIRTIO_FS_SCATTER_GATHER_LIST *SgList;
+  UINTN                         IoVecIdx;
+  VIRTIO_FS_IO_VECTOR           *IoVec;
+
+  SgListParam[0] = Exchange->RequestSgList;
+  SgListParam[1] = Exchange->ResponseSgList;
 
   //
-  // We've succeeded; fall through.
-  //
-Unmap:
-  //
-  // Unmap all mapped IO Vectors on both the success and the error paths. The
-  // unmapping occurs in reverse order of mapping, in an attempt to avoid
+  // The unmapping occurs in reverse order of mapping, in an attempt to avoid
   // memory fragmentation.
   //
   ListId = ARRAY_SIZE (SgListParam);
@@ -703,6 +785,322 @@ Unmap:
   return Status;
 }
 
+/**
+  Submit a validated pair of (request buffer list, response buffer list) to the
+  Virtio Filesystem device.
+
+  On input, the pair of VIRTIO_FS_SCATTER_GATHER_LIST objects must have been
+  validated together, using the VirtioFsSgListsValidate() function.
+
+  On output (on successful return), the following fields will be re-initialized
+  to zero (after temporarily setting them to different values):
+  - VIRTIO_FS_IO_VECTOR.Mapped,
+  - VIRTIO_FS_IO_VECTOR.MappedAddress,
+  - VIRTIO_FS_IO_VECTOR.Mapping.
+
+  On output (on successful return), the following fields will be calculated:
+  - VIRTIO_FS_IO_VECTOR.Transferred.
+
+  The function may only be called after VirtioFsInit() returns successfully and
+  before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs        The Virtio Filesystem device that the
+                                 request-response exchange, expressed via
+                                 RequestSgList and ResponseSgList, should now
+                                 be submitted to.
+
+  @param[in,out] RequestSgList   The scatter-gather list that describes the
+                                 request part of the exchange -- the buffers
+                                 that should be sent to the Virtio Filesystem
+                                 device in the virtio transfer.
+
+  @param[in,out] ResponseSgList  The scatter-gather list that describes the
+                                 response part of the exchange -- the buffers
+                                 that the Virtio Filesystem device should
+                                 populate in the virtio transfer. May be NULL
+                                 if and only if NULL was passed to
+                                 VirtioFsSgListsValidate() as ResponseSgList.
+
+  @retval EFI_SUCCESS       Transfer complete. The caller should investigate
+                            the VIRTIO_FS_IO_VECTOR.Transferred fields in
+                            ResponseSgList, to ensure coverage of the relevant
+                            response buffers. Subsequently, the caller should
+                            investigate the contents of those buffers.
+
+  @retval EFI_DEVICE_ERROR  The Virtio Filesystem device reported populating
+                            more response bytes than ResponseSgList->TotalSize.
+
+  @return                   Error codes propagated from
+                            VirtioMapAllBytesInSharedBuffer(), VirtioFlush(),
+                            or VirtioFs->Virtio->UnmapSharedBuffer().
+**/
+EFI_STATUS
+VirtioFsSgListsSubmit (
+  IN OUT VIRTIO_FS                     *VirtioFs,
+  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST *RequestSgList,
+  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST *ResponseSgList OPTIONAL
+  )
+{
+  VIRTIO_FS_EXCHANGE Exchange;
+  EFI_STATUS         Status;
+  DESC_INDICES       Indices;
+  UINT32             TotalBytesWrittenByDevice;
+
+  Exchange.RequestSgList  = RequestSgList;
+  Exchange.ResponseSgList = ResponseSgList;
+
+  //
+  // Map all IO Vectors.
+  //
+  Status = VirtioFsExchangeMap (VirtioFs, &Exchange);
+  if (EFI_ERROR (Status)) {
+    goto Unmap;
+  }
+
+  //
+  // Compose the descriptor chain on the first request queue.
+  //
+  VirtioPrepare (&VirtioFs->Ring[0], &Indices);
+  VirtioFsExchangeAppend (&VirtioFs->Ring[0], &Exchange, &Indices);
+
+  //
+  // Submit the descriptor chain.
+  //
+  Status = VirtioFlush (VirtioFs->Virtio, VIRTIO_FS_REQUEST_QUEUE,
+             &VirtioFs->Ring[0], &Indices, &TotalBytesWrittenByDevice);
+  if (EFI_ERROR (Status)) {
+    goto Unmap;
+  }
+
+  Status = VirtioFsExchangeComplete (&Exchange, TotalBytesWrittenByDevice);
+
+  //
+  // Fall through.
+  //
+Unmap:
+  //
+  // Unmap all mapped IO Vectors on both the success and the error paths.
+  //
+  return VirtioFsExchangeUnmap (VirtioFs, &Exchange, Status);
+}
+
+/**
+  Submit a batch of validated request-response exchanges to the Virtio
+  Filesystem device, keeping all of them in flight at the same time.
+
+  The exchanges are distributed over the request queues in round-robin order,
+  and their descriptor chains are placed on the rings side by side. The device
+  is notified once per queue, and the function waits until the device has
+  processed all exchanges. The device may process (and complete) the exchanges
+  in any order.
+
+  On input, the scatter-gather lists of each exchange must have been validated
+  together, using the VirtioFsSgListsValidate() function. On output, the
+  VIRTIO_FS_IO_VECTOR fields are updated like in VirtioFsSgListsSubmit().
+
+  The function may only be called after VirtioFsInit() returns successfully and
+  before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs   The Virtio Filesystem device that the exchanges
+                            should now be submitted to.
+
+  @param[in,out] Exchanges  The array of exchanges to submit.
+
+  @param[in] NumExchanges   The number of elements in Exchanges.
+
+  @retval EFI_SUCCESS            Transfer complete for all exchanges. The
+                                 caller should investigate the response
+                                 buffers of each exchange, like after
+                                 VirtioFsSgListsSubmit().
+
+  @retval EFI_INVALID_PARAMETER  NumExchanges is zero, or it exceeds
+                                 VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT.
+
+  @retval EFI_UNSUPPORTED        The descriptor chains assigned to a request
+                                 queue do not fit on its ring together.
+
+  @retval EFI_DEVICE_ERROR       The Virtio Filesystem device completed an
+                                 unknown descriptor chain, or it reported
+                                 populating more response bytes than an
+                                 exchange could hold.
+
+  @return                        Error codes propagated from
+                                 VirtioMapAllBytesInSharedBuffer(),
+                                 VirtioFs->Virtio->SetQueueNotify(), or
+                                 VirtioFs->Virtio->UnmapSharedBuffer().
+**/
+EFI_STATUS
+VirtioFsSgListsSubmitBatch (
+  IN OUT VIRTIO_FS          *VirtioFs,
+  IN OUT VIRTIO_FS_EXCHANGE *Exchanges,
+  IN     UINTN              NumExchanges
+  )
+{
+  UINTN        NumDescs[VIRTIO_FS_MAX_REQUEST_QUEUES];
+  DESC_INDICES Indices[VIRTIO_FS_MAX_REQUEST_QUEUES];
+  UINT16       FirstAvailIdx[VIRTIO_FS_MAX_REQUEST_QUEUES];
+  UINT16       NextAvailIdx[VIRTIO_FS_MAX_REQUEST_QUEUES];
+  UINT16       HeadDescIdx[VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT];
+  UINT32       UsedLen[VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT];
+  UINTN        NumQueues;
+  UINTN        NumNotified;
+  UINTN        QueueIdx;
+  UINTN        Idx;
+  VRING        *Ring;
+  EFI_STATUS   Status;
+  UINTN        PollPeriodUsecs;
+  BOOLEAN      Pending;
+  UINT16       UsedIdx;
+
+  if (NumExchanges == 0 || NumExchanges > VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT) {
+    return EFI_INVALID_PARAMETER;
+  }
+  NumQueues = MIN ((UINTN)VirtioFs->NumQueues, NumExchanges);
+
+  //
+  // Exchange #N goes to queue #(N % NumQueues). Make sure that each queue can
+  // take all of its descriptor chains at once.
+  //
+  ZeroMem (NumDescs, sizeof NumDescs);
+  for (Idx = 0; Idx < NumExchanges; Idx++) {
+    NumDescs[Idx % NumQueues] += Exchanges[Idx].RequestSgList->NumVec;
+    if (Exchanges[Idx].ResponseSgList != NULL) {
+      NumDescs[Idx % NumQueues] += Exchanges[Idx].ResponseSgList->NumVec;
+    }
+  }
+  for (QueueIdx = 0; QueueIdx < NumQueues; QueueIdx++) {
+    if (NumDescs[QueueIdx] > VirtioFs->Ring[QueueIdx].QueueSize) {
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  //
+  // Map all IO Vectors of all exchanges.
+  //
+  for (Idx = 0; Idx < NumExchanges; Idx++) {
+    Status = VirtioFsExchangeMap (VirtioFs, &Exchanges[Idx]);
+    if (EFI_ERROR (Status)) {
+      goto Unmap;
+    }
+  }
+
+  //
+  // Compose the descriptor chains, and make their heads available. Each ring
+  // is used exclusively by this batch until all exchanges complete, so the
+  // chains can start at descriptor #0, following each other.
+  //
+  for (QueueIdx = 0; QueueIdx < NumQueues; QueueIdx++) {
+    Ring = &VirtioFs->Ring[QueueIdx];
+    VirtioPrepare (Ring, &Indices[QueueIdx]);
+    FirstAvailIdx[QueueIdx] = *Ring->Avail.Idx;
+    NextAvailIdx[QueueIdx]  = FirstAvailIdx[QueueIdx];
+  }
+  for (Idx = 0; Idx < NumExchanges; Idx++) {
+    QueueIdx = Idx % NumQueues;
+    Ring     = &VirtioFs->Ring[QueueIdx];
+
+    HeadDescIdx[Idx] = Indices[QueueIdx].NextDescIdx % Ring->QueueSize;
+    VirtioFsExchangeAppend (Ring, &Exchanges[Idx], &Indices[QueueIdx]);
+    Ring->Avail.Ring[NextAvailIdx[QueueIdx]++ % Ring->QueueSize] =
+      HeadDescIdx[Idx];
+  }
+
+  //
+  // Publish the new available indices, and notify the device about each
+  // queue.
+  //
+  for (NumNotified = 0; NumNotified < NumQueues; NumNotified++) {
+    Ring = &VirtioFs->Ring[NumNotified];
+    MemoryFence ();
+    *Ring->Avail.Idx = NextAvailIdx[NumNotified];
+    MemoryFence ();
+    Status = VirtioFs->Virtio->SetQueueNotify (VirtioFs->Virtio,
+                                 (UINT16)(VIRTIO_FS_REQUEST_QUEUE +
+                                          NumNotified));
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  //
+  // Wait until the device processes all descriptor chains on the notified
+  // queues. Keep slowing down until we reach a poll period of slightly above
+  // 1 ms.
+  //
+  PollPeriodUsecs = 1;
+  for (;;) {
+    MemoryFence ();
+    Pending = FALSE;
+    for (QueueIdx = 0; QueueIdx < NumNotified; QueueIdx++) {
+      if (*VirtioFs->Ring[QueueIdx].Used.Idx != NextAvailIdx[QueueIdx]) {
+        Pending = TRUE;
+        break;
+      }
+    }
+    if (!Pending) {
+      break;
+    }
+    gBS->Stall (PollPeriodUsecs);
+    if (PollPeriodUsecs < 1024) {
+      PollPeriodUsecs *= 2;
+    }
+  }
+  MemoryFence ();
+
+  if (NumNotified < NumQueues) {
+    goto Unmap;
+  }
+
+  //
+  // Match the used elements to the exchanges by head descriptor index.
+  //
+  for (Idx = 0; Idx < NumExchanges; Idx++) {
+    UsedLen[Idx] = MAX_UINT32;
+  }
+  for (QueueIdx = 0; QueueIdx < NumQueues; QueueIdx++) {
+    Ring = &VirtioFs->Ring[QueueIdx];
+    for (UsedIdx = FirstAvailIdx[QueueIdx];
+         UsedIdx != NextAvailIdx[QueueIdx];
+         UsedIdx++) {
+      volatile CONST VRING_USED_ELEM *UsedElem;
+
+      UsedElem = &Ring->Used.UsedElem[UsedIdx % Ring->QueueSize];
+      for (Idx = QueueIdx; Idx < NumExchanges; Idx += NumQueues) {
+        if (HeadDescIdx[Idx] == UsedElem->Id) {
+          UsedLen[Idx] = UsedElem->Len;
+          break;
+        }
+      }
+      if (Idx >= NumExchanges) {
+        Status = EFI_DEVICE_ERROR;
+        goto Unmap;
+      }
+    }
+  }
+
+  //
+  // Update the transfer sizes in the IO Vectors. An exchange that the device
+  // did not complete is caught by the sanity check on MAX_UINT32 bytes.
+  //
+  for (Idx = 0; Idx < NumExchanges; Idx++) {
+    Status = VirtioFsExchangeComplete (&Exchanges[Idx], UsedLen[Idx]);
+    if (EFI_ERROR (Status)) {
+      goto Unmap;
+    }
+  }
+
+  //
+  // We've succeeded; fall through.
+  //
+Unmap:
+  Idx = NumExchanges;
+  while (Idx > 0) {
+    --Idx;
+    Status = VirtioFsExchangeUnmap (VirtioFs, &Exchanges[Idx], Status);
+  }
+  return Status;
+}
+
 /**
   Set up the fields of a new VIRTIO_FS_FUSE_REQUEST object.
 
@@ -1612,11 +2010,10 @@ FreeRhsPath8:
                              its original contents.
 
   @param[out] DirNodeId      The NodeId of the most specific parent directory
-                             identified by Path. The caller is responsible for
-                             sending a FUSE_FORGET request to the Virtio
-                             Filesystem device for DirNodeId -- unless
-                             DirNodeId equals VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID
-                             --, when DirNodeId's use ends.
+                             identified by Path. DirNodeId is borrowed from
+                             the dentry cache; the caller is responsible for
+                             returning it with VirtioFsCacheReleaseDir() when
+                             DirNodeId's use ends.
 
   @param[out] LastComponent  A pointer into Path, pointing at the start of the
                              last pathname component.
@@ -1629,8 +2026,7 @@ FreeRhsPath8:
                                  is not a directory.
 
   @return                        Error codes propagated from
-                                 VirtioFsFuseLookup() and
-                                 VirtioFsFuseAttrToEfiFileInfo().
+                                 VirtioFsCacheLookupDir().
 **/
 EFI_STATUS
 VirtioFsLookupMostSpecificParentDir (
@@ -1652,9 +2048,7 @@ VirtioFsLookupMostSpecificParentDir (
   ParentDirNodeId = VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID;
   Slash           = Path;
   for (;;) {
-    CHAR8                              *NextSlash;
-    VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE FuseAttr;
-    EFI_FILE_INFO                      FileInfo;
+    CHAR8 *NextSlash;
 
     //
     // Find the slash (if any) that terminates the next pathname component.
@@ -1670,37 +2064,23 @@ VirtioFsLookupMostSpecificParentDir (
     // up.
     //
     *NextSlash = '\0';
-    Status = VirtioFsFuseLookup (VirtioFs, ParentDirNodeId, Slash + 1,
-               &NextDirNodeId, &FuseAttr);
+    Status = VirtioFsCacheLookupDir (VirtioFs, ParentDirNodeId, Slash + 1,
+               &NextDirNodeId);
     *NextSlash = '/';
 
     //
     // We're done with the directory inode that was the basis for the lookup.
     //
-    if (ParentDirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-      VirtioFsFuseForget (VirtioFs, ParentDirNodeId);
-    }
+    VirtioFsCacheReleaseDir (VirtioFs, ParentDirNodeId);
 
     //
-    // If we couldn't look up the next *non-final* pathname component, bail.
+    // If we couldn't look up the next *non-final* pathname component, or it
+    // is not a directory, bail.
     //
     if (EFI_ERROR (Status)) {
       return Status;
     }
 
-    //
-    // Lookup successful; now check if the next (non-final) component is a
-    // directory. If not, bail.
-    //
-    Status = VirtioFsFuseAttrToEfiFileInfo (&FuseAttr, &FileInfo);
-    if (EFI_ERROR (Status)) {
-      goto ForgetNextDirNodeId;
-    }
-    if ((FileInfo.Attribute & EFI_FILE_DIRECTORY) == 0) {
-      Status = EFI_ACCESS_DENIED;
-      goto ForgetNextDirNodeId;
-    }
-
     //
     // Advance.
     //
@@ -1716,10 +2096,6 @@ VirtioFsLookupMostSpecificParentDir (
   *DirNodeId     = ParentDirNodeId;
   *LastComponent = Slash + 1;
   return EFI_SUCCESS;
-
-ForgetNextDirNodeId:
-  VirtioFsFuseForget (VirtioFs, NextDirNodeId);
-  return Status;
 }
 
 /**
@@ -0,0 +1,594 @@
+/** @file
+  Dentry and attribute caches for the Virtio Filesystem device.
+
+  FUSE_LOOKUP and FUSE_GETATTR responses carry validity periods for the name
+  to inode binding and for the inode attributes, respectively. The caches below
+  keep the responses for that long, so that resolving the same directories over
+  and over, and re-fetching the attributes of an open file, cost no round trips
+  to the device. The FUSE primitives that modify the filesystem invalidate the
+  affected cache entries.
+
+  Copyright (c) 2021, Vladislav Yaroshchuk <yaroshchuk2000@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/BaseLib.h>             // AsciiStrCmp()
+#include <Library/BaseMemoryLib.h>       // CopyMem()
+#include <Library/MemoryAllocationLib.h> // AllocatePool()
+#include <Library/TimerLib.h>            // GetPerformanceCounter()
+
+#include "VirtioFsDxe.h"
+
+/**
+  Read the clock of the caches.
+
+  @param[in] VirtioFs  The Virtio Filesystem device owning the caches.
+
+  @return  The nanoseconds elapsed since VirtioFsCacheInit().
+**/
+STATIC
+UINT64
+VirtioFsCacheNow (
+  IN VIRTIO_FS *VirtioFs
+  )
+{
+  UINT64 Counter;
+  UINT64 Elapsed;
+
+  Counter = GetPerformanceCounter ();
+  if (VirtioFs->CacheUp) {
+    Elapsed = Counter - VirtioFs->CacheBase;
+    if (Counter < VirtioFs->CacheBase) {
+      Elapsed += VirtioFs->CacheSpan;
+    }
+  } else {
+    Elapsed = VirtioFs->CacheBase - Counter;
+    if (Counter > VirtioFs->CacheBase) {
+      Elapsed += VirtioFs->CacheSpan;
+    }
+  }
+  return GetTimeInNanoSecond (Elapsed);
+}
+
+/**
+  Unlink a dentry from the cache, return its FUSE lookup reference to the
+  Virtio Filesystem device, and free it.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the cache.
+
+  @param[in] Dentry        The dentry to free. Dentry->Users must be zero.
+**/
+STATIC
+VOID
+VirtioFsCacheFreeDentry (
+  IN OUT VIRTIO_FS        *VirtioFs,
+  IN     VIRTIO_FS_DENTRY *Dentry
+  )
+{
+  ASSERT (Dentry->Users == 0);
+
+  RemoveEntryList (&Dentry->Link);
+  VirtioFs->NumDents--;
+  VirtioFsFuseForget (VirtioFs, Dentry->NodeId);
+  FreePool (Dentry->Name);
+  FreePool (Dentry);
+}
+
+/**
+  Make a dentry stale, so that it no longer resolves its name. Free it if no
+  inode number borrowed from it is in use.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the cache.
+
+  @param[in] Dentry        The dentry to make stale.
+**/
+STATIC
+VOID
+VirtioFsCacheStaleDentry (
+  IN OUT VIRTIO_FS        *VirtioFs,
+  IN     VIRTIO_FS_DENTRY *Dentry
+  )
+{
+  Dentry->Stale = TRUE;
+  if (Dentry->Users == 0) {
+    VirtioFsCacheFreeDentry (VirtioFs, Dentry);
+  }
+}
+
+/**
+  Evict the least recently used dentry that is not in use, if the dentry cache
+  is full.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the cache.
+**/
+STATIC
+VOID
+VirtioFsCacheEvictDentry (
+  IN OUT VIRTIO_FS *VirtioFs
+  )
+{
+  LIST_ENTRY       *Link;
+  VIRTIO_FS_DENTRY *Dentry;
+
+  if (VirtioFs->NumDents < VIRTIO_FS_CACHE_MAX_ENTRIES) {
+    return;
+  }
+  for (Link = GetPreviousNode (&VirtioFs->Dentries, &VirtioFs->Dentries);
+       Link != &VirtioFs->Dentries;
+       Link = GetPreviousNode (&VirtioFs->Dentries, Link)) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_LINK (Link);
+    if (Dentry->Users == 0) {
+      VirtioFsCacheFreeDentry (VirtioFs, Dentry);
+      return;
+    }
+  }
+}
+
+/**
+  Find the attribute cache entry for an inode.
+
+  @param[in] VirtioFs  The Virtio Filesystem device owning the cache.
+
+  @param[in] NodeId    The inode number to look up.
+
+  @return  The attribute cache entry, or NULL if NodeId is not cached.
+**/
+STATIC
+VIRTIO_FS_ATTR *
+VirtioFsCacheFindAttr (
+  IN VIRTIO_FS *VirtioFs,
+  IN UINT64    NodeId
+  )
+{
+  LIST_ENTRY     *Link;
+  VIRTIO_FS_ATTR *Attr;
+
+  BASE_LIST_FOR_EACH (Link, &VirtioFs->Attrs) {
+    Attr = VIRTIO_FS_ATTR_FROM_LINK (Link);
+    if (Attr->NodeId == NodeId) {
+      return Attr;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Initialize the dentry and attribute caches of a Virtio Filesystem device,
+  and start their clock.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to initialize the
+                           caches of.
+**/
+VOID
+VirtioFsCacheInit (
+  IN OUT VIRTIO_FS *VirtioFs
+  )
+{
+  UINT64 Start;
+  UINT64 End;
+  UINT64 Frequency;
+
+  InitializeListHead (&VirtioFs->Dentries);
+  VirtioFs->NumDents = 0;
+  InitializeListHead (&VirtioFs->Attrs);
+  VirtioFs->NumAttrs = 0;
+
+  //
+  // CacheSpan is the number of distinct counter values; it is zero (that is,
+  // 2^64) for a full 64-bit counter.
+  //
+  Frequency           = GetPerformanceCounterProperties (&Start, &End);
+  VirtioFs->CacheUp   = (BOOLEAN)(Start < End);
+  VirtioFs->CacheSpan = (VirtioFs->CacheUp ? End - Start : Start - End) + 1;
+  VirtioFs->CacheOn   = (BOOLEAN)(
+                          Frequency != 0 &&
+                          (VirtioFs->CacheSpan == 0 ||
+                           DivU64x64Remainder (VirtioFs->CacheSpan, Frequency,
+                             NULL) >= VIRTIO_FS_CACHE_MIN_CLOCK_SECONDS)
+                          );
+  VirtioFs->CacheBase = GetPerformanceCounter ();
+
+  DEBUG ((DEBUG_VERBOSE, "%a: Label=\"%s\" CacheOn=%d Frequency=%Lu\n",
+    __FUNCTION__, VirtioFs->Label, VirtioFs->CacheOn, Frequency));
+}
+
+/**
+  Empty the dentry and attribute caches of a Virtio Filesystem device, and
+  release their resources.
+
+  The function may only be called while no inode number borrowed from the
+  dentry cache is in use, and before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to tear down the
+                           caches of.
+**/
+VOID
+VirtioFsCacheUninit (
+  IN OUT VIRTIO_FS *VirtioFs
+  )
+{
+  VIRTIO_FS_ATTR *Attr;
+
+  while (!IsListEmpty (&VirtioFs->Dentries)) {
+    VirtioFsCacheFreeDentry (VirtioFs,
+      VIRTIO_FS_DENTRY_FROM_LINK (GetFirstNode (&VirtioFs->Dentries)));
+  }
+  while (!IsListEmpty (&VirtioFs->Attrs)) {
+    Attr = VIRTIO_FS_ATTR_FROM_LINK (GetFirstNode (&VirtioFs->Attrs));
+    RemoveEntryList (&Attr->Link);
+    FreePool (Attr);
+  }
+  VirtioFs->NumAttrs = 0;
+}
+
+/**
+  Convert a validity period reported by the Virtio Filesystem device to an
+  expiry time on the clock of the caches.
+
+  @param[in] VirtioFs     The Virtio Filesystem device owning the caches.
+
+  @param[in] Seconds      The seconds part of the validity period.
+
+  @param[in] Nanoseconds  The nanoseconds part of the validity period.
+
+  @return  The expiry time. An entry is valid while VirtioFsCacheNow() is less
+           than its expiry time. Zero if the caches have no usable clock.
+**/
+UINT64
+VirtioFsCacheExpiry (
+  IN VIRTIO_FS *VirtioFs,
+  IN UINT64    Seconds,
+  IN UINT32    Nanoseconds
+  )
+{
+  UINT64 Period;
+
+  if (!VirtioFs->CacheOn) {
+    return 0;
+  }
+
+  //
+  // Clamp the validity period to a day; that's long enough for a firmware
+  // session, and keeps the arithmetic below from overflowing.
+  //
+  if (Seconds >= 24 * 60 * 60) {
+    Period = MultU64x32 (24 * 60 * 60, 1000000000);
+  } else {
+    Period = MultU64x32 (Seconds, 1000000000) + Nanoseconds;
+  }
+  return VirtioFsCacheNow (VirtioFs) + Period;
+}
+
+/**
+  Resolve a single-component name in a directory to the inode number of a
+  subdirectory, through the dentry cache.
+
+  The function may only be called after VirtioFsCacheInit() returns
+  successfully and before VirtioFsCacheUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to send the
+                           FUSE_LOOKUP request to, if the cache cannot
+                           resolve Name.
+
+  @param[in] DirNodeId     The inode number of the directory in which Name
+                           should be resolved.
+
+  @param[in] Name          The single-component filename to resolve.
+
+  @param[out] NodeId       The inode number of the subdirectory. NodeId is
+                           borrowed from the dentry cache; the caller is
+                           responsible for returning it with
+                           VirtioFsCacheReleaseDir().
+
+  @retval EFI_SUCCESS           Name has been resolved to a directory.
+
+  @retval EFI_ACCESS_DENIED     Name refers to a non-directory.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Error codes propagated from
+                                VirtioFsFuseLookup() and
+                                VirtioFsFuseAttrToEfiFileInfo().
+**/
+EFI_STATUS
+VirtioFsCacheLookupDir (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    DirNodeId,
+  IN     CHAR8     *Name,
+     OUT UINT64    *NodeId
+  )
+{
+  LIST_ENTRY                         *Link;
+  VIRTIO_FS_DENTRY                   *Dentry;
+  EFI_STATUS                         Status;
+  VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE FuseAttr;
+  EFI_FILE_INFO                      FileInfo;
+  UINT64                             NewNodeId;
+  UINT64                             Expiry;
+  CHAR8                              *NewName;
+
+  //
+  // Look for a live dentry.
+  //
+  BASE_LIST_FOR_EACH (Link, &VirtioFs->Dentries) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_LINK (Link);
+    if (Dentry->Stale ||
+        Dentry->ParentNodeId != DirNodeId ||
+        AsciiStrCmp (Dentry->Name, Name) != 0) {
+      continue;
+    }
+    if (VirtioFsCacheNow (VirtioFs) < Dentry->Expiry) {
+      //
+      // Hit; move the dentry to the front of the LRU list.
+      //
+      RemoveEntryList (&Dentry->Link);
+      InsertHeadList (&VirtioFs->Dentries, &Dentry->Link);
+      Dentry->Users++;
+      *NodeId = Dentry->NodeId;
+      return EFI_SUCCESS;
+    }
+    VirtioFsCacheStaleDentry (VirtioFs, Dentry);
+    break;
+  }
+
+  //
+  // Miss; ask the device.
+  //
+  Status = VirtioFsFuseLookup (VirtioFs, DirNodeId, Name, &NewNodeId,
+             &FuseAttr, &Expiry);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Status = VirtioFsFuseAttrToEfiFileInfo (&FuseAttr, &FileInfo);
+  if (!EFI_ERROR (Status) && (FileInfo.Attribute & EFI_FILE_DIRECTORY) == 0) {
+    Status = EFI_ACCESS_DENIED;
+  }
+  if (EFI_ERROR (Status)) {
+    goto ForgetNewNodeId;
+  }
+
+  NewName = AllocateCopyPool (AsciiStrSize (Name), Name);
+  if (NewName == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ForgetNewNodeId;
+  }
+
+  //
+  // If a dentry (live or stale) already refers to the inode, then it already
+  // owns a lookup reference; rebind it to the name just looked up.
+  //
+  BASE_LIST_FOR_EACH (Link, &VirtioFs->Dentries) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_LINK (Link);
+    if (Dentry->NodeId == NewNodeId) {
+      VirtioFsFuseForget (VirtioFs, NewNodeId);
+      FreePool (Dentry->Name);
+      RemoveEntryList (&Dentry->Link);
+      goto InitDentry;
+    }
+  }
+
+  VirtioFsCacheEvictDentry (VirtioFs);
+  Dentry = AllocatePool (sizeof *Dentry);
+  if (Dentry == NULL) {
+    FreePool (NewName);
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ForgetNewNodeId;
+  }
+  Dentry->Signature = VIRTIO_FS_DENTRY_SIG;
+  Dentry->NodeId    = NewNodeId;
+  Dentry->Users     = 0;
+  VirtioFs->NumDents++;
+
+InitDentry:
+  Dentry->ParentNodeId = DirNodeId;
+  Dentry->Name         = NewName;
+  Dentry->Expiry       = Expiry;
+  Dentry->Stale        = FALSE;
+  Dentry->Users++;
+  InsertHeadList (&VirtioFs->Dentries, &Dentry->Link);
+
+  *NodeId = NewNodeId;
+  return EFI_SUCCESS;
+
+ForgetNewNodeId:
+  VirtioFsFuseForget (VirtioFs, NewNodeId);
+  return Status;
+}
+
+/**
+  Return an inode number borrowed from the dentry cache with
+  VirtioFsCacheLookupDir().
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the cache.
+
+  @param[in] NodeId        The inode number to return. The root directory's
+                           inode number is ignored.
+**/
+VOID
+VirtioFsCacheReleaseDir (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  )
+{
+  LIST_ENTRY       *Link;
+  VIRTIO_FS_DENTRY *Dentry;
+
+  if (NodeId == VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
+    return;
+  }
+
+  BASE_LIST_FOR_EACH (Link, &VirtioFs->Dentries) {
+    Dentry = VIRTIO_FS_DENTRY_FROM_LINK (Link);
+    if (Dentry->NodeId == NodeId) {
+      ASSERT (Dentry->Users > 0);
+      Dentry->Users--;
+      if (Dentry->Stale && Dentry->Users == 0) {
+        VirtioFsCacheFreeDentry (VirtioFs, Dentry);
+      }
+      return;
+    }
+  }
+  ASSERT (FALSE);
+}
+
+/**
+  Store the attributes of an inode in the attribute cache.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the cache.
+
+  @param[in] NodeId        The inode number that FuseAttr describes.
+
+  @param[in] FuseAttr      The attributes reported by the Virtio Filesystem
+                           device.
+
+  @param[in] Expiry        The expiry time of FuseAttr, from
+                           VirtioFsCacheExpiry().
+**/
+VOID
+VirtioFsCacheStoreAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+  IN     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr,
+  IN     UINT64                             Expiry
+  )
+{
+  VIRTIO_FS_ATTR *Attr;
+
+  Attr = VirtioFsCacheFindAttr (VirtioFs, NodeId);
+  if (Attr != NULL) {
+    RemoveEntryList (&Attr->Link);
+  } else if (VirtioFs->NumAttrs == VIRTIO_FS_CACHE_MAX_ENTRIES) {
+    //
+    // Recycle the least recently used entry.
+    //
+    Attr = VIRTIO_FS_ATTR_FROM_LINK (
+             GetPreviousNode (&VirtioFs->Attrs, &VirtioFs->Attrs));
+    RemoveEntryList (&Attr->Link);
+  } else {
+    Attr = AllocatePool (sizeof *Attr);
+    if (Attr == NULL) {
+      return;
+    }
+    Attr->Signature = VIRTIO_FS_ATTR_SIG;
+    VirtioFs->NumAttrs++;
+  }
+
+  Attr->NodeId = NodeId;
+  Attr->Expiry = Expiry;
+  CopyMem (&Attr->Attr, FuseAttr, sizeof *FuseAttr);
+  InsertHeadList (&VirtioFs->Attrs, &Attr->Link);
+}
+
+/**
+  Fetch the attributes of an inode, from the attribute cache if they are still
+  valid, or else with a FUSE_GETATTR request.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to send the
+                           FUSE_GETATTR request to.
+
+  @param[in] NodeId        The inode number for which the attributes should be
+                           retrieved.
+
+  @param[out] FuseAttr     The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object
+                           describing the properties of the inode.
+
+  @retval EFI_SUCCESS  FuseAttr has been filled in.
+
+  @return              Error codes propagated from VirtioFsFuseGetAttr().
+**/
+EFI_STATUS
+VirtioFsCacheGetAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  )
+{
+  VIRTIO_FS_ATTR *Attr;
+
+  Attr = VirtioFsCacheFindAttr (VirtioFs, NodeId);
+  if (Attr != NULL && VirtioFsCacheNow (VirtioFs) < Attr->Expiry) {
+    //
+    // Hit; move the attributes to the front of the LRU list.
+    //
+    RemoveEntryList (&Attr->Link);
+    InsertHeadList (&VirtioFs->Attrs, &Attr->Link);
+    CopyMem (FuseAttr, &Attr->Attr, sizeof *FuseAttr);
+    return EFI_SUCCESS;
+  }
+  return VirtioFsFuseGetAttr (VirtioFs, NodeId, FuseAttr);
+}
+
+/**
+  Drop the cached attributes of an inode.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the cache.
+
+  @param[in] NodeId        The inode number whose attributes have changed.
+**/
+VOID
+VirtioFsCacheDropAttr (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  )
+{
+  VIRTIO_FS_ATTR *Attr;
+
+  Attr = VirtioFsCacheFindAttr (VirtioFs, NodeId);
+  if (Attr != NULL) {
+    RemoveEntryList (&Attr->Link);
+    VirtioFs->NumAttrs--;
+    FreePool (Attr);
+  }
+}
+
+/**
+  Invalidate all dentries and all cached attributes, after the directory tree
+  has been changed by renaming or removing an entry.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the caches.
+**/
+VOID
+VirtioFsCacheInvalidate (
+  IN OUT VIRTIO_FS *VirtioFs
+  )
+{
+  LIST_ENTRY     *Link;
+  LIST_ENTRY     *NextLink;
+  VIRTIO_FS_ATTR *Attr;
+
+  BASE_LIST_FOR_EACH_SAFE (Link, NextLink, &VirtioFs->Dentries) {
+    VirtioFsCacheStaleDentry (VirtioFs, VIRTIO_FS_DENTRY_FROM_LINK (Link));
+  }
+  BASE_LIST_FOR_EACH_SAFE (Link, NextLink, &VirtioFs->Attrs) {
+    Attr = VIRTIO_FS_ATTR_FROM_LINK (Link);
+    RemoveEntryList (&Attr->Link);
+    FreePool (Attr);
+  }
+  VirtioFs->NumAttrs = 0;
+}
+
+/**
+  Empty the readahead windows of all open files that refer to an inode, after
+  the contents of the inode have been changed.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device owning the open files.
+
+  @param[in] NodeId        The inode number whose contents have changed.
+**/
+VOID
+VirtioFsCacheDropData (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  )
+{
+  LIST_ENTRY     *Link;
+  VIRTIO_FS_FILE *VirtioFsFile;
+
+  BASE_LIST_FOR_EACH (Link, &VirtioFs->OpenFiles) {
+    VirtioFsFile = VIRTIO_FS_FILE_FROM_OPEN_FILES_ENTRY (Link);
+    if (VirtioFsFile->NodeId == NodeId) {
+      VirtioFsFile->ReadaheadSize = 0;
+    }
+  }
+}
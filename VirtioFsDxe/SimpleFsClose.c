@@ -63,6 +63,9 @@ VirtioFsSimpleFileClose (
   if (VirtioFsFile->FileInfoArray != NULL) {
     FreePool (VirtioFsFile->FileInfoArray);
   }
+  if (VirtioFsFile->ReadaheadBuffer != NULL) {
+    FreePool (VirtioFsFile->ReadaheadBuffer);
+  }
   FreePool (VirtioFsFile);
   return EFI_SUCCESS;
 }
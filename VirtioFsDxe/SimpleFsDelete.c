@@ -74,9 +74,7 @@ VirtioFsSimpleFileDelete (
                  LastComponent,
                  VirtioFsFile->IsDirectory
                  );
-      if (ParentNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-        VirtioFsFuseForget (VirtioFs, ParentNodeId);
-      }
+      VirtioFsCacheReleaseDir (VirtioFs, ParentNodeId);
     }
     if (EFI_ERROR (Status)) {
       //
@@ -105,6 +103,9 @@ VirtioFsSimpleFileDelete (
   if (VirtioFsFile->FileInfoArray != NULL) {
     FreePool (VirtioFsFile->FileInfoArray);
   }
+  if (VirtioFsFile->ReadaheadBuffer != NULL) {
+    FreePool (VirtioFsFile->ReadaheadBuffer);
+  }
   FreePool (VirtioFsFile);
   return Status;
 }
@@ -62,7 +62,7 @@ GetFileInfo (
   //
   // Fetch the file attributes, and convert them into the caller's buffer.
   //
-  Status = VirtioFsFuseGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
+  Status = VirtioFsCacheGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
   if (!EFI_ERROR (Status)) {
     Status = VirtioFsFuseAttrToEfiFileInfo (&FuseAttr, FileInfo);
   }
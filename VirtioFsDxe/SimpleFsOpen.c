@@ -57,7 +57,7 @@ OpenRootDirectory (
     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE FuseAttr;
     EFI_FILE_INFO                      FileInfo;
 
-    Status = VirtioFsFuseGetAttr (VirtioFs, VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID,
+    Status = VirtioFsCacheGetAttr (VirtioFs, VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID,
                &FuseAttr);
     if (EFI_ERROR (Status)) {
       return Status;
@@ -149,7 +149,7 @@ OpenExistentFileOrDirectory (
   UINT64                             NewFuseHandle;
 
   Status = VirtioFsFuseLookup (VirtioFs, DirNodeId, Name, &ResolvedNodeId,
-             &FuseAttr);
+             &FuseAttr, NULL);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -463,9 +463,7 @@ VirtioFsSimpleFileOpen (
   //
   // Regardless of the branch taken, we're done with DirNodeId.
   //
-  if (DirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, DirNodeId);
-  }
+  VirtioFsCacheReleaseDir (VirtioFs, DirNodeId);
 
   if (EFI_ERROR (Status)) {
     goto FreeNewCanonicalPath;
@@ -497,6 +495,9 @@ VirtioFsSimpleFileOpen (
   NewVirtioFsFile->SingleFileInfoSize     = 0;
   NewVirtioFsFile->NumFileInfo            = 0;
   NewVirtioFsFile->NextFileInfo           = 0;
+  NewVirtioFsFile->ReadaheadBuffer        = NULL;
+  NewVirtioFsFile->ReadaheadOffset        = 0;
+  NewVirtioFsFile->ReadaheadSize          = 0;
 
   //
   // One more file is now open for the filesystem.
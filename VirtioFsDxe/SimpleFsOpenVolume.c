@@ -79,6 +79,9 @@ VirtioFsOpenVolume (
   VirtioFsFile->SingleFileInfoSize     = 0;
   VirtioFsFile->NumFileInfo            = 0;
   VirtioFsFile->NextFileInfo           = 0;
+  VirtioFsFile->ReadaheadBuffer        = NULL;
+  VirtioFsFile->ReadaheadOffset        = 0;
+  VirtioFsFile->ReadaheadSize          = 0;
 
   //
   // One more file open for the filesystem.
@@ -351,6 +351,12 @@ ReadFileInfoCache (
 
 /**
   Read from a regular file.
+
+  Reads smaller than the readahead window are served from the window, which is
+  refilled from the current position when needed. Larger reads go to the
+  device directly. The window is emptied if the size or the modification time
+  of the file differ from when it was filled; the attributes are fetched from
+  the device again whenever their validity period has expired.
 **/
 STATIC
 EFI_STATUS
@@ -370,35 +376,89 @@ ReadRegularFile (
   //
   // The UEFI spec forbids reads that start beyond the end of the file.
   //
-  Status = VirtioFsFuseGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
+  Status = VirtioFsCacheGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
   if (EFI_ERROR (Status) || VirtioFsFile->FilePosition > FuseAttr.Size) {
     return EFI_DEVICE_ERROR;
   }
 
+  //
+  // Drop the readahead window if the file has changed on the host side.
+  //
+  if (VirtioFsFile->ReadaheadSize > 0 &&
+      (FuseAttr.Size != VirtioFsFile->ReadaheadAttr.Size ||
+       FuseAttr.Mtime != VirtioFsFile->ReadaheadAttr.Mtime ||
+       FuseAttr.MtimeNsec != VirtioFsFile->ReadaheadAttr.MtimeNsec)) {
+    VirtioFsFile->ReadaheadSize = 0;
+  }
+
   Status      = EFI_SUCCESS;
   Transferred = 0;
   Left        = *BufferSize;
   while (Left > 0) {
-    UINT32 ReadSize;
+    UINT64 Position;
+    UINTN  ReadSize;
+
+    Position = VirtioFsFile->FilePosition + Transferred;
 
     //
-    // FUSE_READ cannot express a >=4GB buffer size.
+    // Serve as much as we can from the readahead window.
     //
-    ReadSize = (UINT32)MIN ((UINTN)MAX_UINT32, Left);
-    Status = VirtioFsFuseReadFileOrDir (
+    if (Position >= VirtioFsFile->ReadaheadOffset &&
+        Position - VirtioFsFile->ReadaheadOffset <
+        VirtioFsFile->ReadaheadSize) {
+      UINTN Skip;
+
+      Skip     = (UINTN)(Position - VirtioFsFile->ReadaheadOffset);
+      ReadSize = MIN (Left, VirtioFsFile->ReadaheadSize - Skip);
+      CopyMem ((UINT8 *)Buffer + Transferred,
+        VirtioFsFile->ReadaheadBuffer + Skip, ReadSize);
+      Transferred += ReadSize;
+      Left        -= ReadSize;
+      continue;
+    }
+
+    if (Left < VirtioFs->Readahead &&
+        VirtioFsFile->ReadaheadBuffer == NULL) {
+      VirtioFsFile->ReadaheadBuffer = AllocatePool (VirtioFs->Readahead);
+    }
+
+    //
+    // Read the rest directly if it is at least as large as the readahead
+    // window (or if we have no window).
+    //
+    if (Left >= VirtioFs->Readahead ||
+        VirtioFsFile->ReadaheadBuffer == NULL) {
+      ReadSize = Left;
+      Status = VirtioFsFuseReadFile (
+                 VirtioFs,
+                 VirtioFsFile->NodeId,
+                 VirtioFsFile->FuseHandle,
+                 Position,
+                 &ReadSize,
+                 (UINT8 *)Buffer + Transferred
+                 );
+      Transferred += ReadSize;
+      break;
+    }
+
+    //
+    // Refill the readahead window from the current position.
+    //
+    ReadSize = VirtioFs->Readahead;
+    Status = VirtioFsFuseReadFile (
                VirtioFs,
                VirtioFsFile->NodeId,
                VirtioFsFile->FuseHandle,
-               FALSE,                                    // IsDir
-               VirtioFsFile->FilePosition + Transferred,
+               Position,
                &ReadSize,
-               (UINT8 *)Buffer + Transferred
+               VirtioFsFile->ReadaheadBuffer
                );
+    VirtioFsFile->ReadaheadOffset = Position;
+    VirtioFsFile->ReadaheadSize   = ReadSize;
+    CopyMem (&VirtioFsFile->ReadaheadAttr, &FuseAttr, sizeof FuseAttr);
     if (EFI_ERROR (Status) || ReadSize == 0) {
       break;
     }
-    Transferred += ReadSize;
-    Left        -= ReadSize;
   }
 
   *BufferSize = Transferred;
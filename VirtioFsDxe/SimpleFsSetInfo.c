@@ -292,14 +292,10 @@ Rename (
   // Fall through.
   //
 ForgetNewParentDirNodeId:
-  if (NewParentDirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, NewParentDirNodeId);
-  }
+  VirtioFsCacheReleaseDir (VirtioFs, NewParentDirNodeId);
 
 ForgetOldParentDirNodeId:
-  if (OldParentDirNodeId != VIRTIO_FS_FUSE_ROOT_DIR_NODE_ID) {
-    VirtioFsFuseForget (VirtioFs, OldParentDirNodeId);
-  }
+  VirtioFsCacheReleaseDir (VirtioFs, OldParentDirNodeId);
 
 FreeDestination:
   if (Destination != NULL) {
@@ -355,7 +351,7 @@ UpdateAttributes (
   // Fetch the current attributes first, so we can build the difference between
   // them and NewFileInfo.
   //
-  Status = VirtioFsFuseGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
+  Status = VirtioFsCacheGetAttr (VirtioFs, VirtioFsFile->NodeId, &FuseAttr);
   if (EFI_ERROR (Status)) {
     return Status;
   }
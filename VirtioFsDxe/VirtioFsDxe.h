@@ -23,6 +23,12 @@
 #define VIRTIO_FS_FILE_SIG \
   SIGNATURE_64 ('V', 'I', 'O', 'F', 'S', 'F', 'I', 'L')
 
+#define VIRTIO_FS_DENTRY_SIG \
+  SIGNATURE_64 ('V', 'I', 'O', 'F', 'S', 'D', 'E', 'N')
+
+#define VIRTIO_FS_ATTR_SIG \
+  SIGNATURE_64 ('V', 'I', 'O', 'F', 'S', 'A', 'T', 'R')
+
 //
 // The following limit applies to two kinds of pathnames.
 //
@@ -52,6 +58,41 @@
 //
 #define VIRTIO_FS_FILE_MAX_FILE_INFO 256
 
+//
+// The dentry and attribute caches are aged by the performance counter of
+// TimerLib, in nanoseconds elapsed since VirtioFsCacheInit(). If the counter
+// wraps around sooner than VIRTIO_FS_CACHE_MIN_CLOCK_SECONDS, the time elapsed
+// between two readings is ambiguous; in that case nothing is cached beyond the
+// request that fetched it.
+//
+#define VIRTIO_FS_CACHE_MIN_CLOCK_SECONDS (365 * 24 * 60 * 60)
+
+//
+// Maximum number of entries in each of the dentry and attribute caches. The
+// least recently used entries are evicted when a cache is full.
+//
+#define VIRTIO_FS_CACHE_MAX_ENTRIES 64
+
+//
+// Maximum number of request queues used, out of those exposed by the device.
+// The first one carries all synchronous requests; the FUSE_READ requests of a
+// pipelined read are spread over all of them.
+//
+#define VIRTIO_FS_MAX_REQUEST_QUEUES 4
+
+//
+// Maximum number of requests in a batch submitted with
+// VirtioFsSgListsSubmitBatch(), hence the maximum number of FUSE_READ requests
+// kept in flight by a pipelined read.
+//
+#define VIRTIO_FS_MAX_REQUESTS_IN_FLIGHT 16
+
+//
+// The readahead window requested in FUSE_INIT. Small sequential reads from a
+// regular file are served from a readahead buffer of the negotiated size.
+//
+#define VIRTIO_FS_READAHEAD_SIZE SIZE_256KB
+
 //
 // Filesystem label encoded in UCS-2, transformed from the UTF-8 representation
 // in "VIRTIO_FS_CONFIG.Tag", and NUL-terminated. Only the printable ASCII code
@@ -59,6 +100,13 @@
 //
 typedef CHAR16 VIRTIO_FS_LABEL[VIRTIO_FS_TAG_BYTES + 1];
 
+//
+// Rings of the request queues in use, and their mappings. Element #N
+// belongs to virtio queue (VIRTIO_FS_REQUEST_QUEUE + N).
+//
+typedef VRING VIRTIO_FS_RINGS[VIRTIO_FS_MAX_REQUEST_QUEUES];
+typedef VOID  *VIRTIO_FS_RING_MAPS[VIRTIO_FS_MAX_REQUEST_QUEUES];
+
 //
 // Main context structure, expressing an EFI_SIMPLE_FILE_SYSTEM_PROTOCOL
 // interface on top of the Virtio Filesystem device.
@@ -74,14 +122,26 @@ typedef struct {
   UINT64                          Signature; // DriverBindingStart  0
   VIRTIO_DEVICE_PROTOCOL          *Virtio;   // DriverBindingStart  0
   VIRTIO_FS_LABEL                 Label;     // VirtioFsInit        1
+  UINT16                          NumQueues; // VirtioFsInit        1
   UINT16                          QueueSize; // VirtioFsInit        1
-  VRING                           Ring;      // VirtioRingInit      2
-  VOID                            *RingMap;  // VirtioRingMap       2
+  VIRTIO_FS_RINGS                 Ring;      // VirtioRingInit      2
+  VIRTIO_FS_RING_MAPS             RingMap;   // VirtioRingMap       2
   UINT64                          RequestId; // FuseInitSession     1
   UINT32                          MaxWrite;  // FuseInitSession     1
+  UINT32                          MaxRead;   // FuseInitSession     1
+  UINT32                          Readahead; // FuseInitSession     1
+  UINTN                           ReadDepth; // FuseInitSession     1
   EFI_EVENT                       ExitBoot;  // DriverBindingStart  0
   LIST_ENTRY                      OpenFiles; // DriverBindingStart  0
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL SimpleFs;  // DriverBindingStart  0
+  BOOLEAN                         CacheOn;   // VirtioFsCacheInit   1
+  BOOLEAN                         CacheUp;   // VirtioFsCacheInit   1
+  UINT64                          CacheBase; // VirtioFsCacheInit   1
+  UINT64                          CacheSpan; // VirtioFsCacheInit   1
+  LIST_ENTRY                      Dentries;  // VirtioFsCacheInit   1
+  UINTN                           NumDents;  // VirtioFsCacheInit   1
+  LIST_ENTRY                      Attrs;     // VirtioFsCacheInit   1
+  UINTN                           NumAttrs;  // VirtioFsCacheInit   1
 } VIRTIO_FS;
 
 #define VIRTIO_FS_FROM_SIMPLE_FS(SimpleFsReference) \
@@ -133,6 +193,14 @@ typedef struct {
   UINT32 TotalSize;
 } VIRTIO_FS_SCATTER_GATHER_LIST;
 
+//
+// A request-response exchange submitted as part of a batch.
+//
+typedef struct {
+  VIRTIO_FS_SCATTER_GATHER_LIST *RequestSgList;
+  VIRTIO_FS_SCATTER_GATHER_LIST *ResponseSgList;
+} VIRTIO_FS_EXCHANGE;
+
 //
 // Private context structure that exposes EFI_FILE_PROTOCOL on top of an open
 // FUSE file reference.
@@ -174,6 +242,19 @@ typedef struct {
   UINTN SingleFileInfoSize;
   UINTN NumFileInfo;
   UINTN NextFileInfo;
+  //
+  // Readahead window for reading a regular file in small pieces. The
+  // ReadaheadSize bytes in ReadaheadBuffer (allocated on first use, with room
+  // for "VIRTIO_FS.Readahead" bytes) mirror the file contents starting at
+  // ReadaheadOffset. Local writes and size changes empty the window. So does
+  // a change of the size or the modification time that the host reports once
+  // the cached attributes of the file expire; ReadaheadAttr holds the
+  // attributes the window was filled under.
+  //
+  UINT8                              *ReadaheadBuffer;
+  UINT64                             ReadaheadOffset;
+  UINTN                              ReadaheadSize;
+  VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE ReadaheadAttr;
 } VIRTIO_FS_FILE;
 
 #define VIRTIO_FS_FILE_FROM_SIMPLE_FILE(SimpleFileReference) \
@@ -183,6 +264,46 @@ typedef struct {
   CR (OpenFilesEntryReference, VIRTIO_FS_FILE, OpenFilesEntry, \
     VIRTIO_FS_FILE_SIG);
 
+//
+// Dentry cache entry, resolving a single-component name in a directory to the
+// inode number of a subdirectory. Only directories are cached, as only
+// non-final pathname components are resolved through the cache.
+//
+// Every entry owns exactly one FUSE lookup reference on NodeId, which is
+// returned to the Virtio Filesystem device with FUSE_FORGET when the entry is
+// freed. NodeId values handed out by VirtioFsCacheLookupDir() are borrowed
+// from the entry; Users counts them. An entry that is found expired, or that
+// is invalidated, becomes Stale: it no longer resolves names, and it is freed
+// as soon as Users drops to zero.
+//
+typedef struct {
+  UINT64     Signature;
+  LIST_ENTRY Link;
+  UINT64     ParentNodeId;
+  CHAR8      *Name;
+  UINT64     NodeId;
+  UINT64     Expiry;
+  UINTN      Users;
+  BOOLEAN    Stale;
+} VIRTIO_FS_DENTRY;
+
+#define VIRTIO_FS_DENTRY_FROM_LINK(LinkReference) \
+  CR (LinkReference, VIRTIO_FS_DENTRY, Link, VIRTIO_FS_DENTRY_SIG);
+
+//
+// Attribute cache entry.
+//
+typedef struct {
+  UINT64                             Signature;
+  LIST_ENTRY                         Link;
+  UINT64                             NodeId;
+  UINT64                             Expiry;
+  VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE Attr;
+} VIRTIO_FS_ATTR;
+
+#define VIRTIO_FS_ATTR_FROM_LINK(LinkReference) \
+  CR (LinkReference, VIRTIO_FS_ATTR, Link, VIRTIO_FS_ATTR_SIG);
+
 //
 // Initialization and helper routines for the Virtio Filesystem device.
 //
@@ -218,6 +339,13 @@ VirtioFsSgListsSubmit (
   IN OUT VIRTIO_FS_SCATTER_GATHER_LIST *ResponseSgList OPTIONAL
   );
 
+EFI_STATUS
+VirtioFsSgListsSubmitBatch (
+  IN OUT VIRTIO_FS          *VirtioFs,
+  IN OUT VIRTIO_FS_EXCHANGE *Exchanges,
+  IN     UINTN              NumExchanges
+  );
+
 EFI_STATUS
 VirtioFsFuseNewRequest (
   IN OUT VIRTIO_FS              *VirtioFs,
@@ -308,6 +436,73 @@ VirtioFsGetFuseModeUpdate (
      OUT UINT32        *Mode
      );
 
+//
+// Dentry and attribute cache routines for the Virtio Filesystem device.
+//
+
+VOID
+VirtioFsCacheInit (
+  IN OUT VIRTIO_FS *VirtioFs
+  );
+
+VOID
+VirtioFsCacheUninit (
+  IN OUT VIRTIO_FS *VirtioFs
+  );
+
+UINT64
+VirtioFsCacheExpiry (
+  IN VIRTIO_FS *VirtioFs,
+  IN UINT64    Seconds,
+  IN UINT32    Nanoseconds
+  );
+
+EFI_STATUS
+VirtioFsCacheLookupDir (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    DirNodeId,
+  IN     CHAR8     *Name,
+     OUT UINT64    *NodeId
+  );
+
+VOID
+VirtioFsCacheReleaseDir (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  );
+
+VOID
+VirtioFsCacheStoreAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+  IN     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr,
+  IN     UINT64                             Expiry
+  );
+
+EFI_STATUS
+VirtioFsCacheGetAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  );
+
+VOID
+VirtioFsCacheDropAttr (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  );
+
+VOID
+VirtioFsCacheInvalidate (
+  IN OUT VIRTIO_FS *VirtioFs
+  );
+
+VOID
+VirtioFsCacheDropData (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  );
+
 //
 // Wrapper functions for FUSE commands (primitives).
 //
@@ -318,7 +513,8 @@ VirtioFsFuseLookup (
   IN     UINT64                             DirNodeId,
   IN     CHAR8                              *Name,
      OUT UINT64                             *NodeId,
-     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr,
+     OUT UINT64                             *EntryExpiry OPTIONAL
   );
 
 EFI_STATUS
@@ -379,6 +575,16 @@ VirtioFsFuseReadFileOrDir (
      OUT VOID      *Data
   );
 
+EFI_STATUS
+VirtioFsFuseReadFile (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId,
+  IN     UINT64    FuseHandle,
+  IN     UINT64    Offset,
+  IN OUT UINTN     *Size,
+     OUT VOID      *Data
+  );
+
 EFI_STATUS
 VirtioFsFuseWrite (
   IN OUT VIRTIO_FS *VirtioFs,
@@ -88,6 +88,305 @@ VirtioRngGetInfo (
   return EFI_SUCCESS;
 }
 
+/**
+  Append a descriptor to the available ring. The device sees it only after the
+  next VirtioRngKick().
+
+  @param[in,out] Dev      The virtio-rng device.
+  @param[in]     DescIdx  The descriptor to post.
+
+**/
+STATIC
+VOID
+VirtioRngPost (
+  IN OUT VIRTIO_RNG_DEV *Dev,
+  IN     UINT16         DescIdx
+  )
+{
+  //
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring
+  //
+  Dev->Ring.Avail.Ring[Dev->NextAvail++ % Dev->Ring.QueueSize] = DescIdx;
+  Dev->AvailPending = TRUE;
+}
+
+/**
+  Publish the descriptors posted since the last call, and notify the device
+  about them, once for all of them.
+
+  @param[in,out] Dev  The virtio-rng device.
+
+  @return  Status codes from VirtIo->SetQueueNotify().
+
+**/
+STATIC
+EFI_STATUS
+VirtioRngKick (
+  IN OUT VIRTIO_RNG_DEV *Dev
+  )
+{
+  if (!Dev->AvailPending) {
+    return EFI_SUCCESS;
+  }
+  Dev->AvailPending = FALSE;
+
+  //
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field
+  //
+  MemoryFence ();
+  *Dev->Ring.Avail.Idx = Dev->NextAvail;
+
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device
+  //
+  MemoryFence ();
+  return Dev->VirtIo->SetQueueNotify (Dev->VirtIo, 0);
+}
+
+/**
+  Collect the descriptors the device has returned: filled pool buffers are
+  queued for serving (empty ones are posted again), and the completion of a
+  direct request is recorded.
+
+  @param[in,out] Dev  The virtio-rng device.
+
+**/
+STATIC
+VOID
+VirtioRngReap (
+  IN OUT VIRTIO_RNG_DEV *Dev
+  )
+{
+  UINT16                         UsedIdx;
+  volatile CONST VRING_USED_ELEM *UsedElem;
+  UINT16                         DescIdx;
+  UINT32                         Len;
+  UINT16                         Tail;
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  MemoryFence ();
+  UsedIdx = *Dev->Ring.Used.Idx;
+  MemoryFence ();
+
+  while (Dev->LastUsed != UsedIdx) {
+    UsedElem = &Dev->Ring.Used.UsedElem[Dev->LastUsed++ %
+                                        Dev->Ring.QueueSize];
+    DescIdx = (UINT16)UsedElem->Id;
+    Len     = UsedElem->Len;
+
+    if (DescIdx == Dev->PoolBuffers) {
+      Dev->DirectLen  = Len;
+      Dev->DirectDone = TRUE;
+      continue;
+    }
+
+    ASSERT (DescIdx < Dev->PoolBuffers);
+    ASSERT (Len <= VIRTIO_RNG_POOL_BUFFER_SIZE);
+    if (Len == 0) {
+      VirtioRngPost (Dev, DescIdx);
+      continue;
+    }
+
+    Tail = (Dev->FilledHead + Dev->FilledCount) % VIRTIO_RNG_POOL_BUFFERS;
+    Dev->FilledId[Tail]  = DescIdx;
+    Dev->FilledLen[Tail] = MIN (Len, VIRTIO_RNG_POOL_BUFFER_SIZE);
+    Dev->FilledCount++;
+  }
+}
+
+/**
+  Wait until the device returns at least one descriptor, and collect it.
+
+  @param[in,out] Dev  The virtio-rng device.
+
+  @return  Status codes from VirtioRngKick().
+
+**/
+STATIC
+EFI_STATUS
+VirtioRngWait (
+  IN OUT VIRTIO_RNG_DEV *Dev
+  )
+{
+  EFI_STATUS Status;
+  UINTN      PollPeriodUsecs;
+
+  Status = VirtioRngKick (Dev);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // As in VirtioFlush(), keep slowing down until we reach a poll period of
+  // slightly above 1 ms.
+  //
+  PollPeriodUsecs = 1;
+  MemoryFence ();
+  while (*Dev->Ring.Used.Idx == Dev->LastUsed) {
+    gBS->Stall (PollPeriodUsecs);
+
+    if (PollPeriodUsecs < 1024) {
+      PollPeriodUsecs *= 2;
+    }
+    MemoryFence ();
+  }
+
+  VirtioRngReap (Dev);
+  return EFI_SUCCESS;
+}
+
+/**
+  Serve a request from the entropy pool, waiting for the device to fill pool
+  buffers as needed. Drained buffers are posted again, and the device is
+  notified about them once, before waiting or on return.
+
+  @param[in,out] Dev             The virtio-rng device.
+  @param[in]     RNGValueLength  The number of bytes to return.
+  @param[out]    RNGValue        The buffer to fill.
+
+  @retval EFI_SUCCESS       RNGValue has been filled.
+  @retval EFI_DEVICE_ERROR  The device could not be notified.
+
+**/
+STATIC
+EFI_STATUS
+VirtioRngGetFromPool (
+  IN OUT VIRTIO_RNG_DEV *Dev,
+  IN     UINTN          RNGValueLength,
+  OUT    UINT8          *RNGValue
+  )
+{
+  UINTN      Index;
+  UINT16     DescIdx;
+  UINT32     Chunk;
+  UINT8      *Buffer;
+  EFI_STATUS Status;
+
+  VirtioRngReap (Dev);
+
+  for (Index = 0; Index < RNGValueLength; Index += Chunk) {
+    if (Dev->FilledCount == 0) {
+      Status = VirtioRngWait (Dev);
+      if (EFI_ERROR (Status)) {
+        return EFI_DEVICE_ERROR;
+      }
+      Chunk = 0;
+      continue;
+    }
+
+    DescIdx = Dev->FilledId[Dev->FilledHead];
+    Buffer  = (UINT8 *)Dev->Pool + DescIdx * VIRTIO_RNG_POOL_BUFFER_SIZE;
+    Chunk   = (UINT32)MIN (RNGValueLength - Index,
+                        Dev->FilledLen[Dev->FilledHead] - Dev->FilledOffset);
+    CopyMem (RNGValue + Index, Buffer + Dev->FilledOffset, Chunk);
+
+    //
+    // Never hand out the same bytes twice.
+    //
+    ZeroMem (Buffer + Dev->FilledOffset, Chunk);
+    Dev->FilledOffset += Chunk;
+
+    if (Dev->FilledOffset == Dev->FilledLen[Dev->FilledHead]) {
+      Dev->FilledHead = (Dev->FilledHead + 1) % VIRTIO_RNG_POOL_BUFFERS;
+      Dev->FilledCount--;
+      Dev->FilledOffset = 0;
+      VirtioRngPost (Dev, DescIdx);
+      Dev->Refills++;
+    }
+  }
+
+  Dev->PoolBytes += RNGValueLength;
+
+  if (EFI_ERROR (VirtioRngKick (Dev))) {
+    return EFI_DEVICE_ERROR;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Serve a large request by having the device write the caller's buffer
+  directly, through the descriptor reserved for this purpose.
+
+  @param[in,out] Dev             The virtio-rng device.
+  @param[in]     RNGValueLength  The number of bytes to return.
+  @param[out]    RNGValue        The buffer to fill.
+
+  @retval EFI_SUCCESS       RNGValue has been filled.
+  @retval EFI_DEVICE_ERROR  RNGValue could not be mapped, or the device could
+                            not be notified.
+
+**/
+STATIC
+EFI_STATUS
+VirtioRngGetDirect (
+  IN OUT VIRTIO_RNG_DEV *Dev,
+  IN     UINTN          RNGValueLength,
+  OUT    UINT8          *RNGValue
+  )
+{
+  UINTN                     Index;
+  UINT32                    BufferSize;
+  volatile VRING_DESC       *Desc;
+  EFI_STATUS                Status;
+  EFI_PHYSICAL_ADDRESS      DeviceAddress;
+  VOID                      *Mapping;
+
+  //
+  // Map RNGValue's system physical address to device address
+  //
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterWrite,
+             RNGValue,
+             RNGValueLength,
+             &DeviceAddress,
+             &Mapping
+             );
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  //
+  // The Virtio RNG device may return less data than we asked it to, and can
+  // only return MAX_UINT32 bytes per invocation. So loop as long as needed to
+  // get all the entropy we were asked for.
+  //
+  Desc = &Dev->Ring.Desc[Dev->PoolBuffers];
+  for (Index = 0; Index < RNGValueLength; Index += Dev->DirectLen) {
+    BufferSize = (UINT32)MIN (RNGValueLength - Index, (UINTN)MAX_UINT32);
+
+    Desc->Addr  = DeviceAddress + Index;
+    Desc->Len   = BufferSize;
+    Desc->Flags = VRING_DESC_F_WRITE;
+    Dev->DirectDone = FALSE;
+    VirtioRngPost (Dev, Dev->PoolBuffers);
+
+    do {
+      Status = VirtioRngWait (Dev);
+      if (EFI_ERROR (Status)) {
+        Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Mapping);
+        return EFI_DEVICE_ERROR;
+      }
+    } while (!Dev->DirectDone);
+
+    ASSERT (Dev->DirectLen > 0);
+    ASSERT (Dev->DirectLen <= BufferSize);
+  }
+
+  Dev->DirectBytes += RNGValueLength;
+
+  //
+  // Unmap the device buffer before the caller accesses it.
+  //
+  Status = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Mapping);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+  return EFI_SUCCESS;
+}
+
 /**
   Produces and returns an RNG value using either the default or specified RNG
   algorithm.
@@ -128,14 +427,8 @@ VirtioRngGetRNG (
   )
 {
   VIRTIO_RNG_DEV            *Dev;
-  DESC_INDICES              Indices;
-  volatile UINT8            *Buffer;
-  UINTN                     Index;
-  UINT32                    Len;
-  UINT32                    BufferSize;
+  EFI_TPL                   OldTpl;
   EFI_STATUS                Status;
-  EFI_PHYSICAL_ADDRESS      DeviceAddress;
-  VOID                      *Mapping;
 
   if (This == NULL || RNGValueLength == 0 || RNGValue == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -149,77 +442,110 @@ VirtioRngGetRNG (
     return EFI_UNSUPPORTED;
   }
 
-  Buffer = (volatile UINT8 *)AllocatePool (RNGValueLength);
-  if (Buffer == NULL) {
-    return EFI_DEVICE_ERROR;
+  Dev = VIRTIO_ENTROPY_SOURCE_FROM_RNG (This);
+
+  //
+  // The pool and the ring are shared by all callers.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (RNGValueLength > VIRTIO_RNG_POOL_BUFFER_SIZE) {
+    Status = VirtioRngGetDirect (Dev, RNGValueLength, RNGValue);
+  } else {
+    Status = VirtioRngGetFromPool (Dev, RNGValueLength, RNGValue);
   }
+  gBS->RestoreTPL (OldTpl);
 
-  Dev = VIRTIO_ENTROPY_SOURCE_FROM_RNG (This);
+  return Status;
+}
+
+/**
+  Allocate and map the entropy pool, and post all of its buffers to the
+  device. The device must be live (VSTAT_DRIVER_OK).
+
+  @param[in,out] Dev  The virtio-rng device.
+
+  @return  Status codes from VirtIo->AllocateSharedPages(),
+           VirtioMapAllBytesInSharedBuffer() or VirtIo->SetQueueNotify().
+
+  @retval EFI_SUCCESS  The pool is set up, and the device may already be
+                       filling it.
+
+**/
+STATIC
+EFI_STATUS
+VirtioRngInitPool (
+  IN OUT VIRTIO_RNG_DEV *Dev
+  )
+{
+  EFI_STATUS Status;
+  UINT16     DescIdx;
+
+  //
+  // Keep one descriptor for VirtioRngGetDirect().
   //
-  // Map Buffer's system physical address to device address
+  Dev->PoolBuffers = (UINT16)MIN (Dev->Ring.QueueSize - 1,
+                               VIRTIO_RNG_POOL_BUFFERS);
+
+  //
+  // The pool is shared between guest and hypervisor, and stays mapped as a
+  // BusMasterCommonBuffer for the lifetime of the device.
   //
+  Status = Dev->VirtIo->AllocateSharedPages (Dev->VirtIo, 1, &Dev->Pool);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  ZeroMem (Dev->Pool, EFI_PAGE_SIZE);
+
   Status = VirtioMapAllBytesInSharedBuffer (
              Dev->VirtIo,
-             VirtioOperationBusMasterWrite,
-             (VOID *)Buffer,
-             RNGValueLength,
-             &DeviceAddress,
-             &Mapping
+             VirtioOperationBusMasterCommonBuffer,
+             Dev->Pool,
+             EFI_PAGE_SIZE,
+             &Dev->PoolDeviceBase,
+             &Dev->PoolMap
              );
   if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeBuffer;
+    goto FreeSharedPool;
   }
 
   //
-  // The Virtio RNG device may return less data than we asked it to, and can
-  // only return MAX_UINT32 bytes per invocation. So loop as long as needed to
-  // get all the entropy we were asked for.
+  // We poll, the host should not send interrupts.
   //
-  for (Index = 0; Index < RNGValueLength; Index += Len) {
-    BufferSize = (UINT32)MIN (RNGValueLength - Index, (UINTN)MAX_UINT32);
+  *Dev->Ring.Avail.Flags = (UINT16)VRING_AVAIL_F_NO_INTERRUPT;
 
-    VirtioPrepare (&Dev->Ring, &Indices);
-    VirtioAppendDesc (&Dev->Ring,
-      DeviceAddress + Index,
-      BufferSize,
-      VRING_DESC_F_WRITE,
-      &Indices);
-
-    if (VirtioFlush (Dev->VirtIo, 0, &Dev->Ring, &Indices, &Len) !=
-        EFI_SUCCESS) {
-      Status = EFI_DEVICE_ERROR;
-      goto UnmapBuffer;
-    }
-    ASSERT (Len > 0);
-    ASSERT (Len <= BufferSize);
-  }
+  MemoryFence ();
+  Dev->LastUsed  = *Dev->Ring.Used.Idx;
+  Dev->NextAvail = *Dev->Ring.Avail.Idx;
 
   //
-  // Unmap the device buffer before accessing it.
+  // virtio-0.9.5, 2.4.1.1 Placing Buffers into the Descriptor Table
   //
-  Status = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Mapping);
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeBuffer;
+  for (DescIdx = 0; DescIdx < Dev->PoolBuffers; DescIdx++) {
+    Dev->Ring.Desc[DescIdx].Addr  = Dev->PoolDeviceBase +
+                                    DescIdx * VIRTIO_RNG_POOL_BUFFER_SIZE;
+    Dev->Ring.Desc[DescIdx].Len   = VIRTIO_RNG_POOL_BUFFER_SIZE;
+    Dev->Ring.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
+    Dev->Ring.Desc[DescIdx].Next  = 0;
+    VirtioRngPost (Dev, DescIdx);
   }
 
-  for (Index = 0; Index < RNGValueLength; Index++) {
-    RNGValue[Index] = Buffer[Index];
-  }
-  Status = EFI_SUCCESS;
-
-UnmapBuffer:
   //
-  // If we are reached here due to the error then unmap the buffer otherwise
-  // the buffer is already unmapped after VirtioFlush().
+  // If we fail to kick the host, the device may have seen the buffers
+  // anyway; stop it before tearing anything down.
   //
+  Status = VirtioRngKick (Dev);
   if (EFI_ERROR (Status)) {
-    Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Mapping);
+    Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
+    goto UnmapPool;
   }
 
-FreeBuffer:
-  FreePool ((VOID *)Buffer);
+  return EFI_SUCCESS;
+
+UnmapPool:
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->PoolMap);
+
+FreeSharedPool:
+  Dev->VirtIo->FreeSharedPages (Dev->VirtIo, 1, Dev->Pool);
   return Status;
 }
 
@@ -299,9 +625,10 @@ VirtioRngInit (
   }
 
   //
-  // VirtioRngGetRNG() uses one descriptor
+  // The entropy pool needs at least one descriptor, and VirtioRngGetDirect()
+  // one more
   //
-  if (QueueSize < 1) {
+  if (QueueSize < 2) {
     Status = EFI_UNSUPPORTED;
     goto Failed;
   }
@@ -370,6 +697,14 @@ VirtioRngInit (
     goto UnmapQueue;
   }
 
+  //
+  // Start filling the entropy pool.
+  //
+  Status = VirtioRngInitPool (Dev);
+  if (EFI_ERROR (Status)) {
+    goto UnmapQueue;
+  }
+
   //
   // populate the exported interface's attributes
   //
@@ -410,6 +745,9 @@ VirtioRngUninit (
   //
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
 
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->PoolMap);
+  Dev->VirtIo->FreeSharedPages (Dev->VirtIo, 1, Dev->Pool);
+
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
 
   VirtioRingUninit (Dev->VirtIo, &Dev->Ring);
@@ -439,6 +777,10 @@ VirtioRngExitBoot (
   //
   Dev = Context;
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
+
+  DEBUG ((DEBUG_INFO, "%a: served %Lu bytes from the pool in %Lu refills, "
+    "%Lu bytes directly\n", __FUNCTION__, Dev->PoolBytes, Dev->Refills,
+    Dev->DirectBytes));
 }
 
 
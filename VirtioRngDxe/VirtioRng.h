@@ -19,6 +19,17 @@
 
 #define VIRTIO_RNG_SIG SIGNATURE_32 ('V', 'R', 'N', 'G')
 
+//
+// The entropy pool: up to VIRTIO_RNG_POOL_BUFFERS buffers of
+// VIRTIO_RNG_POOL_BUFFER_SIZE bytes each, in one permanently mapped page, are
+// kept posted to the device. Descriptor #N belongs to pool buffer #N; the
+// descriptor after the last pool buffer's is used for requests larger than
+// VIRTIO_RNG_POOL_BUFFER_SIZE, which the device fills in the caller's buffer
+// directly.
+//
+#define VIRTIO_RNG_POOL_BUFFERS     8
+#define VIRTIO_RNG_POOL_BUFFER_SIZE (EFI_PAGE_SIZE / VIRTIO_RNG_POOL_BUFFERS)
+
 typedef struct {
   //
   // Parts of this structure are initialized / torn down in various functions
@@ -33,6 +44,36 @@ typedef struct {
   VRING                     Ring;           // VirtioRingInit       2
   EFI_RNG_PROTOCOL          Rng;            // VirtioRngInit        1
   VOID                      *RingMap;       // VirtioRingMap        2
+  VOID                      *Pool;          // VirtioRngInitPool    2
+  EFI_PHYSICAL_ADDRESS      PoolDeviceBase; // VirtioRngInitPool    2
+  VOID                      *PoolMap;       // VirtioRngInitPool    2
+  UINT16                    PoolBuffers;    // VirtioRngInitPool    2
+  UINT16                    LastUsed;       // VirtioRngInitPool    2
+  UINT16                    NextAvail;      // VirtioRngInitPool    2
+  BOOLEAN                   AvailPending;   // VirtioRngInitPool    2
+
+  //
+  // The pool buffers the device has filled, oldest first, with the number of
+  // bytes in each, and how many bytes of the oldest one have been served.
+  //
+  UINT16                    FilledId[VIRTIO_RNG_POOL_BUFFERS];
+  UINT32                    FilledLen[VIRTIO_RNG_POOL_BUFFERS];
+  UINT16                    FilledHead;     // VirtioRngInitPool    2
+  UINT16                    FilledCount;    // VirtioRngInitPool    2
+  UINT32                    FilledOffset;   // VirtioRngInitPool    2
+
+  //
+  // Completion of the request that fills the caller's buffer directly.
+  //
+  BOOLEAN                   DirectDone;
+  UINT32                    DirectLen;
+
+  //
+  // Statistics, logged at ExitBootServices().
+  //
+  UINT64                    PoolBytes;
+  UINT64                    DirectBytes;
+  UINT64                    Refills;
 } VIRTIO_RNG_DEV;
 
 #define VIRTIO_ENTROPY_SOURCE_FROM_RNG(RngPointer) \
@@ -58,6 +58,13 @@ XenGrantTableGetFreeEntry (
 
   EfiAcquireLock (&mGrantListLock);
   Ref = GrantList[0];
+  if (Ref == 0) {
+    //
+    // The free list is empty.
+    //
+    EfiReleaseLock (&mGrantListLock);
+    return 0;
+  }
   ASSERT (Ref >= NR_RESERVED_ENTRIES && Ref < NR_GRANT_ENTRIES);
   GrantList[0] = GrantList[Ref];
 #ifdef GNT_DEBUG
@@ -81,6 +88,9 @@ XenGrantTableGrantAccess (
 
   ASSERT (GrantTable != NULL);
   Ref = XenGrantTableGetFreeEntry ();
+  if (Ref == 0) {
+    return 0;
+  }
   GrantTable[Ref].frame = (UINT32)Frame;
   GrantTable[Ref].domid = DomainId;
   MemoryFence ();
@@ -187,6 +197,10 @@ XenBusGrantAccess (
   )
 {
   *RefPtr = XenGrantTableGrantAccess (DomainId, Frame, ReadOnly);
+  if (*RefPtr == 0) {
+    DEBUG ((DEBUG_ERROR, "%a: the grant table is exhausted\n", __FUNCTION__));
+    return EFI_OUT_OF_RESOURCES;
+  }
   return EFI_SUCCESS;
 }
 
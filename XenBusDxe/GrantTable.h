@@ -42,6 +42,9 @@ XenGrantTableDeinit (
   @param Frame      Frame Number of the page to grant access to.
   @param ReadOnly   Provide read-only or read-write access.
   @param RefPtr     Reference number of the grant will be written to this pointer.
+
+  @retval EFI_SUCCESS           The access has been granted.
+  @retval EFI_OUT_OF_RESOURCES  The grant table has no free entry.
 **/
 EFI_STATUS
 EFIAPI
@@ -141,6 +141,12 @@ XenBusAddDevice (
       goto out;
     }
 
+    //
+    // The driver of the device reads most of these nodes, and of the
+    // backend ones, while connecting.
+    //
+    XenStoreCacheDirectory (DevicePath, "");
+
     State = XenBusReadDriverState (DevicePath);
     if (State != XenbusStateInitialising) {
       /*
@@ -161,6 +167,7 @@ XenBusAddDevice (
       Status = EFI_NOT_FOUND;
       goto out;
     }
+    XenStoreCacheDirectory (BackendPath, "");
 
     Private = AllocateCopyPool (sizeof (*Private), &gXenBusPrivateData);
     Private->XenBusIo.Type = AsciiStrDup (Type);
@@ -56,6 +56,42 @@ typedef struct {
   UINT32      Len;
 } WRITE_REQUEST;
 
+/* Read cache of a XenStore directory, see XenStoreCacheDirectory (). */
+#define XENSTORE_CACHE_DIR_SIGNATURE SIGNATURE_32 ('X','S','c','d')
+typedef struct {
+  UINT32          Signature;
+  LIST_ENTRY      Link;
+
+  /* Path of the directory. */
+  CHAR8           *Path;
+
+  /* Watch reporting the changes below Path. */
+  XENSTORE_WATCH  *Watch;
+
+  /* Cached children, XENSTORE_CACHE_ENTRY. */
+  LIST_ENTRY      Entries;
+
+  /* Entries holds every child of Path; a child not in it does not exist. */
+  BOOLEAN         Complete;
+
+  /* Bumped by every invalidation, to detect changes during a fill. */
+  UINT32          Generation;
+} XENSTORE_CACHE_DIR;
+
+#define XENSTORE_CACHE_DIR_FROM_LINK(l) \
+  CR (l, XENSTORE_CACHE_DIR, Link, XENSTORE_CACHE_DIR_SIGNATURE)
+
+typedef struct {
+  LIST_ENTRY  Link;
+  CHAR8       *Path;
+  /* NUL terminated, as returned by XenStoreRead (). */
+  CHAR8       *Value;
+  UINT32      Len;
+} XENSTORE_CACHE_ENTRY;
+
+/* Number of XS_READ requests in flight while filling a directory cache. */
+#define XENSTORE_CACHE_READ_BURST  16
+
 /* Register callback to watch subtree (node) in the XenStore. */
 #define XENSTORE_WATCH_SIGNATURE SIGNATURE_32 ('X','S','w','a')
 struct _XENSTORE_WATCH
@@ -65,6 +101,9 @@ struct _XENSTORE_WATCH
 
   /* Path being watched. */
   CHAR8       *Node;
+
+  /* The directory cache this watch invalidates, NULL for client watches. */
+  XENSTORE_CACHE_DIR *CacheDir;
 };
 
 #define XENSTORE_WATCH_FROM_LINK(l) \
@@ -149,6 +188,19 @@ typedef struct {
 
   /** Handle for XenStore events. */
   EFI_EVENT EventChannelEvent;
+
+  /**
+   * Directories in the read cache, XENSTORE_CACHE_DIR.
+   */
+  LIST_ENTRY CacheDirs;
+
+  /**
+   * Number of XS_WRITE replies not read yet, see XenStoreWrite ().
+   */
+  UINT32 DeferredReplies;
+
+  /** First failure among the deferred replies. */
+  XENSTORE_STATUS DeferredStatus;
 } XENSTORE_PRIVATE;
 
 //
@@ -275,6 +327,99 @@ XenStoreFindWatch (
   return NULL;
 }
 
+/**
+  Check whether a path is a directory or one of its descendants.
+
+  @param Path       The path to check.
+  @param Directory  The directory.
+
+  @retval TRUE   Path is Directory, or is below it.
+  @retval FALSE  Otherwise.
+**/
+STATIC
+BOOLEAN
+XenStorePathIsUnder (
+  IN CONST CHAR8 *Path,
+  IN CONST CHAR8 *Directory
+  )
+{
+  UINTN Len;
+
+  Len = AsciiStrLen (Directory);
+  return (AsciiStrnCmp (Path, Directory, Len) == 0 &&
+          (Path[Len] == '\0' || Path[Len] == '/'));
+}
+
+/**
+  Drop the entries of a directory cache.
+
+  @param CacheDir  The directory cache.
+**/
+STATIC
+VOID
+XenStoreCacheFlush (
+  IN OUT XENSTORE_CACHE_DIR *CacheDir
+  )
+{
+  XENSTORE_CACHE_ENTRY *CacheEntry;
+  LIST_ENTRY *Entry;
+
+  while (!IsListEmpty (&CacheDir->Entries)) {
+    Entry = GetFirstNode (&CacheDir->Entries);
+    RemoveEntryList (Entry);
+    CacheEntry = BASE_CR (Entry, XENSTORE_CACHE_ENTRY, Link);
+    FreePool (CacheEntry->Path);
+    FreePool (CacheEntry->Value);
+    FreePool (CacheEntry);
+  }
+  CacheDir->Complete = FALSE;
+}
+
+/**
+  Drop the cached values of a path and of its descendants.
+
+  @param Path  The path that changed.
+**/
+STATIC
+VOID
+XenStoreCacheInvalidate (
+  IN CONST CHAR8 *Path
+  )
+{
+  XENSTORE_CACHE_DIR *CacheDir;
+  XENSTORE_CACHE_ENTRY *CacheEntry;
+  LIST_ENTRY *DirEntry;
+  LIST_ENTRY *Entry;
+
+  for (DirEntry = GetFirstNode (&xs.CacheDirs);
+       !IsNull (&xs.CacheDirs, DirEntry);
+       DirEntry = GetNextNode (&xs.CacheDirs, DirEntry)) {
+    CacheDir = XENSTORE_CACHE_DIR_FROM_LINK (DirEntry);
+    if (!XenStorePathIsUnder (Path, CacheDir->Path) &&
+        !XenStorePathIsUnder (CacheDir->Path, Path)) {
+      continue;
+    }
+
+    Entry = GetFirstNode (&CacheDir->Entries);
+    while (!IsNull (&CacheDir->Entries, Entry)) {
+      CacheEntry = BASE_CR (Entry, XENSTORE_CACHE_ENTRY, Link);
+      Entry = GetNextNode (&CacheDir->Entries, Entry);
+      if (XenStorePathIsUnder (CacheEntry->Path, Path)) {
+        RemoveEntryList (&CacheEntry->Link);
+        FreePool (CacheEntry->Path);
+        FreePool (CacheEntry->Value);
+        FreePool (CacheEntry);
+      }
+    }
+    //
+    // A node may have been added, so a missing entry no longer means that
+    // the node does not exist.
+    //
+    CacheDir->Complete = FALSE;
+    CacheDir->Generation++;
+  }
+}
+
 //
 // Public Utility Functions
 // API comments for these methods can be found in XenStore.h
@@ -640,7 +785,15 @@ XenStoreProcessMessage (
       XenStoreFindWatch (Message->u.Watch.Vector[XS_WATCH_TOKEN]);
     DEBUG ((DEBUG_INFO, "XenStore: Watch event %a\n",
             Message->u.Watch.Vector[XS_WATCH_TOKEN]));
-    if (Message->u.Watch.Handle != NULL) {
+    if (Message->u.Watch.Handle != NULL &&
+        Message->u.Watch.Handle->CacheDir != NULL) {
+      //
+      // A change below a cached directory; nobody waits for this event.
+      //
+      XenStoreCacheInvalidate (Message->u.Watch.Vector[XS_WATCH_PATH]);
+      FreePool((VOID*)Message->u.Watch.Vector);
+      FreePool(Message);
+    } else if (Message->u.Watch.Handle != NULL) {
       EfiAcquireLock (&xs.WatchEventsLock);
       InsertHeadList (&xs.WatchEvents, &Message->Link);
       EfiReleaseLock (&xs.WatchEventsLock);
@@ -761,31 +914,27 @@ XenStoreReadReply (
 }
 
 /**
-  Send a message with an optionally multi-part body to the XenStore service.
+  Send a message with an optionally multi-part body to the XenStore service,
+  without waiting for the reply.
 
   @param Transaction    The transaction to use for this request.
   @param RequestType    The type of message to send.
   @param WriteRequest   Pointers to the body sections of the request.
   @param NumRequests    The number of body sections in the request.
-  @param LenPtr         The returned length of the reply.
-  @param ResultPtr      The returned body of the reply.
 
   @return  XENSTORE_STATUS_SUCCESS on success.  Otherwise an errno indicating
            the cause of failure.
 **/
 STATIC
 XENSTORE_STATUS
-XenStoreTalkv (
+XenStoreSend (
   IN  CONST XENSTORE_TRANSACTION *Transaction,
   IN  enum xsd_sockmsg_type   RequestType,
   IN  CONST WRITE_REQUEST     *WriteRequest,
-  IN  UINT32                  NumRequests,
-  OUT UINT32                  *LenPtr OPTIONAL,
-  OUT VOID                    **ResultPtr OPTIONAL
+  IN  UINT32                  NumRequests
   )
 {
   struct xsd_sockmsg Message;
-  void *Return = NULL;
   UINT32 Index;
   XENSTORE_STATUS Status;
 
@@ -803,33 +952,58 @@ XenStoreTalkv (
 
   Status = XenStoreWriteStore (&Message, sizeof (Message));
   if (Status != XENSTORE_STATUS_SUCCESS) {
-    DEBUG ((DEBUG_ERROR, "XenStoreTalkv failed %d\n", Status));
-    goto Error;
+    DEBUG ((DEBUG_ERROR, "XenStoreSend failed %d\n", Status));
+    return Status;
   }
 
   for (Index = 0; Index < NumRequests; Index++) {
     Status = XenStoreWriteStore (WriteRequest[Index].Data, WriteRequest[Index].Len);
     if (Status != XENSTORE_STATUS_SUCCESS) {
-      DEBUG ((DEBUG_ERROR, "XenStoreTalkv failed %d\n", Status));
-      goto Error;
+      DEBUG ((DEBUG_ERROR, "XenStoreSend failed %d\n", Status));
+      return Status;
     }
   }
 
-  Status = XenStoreReadReply ((enum xsd_sockmsg_type *)&Message.type, LenPtr, &Return);
+  return XENSTORE_STATUS_SUCCESS;
+}
+
+/**
+  Wait for the reply to the oldest request sent with XenStoreSend.
+
+  The XenStore service answers the requests in the order they were sent.
+
+  @param RequestType    The type of the request.
+  @param LenPtr         The returned length of the reply.
+  @param ResultPtr      The returned body of the reply.
 
-Error:
+  @return  XENSTORE_STATUS_SUCCESS on success.  Otherwise an errno indicating
+           the cause of failure.
+**/
+STATIC
+XENSTORE_STATUS
+XenStoreReceive (
+  IN  enum xsd_sockmsg_type   RequestType,
+  OUT UINT32                  *LenPtr OPTIONAL,
+  OUT VOID                    **ResultPtr OPTIONAL
+  )
+{
+  enum xsd_sockmsg_type Type;
+  VOID *Return = NULL;
+  XENSTORE_STATUS Status;
+
+  Status = XenStoreReadReply (&Type, LenPtr, &Return);
   if (Status != XENSTORE_STATUS_SUCCESS) {
     return Status;
   }
 
-  if (Message.type == XS_ERROR) {
+  if (Type == XS_ERROR) {
     Status = XenStoreGetError (Return);
     FreePool (Return);
     return Status;
   }
 
   /* Reply is either error or an echo of our request message type. */
-  ASSERT ((enum xsd_sockmsg_type)Message.type == RequestType);
+  ASSERT (Type == RequestType);
 
   if (ResultPtr) {
     *ResultPtr = Return;
@@ -840,6 +1014,168 @@ Error:
   return XENSTORE_STATUS_SUCCESS;
 }
 
+/**
+  Read the replies to the writes XenStoreWrite did not wait for, and record
+  the first failure for XenStoreTransactionEnd.
+**/
+STATIC
+VOID
+XenStoreCollectDeferredReplies (
+  VOID
+  )
+{
+  XENSTORE_STATUS Status;
+
+  while (xs.DeferredReplies > 0) {
+    xs.DeferredReplies--;
+    Status = XenStoreReceive (XS_WRITE, NULL, NULL);
+    if (Status != XENSTORE_STATUS_SUCCESS &&
+        xs.DeferredStatus == XENSTORE_STATUS_SUCCESS) {
+      DEBUG ((DEBUG_ERROR, "XenStore: write in transaction failed (%d)\n",
+              Status));
+      xs.DeferredStatus = Status;
+    }
+  }
+}
+
+/**
+  Send a message with an optionally multi-part body to the XenStore service.
+
+  @param Transaction    The transaction to use for this request.
+  @param RequestType    The type of message to send.
+  @param WriteRequest   Pointers to the body sections of the request.
+  @param NumRequests    The number of body sections in the request.
+  @param LenPtr         The returned length of the reply.
+  @param ResultPtr      The returned body of the reply.
+
+  @return  XENSTORE_STATUS_SUCCESS on success.  Otherwise an errno indicating
+           the cause of failure.
+**/
+STATIC
+XENSTORE_STATUS
+XenStoreTalkv (
+  IN  CONST XENSTORE_TRANSACTION *Transaction,
+  IN  enum xsd_sockmsg_type   RequestType,
+  IN  CONST WRITE_REQUEST     *WriteRequest,
+  IN  UINT32                  NumRequests,
+  OUT UINT32                  *LenPtr OPTIONAL,
+  OUT VOID                    **ResultPtr OPTIONAL
+  )
+{
+  XENSTORE_STATUS Status;
+
+  //
+  // Replies come back in order; get the deferred ones out of the way.
+  //
+  XenStoreCollectDeferredReplies ();
+
+  Status = XenStoreSend (Transaction, RequestType, WriteRequest, NumRequests);
+  if (Status != XENSTORE_STATUS_SUCCESS) {
+    return Status;
+  }
+
+  return XenStoreReceive (RequestType, LenPtr, ResultPtr);
+}
+
+/**
+  Look a path up in the read cache.
+
+  @param Path    The path to read.
+  @param Status  The result of the read, when it is served from the cache.
+  @param LenPtr  The length of the value.
+  @param Result  A copy of the value, to be freed by the caller.
+
+  @retval TRUE   The read has been served from the cache.
+  @retval FALSE  The XenStore has to be asked.
+**/
+STATIC
+BOOLEAN
+XenStoreCacheLookup (
+  IN  CONST CHAR8     *Path,
+  OUT XENSTORE_STATUS *Status,
+  OUT UINT32          *LenPtr OPTIONAL,
+  OUT VOID            **Result
+  )
+{
+  XENSTORE_CACHE_DIR *CacheDir;
+  XENSTORE_CACHE_ENTRY *CacheEntry;
+  XENSTORE_WATCH *Watch;
+  LIST_ENTRY *DirEntry;
+  LIST_ENTRY *Entry;
+  UINTN DirLen;
+  BOOLEAN Watched;
+
+  if (IsListEmpty (&xs.CacheDirs)) {
+    return FALSE;
+  }
+
+  //
+  // Apply the changes the XenStore has already reported.
+  //
+  while (xs.XenStore->rsp_cons != xs.XenStore->rsp_prod) {
+    if (XenStoreProcessMessage () != XENSTORE_STATUS_SUCCESS) {
+      return FALSE;
+    }
+  }
+
+  //
+  // A client watching the path reads it when its watch fires, and must see
+  // the value that fired it, whether or not our own watch event has been
+  // processed yet.
+  //
+  Watched = FALSE;
+  EfiAcquireLock (&xs.RegisteredWatchesLock);
+  for (Entry = GetFirstNode (&xs.RegisteredWatches);
+       !IsNull (&xs.RegisteredWatches, Entry) && !Watched;
+       Entry = GetNextNode (&xs.RegisteredWatches, Entry)) {
+    Watch = XENSTORE_WATCH_FROM_LINK (Entry);
+    Watched = (Watch->CacheDir == NULL &&
+               XenStorePathIsUnder (Path, Watch->Node));
+  }
+  EfiReleaseLock (&xs.RegisteredWatchesLock);
+  if (Watched) {
+    return FALSE;
+  }
+
+  for (DirEntry = GetFirstNode (&xs.CacheDirs);
+       !IsNull (&xs.CacheDirs, DirEntry);
+       DirEntry = GetNextNode (&xs.CacheDirs, DirEntry)) {
+    CacheDir = XENSTORE_CACHE_DIR_FROM_LINK (DirEntry);
+    if (!XenStorePathIsUnder (Path, CacheDir->Path)) {
+      continue;
+    }
+
+    for (Entry = GetFirstNode (&CacheDir->Entries);
+         !IsNull (&CacheDir->Entries, Entry);
+         Entry = GetNextNode (&CacheDir->Entries, Entry)) {
+      CacheEntry = BASE_CR (Entry, XENSTORE_CACHE_ENTRY, Link);
+      if (AsciiStrCmp (CacheEntry->Path, Path) == 0) {
+        *Result = AllocateCopyPool (CacheEntry->Len + 1, CacheEntry->Value);
+        if (*Result == NULL) {
+          return FALSE;
+        }
+        if (LenPtr != NULL) {
+          *LenPtr = CacheEntry->Len;
+        }
+        *Status = XENSTORE_STATUS_SUCCESS;
+        return TRUE;
+      }
+    }
+
+    //
+    // A direct child missing from a complete directory does not exist.
+    //
+    DirLen = AsciiStrLen (CacheDir->Path);
+    if (CacheDir->Complete && Path[DirLen] == '/' &&
+        AsciiStrStr (&Path[DirLen + 1], "/") == NULL) {
+      *Status = XENSTORE_STATUS_ENOENT;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 /**
   Wrapper for XenStoreTalkv allowing easy transmission of a message with
   a single, contiguous, message body.
@@ -1052,6 +1388,7 @@ XenStoreInit (
   InitializeListHead (&xs.ReplyList);
   InitializeListHead (&xs.WatchEvents);
   InitializeListHead (&xs.RegisteredWatches);
+  InitializeListHead (&xs.CacheDirs);
 
   EfiInitializeLock (&xs.ReplyLock, TPL_NOTIFY);
   EfiInitializeLock (&xs.RegisteredWatchesLock, TPL_NOTIFY);
@@ -1068,6 +1405,21 @@ XenStoreDeinit (
   IN XENBUS_DEVICE *Dev
   )
 {
+  //
+  // Drop the directory caches, along with the watches that keep them
+  // up to date.
+  //
+  while (!IsListEmpty (&xs.CacheDirs)) {
+    XENSTORE_CACHE_DIR *CacheDir;
+
+    CacheDir = XENSTORE_CACHE_DIR_FROM_LINK (GetFirstNode (&xs.CacheDirs));
+    RemoveEntryList (&CacheDir->Link);
+    XenStoreUnregisterWatch (CacheDir->Watch);
+    XenStoreCacheFlush (CacheDir);
+    FreePool (CacheDir->Path);
+    FreePool (CacheDir);
+  }
+
   //
   // Emptying the list RegisteredWatches, but this list should already be
   // empty. Every driver that is using Watches should unregister them when
@@ -1203,6 +1555,16 @@ XenStoreRead (
   XENSTORE_STATUS Status;
 
   Path = XenStoreJoin (DirectoryPath, Node);
+  if (Transaction == XST_NIL &&
+      XenStoreCacheLookup (Path, &Status, LenPtr, &Value)) {
+    FreePool (Path);
+    if (Status != XENSTORE_STATUS_SUCCESS) {
+      return Status;
+    }
+    *Result = Value;
+    return XENSTORE_STATUS_SUCCESS;
+  }
+
   Status = XenStoreSingle (Transaction, XS_READ, Path, LenPtr, &Value);
   FreePool (Path);
   if (Status != XENSTORE_STATUS_SUCCESS) {
@@ -1232,7 +1594,19 @@ XenStoreWrite (
   WriteRequest[1].Data = (VOID *) Str;
   WriteRequest[1].Len = (UINT32)AsciiStrLen (Str);
 
-  Status = XenStoreTalkv (Transaction, XS_WRITE, WriteRequest, 2, NULL, NULL);
+  if (Transaction != XST_NIL) {
+    //
+    // Do not wait for the reply; a failure is reported when the
+    // transaction ends, and fails the whole transaction.
+    //
+    Status = XenStoreSend (Transaction, XS_WRITE, WriteRequest, 2);
+    if (Status == XENSTORE_STATUS_SUCCESS) {
+      xs.DeferredReplies++;
+    }
+  } else {
+    Status = XenStoreTalkv (Transaction, XS_WRITE, WriteRequest, 2, NULL, NULL);
+  }
+  XenStoreCacheInvalidate (Path);
   FreePool (Path);
 
   return Status;
@@ -1250,6 +1624,7 @@ XenStoreRemove (
 
   Path = XenStoreJoin (DirectoryPath, Node);
   Status = XenStoreSingle (Transaction, XS_RM, Path, NULL, NULL);
+  XenStoreCacheInvalidate (Path);
   FreePool (Path);
 
   return Status;
@@ -1263,6 +1638,9 @@ XenStoreTransactionStart (
   CHAR8 *IdStr;
   XENSTORE_STATUS Status;
 
+  XenStoreCollectDeferredReplies ();
+  xs.DeferredStatus = XENSTORE_STATUS_SUCCESS;
+
   Status = XenStoreSingle (XST_NIL, XS_TRANSACTION_START, "", NULL,
                            (VOID **) &IdStr);
   if (Status == XENSTORE_STATUS_SUCCESS) {
@@ -1280,11 +1658,193 @@ XenStoreTransactionEnd (
   )
 {
   CHAR8 AbortStr[2];
+  XENSTORE_STATUS WriteStatus;
+  XENSTORE_STATUS Status;
+
+  XenStoreCollectDeferredReplies ();
+  WriteStatus = xs.DeferredStatus;
+  xs.DeferredStatus = XENSTORE_STATUS_SUCCESS;
+  if (WriteStatus != XENSTORE_STATUS_SUCCESS) {
+    Abort = TRUE;
+  }
 
   AbortStr[0] = Abort ? 'F' : 'T';
   AbortStr[1] = '\0';
 
-  return XenStoreSingle (Transaction, XS_TRANSACTION_END, AbortStr, NULL, NULL);
+  Status = XenStoreSingle (Transaction, XS_TRANSACTION_END, AbortStr, NULL, NULL);
+  if (WriteStatus != XENSTORE_STATUS_SUCCESS) {
+    return WriteStatus;
+  }
+  return Status;
+}
+
+/**
+  Fill a directory cache with the values of the nodes of the directory.
+
+  The directory is listed first, then the values are read in bursts of
+  XENSTORE_CACHE_READ_BURST requests, each sent before waiting for any of
+  the replies.
+
+  @param CacheDir  The directory cache.
+
+  @return  XENSTORE_STATUS_SUCCESS on success.  Otherwise an errno indicating
+           the cause of failure.
+**/
+STATIC
+XENSTORE_STATUS
+XenStoreCacheFill (
+  IN OUT XENSTORE_CACHE_DIR *CacheDir
+  )
+{
+  CONST CHAR8 **Nodes;
+  UINT32 NodeCount;
+  UINT32 Generation;
+  UINT32 Index;
+  UINT32 Sent;
+  UINT32 Received;
+  UINT32 Len;
+  CHAR8 *Paths[XENSTORE_CACHE_READ_BURST];
+  WRITE_REQUEST WriteRequest;
+  XENSTORE_CACHE_ENTRY *CacheEntry;
+  VOID *Value;
+  XENSTORE_STATUS Status;
+
+  XenStoreCacheFlush (CacheDir);
+
+  Status = XenStoreListDirectory (XST_NIL, CacheDir->Path, "",
+                                  &NodeCount, &Nodes);
+  if (Status != XENSTORE_STATUS_SUCCESS) {
+    return Status;
+  }
+  Generation = CacheDir->Generation;
+
+  for (Index = 0; Index < NodeCount; Index += Sent) {
+    for (Sent = 0;
+         Sent < XENSTORE_CACHE_READ_BURST && Index + Sent < NodeCount;
+         Sent++) {
+      Paths[Sent] = XenStoreJoin (CacheDir->Path, Nodes[Index + Sent]);
+      WriteRequest.Data = Paths[Sent];
+      WriteRequest.Len = (UINT32)AsciiStrSize (Paths[Sent]);
+      Status = XenStoreSend (XST_NIL, XS_READ, &WriteRequest, 1);
+      if (Status != XENSTORE_STATUS_SUCCESS) {
+        FreePool (Paths[Sent]);
+        break;
+      }
+    }
+
+    //
+    // Every request that went out gets a reply, which has to be read even
+    // if the burst is cut short.
+    //
+    for (Received = 0; Received < Sent; Received++) {
+      if (XenStoreReceive (XS_READ, &Len, &Value) !=
+          XENSTORE_STATUS_SUCCESS) {
+        //
+        // The node is gone, or is not readable; leave it out of the cache.
+        //
+        FreePool (Paths[Received]);
+        continue;
+      }
+      CacheEntry = AllocatePool (sizeof *CacheEntry);
+      if (CacheEntry == NULL) {
+        FreePool (Value);
+        FreePool (Paths[Received]);
+        Status = XENSTORE_STATUS_ENOMEM;
+        continue;
+      }
+      CacheEntry->Path = Paths[Received];
+      CacheEntry->Value = Value;
+      CacheEntry->Len = Len;
+      InsertTailList (&CacheDir->Entries, &CacheEntry->Link);
+    }
+
+    if (Status != XENSTORE_STATUS_SUCCESS) {
+      break;
+    }
+  }
+  FreePool ((VOID *)Nodes);
+
+  //
+  // A change reported while the values were read may not be reflected in
+  // them; start over on the next request.
+  //
+  if (Status != XENSTORE_STATUS_SUCCESS ||
+      CacheDir->Generation != Generation) {
+    XenStoreCacheFlush (CacheDir);
+    return Status;
+  }
+
+  CacheDir->Complete = TRUE;
+  return XENSTORE_STATUS_SUCCESS;
+}
+
+XENSTORE_STATUS
+XenStoreCacheDirectory (
+  IN CONST CHAR8 *DirectoryPath,
+  IN CONST CHAR8 *Node
+  )
+{
+  CHAR8 *Path;
+  XENSTORE_CACHE_DIR *CacheDir;
+  LIST_ENTRY *Entry;
+  XENSTORE_STATUS Status;
+
+  Path = XenStoreJoin (DirectoryPath, Node);
+
+  for (Entry = GetFirstNode (&xs.CacheDirs);
+       !IsNull (&xs.CacheDirs, Entry);
+       Entry = GetNextNode (&xs.CacheDirs, Entry)) {
+    CacheDir = XENSTORE_CACHE_DIR_FROM_LINK (Entry);
+    if (AsciiStrCmp (CacheDir->Path, Path) == 0) {
+      FreePool (Path);
+      if (CacheDir->Complete) {
+        return XENSTORE_STATUS_SUCCESS;
+      }
+      return XenStoreCacheFill (CacheDir);
+    }
+  }
+
+  CacheDir = AllocateZeroPool (sizeof *CacheDir);
+  if (CacheDir == NULL) {
+    FreePool (Path);
+    return XENSTORE_STATUS_ENOMEM;
+  }
+  CacheDir->Signature = XENSTORE_CACHE_DIR_SIGNATURE;
+  CacheDir->Path = Path;
+  InitializeListHead (&CacheDir->Entries);
+
+  Status = XenStoreRegisterWatch (Path, "", &CacheDir->Watch);
+  if (Status != XENSTORE_STATUS_SUCCESS) {
+    FreePool (Path);
+    FreePool (CacheDir);
+    return Status;
+  }
+
+  //
+  // From now on, the events of the watch invalidate the cache instead of
+  // being queued. The one the XenStore sends when a watch is set may
+  // already be queued; nobody waits for it.
+  //
+  EfiAcquireLock (&xs.RegisteredWatchesLock);
+  CacheDir->Watch->CacheDir = CacheDir;
+  EfiReleaseLock (&xs.RegisteredWatchesLock);
+
+  EfiAcquireLock (&xs.WatchEventsLock);
+  Entry = GetFirstNode (&xs.WatchEvents);
+  while (!IsNull (&xs.WatchEvents, Entry)) {
+    XENSTORE_MESSAGE *Message = XENSTORE_MESSAGE_FROM_LINK (Entry);
+    Entry = GetNextNode (&xs.WatchEvents, Entry);
+    if (Message->u.Watch.Handle == CacheDir->Watch) {
+      RemoveEntryList (&Message->Link);
+      FreePool ((VOID*)Message->u.Watch.Vector);
+      FreePool (Message);
+    }
+  }
+  EfiReleaseLock (&xs.WatchEventsLock);
+
+  InsertTailList (&xs.CacheDirs, &CacheDir->Link);
+
+  return XenStoreCacheFill (CacheDir);
 }
 
 XENSTORE_STATUS
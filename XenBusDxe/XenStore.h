@@ -97,6 +97,9 @@ XenStoreRead (
   @param Node           The basename of the file to write.
   @param Str            The NUL terminated string of data to write.
 
+  Within a transaction, the write does not wait for the reply of the
+  XenStore; a failure is returned by XenStoreTransactionEnd () instead.
+
   @return  On success, XENSTORE_STATUS_SUCCESS. Otherwise an errno value
            indicating the type of failure.
 **/
@@ -149,6 +152,9 @@ XenStoreTransactionStart (
   @param Abort        If TRUE, the transaction is discarded
                       instead of committed.
 
+  If one of the writes of the transaction has failed, the transaction is
+  discarded, and the error of the first failed write is returned.
+
   @return  On success, XENSTORE_STATUS_SUCCESS. Otherwise an errno value
            indicating the type of failure.
 **/
@@ -158,6 +164,27 @@ XenStoreTransactionEnd (
   IN BOOLEAN                Abort
   );
 
+/**
+  Cache the nodes of a XenStore directory.
+
+  The directory is listed, and the values of its nodes are read with
+  pipelined requests. XenStoreRead () then serves reads of these nodes,
+  outside of a transaction, from the cache, which a watch on the directory
+  keeps up to date. Nodes below the path of a client watch are always read
+  from the XenStore.
+
+  @param DirectoryPath  The dirname of the directory to cache.
+  @param Node           The basename of the directory to cache.
+
+  @return  On success, XENSTORE_STATUS_SUCCESS. Otherwise an errno value
+           indicating the type of failure.
+**/
+XENSTORE_STATUS
+XenStoreCacheDirectory (
+  IN CONST CHAR8 *DirectoryPath,
+  IN CONST CHAR8 *Node
+  );
+
 /**
   Printf formatted write to a XenStore file.
 
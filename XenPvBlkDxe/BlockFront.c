@@ -16,6 +16,11 @@
 #include <IndustryStandard/Xen/io/protocols.h>
 #include <IndustryStandard/Xen/io/xenbus.h>
 
+//
+// How often the ring is polled while BlockIo2 transfers are in flight.
+//
+#define XEN_BLOCK_FRONT_POLL_PERIOD  EFI_TIMER_PERIOD_MILLISECONDS (1)
+
 /**
   Helper to read an integer from XenStore.
 
@@ -69,19 +74,95 @@ XenPvBlockFree (
   )
 {
   XENBUS_PROTOCOL *XenBusIo = Dev->XenBusIo;
+  LIST_ENTRY *Entry;
+  XEN_BLOCK_FRONT_IO *IoData;
+  XEN_BLOCK_FRONT_GRANT *Grant;
+  UINTN Index;
+
+  while (!IsListEmpty (&Dev->FreeIos)) {
+    Entry = GetFirstNode (&Dev->FreeIos);
+    RemoveEntryList (Entry);
+    IoData = BASE_CR (Entry, XEN_BLOCK_FRONT_IO, Link);
+    if (IoData->IndirectPage != NULL) {
+      FreePages (IoData->IndirectPage, 1);
+    }
+    FreePool (IoData);
+  }
+  while (!IsListEmpty (&Dev->FreeGrants)) {
+    Entry = GetFirstNode (&Dev->FreeGrants);
+    RemoveEntryList (Entry);
+    Grant = BASE_CR (Entry, XEN_BLOCK_FRONT_GRANT, Link);
+    XenBusIo->GrantEndAccess (XenBusIo, Grant->Ref);
+    FreePages (Grant->Page, 1);
+    FreePool (Grant);
+  }
 
-  if (Dev->RingRef != 0) {
-    XenBusIo->GrantEndAccess (XenBusIo, Dev->RingRef);
+  for (Index = 0; Index < XEN_BLOCK_FRONT_MAX_RING_PAGES; Index++) {
+    if (Dev->RingRef[Index] != 0) {
+      XenBusIo->GrantEndAccess (XenBusIo, Dev->RingRef[Index]);
+    }
   }
   if (Dev->Ring.sring != NULL) {
-    FreePages (Dev->Ring.sring, 1);
+    FreePages (Dev->Ring.sring, 1 << Dev->RingPageOrder);
   }
   if (Dev->EventChannel != 0) {
     XenBusIo->EventChannelClose (XenBusIo, Dev->EventChannel);
   }
+  if (Dev->PollEvent != NULL) {
+    gBS->CloseEvent (Dev->PollEvent);
+  }
   FreePool (Dev);
 }
 
+/**
+  Remove the nodes written by XenPvBlockFrontInitialization from the frontend
+  directory.
+
+  @param Dev  A XEN_BLOCK_FRONT_DEVICE instance.
+**/
+STATIC
+VOID
+XenPvBlockRemoveNodes (
+  IN XEN_BLOCK_FRONT_DEVICE *Dev
+  )
+{
+  XENBUS_PROTOCOL *XenBusIo = Dev->XenBusIo;
+  CHAR8 Node[sizeof "ring-refNN"];
+  UINT32 Index;
+
+  if (Dev->RingPageOrder == 0) {
+    XenBusIo->XsRemove (XenBusIo, XST_NIL, "ring-ref");
+  } else {
+    for (Index = 0; Index < (1U << Dev->RingPageOrder); Index++) {
+      AsciiSPrint (Node, sizeof Node, "ring-ref%u", Index);
+      XenBusIo->XsRemove (XenBusIo, XST_NIL, Node);
+    }
+    XenBusIo->XsRemove (XenBusIo, XST_NIL, "ring-page-order");
+  }
+  XenBusIo->XsRemove (XenBusIo, XST_NIL, "event-channel");
+  XenBusIo->XsRemove (XenBusIo, XST_NIL, "protocol");
+  if (Dev->MediaInfo.FeaturePersistent) {
+    XenBusIo->XsRemove (XenBusIo, XST_NIL, "feature-persistent");
+  }
+}
+
+/**
+  Timer notification polling the ring while BlockIo2 transfers are in flight.
+
+  @param Event    The poll timer.
+  @param Context  A XEN_BLOCK_FRONT_DEVICE instance.
+**/
+STATIC
+VOID
+EFIAPI
+XenPvBlockPollNotify (
+  IN EFI_EVENT Event,
+  IN VOID      *Context
+  )
+{
+  XenPvBlockAsyncIoPoll (Context);
+}
+
 /**
   Wait until until the backend has reached the ExpectedState.
 
@@ -151,6 +232,9 @@ XenPvBlockFrontInitialization (
   XenbusState State;
   UINT64 Value;
   CHAR8 *Params;
+  CHAR8 Node[sizeof "ring-refNN"];
+  UINT32 Index;
+  EFI_STATUS EfiStatus;
 
   ASSERT (NodeName != NULL);
 
@@ -163,6 +247,15 @@ XenPvBlockFrontInitialization (
   Dev->NodeName = NodeName;
   Dev->XenBusIo = XenBusIo;
   Dev->DeviceId = XenBusIo->DeviceId;
+  InitializeListHead (&Dev->FreeGrants);
+  InitializeListHead (&Dev->FreeIos);
+
+  EfiStatus = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_CALLBACK,
+                                XenPvBlockPollNotify, Dev, &Dev->PollEvent);
+  if (EFI_ERROR (EfiStatus)) {
+    FreePool (Dev);
+    return EfiStatus;
+  }
 
   XenBusIo->XsRead (XenBusIo, XST_NIL, "device-type", (VOID**)&DeviceType);
   if (AsciiStrCmp (DeviceType, "cdrom") == 0) {
@@ -195,14 +288,42 @@ XenPvBlockFrontInitialization (
   Dev->DomainId = (domid_t)Value;
   XenBusIo->EventChannelAllocate (XenBusIo, Dev->DomainId, &Dev->EventChannel);
 
-  SharedRing = (blkif_sring_t*) AllocatePages (1);
+  //
+  // A ring spanning several pages lets more requests be in flight.
+  //
+  Value = 0;
+  XenBusReadUint64 (XenBusIo, "max-ring-page-order", TRUE, &Value);
+  Dev->RingPageOrder = (UINT32)MIN (Value, XEN_BLOCK_FRONT_MAX_RING_PAGE_ORDER);
+
+  //
+  // With persistent grants, the backend keeps our data pages mapped across
+  // requests, and we copy the data through them.
+  //
+  Value = 0;
+  XenBusReadUint64 (XenBusIo, "feature-persistent", TRUE, &Value);
+  if (Value == 1) {
+    Dev->MediaInfo.FeaturePersistent = TRUE;
+  } else {
+    Dev->MediaInfo.FeaturePersistent = FALSE;
+  }
+
+  SharedRing = (blkif_sring_t*) AllocatePages (1 << Dev->RingPageOrder);
+  if (SharedRing == NULL) {
+    goto Error;
+  }
   SHARED_RING_INIT (SharedRing);
-  FRONT_RING_INIT (&Dev->Ring, SharedRing, EFI_PAGE_SIZE);
-  XenBusIo->GrantAccess (XenBusIo,
-                         Dev->DomainId,
-                         (INTN) SharedRing >> EFI_PAGE_SHIFT,
-                         FALSE,
-                         &Dev->RingRef);
+  FRONT_RING_INIT (&Dev->Ring, SharedRing,
+                   EFI_PAGES_TO_SIZE (1 << Dev->RingPageOrder));
+  for (Index = 0; Index < (1U << Dev->RingPageOrder); Index++) {
+    EfiStatus = XenBusIo->GrantAccess (XenBusIo,
+                            Dev->DomainId,
+                            ((UINTN) SharedRing >> EFI_PAGE_SHIFT) + Index,
+                            FALSE,
+                            &Dev->RingRef[Index]);
+    if (EFI_ERROR (EfiStatus)) {
+      goto Error;
+    }
+  }
 
 Again:
   Status = XenBusIo->XsTransactionStart (XenBusIo, &Transaction);
@@ -211,11 +332,29 @@ Again:
     goto Error;
   }
 
-  Status = XenBusIo->XsPrintf (XenBusIo, &Transaction, NodeName, "ring-ref", "%d",
-                               Dev->RingRef);
-  if (Status != XENSTORE_STATUS_SUCCESS) {
-    DEBUG ((DEBUG_ERROR, "XenPvBlk: Failed to write ring-ref.\n"));
-    goto AbortTransaction;
+  if (Dev->RingPageOrder == 0) {
+    Status = XenBusIo->XsPrintf (XenBusIo, &Transaction, NodeName, "ring-ref",
+                                 "%d", Dev->RingRef[0]);
+    if (Status != XENSTORE_STATUS_SUCCESS) {
+      DEBUG ((DEBUG_ERROR, "XenPvBlk: Failed to write ring-ref.\n"));
+      goto AbortTransaction;
+    }
+  } else {
+    Status = XenBusIo->XsPrintf (XenBusIo, &Transaction, NodeName,
+                                 "ring-page-order", "%u", Dev->RingPageOrder);
+    if (Status != XENSTORE_STATUS_SUCCESS) {
+      DEBUG ((DEBUG_ERROR, "XenPvBlk: Failed to write ring-page-order.\n"));
+      goto AbortTransaction;
+    }
+    for (Index = 0; Index < (1U << Dev->RingPageOrder); Index++) {
+      AsciiSPrint (Node, sizeof Node, "ring-ref%u", Index);
+      Status = XenBusIo->XsPrintf (XenBusIo, &Transaction, NodeName, Node,
+                                   "%d", Dev->RingRef[Index]);
+      if (Status != XENSTORE_STATUS_SUCCESS) {
+        DEBUG ((DEBUG_ERROR, "XenPvBlk: Failed to write %a.\n", Node));
+        goto AbortTransaction;
+      }
+    }
   }
   Status = XenBusIo->XsPrintf (XenBusIo, &Transaction, NodeName,
                                "event-channel", "%d", Dev->EventChannel);
@@ -229,6 +368,14 @@ Again:
     DEBUG ((DEBUG_ERROR, "XenPvBlk: Failed to write protocol.\n"));
     goto AbortTransaction;
   }
+  if (Dev->MediaInfo.FeaturePersistent) {
+    Status = XenBusIo->XsPrintf (XenBusIo, &Transaction, NodeName,
+                                 "feature-persistent", "%d", 1);
+    if (Status != XENSTORE_STATUS_SUCCESS) {
+      DEBUG ((DEBUG_ERROR, "XenPvBlk: Failed to write feature-persistent.\n"));
+      goto AbortTransaction;
+    }
+  }
 
   Status = XenBusIo->SetState (XenBusIo, &Transaction, XenbusStateConnected);
   if (Status != XENSTORE_STATUS_SUCCESS) {
@@ -236,10 +383,19 @@ Again:
     goto AbortTransaction;
   }
 
+  //
+  // The writes above are acknowledged only when the transaction ends, so a
+  // failed write shows up here. The transaction is closed in any case.
+  //
   Status = XenBusIo->XsTransactionEnd (XenBusIo, &Transaction, FALSE);
   if (Status == XENSTORE_STATUS_EAGAIN) {
     goto Again;
   }
+  if (Status != XENSTORE_STATUS_SUCCESS) {
+    DEBUG ((DEBUG_ERROR, "XenPvBlk: Failed to end transaction, %d\n",
+      Status));
+    goto Error;
+  }
 
   XenBusIo->RegisterWatchBackend (XenBusIo, "state", &Dev->StateWatchToken);
 
@@ -302,17 +458,35 @@ Again:
     Dev->MediaInfo.FeatureFlushCache = FALSE;
   }
 
+  //
+  // Indirect requests carry more segments than fit in a ring slot; they are
+  // only worth it when the backend takes more than that.
+  //
+  Value = 0;
+  XenBusReadUint64 (XenBusIo, "feature-max-indirect-segments", TRUE, &Value);
+  if (Value > BLKIF_MAX_SEGMENTS_PER_REQUEST) {
+    Dev->MediaInfo.MaxIndirectSegments =
+      (UINT32)MIN (Value, XEN_BLOCK_FRONT_MAX_SEGMENTS);
+    Dev->MaxSegments = Dev->MediaInfo.MaxIndirectSegments;
+  } else {
+    Dev->MediaInfo.MaxIndirectSegments = 0;
+    Dev->MaxSegments = BLKIF_MAX_SEGMENTS_PER_REQUEST;
+  }
+
   DEBUG ((DEBUG_INFO, "XenPvBlk: New disk with %ld sectors of %d bytes\n",
           Dev->MediaInfo.Sectors, Dev->MediaInfo.SectorSize));
+  DEBUG ((DEBUG_INFO,
+          "XenPvBlk: %d ring pages, %d segments per request, "
+          "persistent grants %a\n",
+          1 << Dev->RingPageOrder, Dev->MaxSegments,
+          Dev->MediaInfo.FeaturePersistent ? "on" : "off"));
 
   *DevPtr = Dev;
   return EFI_SUCCESS;
 
 Error2:
   XenBusIo->UnregisterWatch (XenBusIo, Dev->StateWatchToken);
-  XenBusIo->XsRemove (XenBusIo, XST_NIL, "ring-ref");
-  XenBusIo->XsRemove (XenBusIo, XST_NIL, "event-channel");
-  XenBusIo->XsRemove (XenBusIo, XST_NIL, "protocol");
+  XenPvBlockRemoveNodes (Dev);
   goto Error;
 AbortTransaction:
   XenBusIo->XsTransactionEnd (XenBusIo, &Transaction, TRUE);
@@ -391,9 +565,7 @@ XenPvBlockFrontShutdown (
 
 Close:
   XenBusIo->UnregisterWatch (XenBusIo, Dev->StateWatchToken);
-  XenBusIo->XsRemove (XenBusIo, XST_NIL, "ring-ref");
-  XenBusIo->XsRemove (XenBusIo, XST_NIL, "event-channel");
-  XenBusIo->XsRemove (XenBusIo, XST_NIL, "protocol");
+  XenPvBlockRemoveNodes (Dev);
 
   XenPvBlockFree (Dev);
 }
@@ -416,56 +588,298 @@ XenPvBlockWaitSlot (
   }
 }
 
+/**
+  Wait until the requests in flight hold few enough grants that a new request
+  can take NumGrants more, within XEN_BLOCK_FRONT_MAX_GRANTS.
+
+  @param Dev        A XEN_BLOCK_FRONT_DEVICE instance.
+  @param NumGrants  The number of grants the new request needs.
+**/
+STATIC
 VOID
+XenPvBlockWaitGrants (
+  IN XEN_BLOCK_FRONT_DEVICE *Dev,
+  IN UINTN                  NumGrants
+  )
+{
+  ASSERT (NumGrants <= XEN_BLOCK_FRONT_MAX_GRANTS);
+  while (Dev->GrantsInUse + NumGrants > XEN_BLOCK_FRONT_MAX_GRANTS) {
+    XenPvBlockAsyncIoPoll (Dev);
+  }
+}
+
+/**
+  Take a page from the pool of persistently granted pages, or grant a new one.
+
+  @param Dev  A XEN_BLOCK_FRONT_DEVICE instance.
+
+  @return The granted page, or NULL if it could not be allocated, or the grant
+          table is exhausted.
+**/
+STATIC
+XEN_BLOCK_FRONT_GRANT *
+XenPvBlockGetGrant (
+  IN XEN_BLOCK_FRONT_DEVICE *Dev
+  )
+{
+  XENBUS_PROTOCOL *XenBusIo = Dev->XenBusIo;
+  XEN_BLOCK_FRONT_GRANT *Grant;
+  LIST_ENTRY *Entry;
+  EFI_STATUS Status;
+
+  if (!IsListEmpty (&Dev->FreeGrants)) {
+    Entry = GetFirstNode (&Dev->FreeGrants);
+    RemoveEntryList (Entry);
+    return BASE_CR (Entry, XEN_BLOCK_FRONT_GRANT, Link);
+  }
+
+  Grant = AllocatePool (sizeof *Grant);
+  if (Grant == NULL) {
+    return NULL;
+  }
+  Grant->Page = AllocatePages (1);
+  if (Grant->Page == NULL) {
+    FreePool (Grant);
+    return NULL;
+  }
+  Status = XenBusIo->GrantAccess (XenBusIo, Dev->DomainId,
+                                  (UINTN) Grant->Page >> EFI_PAGE_SHIFT,
+                                  FALSE, &Grant->Ref);
+  if (EFI_ERROR (Status)) {
+    FreePages (Grant->Page, 1);
+    FreePool (Grant);
+    return NULL;
+  }
+  return Grant;
+}
+
+/**
+  Take a request from the free list, or allocate a new one.
+
+  @param Dev  A XEN_BLOCK_FRONT_DEVICE instance.
+
+  @return The request, or NULL if it could not be allocated.
+**/
+STATIC
+XEN_BLOCK_FRONT_IO *
+XenPvBlockGetIo (
+  IN XEN_BLOCK_FRONT_DEVICE *Dev
+  )
+{
+  XEN_BLOCK_FRONT_IO *IoData;
+  LIST_ENTRY *Entry;
+
+  if (!IsListEmpty (&Dev->FreeIos)) {
+    Entry = GetFirstNode (&Dev->FreeIos);
+    RemoveEntryList (Entry);
+    return BASE_CR (Entry, XEN_BLOCK_FRONT_IO, Link);
+  }
+
+  IoData = AllocateZeroPool (sizeof *IoData);
+  if (IoData != NULL) {
+    IoData->Dev = Dev;
+  }
+  return IoData;
+}
+
+/**
+  Release the grants of a request, and return its persistent grants to the
+  pool.
+
+  @param IoData  The request.
+**/
+STATIC
+VOID
+XenPvBlockReleaseGrants (
+  IN OUT XEN_BLOCK_FRONT_IO *IoData
+  )
+{
+  XEN_BLOCK_FRONT_DEVICE *Dev = IoData->Dev;
+  XENBUS_PROTOCOL *XenBusIo = Dev->XenBusIo;
+  INT32 Index;
+
+  ASSERT (Dev->GrantsInUse >= (UINTN)(IoData->NumRef + IoData->NumGrants));
+  Dev->GrantsInUse -= IoData->NumRef + IoData->NumGrants;
+
+  for (Index = 0; Index < IoData->NumRef; Index++) {
+    XenBusIo->GrantEndAccess (XenBusIo, IoData->GrantRef[Index]);
+  }
+  IoData->NumRef = 0;
+
+  for (Index = 0; Index < IoData->NumGrants; Index++) {
+    InsertHeadList (&Dev->FreeGrants, &IoData->Grants[Index]->Link);
+  }
+  IoData->NumGrants = 0;
+}
+
+/**
+  Put a request on the ring.
+
+  Without persistent grants, the pages of IoData->Buffer are granted to the
+  backend for the duration of the request. With them, the data is copied
+  through pages from the pool, which the backend keeps mapped.
+
+  @param IoData  The request.
+
+  @retval EFI_SUCCESS           The request is on the ring.
+  @retval EFI_OUT_OF_RESOURCES  The pages or the grants for the request could
+                                not be allocated.
+**/
+STATIC
+EFI_STATUS
 XenPvBlockAsyncIo (
-  IN OUT XEN_BLOCK_FRONT_IO *IoData,
-  IN     BOOLEAN            IsWrite
+  IN OUT XEN_BLOCK_FRONT_IO *IoData
   )
 {
   XEN_BLOCK_FRONT_DEVICE *Dev = IoData->Dev;
   XENBUS_PROTOCOL *XenBusIo = Dev->XenBusIo;
+  BOOLEAN Persistent = Dev->MediaInfo.FeaturePersistent;
   blkif_request_t *Request;
+  blkif_request_indirect_t *Indirect;
+  struct blkif_request_segment *Segments;
+  XEN_BLOCK_FRONT_GRANT *Grant;
+  grant_ref_t IndirectRef;
   RING_IDX RingIndex;
   BOOLEAN Notify;
   INT32 NumSegments, Index;
-  UINTN Start, End;
+  UINTN Start, End, Offset;
+  EFI_STATUS Status;
 
   // Can't io at non-sector-aligned location
   ASSERT(!(IoData->Sector & ((Dev->MediaInfo.SectorSize / 512) - 1)));
   // Can't io non-sector-sized amounts
   ASSERT(!(IoData->Size & (Dev->MediaInfo.SectorSize - 1)));
-  // Can't io non-sector-aligned buffer
-  ASSERT(!((UINTN) IoData->Buffer & (Dev->MediaInfo.SectorSize - 1)));
+  // Can't io non-sector-aligned buffer, unless the data is copied
+  ASSERT(Persistent ||
+         !((UINTN) IoData->Buffer & (Dev->MediaInfo.SectorSize - 1)));
+
+  IoData->NumRef = 0;
+  IoData->NumGrants = 0;
 
   Start = (UINTN) IoData->Buffer & ~EFI_PAGE_MASK;
-  End = ((UINTN) IoData->Buffer + IoData->Size + EFI_PAGE_SIZE - 1) & ~EFI_PAGE_MASK;
-  IoData->NumRef = NumSegments = (INT32)((End - Start) / EFI_PAGE_SIZE);
+  if (Persistent) {
+    NumSegments = (INT32)EFI_SIZE_TO_PAGES (IoData->Size);
+  } else {
+    End = ((UINTN) IoData->Buffer + IoData->Size + EFI_PAGE_SIZE - 1) & ~EFI_PAGE_MASK;
+    NumSegments = (INT32)((End - Start) / EFI_PAGE_SIZE);
+  }
 
-  ASSERT (NumSegments <= BLKIF_MAX_SEGMENTS_PER_REQUEST);
+  ASSERT (NumSegments <= (INT32)Dev->MaxSegments);
+
+  //
+  // Keep the grants in flight within budget, counting the one for the
+  // segment descriptors of an indirect request.
+  //
+  XenPvBlockWaitGrants (Dev, (UINTN)NumSegments +
+                               (NumSegments > BLKIF_MAX_SEGMENTS_PER_REQUEST));
+
+  //
+  // Gather the pages before taking a ring slot, so that failing to allocate
+  // them leaves the ring untouched.
+  //
+  if (Persistent) {
+    for (Index = 0; Index < NumSegments; Index++) {
+      Grant = XenPvBlockGetGrant (Dev);
+      if (Grant == NULL) {
+        XenPvBlockReleaseGrants (IoData);
+        return EFI_OUT_OF_RESOURCES;
+      }
+      IoData->Grants[IoData->NumGrants++] = Grant;
+      Dev->GrantsInUse++;
+      if (IoData->IsWrite) {
+        Offset = (UINTN)Index * EFI_PAGE_SIZE;
+        CopyMem (Grant->Page, IoData->Buffer + Offset,
+                 MIN (EFI_PAGE_SIZE, IoData->Size - Offset));
+      }
+    }
+  }
+
+  Segments = NULL;
+  IndirectRef = 0;
+  if (NumSegments > BLKIF_MAX_SEGMENTS_PER_REQUEST) {
+    if (Persistent) {
+      Grant = XenPvBlockGetGrant (Dev);
+      if (Grant == NULL) {
+        XenPvBlockReleaseGrants (IoData);
+        return EFI_OUT_OF_RESOURCES;
+      }
+      IoData->Grants[IoData->NumGrants++] = Grant;
+      Dev->GrantsInUse++;
+      Segments = Grant->Page;
+      IndirectRef = Grant->Ref;
+    } else {
+      if (IoData->IndirectPage == NULL) {
+        IoData->IndirectPage = AllocatePages (1);
+        if (IoData->IndirectPage == NULL) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+      }
+      Segments = IoData->IndirectPage;
+      Status = XenBusIo->GrantAccess (XenBusIo, Dev->DomainId,
+                         (UINTN) IoData->IndirectPage >> EFI_PAGE_SHIFT,
+                         TRUE, &IndirectRef);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      IoData->GrantRef[IoData->NumRef++] = IndirectRef;
+      Dev->GrantsInUse++;
+    }
+  }
 
   XenPvBlockWaitSlot (Dev);
   RingIndex = Dev->Ring.req_prod_pvt;
   Request = RING_GET_REQUEST (&Dev->Ring, RingIndex);
 
-  Request->operation = IsWrite ? BLKIF_OP_WRITE : BLKIF_OP_READ;
-  Request->nr_segments = (UINT8)NumSegments;
-  Request->handle = Dev->DeviceId;
-  Request->id = (UINTN) IoData;
-  Request->sector_number = IoData->Sector;
+  if (Segments == NULL) {
+    Request->operation = IoData->IsWrite ? BLKIF_OP_WRITE : BLKIF_OP_READ;
+    Request->nr_segments = (UINT8)NumSegments;
+    Request->handle = Dev->DeviceId;
+    Request->id = (UINTN) IoData;
+    Request->sector_number = IoData->Sector;
+    Segments = Request->seg;
+  } else {
+    Indirect = (blkif_request_indirect_t *) Request;
+    Indirect->operation = BLKIF_OP_INDIRECT;
+    Indirect->indirect_op = IoData->IsWrite ? BLKIF_OP_WRITE : BLKIF_OP_READ;
+    Indirect->nr_segments = (UINT16)NumSegments;
+    Indirect->handle = Dev->DeviceId;
+    Indirect->id = (UINTN) IoData;
+    Indirect->sector_number = IoData->Sector;
+    Indirect->indirect_grefs[0] = IndirectRef;
+  }
 
   for (Index = 0; Index < NumSegments; Index++) {
-    Request->seg[Index].first_sect = 0;
-    Request->seg[Index].last_sect = EFI_PAGE_SIZE / 512 - 1;
+    Segments[Index].first_sect = 0;
+    Segments[Index].last_sect = EFI_PAGE_SIZE / 512 - 1;
   }
-  Request->seg[0].first_sect = (UINT8)(((UINTN) IoData->Buffer & EFI_PAGE_MASK) / 512);
-  Request->seg[NumSegments - 1].last_sect =
-      (UINT8)((((UINTN) IoData->Buffer + IoData->Size - 1) & EFI_PAGE_MASK) / 512);
-  for (Index = 0; Index < NumSegments; Index++) {
-    UINTN Data = Start + Index * EFI_PAGE_SIZE;
-    XenBusIo->GrantAccess (XenBusIo, Dev->DomainId,
-                           Data >> EFI_PAGE_SHIFT, IsWrite,
-                           &Request->seg[Index].gref);
-    IoData->GrantRef[Index] = Request->seg[Index].gref;
+  if (Persistent) {
+    //
+    // The data starts at the beginning of each pool page.
+    //
+    Segments[NumSegments - 1].last_sect =
+      (UINT8)(((IoData->Size - 1) & EFI_PAGE_MASK) / 512);
+    for (Index = 0; Index < NumSegments; Index++) {
+      Segments[Index].gref = IoData->Grants[Index]->Ref;
+    }
+  } else {
+    Segments[0].first_sect = (UINT8)(((UINTN) IoData->Buffer & EFI_PAGE_MASK) / 512);
+    Segments[NumSegments - 1].last_sect =
+        (UINT8)((((UINTN) IoData->Buffer + IoData->Size - 1) & EFI_PAGE_MASK) / 512);
+    for (Index = 0; Index < NumSegments; Index++) {
+      UINTN Data = Start + Index * EFI_PAGE_SIZE;
+      Status = XenBusIo->GrantAccess (XenBusIo, Dev->DomainId,
+                         Data >> EFI_PAGE_SHIFT, IoData->IsWrite,
+                         &Segments[Index].gref);
+      if (EFI_ERROR (Status)) {
+        //
+        // The slot has not been published; just give back the grants.
+        //
+        XenPvBlockReleaseGrants (IoData);
+        return Status;
+      }
+      IoData->GrantRef[IoData->NumRef++] = Segments[Index].gref;
+      Dev->GrantsInUse++;
+    }
   }
 
   Dev->Ring.req_prod_pvt = RingIndex + 1;
@@ -482,25 +896,184 @@ XenPvBlockAsyncIo (
               ReturnCode));
     }
   }
+  return EFI_SUCCESS;
 }
 
-EFI_STATUS
-XenPvBlockIo (
+/**
+  Drop a reference to a transfer, and complete it when it was the last one.
+
+  @param Dev       A XEN_BLOCK_FRONT_DEVICE instance.
+  @param Transfer  The transfer.
+**/
+STATIC
+VOID
+XenPvBlockTransferRelease (
+  IN XEN_BLOCK_FRONT_DEVICE   *Dev,
+  IN XEN_BLOCK_FRONT_TRANSFER *Transfer
+  )
+{
+  ASSERT (Transfer->Pending > 0);
+  if (--Transfer->Pending != 0 || Transfer->Token == NULL) {
+    return;
+  }
+
+  Transfer->Token->TransactionStatus = Transfer->Status;
+  gBS->SignalEvent (Transfer->Token->Event);
+  FreePool (Transfer);
+
+  ASSERT (Dev->AsyncTransfers > 0);
+  if (--Dev->AsyncTransfers == 0) {
+    gBS->SetTimer (Dev->PollEvent, TimerCancel, 0);
+  }
+}
+
+/**
+  Finish a request the backend has responded to.
+
+  @param IoData  The request.
+  @param Status  The outcome of the request.
+**/
+STATIC
+VOID
+XenPvBlockCompleteIo (
   IN OUT XEN_BLOCK_FRONT_IO *IoData,
-  IN     BOOLEAN            IsWrite
+  IN     EFI_STATUS         Status
+  )
+{
+  XEN_BLOCK_FRONT_DEVICE *Dev = IoData->Dev;
+  XEN_BLOCK_FRONT_TRANSFER *Transfer = IoData->Transfer;
+  UINTN Offset;
+  INT32 Index;
+
+  //
+  // With persistent grants, the data of a read is in the pool pages.
+  //
+  if (!IoData->IsWrite && !EFI_ERROR (Status) && IoData->NumGrants > 0) {
+    for (Index = 0, Offset = 0; Offset < IoData->Size;
+         Index++, Offset += EFI_PAGE_SIZE) {
+      CopyMem (IoData->Buffer + Offset, IoData->Grants[Index]->Page,
+               MIN (EFI_PAGE_SIZE, IoData->Size - Offset));
+    }
+  }
+  XenPvBlockReleaseGrants (IoData);
+
+  IoData->Status = Status;
+  if (EFI_ERROR (Status)) {
+    Transfer->Status = Status;
+  }
+  InsertHeadList (&Dev->FreeIos, &IoData->Link);
+
+  XenPvBlockTransferRelease (Dev, Transfer);
+}
+
+EFI_STATUS
+XenPvBlockTransfer (
+  IN     XEN_BLOCK_FRONT_DEVICE *Dev,
+  IN OUT UINT8                  *Buffer,
+  IN     UINTN                  Size,
+  IN     UINTN                  Sector,
+  IN     BOOLEAN                IsWrite,
+  IN     EFI_BLOCK_IO2_TOKEN    *Token OPTIONAL
   )
 {
+  XEN_BLOCK_FRONT_TRANSFER SyncTransfer;
+  XEN_BLOCK_FRONT_TRANSFER *Transfer;
+  XEN_BLOCK_FRONT_IO *IoData;
+  EFI_TPL OldTpl;
+  EFI_STATUS Status;
+  UINTN Length;
+  BOOLEAN Queued;
+
+  ASSERT (Size > 0);
+
+  if (Token == NULL) {
+    Transfer = &SyncTransfer;
+  } else {
+    Transfer = AllocatePool (sizeof *Transfer);
+    if (Transfer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+  Transfer->Status = EFI_SUCCESS;
+  Transfer->Token = Token;
+  //
+  // Hold a reference while queuing, so that the transfer does not complete
+  // before all of its requests are on the ring.
+  //
+  Transfer->Pending = 1;
+  Queued = FALSE;
+
   //
-  // Status value that correspond to an IO in progress.
+  // Keep the poll timer out while we use the ring.
   //
-  IoData->Status = EFI_ALREADY_STARTED;
-  XenPvBlockAsyncIo (IoData, IsWrite);
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  while (Size > 0) {
+    Length = Dev->MaxSegments * EFI_PAGE_SIZE;
+    if (!Dev->MediaInfo.FeaturePersistent &&
+        ((UINTN)Buffer & EFI_PAGE_MASK) != 0) {
+      Length -= EFI_PAGE_SIZE;
+    }
+    Length = MIN (Length, Size);
+
+    IoData = XenPvBlockGetIo (Dev);
+    if (IoData == NULL) {
+      Transfer->Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
+    IoData->Transfer = Transfer;
+    IoData->Buffer = Buffer;
+    IoData->Size = Length;
+    IoData->Sector = Sector;
+    IoData->IsWrite = IsWrite;
+    //
+    // Status value that correspond to an IO in progress.
+    //
+    IoData->Status = EFI_ALREADY_STARTED;
+
+    Transfer->Pending++;
+    Status = XenPvBlockAsyncIo (IoData);
+    if (EFI_ERROR (Status)) {
+      Transfer->Pending--;
+      InsertHeadList (&Dev->FreeIos, &IoData->Link);
+      Transfer->Status = Status;
+      break;
+    }
+    Queued = TRUE;
+
+    Buffer += Length;
+    Size -= Length;
+    Sector += Length / 512;
+  }
+
+  if (Token != NULL) {
+    if (!Queued) {
+      //
+      // Nothing is on the ring; fail the call rather than the token.
+      //
+      Status = Transfer->Status;
+      FreePool (Transfer);
+      gBS->RestoreTPL (OldTpl);
+      return Status;
+    }
+    if (Dev->AsyncTransfers++ == 0) {
+      gBS->SetTimer (Dev->PollEvent, TimerPeriodic,
+                     XEN_BLOCK_FRONT_POLL_PERIOD);
+    }
+  }
 
-  while (IoData->Status == EFI_ALREADY_STARTED) {
-    XenPvBlockAsyncIoPoll (IoData->Dev);
+  XenPvBlockTransferRelease (Dev, Transfer);
+
+  Status = EFI_SUCCESS;
+  if (Token == NULL) {
+    while (Transfer->Pending != 0) {
+      XenPvBlockAsyncIoPoll (Dev);
+    }
+    Status = Transfer->Status;
   }
 
-  return IoData->Status;
+  gBS->RestoreTPL (OldTpl);
+  return Status;
 }
 
 STATIC
@@ -544,6 +1117,13 @@ XenPvBlockSync (
   IN XEN_BLOCK_FRONT_DEVICE *Dev
   )
 {
+  EFI_TPL OldTpl;
+
+  //
+  // Keep the poll timer out while we use the ring.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
   if (Dev->MediaInfo.ReadWrite) {
     if (Dev->MediaInfo.FeatureBarrier) {
       XenPvBlockPushOperation (Dev, BLKIF_OP_WRITE_BARRIER, 0);
@@ -561,6 +1141,8 @@ XenPvBlockSync (
       break;
     }
   }
+
+  gBS->RestoreTPL (OldTpl);
 }
 
 VOID
@@ -590,25 +1172,17 @@ XenPvBlockAsyncIoPoll (
       switch (Response->operation) {
       case BLKIF_OP_READ:
       case BLKIF_OP_WRITE:
-        {
-          INT32 Index;
-
-          if (Status != BLKIF_RSP_OKAY) {
-            DEBUG ((DEBUG_ERROR,
-                    "XenPvBlk: "
-                    "%a error %d on %a at sector %Lx, num bytes %Lx\n",
-                    Response->operation == BLKIF_OP_READ ? "read" : "write",
-                    Status, IoData->Dev->NodeName,
-                    (UINT64)IoData->Sector,
-                    (UINT64)IoData->Size));
-          }
-
-          for (Index = 0; Index < IoData->NumRef; Index++) {
-            Dev->XenBusIo->GrantEndAccess (Dev->XenBusIo, IoData->GrantRef[Index]);
-          }
-
-          break;
+      case BLKIF_OP_INDIRECT:
+        if (Status != BLKIF_RSP_OKAY) {
+          DEBUG ((DEBUG_ERROR,
+                  "XenPvBlk: "
+                  "%a error %d on %a at sector %Lx, num bytes %Lx\n",
+                  IoData->IsWrite ? "write" : "read",
+                  Status, IoData->Dev->NodeName,
+                  (UINT64)IoData->Sector,
+                  (UINT64)IoData->Size));
         }
+        break;
 
       case BLKIF_OP_WRITE_BARRIER:
         if (Status != BLKIF_RSP_OKAY) {
@@ -630,7 +1204,7 @@ XenPvBlockAsyncIoPoll (
 
       Dev->Ring.rsp_cons = ++ConsumerIndex;
       if (IoData != NULL) {
-        IoData->Status = Status ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+        XenPvBlockCompleteIo (IoData, Status ? EFI_DEVICE_ERROR : EFI_SUCCESS);
       }
       if (Dev->Ring.rsp_cons != ConsumerIndex) {
         /* We reentered, we must not continue here */
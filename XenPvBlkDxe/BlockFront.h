@@ -14,17 +14,81 @@
 typedef struct _XEN_BLOCK_FRONT_DEVICE XEN_BLOCK_FRONT_DEVICE;
 typedef struct _XEN_BLOCK_FRONT_IO XEN_BLOCK_FRONT_IO;
 
+//
+// Largest shared ring we negotiate with the backend, as a page order.
+//
+#define XEN_BLOCK_FRONT_MAX_RING_PAGE_ORDER  2
+#define XEN_BLOCK_FRONT_MAX_RING_PAGES       (1 << XEN_BLOCK_FRONT_MAX_RING_PAGE_ORDER)
+
+//
+// Largest number of segments we put in an indirect request (1MB of data).
+// The segment descriptors of such a request fit in a single indirect page.
+//
+#define XEN_BLOCK_FRONT_MAX_SEGMENTS  256
+
+//
+// Most grants the requests of a device in flight hold for their data and
+// segment descriptors: two requests of the largest size. The grant table
+// (PcdXenGrantFrames pages of 512 entries) is shared by all Xen devices, so a
+// request that would take more waits for earlier requests to complete first.
+// New persistent grants are only made when the pool is empty, so the pool
+// never grows beyond this either.
+//
+#define XEN_BLOCK_FRONT_MAX_GRANTS  (2 * (XEN_BLOCK_FRONT_MAX_SEGMENTS + 1))
+
+//
+// A page granted to the backend once, and reused for the data of many
+// requests when the backend supports persistent grants.
+//
+typedef struct {
+  LIST_ENTRY              Link;
+  VOID                    *Page;
+  grant_ref_t             Ref;
+} XEN_BLOCK_FRONT_GRANT;
+
+//
+// A read or write of a BlockIo or BlockIo2 caller. It is split into as many
+// ring requests as needed, and is complete when Pending drops to zero.
+//
+typedef struct {
+  EFI_STATUS              Status;
+  UINTN                   Pending;
+  EFI_BLOCK_IO2_TOKEN     *Token;   ///< NULL for a blocking transfer.
+} XEN_BLOCK_FRONT_TRANSFER;
+
+//
+// One ring request.
+//
 struct _XEN_BLOCK_FRONT_IO
 {
-  XEN_BLOCK_FRONT_DEVICE  *Dev;
-  UINT8                   *Buffer;
-  UINTN                   Size;
-  UINTN                   Sector; ///< 512 bytes sector.
-
-  grant_ref_t             GrantRef[BLKIF_MAX_SEGMENTS_PER_REQUEST];
-  INT32                   NumRef;
-
-  EFI_STATUS              Status;
+  LIST_ENTRY                Link;
+  XEN_BLOCK_FRONT_DEVICE    *Dev;
+  XEN_BLOCK_FRONT_TRANSFER  *Transfer;
+  UINT8                     *Buffer;
+  UINTN                     Size;
+  UINTN                     Sector; ///< 512 bytes sector.
+  BOOLEAN                   IsWrite;
+
+  //
+  // Grants on the caller's buffer and on IndirectPage, ended on completion.
+  //
+  grant_ref_t               GrantRef[XEN_BLOCK_FRONT_MAX_SEGMENTS + 1];
+  INT32                     NumRef;
+
+  //
+  // Persistent grants holding the data, and the segment descriptors of an
+  // indirect request, returned to the pool on completion.
+  //
+  XEN_BLOCK_FRONT_GRANT     *Grants[XEN_BLOCK_FRONT_MAX_SEGMENTS + 1];
+  INT32                     NumGrants;
+
+  //
+  // Segment descriptors of an indirect request, when the backend does not
+  // support persistent grants. Allocated on first use, kept with the request.
+  //
+  VOID                      *IndirectPage;
+
+  EFI_STATUS                Status;
 };
 
 typedef struct
@@ -36,16 +100,20 @@ typedef struct
   BOOLEAN   CdRom;
   BOOLEAN   FeatureBarrier;
   BOOLEAN   FeatureFlushCache;
+  BOOLEAN   FeaturePersistent;
+  UINT32    MaxIndirectSegments;
 } XEN_BLOCK_FRONT_MEDIA_INFO;
 
 #define XEN_BLOCK_FRONT_SIGNATURE SIGNATURE_32 ('X', 'p', 'v', 'B')
 struct _XEN_BLOCK_FRONT_DEVICE {
   UINT32                      Signature;
   EFI_BLOCK_IO_PROTOCOL       BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL      BlockIo2;
   domid_t                     DomainId;
 
   blkif_front_ring_t          Ring;
-  grant_ref_t                 RingRef;
+  grant_ref_t                 RingRef[XEN_BLOCK_FRONT_MAX_RING_PAGES];
+  UINT32                      RingPageOrder;
   evtchn_port_t               EventChannel;
   blkif_vdev_t                DeviceId;
 
@@ -54,11 +122,20 @@ struct _XEN_BLOCK_FRONT_DEVICE {
 
   VOID                        *StateWatchToken;
 
+  UINT32                      MaxSegments;    ///< Per ring request.
+  UINTN                       GrantsInUse;    ///< By requests in flight.
+  LIST_ENTRY                  FreeGrants;     ///< XEN_BLOCK_FRONT_GRANT
+  LIST_ENTRY                  FreeIos;        ///< XEN_BLOCK_FRONT_IO
+  EFI_EVENT                   PollEvent;
+  UINTN                       AsyncTransfers;
+
   XENBUS_PROTOCOL             *XenBusIo;
 };
 
 #define XEN_BLOCK_FRONT_FROM_BLOCK_IO(b) \
   CR (b, XEN_BLOCK_FRONT_DEVICE, BlockIo, XEN_BLOCK_FRONT_SIGNATURE)
+#define XEN_BLOCK_FRONT_FROM_BLOCK_IO2(b) \
+  CR (b, XEN_BLOCK_FRONT_DEVICE, BlockIo2, XEN_BLOCK_FRONT_SIGNATURE)
 
 EFI_STATUS
 XenPvBlockFrontInitialization (
@@ -72,16 +149,31 @@ XenPvBlockFrontShutdown (
   IN XEN_BLOCK_FRONT_DEVICE *Dev
   );
 
-VOID
-XenPvBlockAsyncIo (
-  IN OUT XEN_BLOCK_FRONT_IO *IoData,
-  IN     BOOLEAN            IsWrite
-  );
-
+/**
+  Read or write Size bytes at Sector, in as many ring requests as needed.
+
+  @param Dev      A XEN_BLOCK_FRONT_DEVICE instance.
+  @param Buffer   The data. Must be aligned on 512 bytes unless the backend
+                  supports persistent grants.
+  @param Size     Size of Buffer, a multiple of the sector size.
+  @param Sector   The first 512 bytes sector to read or write.
+  @param IsWrite  Indicate if the operation is write or read.
+  @param Token    NULL for a blocking transfer. Otherwise, the transfer is
+                  completed in the background, and Token->Event is signaled
+                  once it is done.
+
+  @retval EFI_SUCCESS           The transfer is done, or has been queued.
+  @retval EFI_DEVICE_ERROR      The backend reported an error.
+  @retval EFI_OUT_OF_RESOURCES  The transfer could not be queued.
+**/
 EFI_STATUS
-XenPvBlockIo (
-  IN OUT XEN_BLOCK_FRONT_IO *IoData,
-  IN     BOOLEAN            IsWrite
+XenPvBlockTransfer (
+  IN     XEN_BLOCK_FRONT_DEVICE *Dev,
+  IN OUT UINT8                  *Buffer,
+  IN     UINTN                  Size,
+  IN     UINTN                  Sector,
+  IN     BOOLEAN                IsWrite,
+  IN     EFI_BLOCK_IO2_TOKEN    *Token OPTIONAL
   );
 
 VOID
@@ -46,18 +46,33 @@ EFI_BLOCK_IO_PROTOCOL  gXenPvBlkDxeBlockIo = {
   XenPvBlkDxeBlockIoFlushBlocks             // FlushBlocks
 };
 
+///
+/// Block I/O 2 Protocol instance
+///
+GLOBAL_REMOVE_IF_UNREFERENCED
+EFI_BLOCK_IO2_PROTOCOL  gXenPvBlkDxeBlockIo2 = {
+  &gXenPvBlkDxeBlockIoMedia,                // Media
+  XenPvBlkDxeBlockIo2Reset,                 // Reset
+  XenPvBlkDxeBlockIo2ReadBlocksEx,          // ReadBlocksEx
+  XenPvBlkDxeBlockIo2WriteBlocksEx,         // WriteBlocksEx
+  XenPvBlkDxeBlockIo2FlushBlocksEx          // FlushBlocksEx
+};
+
 
 
 
 /**
   Read/Write BufferSize bytes from Lba into Buffer.
 
-  This function is common to XenPvBlkDxeBlockIoReadBlocks and
-  XenPvBlkDxeBlockIoWriteBlocks.
+  This function is common to the BlockIo and BlockIo2 read and write
+  functions.
 
-  @param  This       Indicates a pointer to the calling context.
-  @param  MediaId    Id of the media, changes every time the media is replaced.
+  @param  Dev        The XEN_BLOCK_FRONT_DEVICE to read from/write to.
+  @param  Media      The media of the device.
   @param  Lba        The starting Logical Block Address to read from/write to.
+  @param  Token      NULL for a blocking operation. Otherwise, the operation
+                     is done in the background, and Token->Event is signaled
+                     once it is complete.
   @param  BufferSize Size of Buffer, must be a multiple of device block size.
   @param  Buffer     A pointer to the destination/source buffer for the data.
   @param  IsWrite    Indicate if the operation is write or read.
@@ -68,16 +83,15 @@ EFI_BLOCK_IO_PROTOCOL  gXenPvBlkDxeBlockIo = {
 STATIC
 EFI_STATUS
 XenPvBlkDxeBlockIoReadWriteBlocks (
-  IN     EFI_BLOCK_IO_PROTOCOL  *This,
-  IN     UINT32                 MediaId,
+  IN     XEN_BLOCK_FRONT_DEVICE *Dev,
+  IN     EFI_BLOCK_IO_MEDIA     *Media,
   IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token OPTIONAL,
   IN     UINTN                  BufferSize,
   IN OUT VOID                   *Buffer,
   IN     BOOLEAN                IsWrite
   )
 {
-  XEN_BLOCK_FRONT_IO IoData;
-  EFI_BLOCK_IO_MEDIA *Media = This->Media;
   UINTN Sector;
   EFI_STATUS Status;
 
@@ -85,6 +99,10 @@ XenPvBlkDxeBlockIoReadWriteBlocks (
     return EFI_INVALID_PARAMETER;
   }
   if (BufferSize == 0) {
+    if (Token != NULL) {
+      Token->TransactionStatus = EFI_SUCCESS;
+      gBS->SignalEvent (Token->Event);
+    }
     return EFI_SUCCESS;
   }
 
@@ -106,6 +124,10 @@ XenPvBlkDxeBlockIoReadWriteBlocks (
     return EFI_WRITE_PROTECTED;
   }
 
+  //
+  // With persistent grants the data is copied through the granted pages, and
+  // IoAlign is 0, so only the other backends need an aligned buffer.
+  //
   if ((Media->IoAlign > 1) && (UINTN)Buffer & (Media->IoAlign - 1)) {
     //
     // Grub2 does not appear to respect IoAlign of 512, so reallocate the
@@ -113,49 +135,81 @@ XenPvBlkDxeBlockIoReadWriteBlocks (
     //
     VOID *NewBuffer;
 
+    if (Token != NULL) {
+      return EFI_INVALID_PARAMETER;
+    }
+
     //
     // Try again with a properly aligned buffer.
     //
     NewBuffer = AllocateAlignedPages((BufferSize + EFI_PAGE_SIZE) / EFI_PAGE_SIZE,
                                      Media->IoAlign);
+    if (NewBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
     if (!IsWrite) {
-      Status = XenPvBlkDxeBlockIoReadBlocks (This, MediaId,
-                                             Lba, BufferSize, NewBuffer);
+      Status = XenPvBlkDxeBlockIoReadWriteBlocks (Dev, Media, Lba, NULL,
+                                                  BufferSize, NewBuffer, FALSE);
       CopyMem (Buffer, NewBuffer, BufferSize);
     } else {
       CopyMem (NewBuffer, Buffer, BufferSize);
-      Status = XenPvBlkDxeBlockIoWriteBlocks (This, MediaId,
-                                              Lba, BufferSize, NewBuffer);
+      Status = XenPvBlkDxeBlockIoReadWriteBlocks (Dev, Media, Lba, NULL,
+                                                  BufferSize, NewBuffer, TRUE);
     }
     FreeAlignedPages (NewBuffer, (BufferSize + EFI_PAGE_SIZE) / EFI_PAGE_SIZE);
     return Status;
   }
 
-  IoData.Dev = XEN_BLOCK_FRONT_FROM_BLOCK_IO (This);
   Sector = (UINTN)MultU64x32 (Lba, Media->BlockSize / 512);
 
-  while (BufferSize > 0) {
-    if (((UINTN)Buffer & EFI_PAGE_MASK) == 0) {
-      IoData.Size = MIN (BLKIF_MAX_SEGMENTS_PER_REQUEST * EFI_PAGE_SIZE,
-                         BufferSize);
-    } else {
-      IoData.Size = MIN ((BLKIF_MAX_SEGMENTS_PER_REQUEST - 1) * EFI_PAGE_SIZE,
-                         BufferSize);
-    }
+  Status = XenPvBlockTransfer (Dev, Buffer, BufferSize, Sector, IsWrite, Token);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "XenPvBlkDxe: Error during %a operation.\n",
+            IsWrite ? "write" : "read"));
+  }
+  return Status;
+}
 
-    IoData.Buffer = Buffer;
-    IoData.Sector = Sector;
-    BufferSize -= IoData.Size;
-    Buffer = (VOID*) ((UINTN) Buffer + IoData.Size);
-    Sector += IoData.Size / 512;
-    Status = XenPvBlockIo (&IoData, IsWrite);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "XenPvBlkDxe: Error during %a operation.\n",
-              IsWrite ? "write" : "read"));
-      return Status;
-    }
+/**
+  Read/Write BufferSize bytes from Lba into Buffer, for BlockIo2.
+
+  A Token without an event, or no Token at all, makes the operation blocking.
+
+  @param  This       Indicates a pointer to the calling context.
+  @param  Lba        The starting Logical Block Address to read from/write to.
+  @param  Token      A pointer to the token associated with the transaction.
+  @param  BufferSize Size of Buffer, must be a multiple of device block size.
+  @param  Buffer     A pointer to the destination/source buffer for the data.
+  @param  IsWrite    Indicate if the operation is write or read.
+
+  @return See description of XenPvBlkDxeBlockIo2ReadBlocksEx and
+          XenPvBlkDxeBlockIo2WriteBlocksEx.
+**/
+STATIC
+EFI_STATUS
+XenPvBlkDxeBlockIo2ReadWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token OPTIONAL,
+  IN     UINTN                  BufferSize,
+  IN OUT VOID                   *Buffer,
+  IN     BOOLEAN                IsWrite
+  )
+{
+  XEN_BLOCK_FRONT_DEVICE *Dev = XEN_BLOCK_FRONT_FROM_BLOCK_IO2 (This);
+  EFI_STATUS Status;
+
+  if (Token != NULL && Token->Event != NULL) {
+    return XenPvBlkDxeBlockIoReadWriteBlocks (Dev, This->Media, Lba, Token,
+                                              BufferSize, Buffer, IsWrite);
   }
-  return EFI_SUCCESS;
+
+  Status = XenPvBlkDxeBlockIoReadWriteBlocks (Dev, This->Media, Lba, NULL,
+                                              BufferSize, Buffer, IsWrite);
+  if (Token != NULL) {
+    Token->TransactionStatus = Status;
+  }
+  return Status;
 }
 
 
@@ -188,8 +242,8 @@ XenPvBlkDxeBlockIoReadBlocks (
   OUT VOID                          *Buffer
   )
 {
-  return XenPvBlkDxeBlockIoReadWriteBlocks (This,
-      MediaId, Lba, BufferSize, Buffer, FALSE);
+  return XenPvBlkDxeBlockIoReadWriteBlocks (XEN_BLOCK_FRONT_FROM_BLOCK_IO (This),
+      This->Media, Lba, NULL, BufferSize, Buffer, FALSE);
 }
 
 /**
@@ -222,8 +276,8 @@ XenPvBlkDxeBlockIoWriteBlocks (
   IN VOID                           *Buffer
   )
 {
-  return XenPvBlkDxeBlockIoReadWriteBlocks (This,
-      MediaId, Lba, BufferSize, Buffer, TRUE);
+  return XenPvBlkDxeBlockIoReadWriteBlocks (XEN_BLOCK_FRONT_FROM_BLOCK_IO (This),
+      This->Media, Lba, NULL, BufferSize, Buffer, TRUE);
 }
 
 /**
@@ -268,3 +322,133 @@ XenPvBlkDxeBlockIoReset (
   //
   return EFI_SUCCESS;
 }
+
+/**
+  Read BufferSize bytes from Lba into Buffer.
+
+  @param  This       Indicates a pointer to the calling context.
+  @param  MediaId    Id of the media, changes every time the media is replaced.
+  @param  Lba        The starting Logical Block Address to read from.
+  @param  Token      A pointer to the token associated with the transaction.
+  @param  BufferSize Size of Buffer, must be a multiple of device block size.
+  @param  Buffer     A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS           The read request was queued if Token->Event is
+                                not NULL. The data was read correctly from the
+                                device if the Token->Event is NULL.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the read.
+  @retval EFI_NO_MEDIA          There is no media in the device.
+  @retval EFI_MEDIA_CHANGED     The MediaId does not match the current device.
+  @retval EFI_BAD_BUFFER_SIZE   The Buffer was not a multiple of the block size of the device.
+  @retval EFI_INVALID_PARAMETER The read request contains LBAs that are not valid,
+                                or the buffer is not on proper alignment.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+XenPvBlkDxeBlockIo2ReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  return XenPvBlkDxeBlockIo2ReadWriteBlocksEx (This,
+      Lba, Token, BufferSize, Buffer, FALSE);
+}
+
+/**
+  Write BufferSize bytes from Lba into Buffer.
+
+  @param  This       Indicates a pointer to the calling context.
+  @param  MediaId    The media ID that the write request is for.
+  @param  Lba        The starting logical block address to be written. The caller is
+                     responsible for writing to only legitimate locations.
+  @param  Token      A pointer to the token associated with the transaction.
+  @param  BufferSize Size of Buffer, must be a multiple of device block size.
+  @param  Buffer     A pointer to the source buffer for the data.
+
+  @retval EFI_SUCCESS           The write request was queued if Event is not
+                                NULL. The data was written correctly to the
+                                device if the Event is NULL.
+  @retval EFI_WRITE_PROTECTED   The device can not be written to.
+  @retval EFI_DEVICE_ERROR      The device reported an error while performing the write.
+  @retval EFI_NO_MEDIA          There is no media in the device.
+  @retval EFI_MEDIA_CHANGED     The MediaId does not match the current device.
+  @retval EFI_BAD_BUFFER_SIZE   The Buffer was not a multiple of the block size of the device.
+  @retval EFI_INVALID_PARAMETER The write request contains LBAs that are not valid,
+                                or the buffer is not on proper alignment.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be completed due to a lack of resources.
+
+**/
+EFI_STATUS
+EFIAPI
+XenPvBlkDxeBlockIo2WriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  return XenPvBlkDxeBlockIo2ReadWriteBlocksEx (This,
+      Lba, Token, BufferSize, Buffer, TRUE);
+}
+
+/**
+  Flush the Block Device.
+
+  The flush waits for the requests in flight, so it always completes before
+  returning; Token->Event is signaled right away.
+
+  @param  This              Indicates a pointer to the calling context.
+  @param  Token             A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS       All outstanding data was written to the device
+  @retval EFI_DEVICE_ERROR  The device reported an error while writing back the data
+  @retval EFI_NO_MEDIA      There is no media in the device.
+
+**/
+EFI_STATUS
+EFIAPI
+XenPvBlkDxeBlockIo2FlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  XenPvBlockSync (XEN_BLOCK_FRONT_FROM_BLOCK_IO2 (This));
+  if (Token != NULL) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    if (Token->Event != NULL) {
+      gBS->SignalEvent (Token->Event);
+    }
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the block device hardware.
+
+  @param[in]  This                 Indicates a pointer to the calling context.
+  @param[in]  ExtendedVerification Not used.
+
+  @retval EFI_SUCCESS          The device was reset.
+
+**/
+EFI_STATUS
+EFIAPI
+XenPvBlkDxeBlockIo2Reset (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN BOOLEAN                 ExtendedVerification
+  )
+{
+  //
+  // Since the initialization of the devices is done, then the device is
+  // working correctly.
+  //
+  return EFI_SUCCESS;
+}
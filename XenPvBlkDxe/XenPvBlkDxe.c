@@ -275,6 +275,8 @@ XenPvBlkDxeDriverBindingStart (
   }
 
   CopyMem (&Dev->BlockIo, &gXenPvBlkDxeBlockIo, sizeof (EFI_BLOCK_IO_PROTOCOL));
+  CopyMem (&Dev->BlockIo2, &gXenPvBlkDxeBlockIo2,
+           sizeof (EFI_BLOCK_IO2_PROTOCOL));
   Media = AllocateCopyPool (sizeof (EFI_BLOCK_IO_MEDIA),
                             &gXenPvBlkDxeBlockIoMedia);
   if (Dev->MediaInfo.VDiskInfo & VDISK_REMOVABLE) {
@@ -296,11 +298,20 @@ XenPvBlkDxeDriverBindingStart (
     Media->LastBlock = Dev->MediaInfo.Sectors - 1;
   }
   ASSERT (Media->BlockSize % 512 == 0);
+  if (Dev->MediaInfo.FeaturePersistent) {
+    //
+    // The data is copied through persistently granted pages, so the caller's
+    // buffer can be anywhere.
+    //
+    Media->IoAlign = 0;
+  }
   Dev->BlockIo.Media = Media;
+  Dev->BlockIo2.Media = Media;
 
   Status = gBS->InstallMultipleProtocolInterfaces (
                     &ControllerHandle,
                     &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
                     NULL
                     );
   if (EFI_ERROR (Status)) {
@@ -369,14 +380,17 @@ XenPvBlkDxeDriverBindingStop (
     return Status;
   }
 
-  Status = gBS->UninstallProtocolInterface (ControllerHandle,
-                  &gEfiBlockIoProtocolGuid, BlockIo);
+  Media = BlockIo->Media;
+  Dev = XEN_BLOCK_FRONT_FROM_BLOCK_IO (BlockIo);
+
+  Status = gBS->UninstallMultipleProtocolInterfaces (ControllerHandle,
+                  &gEfiBlockIoProtocolGuid, BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  Media = BlockIo->Media;
-  Dev = XEN_BLOCK_FRONT_FROM_BLOCK_IO (BlockIo);
   XenPvBlockFrontShutdown (Dev);
 
   FreePool (Media);
@@ -46,6 +46,7 @@
 // Produced Protocols
 //
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 
 
 //